@@ -0,0 +1,419 @@
+#include "commands.hpp"
+#include <thread>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QElapsedTimer>
+
+namespace
+{
+    /// @brief Number of bins of the distribution of session scores: negative means, then ten bins of width 0.1.
+    constexpr std::size_t scoreBins = 11;
+
+    /// @brief Running score statistics, mergeable across threads.
+    struct ScoreStatistics
+    {
+        std::uint64_t count = 0;
+        double mean = 0.0;
+        double deviations = 0.0;
+
+        /// @brief Adds a score (Welford's algorithm).
+        void add(double score)
+        {
+            double delta = score - mean;
+            mean += delta / static_cast<double>(++count);
+            deviations += delta * (score - mean);
+        }
+
+        /// @brief Adds the scores of other statistics (Chan's parallel algorithm).
+        void merge(const ScoreStatistics &other)
+        {
+            if (!other.count)
+                return;
+            std::uint64_t total = count + other.count;
+            double delta = other.mean - mean;
+            mean += delta * other.count / total;
+            deviations += other.deviations + delta * delta * count * other.count / total;
+            count = total;
+        }
+
+        /// @brief Returns the sample standard deviation.
+        double deviation() const { return count > 1 ? std::sqrt(deviations / (count - 1)) : 0.0; }
+    };
+
+    /// @brief Aggregated answers to one question.
+    struct QuestionAggregate
+    {
+        std::uint64_t draws = 0;
+        std::uint64_t correct = 0;
+        ScoreStatistics scores;
+
+        void merge(const QuestionAggregate &other)
+        {
+            draws += other.draws;
+            correct += other.correct;
+            scores.merge(other.scores);
+        }
+    };
+
+    /// @brief Totals of one logged session.
+    struct SessionResult
+    {
+        QString file;
+        qint64 start = 0;
+        std::string type;
+        ScoreStatistics scores;
+    };
+
+    /// @brief The aggregates computed by one thread, merged once all threads finish.
+    struct Partial
+    {
+        std::unordered_map<std::uint64_t, QuestionAggregate> questions;
+        std::vector<SessionResult> sessions;
+        std::uint64_t records = 0;
+        std::uint64_t bytes = 0;
+        std::vector<QString> unreadable;
+    };
+
+    /// @brief Returns whether a score is the full score of a question.
+    bool isCorrect(double score)
+    {
+        return score >= 1.0 - 1e-9;
+    }
+
+    /// @brief Aggregates the records of one log file into a partial result.
+    void aggregateFile(const QString &path, Partial &partial)
+    {
+        std::vector<fq::SessionLog::Record> records = fq::SessionLog::read(path.toStdString());
+        if (records.empty())
+        {
+            partial.unreadable.push_back(path);
+            return;
+        }
+        partial.records += records.size();
+        partial.bytes += static_cast<std::uint64_t>(QFileInfo(path).size());
+        SessionResult *session = nullptr;
+        for (const auto &record : records)
+        {
+            switch (record.type)
+            {
+            case fq::SessionLog::RecordType::Start:
+                partial.sessions.push_back({path, record.timestamp, record.text, {}});
+                session = &partial.sessions.back();
+                break;
+            case fq::SessionLog::RecordType::Draw:
+                ++partial.questions[record.question].draws;
+                break;
+            case fq::SessionLog::RecordType::Answer:
+            {
+                QuestionAggregate &question = partial.questions[record.question];
+                question.scores.add(record.score);
+                if (isCorrect(record.score))
+                    ++question.correct;
+                if (session)
+                    session->scores.add(record.score);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    /// @brief Collects the log files named by the arguments; directories are searched recursively for *.fqlog files.
+    /// @throws std::runtime_error if an argument does not exist.
+    QStringList collectLogs(const QStringList &arguments)
+    {
+        QStringList files;
+        for (const QString &argument : arguments)
+        {
+            QFileInfo info(argument);
+            if (info.isDir())
+            {
+                QDirIterator it(argument, {"*.fqlog"}, QDir::Files, QDirIterator::Subdirectories);
+                while (it.hasNext())
+                    files.append(it.next());
+            }
+            else if (info.isFile())
+                files.append(argument);
+            else
+                throw std::runtime_error("No such file or directory: " + argument.toStdString());
+        }
+        files.sort();
+        files.removeDuplicates();
+        return files;
+    }
+
+    /// @brief Returns the z-scores of values relative to their mean and standard deviation.
+    std::vector<double> zScores(const std::vector<double> &values)
+    {
+        ScoreStatistics statistics;
+        for (double value : values)
+            statistics.add(value);
+        double deviation = statistics.deviation();
+        std::vector<double> scores;
+        scores.reserve(values.size());
+        for (double value : values)
+            scores.push_back(deviation > 0.0 ? (value - statistics.mean) / deviation : 0.0);
+        return scores;
+    }
+
+    /// @brief Quotes a CSV field if needed.
+    std::string csvField(const std::string &text)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string::npos)
+            return text;
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    /// @brief Formats a question identifier as in the output.
+    QString formatId(std::uint64_t id)
+    {
+        return QString::number(id, 16).rightJustified(16, '0');
+    }
+}
+
+int fq::cli::aggregate(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Aggregates many session logs into per-question and per-session statistics.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("aggregate", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file the logs were recorded with.");
+    parser.addPositionalArgument("logs", "Session log files, or directories searched for *.fqlog files.", "logs...");
+    QCommandLineOption formatOption({"f", "format"}, "Output format: csv or json (default: csv).", "format", "csv");
+    QCommandLineOption tableOption("table", "The CSV table to write: questions or sessions (default: questions).", "table", "questions");
+    QCommandLineOption outputOption({"o", "output"}, "Write to this file instead of the standard output.", "file");
+    QCommandLineOption threadsOption({"j", "threads"}, "Number of threads (default: number of cores).", "count");
+    QCommandLineOption minAnswersOption("min-answers", "Answers a question or session needs to be checked for outliers (default: 5).", "count", "5");
+    QCommandLineOption zOption("z", "Mean scores this many standard deviations from the mean are outliers (default: 2.5).", "score", "2.5");
+    parser.addOptions({formatOption, tableOption, outputOption, threadsOption, minAnswersOption, zOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() < 3)
+        parser.showHelp(1);
+    QString format = parser.value(formatOption);
+    QString table = parser.value(tableOption);
+    if ((format != "csv" && format != "json") || (table != "questions" && table != "sessions"))
+        parser.showHelp(1);
+    bool ok = true;
+    std::uint64_t minAnswers = parser.value(minAnswersOption).toULongLong(&ok);
+    double threshold = ok ? parser.value(zOption).toDouble(&ok) : 0.0;
+    if (!ok || threshold <= 0.0)
+        throw std::invalid_argument("Invalid outlier options");
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (parser.isSet(threadsOption))
+    {
+        threadCount = parser.value(threadsOption).toUInt(&ok);
+        if (!ok || !threadCount)
+            throw std::invalid_argument("Invalid number of threads: " + parser.value(threadsOption).toStdString());
+    }
+
+    std::unique_ptr<Repository> repository = openRepository(positional[1]);
+    QStringList files = collectLogs(positional.mid(2));
+    if (files.isEmpty())
+        throw std::runtime_error("No session logs found");
+
+    // Every thread takes the next unread file and aggregates it on its own; the partial results are merged at the end,
+    // so the threads share nothing but the index of the next file.
+    QElapsedTimer timer;
+    timer.start();
+    threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(files.size()));
+    std::vector<Partial> partials(threadCount);
+    std::atomic<qsizetype> nextFile{0};
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t)
+        threads.emplace_back([&, t]
+                             {
+                                 for (qsizetype i = nextFile++; i < files.size(); i = nextFile++)
+                                     aggregateFile(files[i], partials[t]); });
+    for (auto &thread : threads)
+        thread.join();
+
+    Partial total = std::move(partials.front());
+    for (std::size_t t = 1; t < partials.size(); ++t)
+    {
+        for (const auto &[id, question] : partials[t].questions)
+            total.questions[id].merge(question);
+        std::move(partials[t].sessions.begin(), partials[t].sessions.end(), std::back_inserter(total.sessions));
+        std::move(partials[t].unreadable.begin(), partials[t].unreadable.end(), std::back_inserter(total.unreadable));
+        total.records += partials[t].records;
+        total.bytes += partials[t].bytes;
+    }
+    std::sort(total.sessions.begin(), total.sessions.end(), [](const SessionResult &a, const SessionResult &b)
+              { return a.file != b.file ? a.file < b.file : a.start < b.start; });
+    for (const QString &file : total.unreadable)
+        std::cerr << "Skipped " << file.toStdString() << ": not a session log\n";
+
+    // Join with the repository: every question of the repository gets a row, followed by questions which are only
+    // found in the logs (e.g. deleted since).
+    struct QuestionRow
+    {
+        std::uint64_t id;
+        const fq::Question *question;
+        QuestionAggregate aggregate;
+        double z = 0.0;
+        bool outlier = false;
+    };
+    std::vector<QuestionRow> rows;
+    std::unordered_map<std::uint64_t, bool> known;
+    for (const fq::Question *question : repository->getQuestions())
+    {
+        std::uint64_t id = SessionLog::questionId(question);
+        if (known.emplace(id, true).second)
+        {
+            auto it = total.questions.find(id);
+            rows.push_back({id, question, it != total.questions.end() ? it->second : QuestionAggregate{}});
+        }
+    }
+    std::vector<std::uint64_t> missing;
+    for (const auto &[id, aggregate] : total.questions)
+    {
+        if (!known.count(id))
+            missing.push_back(id);
+    }
+    std::sort(missing.begin(), missing.end());
+    for (std::uint64_t id : missing)
+        rows.push_back({id, nullptr, total.questions[id]});
+
+    // Outliers are questions and sessions with enough answers whose mean score lies far from the mean of the others.
+    std::vector<double> means;
+    for (const auto &row : rows)
+    {
+        if (row.aggregate.scores.count && row.aggregate.scores.count >= minAnswers)
+            means.push_back(row.aggregate.scores.mean);
+    }
+    std::vector<double> z = zScores(means);
+    for (std::size_t r = 0, i = 0; r < rows.size(); ++r)
+    {
+        if (rows[r].aggregate.scores.count && rows[r].aggregate.scores.count >= minAnswers)
+        {
+            rows[r].z = z[i++];
+            rows[r].outlier = std::abs(rows[r].z) >= threshold;
+        }
+    }
+    means.clear();
+    for (const auto &session : total.sessions)
+    {
+        if (session.scores.count && session.scores.count >= minAnswers)
+            means.push_back(session.scores.mean);
+    }
+    z = zScores(means);
+    std::vector<double> sessionZ(total.sessions.size(), 0.0);
+    std::array<std::uint64_t, scoreBins> distribution{};
+    for (std::size_t s = 0, i = 0; s < total.sessions.size(); ++s)
+    {
+        const ScoreStatistics &scores = total.sessions[s].scores;
+        if (!scores.count)
+            continue;
+        std::size_t bin = scores.mean < 0.0 ? 0 : 1 + std::min<std::size_t>(scoreBins - 2, static_cast<std::size_t>(scores.mean * 10.0));
+        ++distribution[bin];
+        if (scores.count >= minAnswers)
+            sessionZ[s] = z[i++];
+    }
+
+    QByteArray output;
+    if (format == "json")
+    {
+        QJsonArray questions;
+        for (const auto &row : rows)
+        {
+            QJsonObject object{
+                {"id", formatId(row.id)},
+                {"question", row.question ? QJsonValue(QString::fromStdString(row.question->getQuestion())) : QJsonValue()},
+                {"draws", static_cast<qint64>(row.aggregate.draws)},
+                {"answers", static_cast<qint64>(row.aggregate.scores.count)},
+                {"correct", static_cast<qint64>(row.aggregate.correct)},
+                {"meanScore", row.aggregate.scores.mean},
+                {"scoreDeviation", row.aggregate.scores.deviation()},
+                {"z", row.z},
+                {"outlier", row.outlier},
+            };
+            questions.append(object);
+        }
+        QJsonArray sessions;
+        for (std::size_t s = 0; s < total.sessions.size(); ++s)
+        {
+            const SessionResult &session = total.sessions[s];
+            sessions.append(QJsonObject{
+                {"log", session.file},
+                {"start", QDateTime::fromMSecsSinceEpoch(session.start).toString(Qt::ISODate)},
+                {"type", QString::fromStdString(session.type)},
+                {"answers", static_cast<qint64>(session.scores.count)},
+                {"totalScore", session.scores.mean * session.scores.count},
+                {"meanScore", session.scores.mean},
+                {"z", sessionZ[s]},
+                {"outlier", std::abs(sessionZ[s]) >= threshold},
+            });
+        }
+        QJsonArray histogram;
+        for (auto count : distribution)
+            histogram.append(static_cast<qint64>(count));
+        QJsonObject root{
+            {"logs", static_cast<qint64>(files.size() - total.unreadable.size())},
+            {"records", static_cast<qint64>(total.records)},
+            {"questions", questions},
+            {"sessions", sessions},
+            {"sessionScoreDistribution", histogram},
+        };
+        output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    }
+    else if (table == "questions")
+    {
+        std::string csv = "id,question,draws,answers,correct,mean_score,score_deviation,z,outlier\n";
+        for (const auto &row : rows)
+        {
+            csv += formatId(row.id).toStdString() + "," + csvField(row.question ? row.question->getQuestion() : "") + "," +
+                   std::to_string(row.aggregate.draws) + "," + std::to_string(row.aggregate.scores.count) + "," +
+                   std::to_string(row.aggregate.correct) + "," + QString::number(row.aggregate.scores.mean).toStdString() + "," +
+                   QString::number(row.aggregate.scores.deviation()).toStdString() + "," +
+                   QString::number(row.z).toStdString() + "," + (row.outlier ? "1" : "0") + "\n";
+        }
+        output = QByteArray::fromStdString(csv);
+    }
+    else
+    {
+        std::string csv = "log,start,type,answers,total_score,mean_score,z,outlier\n";
+        for (std::size_t s = 0; s < total.sessions.size(); ++s)
+        {
+            const SessionResult &session = total.sessions[s];
+            csv += csvField(session.file.toStdString()) + "," +
+                   QDateTime::fromMSecsSinceEpoch(session.start).toString(Qt::ISODate).toStdString() + "," +
+                   csvField(session.type) + "," + std::to_string(session.scores.count) + "," +
+                   QString::number(session.scores.mean * session.scores.count).toStdString() + "," +
+                   QString::number(session.scores.mean).toStdString() + "," + QString::number(sessionZ[s]).toStdString() + "," +
+                   (std::abs(sessionZ[s]) >= threshold ? "1" : "0") + "\n";
+        }
+        output = QByteArray::fromStdString(csv);
+    }
+
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(output) != output.size())
+            throw std::runtime_error("Failed to write " + parser.value(outputOption).toStdString());
+    }
+    else
+        std::cout.write(output.constData(), output.size());
+    std::cerr << "Aggregated " << total.records << " records of " << total.sessions.size() << " sessions from "
+              << files.size() - total.unreadable.size() << " logs (" << total.bytes / 1024 << " KiB) in "
+              << timer.elapsed() << " ms using " << threadCount << " threads\n";
+    return 0;
+}
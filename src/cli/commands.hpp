@@ -0,0 +1,82 @@
+/// @file commands.hpp
+/// @brief Contains declarations of the commands of the FunQuizz command-line tool.
+
+#pragma once
+#include <string>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+#include "repository.hpp"
+
+/// @namespace fq::cli
+/// @brief Contains the commands of the FunQuizz command-line tool.
+/// @details Every command receives its own arguments (starting with the command name) and returns the exit code of the tool.
+namespace fq::cli
+{
+    /// @brief Opens a repository for a command which reads all of its questions.
+    /// @details The repository is never saved. The shards of a sharded repository are merged, so getQuestions and
+    /// getBank return every question instead of none.
+    /// @param path The path to the repository JSON file.
+    /// @return The repository.
+    /// @throws std::runtime_error if the repository or one of its shards cannot be loaded.
+    std::unique_ptr<Repository> openRepository(const QString &path);
+
+    /// @brief Aggregates many session logs in parallel into per-question and per-session statistics.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int aggregate(const QStringList &arguments);
+
+    /// @brief Reports the pairs of near-duplicate questions of a repository.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int duplicates(const QStringList &arguments);
+
+    /// @brief Generates exam papers satisfying tag quotas, type balance and a target difficulty.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int exam(const QStringList &arguments);
+
+    /// @brief Exports the questions of a repository as compact JSON, CSV or a printable HTML or LaTeX exam.
+    /// @details Not named after its command, since export is a keyword.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int exportQuestions(const QStringList &arguments);
+
+    /// @brief Imports questions from CSV, Markdown or GIFT files into a repository.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int import(const QStringList &arguments);
+
+    /// @brief Splits a repository into shards and writes their manifest.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int shard(const QStringList &arguments);
+
+    /// @brief Checks repository files and reports all of their problems.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int validate(const QStringList &arguments);
+
+    /// @brief Loads a repository and reports the memory saved by interning its answer texts and explanations.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int strings(const QStringList &arguments);
+
+    /// @brief Loads a repository and reports the estimated memory used by its questions, by category and by type.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int memory(const QStringList &arguments);
+
+    /// @brief Simulates many clients taking quizzes from a running server and reports its throughput and latency.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int load(const QStringList &arguments);
+
+    /// @brief Replays the logged sessions of a repository and reports whether each was reproduced exactly.
+    /// @param arguments The arguments of the command, starting with the command name.
+    /// @return The exit code of the tool.
+    int replay(const QStringList &arguments);
+}
@@ -0,0 +1,43 @@
+#include "commands.hpp"
+#include "duplicateindex.hpp"
+#include <chrono>
+
+int fq::cli::duplicates(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Reports pairs of near-duplicate questions of a repository.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("duplicates", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    QCommandLineOption distanceOption({"d", "distance"}, "Number of differing signature bits (0-15) up to which questions are near-duplicates (default: 3).", "bits", QString::number(DuplicateIndex::defaultMaxDistance));
+    QCommandLineOption threadsOption({"j", "threads"}, "Number of threads (default: number of cores).", "count", "0");
+    parser.addOptions({distanceOption, threadsOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2)
+        parser.showHelp(1);
+    bool ok = false;
+    int distance = parser.value(distanceOption).toInt(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid distance: " + parser.value(distanceOption).toStdString());
+    unsigned threads = parser.value(threadsOption).toUInt(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid number of threads: " + parser.value(threadsOption).toStdString());
+
+    std::unique_ptr<Repository> repository = openRepository(positional[1]);
+    auto start = std::chrono::steady_clock::now();
+    DuplicateIndex index(distance);
+    index.build(repository->getQuestions(), threads);
+    auto matches = index.findDuplicates(threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto &match : matches)
+    {
+        std::cout << static_cast<int>(DuplicateIndex::similarity(match.distance) * 100 + 0.5) << "%\t"
+                  << index.at(match.first)->getQuestion() << "\n\t"
+                  << index.at(match.second)->getQuestion() << "\n";
+    }
+    std::cout << matches.size() << " near-duplicate pairs among " << index.size() << " questions (" << seconds << " s)\n";
+    return matches.empty() ? 0 : 1;
+}
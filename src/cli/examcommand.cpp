@@ -0,0 +1,68 @@
+#include "commands.hpp"
+#include "exam.hpp"
+#include <QDir>
+
+int fq::cli::exam(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates exam papers from a repository. Every paper is written as a non-repeating repository.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("exam", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    parser.addPositionalArgument("output", "The directory the papers are written to.");
+    QCommandLineOption countOption({"n", "count"}, "Number of questions on each paper.", "count");
+    QCommandLineOption quotaOption({"q", "quota"}, "Minimum number of questions with a tag, as tag=count. Can be repeated.", "quota");
+    QCommandLineOption filterOption({"f", "filter"}, "Tag expression selecting the questions which may be used.", "expression");
+    QCommandLineOption balanceOption({"b", "balance-types"}, "Represent the question types as evenly as possible.");
+    QCommandLineOption difficultyOption({"d", "difficulty"}, "Target mean difficulty of each paper.", "difficulty");
+    QCommandLineOption variantsOption({"v", "variants"}, "Number of distinct papers to generate.", "variants", "1");
+    QCommandLineOption seedOption({"s", "seed"}, "Seed of the batch. The same seed always gives the same papers.", "seed", "0");
+    QCommandLineOption threadsOption({"t", "threads"}, "Number of worker threads. 0 uses one thread per core.", "threads", "0");
+    parser.addOptions({countOption, quotaOption, filterOption, balanceOption, difficultyOption, variantsOption, seedOption, threadsOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 3 || !parser.isSet(countOption))
+        parser.showHelp(1);
+
+    ExamConstraints constraints;
+    bool ok = false;
+    constraints.questionCount = parser.value(countOption).toULongLong(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid question count: " + parser.value(countOption).toStdString());
+    for (const QString &quota : parser.values(quotaOption))
+    {
+        int separator = quota.lastIndexOf('=');
+        std::size_t count = separator > 0 ? quota.mid(separator + 1).toULongLong(&ok) : 0;
+        if (separator <= 0 || !ok)
+            throw std::invalid_argument("Invalid quota (expected tag=count): " + quota.toStdString());
+        constraints.tagQuotas[quota.left(separator).toStdString()] = count;
+    }
+    constraints.filter = parser.value(filterOption).toStdString();
+    constraints.balanceTypes = parser.isSet(balanceOption);
+    if (parser.isSet(difficultyOption))
+    {
+        constraints.targetDifficulty = parser.value(difficultyOption).toDouble(&ok);
+        if (!ok)
+            throw std::invalid_argument("Invalid target difficulty: " + parser.value(difficultyOption).toStdString());
+    }
+    std::size_t variants = parser.value(variantsOption).toULongLong();
+    std::uint64_t seed = parser.value(seedOption).toULongLong();
+    unsigned threads = parser.value(threadsOption).toUInt();
+
+    std::unique_ptr<Repository> repository = openRepository(positional[1]);
+    ExamGenerator generator(*repository);
+    auto papers = generator.generateVariants(constraints, variants, seed, threads);
+
+    QDir output(positional[2]);
+    if (!output.mkpath("."))
+        throw std::runtime_error("Failed to create output directory: " + positional[2].toStdString());
+    int width = QString::number(papers.size()).size();
+    for (std::size_t i = 0; i < papers.size(); ++i)
+    {
+        QString name = QString("exam_%1.json").arg(i + 1, width, 10, QChar('0'));
+        ExamGenerator::savePaper(papers[i], output.filePath(name).toStdString(), seed, i);
+    }
+    std::cout << "Generated " << papers.size() << " papers in " << positional[2].toStdString() << "\n";
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "commands.hpp"
+#include "exporter.hpp"
+
+int fq::cli::exportQuestions(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Exports the questions of a repository as repository JSON, CSV or a printable HTML or LaTeX exam.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("export", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    parser.addPositionalArgument("output", "The file to be written (.json, .csv, .html or .tex).");
+    QCommandLineOption titleOption({"t", "title"}, "The title of HTML and LaTeX exams.", "title", "Exam");
+    QCommandLineOption answersOption({"a", "answers"}, "Mark the correct answers and show the explanations in HTML and LaTeX exams.");
+    QCommandLineOption seedOption({"s", "seed"}, "Seed of the values of template questions in CSV, HTML and LaTeX files.", "seed", "0");
+    parser.addOptions({titleOption, answersOption, seedOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 3)
+        parser.showHelp(1);
+
+    std::unique_ptr<Repository> repository(Repository::createRepository(positional[1].toStdString()));
+    repository->setAutoSave(false);
+    if (!repository->isEditable())
+        throw std::invalid_argument("Only plain repositories can be exported; export the shards of a sharded repository one by one");
+    Exporter::Options options;
+    options.type = repository->getType();
+    options.title = parser.value(titleOption).toStdString();
+    options.answers = parser.isSet(answersOption);
+    bool ok = false;
+    options.seed = parser.value(seedOption).toUInt(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid seed: " + parser.value(seedOption).toStdString());
+    auto questions = repository->getQuestions();
+    Exporter::exportFile(positional[2].toStdString(), questions, options);
+    std::cout << "Exported " << questions.size() << " questions to " << positional[2].toStdString() << "\n";
+    return 0;
+}
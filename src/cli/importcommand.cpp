@@ -0,0 +1,58 @@
+#include "commands.hpp"
+#include "importer.hpp"
+
+int fq::cli::import(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Imports questions from CSV, Markdown or GIFT files into a repository.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("import", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    parser.addPositionalArgument("files", "Files to import (.csv, .md, .gift or .txt).", "files...");
+    QCommandLineOption threadsOption({"j", "threads"}, "Number of threads (default: number of cores).", "count", "0");
+    QCommandLineOption dryRunOption({"n", "dry-run"}, "Only check the files; do not change the repository.");
+    parser.addOptions({threadsOption, dryRunOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() < 3)
+        parser.showHelp(1);
+    bool ok = false;
+    unsigned threads = parser.value(threadsOption).toUInt(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid number of threads: " + parser.value(threadsOption).toStdString());
+
+    std::unique_ptr<Repository> repository(Repository::createRepository(positional[1].toStdString()));
+    repository->setAutoSave(false);
+    if (!repository->isEditable())
+        throw std::invalid_argument("Questions can only be imported into plain repositories");
+
+    // The imported questions stay owned here until the repository takes them, so none leaks if a later file fails.
+    std::vector<std::unique_ptr<fq::Question>> imported;
+    std::size_t errors = 0;
+    for (const QString &file : positional.mid(2))
+    {
+        Importer::Result result = Importer::importFile(file.toStdString(), threads);
+        for (const auto &error : result.errors)
+            std::cerr << file.toStdString() << ":" << error.line << ": " << error.message << "\n";
+        std::cout << file.toStdString() << ": " << result.questions.size() << " questions, " << result.errors.size() << " errors\n";
+        errors += result.errors.size();
+        for (auto &question : result.questions)
+            imported.push_back(std::move(question));
+    }
+    if (parser.isSet(dryRunOption))
+        return errors ? 1 : 0;
+    std::vector<fq::Question *> questions;
+    questions.reserve(imported.size());
+    for (auto &question : imported)
+        questions.push_back(question.release());
+    std::size_t count = questions.size();
+    std::size_t added = repository->addQuestions(questions);
+    if (added)
+        repository->save();
+    std::cout << "Added " << added << " questions to " << positional[1].toStdString();
+    if (added < count)
+        std::cout << " (" << count - added << " already present)";
+    std::cout << "\n";
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#include "commands.hpp"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <QTcpSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+namespace
+{
+    /// @brief Results of one simulated client.
+    struct ClientResult
+    {
+        std::size_t answers = 0;
+        std::size_t errors = 0;
+        std::vector<double> latencies;
+        std::string failure;
+    };
+
+    /// @brief Sends a request to the server and waits for its response.
+    /// @throws std::runtime_error if the connection fails or the server does not answer in time.
+    QJsonObject request(QTcpSocket &socket, const QJsonObject &object)
+    {
+        socket.write(QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n');
+        while (!socket.canReadLine())
+        {
+            if (!socket.waitForReadyRead(10000))
+                throw std::runtime_error("Server did not respond: " + socket.errorString().toStdString());
+        }
+        return QJsonDocument::fromJson(socket.readLine()).object();
+    }
+
+    /// @brief Takes quizzes from the server as one client until the deadline, answering randomly.
+    void simulateClient(const QString &host, quint16 port, std::uint32_t seed, std::chrono::steady_clock::time_point deadline, ClientResult &result)
+    {
+        try
+        {
+            QTcpSocket socket;
+            socket.connectToHost(host, port);
+            if (!socket.waitForConnected(10000))
+                throw std::runtime_error("Failed to connect: " + socket.errorString().toStdString());
+            socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            std::mt19937 generator(seed);
+            while (std::chrono::steady_clock::now() < deadline)
+            {
+                QJsonObject question = request(socket, {{"op", "next"}});
+                if (question.contains("error"))
+                {
+                    ++result.errors;
+                    continue;
+                }
+                int count = question["answers"].toArray().size();
+                QJsonArray selected;
+                if (count)
+                    selected.append(std::uniform_int_distribution<int>(0, count - 1)(generator));
+                auto start = std::chrono::steady_clock::now();
+                QJsonObject response = request(socket, {{"op", "answer"}, {"selected", selected}});
+                std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - start;
+                if (response.contains("error"))
+                    ++result.errors;
+                else
+                {
+                    ++result.answers;
+                    result.latencies.push_back(latency.count());
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            result.failure = e.what();
+        }
+    }
+}
+
+int fq::cli::load(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates many clients taking quizzes from a running FunQuizzServer and reports its throughput.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("load", "The command name.");
+    QCommandLineOption hostOption({"a", "address"}, "The address of the server.", "address", "127.0.0.1");
+    QCommandLineOption portOption({"p", "port"}, "The port of the server.", "port", "5757");
+    QCommandLineOption clientsOption({"c", "clients"}, "Number of simultaneous clients.", "clients", "200");
+    QCommandLineOption durationOption({"d", "duration"}, "Duration of the test in seconds.", "seconds", "10");
+    parser.addOptions({hostOption, portOption, clientsOption, durationOption});
+    parser.process(arguments);
+
+    bool ok = false;
+    quint16 port = parser.value(portOption).toUShort(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid port: " + parser.value(portOption).toStdString());
+    std::size_t clients = parser.value(clientsOption).toULongLong(&ok);
+    if (!ok || !clients)
+        throw std::invalid_argument("Invalid number of clients: " + parser.value(clientsOption).toStdString());
+    double duration = parser.value(durationOption).toDouble(&ok);
+    if (!ok || duration <= 0.0)
+        throw std::invalid_argument("Invalid duration: " + parser.value(durationOption).toStdString());
+
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    threads.reserve(clients);
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(duration));
+    for (std::size_t i = 0; i < clients; ++i)
+        threads.emplace_back(simulateClient, parser.value(hostOption), port, static_cast<std::uint32_t>(i), deadline, std::ref(results[i]));
+    for (auto &thread : threads)
+        thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::size_t answers = 0, errors = 0, failed = 0;
+    std::vector<double> latencies;
+    for (auto &result : results)
+    {
+        answers += result.answers;
+        errors += result.errors;
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        if (!result.failure.empty())
+        {
+            if (!failed)
+                std::cerr << "Client failed: " << result.failure << "\n";
+            ++failed;
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double fraction)
+    {
+        return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(fraction * latencies.size()))];
+    };
+    std::cout << "Clients:              " << clients << " (" << failed << " failed)\n"
+              << "Answers submitted:    " << answers << " (" << errors << " errors)\n"
+              << "Answers per second:   " << static_cast<std::size_t>(answers / elapsed.count()) << "\n"
+              << "Answer latency (ms):  p50 " << percentile(0.5) << ", p99 " << percentile(0.99) << ", max " << percentile(1.0) << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <map>
+#include <functional>
+#include <QCoreApplication>
+#include "commands.hpp"
+#include "shardedrepository.hpp"
+
+std::unique_ptr<fq::Repository> fq::cli::openRepository(const QString &path)
+{
+    std::unique_ptr<Repository> repository(Repository::createRepository(path.toStdString()));
+    repository->setAutoSave(false);
+    if (auto *sharded = dynamic_cast<ShardedRepository *>(repository.get()))
+        sharded->mergeShards();
+    return repository;
+}
+
+/// @brief Prints the list of available commands.
+static void printUsage()
+{
+    std::cerr << "Usage: FunQuizzCli <command> [options]\n\n"
+              << "Commands:\n"
+              << "  aggregate  Aggregate session logs into per-question statistics\n"
+              << "  duplicates Report near-duplicate questions\n"
+              << "  exam       Generate exam papers from a repository\n"
+              << "  export     Export questions as JSON, CSV or a printable exam\n"
+              << "  import     Import questions from CSV, Markdown or GIFT files\n"
+              << "  load       Measure the throughput of a running quiz server\n"
+              << "  memory     Report the memory used by the questions of a repository\n"
+              << "  replay     Replay logged sessions to audit them\n"
+              << "  shard      Split a repository into shards loaded on demand\n"
+              << "  strings    Report the memory saved by sharing repeated texts\n"
+              << "  validate   Check repository files and report every problem\n\n"
+              << "Run 'FunQuizzCli <command> --help' for the options of a command.\n";
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("FunQuizzCli");
+    const std::map<QString, std::function<int(const QStringList &)>> commands = {
+        {"aggregate", fq::cli::aggregate},
+        {"duplicates", fq::cli::duplicates},
+        {"exam", fq::cli::exam},
+        {"export", fq::cli::exportQuestions},
+        {"import", fq::cli::import},
+        {"load", fq::cli::load},
+        {"memory", fq::cli::memory},
+        {"replay", fq::cli::replay},
+        {"shard", fq::cli::shard},
+        {"strings", fq::cli::strings},
+        {"validate", fq::cli::validate},
+    };
+    QStringList arguments = app.arguments();
+    if (arguments.size() < 2 || !commands.count(arguments[1]))
+    {
+        printUsage();
+        return 1;
+    }
+    try
+    {
+        return commands.at(arguments[1])(arguments.mid(1));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,49 @@
+#include "commands.hpp"
+#include <QJsonObject>
+#include <QJsonDocument>
+
+int fq::cli::memory(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Reports the estimated memory used by the questions of a repository, by category and by question type.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("memory", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    QCommandLineOption jsonOption({"j", "json"}, "Write the report as JSON.");
+    parser.addOption(jsonOption);
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2)
+        parser.showHelp(1);
+
+    std::unique_ptr<Repository> repository = openRepository(positional[1]);
+    // Statistics are loaded with the first answer, so they are part of the memory of a running quiz.
+    repository->getStatistics();
+    MemoryUsage usage = repository->getMemoryUsage();
+    if (parser.isSet(jsonOption))
+    {
+        QJsonObject types;
+        for (const auto &[type, typeUsage] : usage.types)
+            types[QString::fromStdString(type)] = QJsonObject{{"questions", static_cast<qint64>(typeUsage.questions)},
+                                                              {"bytes", static_cast<qint64>(typeUsage.bytes)}};
+        QJsonObject json{{"questions", static_cast<qint64>(usage.questions)},
+                         {"text_bytes", static_cast<qint64>(usage.textBytes)},
+                         {"answer_bytes", static_cast<qint64>(usage.answerBytes)},
+                         {"explanation_bytes", static_cast<qint64>(usage.explanationBytes)},
+                         {"tag_bytes", static_cast<qint64>(usage.tagBytes)},
+                         {"object_bytes", static_cast<qint64>(usage.objectBytes)},
+                         {"container_bytes", static_cast<qint64>(usage.containerBytes)},
+                         {"statistics_bytes", static_cast<qint64>(usage.statisticsBytes)},
+                         {"total_bytes", static_cast<qint64>(usage.total())},
+                         {"types", types}};
+        std::cout << QJsonDocument(json).toJson().toStdString();
+        return 0;
+    }
+    std::cout << "Questions:            " << repository->getQuestionCount();
+    if (usage.questions != repository->getQuestionCount())
+        std::cout << " (" << usage.questions << " in memory)";
+    std::cout << "\n\n"
+              << usage.toString();
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "commands.hpp"
+#include <QDateTime>
+
+int fq::cli::replay(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays the logged sessions of a repository and checks that they are reproduced exactly.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("replay", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    QCommandLineOption logOption({"l", "log"}, "The session log. Defaults to the log next to the repository.", "log");
+    QCommandLineOption lastOption("last", "Replay only the last session.");
+    parser.addOptions({logOption, lastOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2)
+        parser.showHelp(1);
+
+    std::unique_ptr<Repository> repository(Repository::createRepository(positional[1].toStdString()));
+    repository->setAutoSave(false);
+    std::string logPath = parser.isSet(logOption) ? parser.value(logOption).toStdString() : SessionLog::logPath(repository->getPath());
+    auto sessions = SessionLog::splitSessions(SessionLog::read(logPath));
+    if (sessions.empty())
+        throw std::runtime_error("No sessions logged in " + logPath);
+    if (parser.isSet(lastOption))
+        sessions.erase(sessions.begin(), sessions.end() - 1);
+
+    std::size_t inexact = 0;
+    for (const auto &records : sessions)
+    {
+        const SessionLog::Record &start = records.front();
+        auto session = Session::create(start.text, repository->getBank(), start.seed);
+        SessionLog::ReplaySummary summary = session->replay(records);
+        std::cout << QDateTime::fromMSecsSinceEpoch(start.timestamp).toString(Qt::ISODate).toStdString() << "  "
+                  << start.text << " session, seed " << start.seed << ": " << summary.answers << " answers, score "
+                  << summary.totalScore << ", " << summary.verifiedDraws << "/" << summary.draws << " draws reproduced";
+        if (summary.scoreMismatches)
+            std::cout << ", " << summary.scoreMismatches << " scores differ";
+        if (summary.missingQuestions)
+            std::cout << ", " << summary.missingQuestions << " records of missing questions";
+        std::cout << (summary.isExact() ? "" : "  [NOT EXACT]") << "\n";
+        if (!summary.isExact())
+            ++inexact;
+    }
+    std::cout << sessions.size() - inexact << " of " << sessions.size() << " sessions reproduced exactly\n";
+    return inexact ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+#include "commands.hpp"
+#include "shardedrepository.hpp"
+
+int fq::cli::shard(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Splits a repository into shards, which are loaded only when questions are drawn from them.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("shard", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    parser.addPositionalArgument("manifest", "The manifest to be written. The shards are written next to it.");
+    QCommandLineOption sizeOption({"n", "size"}, "Maximum number of questions in one shard.", "size", "5000");
+    parser.addOptions({sizeOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 3)
+        parser.showHelp(1);
+
+    bool ok = false;
+    std::size_t size = parser.value(sizeOption).toULongLong(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid shard size: " + parser.value(sizeOption).toStdString());
+
+    std::unique_ptr<Repository> repository(Repository::createRepository(positional[1].toStdString()));
+    repository->setAutoSave(false);
+    if (!repository->isEditable())
+        throw std::invalid_argument("Only plain repositories can be split into shards");
+    ShardedRepository::split(repository->getQuestions(), repository->getType(), positional[2].toStdString(), size);
+    std::size_t count = repository->getQuestionCount();
+    std::cout << "Split " << count << " questions into " << (count + size - 1) / size << " shards listed in "
+              << positional[2].toStdString() << "\n";
+    return 0;
+}
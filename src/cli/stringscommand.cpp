@@ -0,0 +1,28 @@
+#include "commands.hpp"
+
+int fq::cli::strings(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Reports the memory saved by sharing repeated answer texts and explanations.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("strings", "The command name.");
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2)
+        parser.showHelp(1);
+
+    std::unique_ptr<Repository> repository = openRepository(positional[1]);
+    InternedString::Statistics statistics = InternedString::statistics();
+    std::size_t saved = statistics.plainBytes > statistics.internedBytes ? statistics.plainBytes - statistics.internedBytes : 0;
+    std::cout << "Questions:            " << repository->getQuestionCount() << "\n"
+              << "Interned strings:     " << statistics.references << " (" << statistics.uniqueStrings << " distinct)\n"
+              << "Without interning:    " << statistics.plainBytes << " bytes\n"
+              << "With interning:       " << statistics.internedBytes << " bytes\n"
+              << "Saved:                " << saved << " bytes";
+    if (statistics.plainBytes)
+        std::cout << " (" << 100 * saved / statistics.plainBytes << "%)";
+    std::cout << "\n";
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "commands.hpp"
+#include "validator.hpp"
+#include <chrono>
+
+int fq::cli::validate(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Checks repository files and reports every problem with its line and JSON location.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("validate", "The command name.");
+    parser.addPositionalArgument("files", "The repository JSON files.", "files...");
+    QCommandLineOption threadsOption({"j", "threads"}, "Number of threads (default: number of cores).", "count", "0");
+    QCommandLineOption quietOption({"q", "quiet"}, "Report errors only, not warnings.");
+    parser.addOptions({threadsOption, quietOption});
+    parser.process(arguments);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() < 2)
+        parser.showHelp(1);
+    bool ok = false;
+    unsigned threads = parser.value(threadsOption).toUInt(&ok);
+    if (!ok)
+        throw std::invalid_argument("Invalid number of threads: " + parser.value(threadsOption).toStdString());
+
+    std::size_t errors = 0;
+    for (const QString &file : positional.mid(1))
+    {
+        auto start = std::chrono::steady_clock::now();
+        Validator::Report report = Validator::validateFile(file.toStdString(), threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (const auto &problem : report.problems)
+        {
+            if (problem.severity == Validator::Severity::Warning && parser.isSet(quietOption))
+                continue;
+            std::cerr << file.toStdString() << ":" << problem.line << ": " << Validator::describe(problem) << "\n";
+        }
+        std::size_t fileErrors = report.count(Validator::Severity::Error);
+        std::cout << file.toStdString() << ": " << report.questions << " questions, " << fileErrors << " errors, "
+                  << report.count(Validator::Severity::Warning) << " warnings (" << seconds << " s)\n";
+        errors += fileErrors;
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,665 @@
+#include "expression.hpp"
+#include <cmath>
+#include <cctype>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace
+{
+    using Op = fq::Expression::Op;
+
+    /// @brief A function callable in expressions.
+    struct Function
+    {
+        const char *name;
+        Op op;
+        std::uint32_t minArguments;
+        std::uint32_t maxArguments;
+    };
+
+    /// @brief The functions callable in expressions. round with two arguments is compiled to RoundDigits.
+    constexpr Function functions[] = {
+        {"abs", Op::Abs, 1, 1},
+        {"sqrt", Op::Sqrt, 1, 1},
+        {"exp", Op::Exp, 1, 1},
+        {"log", Op::Log, 1, 1},
+        {"sin", Op::Sin, 1, 1},
+        {"cos", Op::Cos, 1, 1},
+        {"tan", Op::Tan, 1, 1},
+        {"floor", Op::Floor, 1, 1},
+        {"ceil", Op::Ceil, 1, 1},
+        {"round", Op::Round, 1, 2},
+        {"min", Op::Min, 1, fq::Expression::maxDepth},
+        {"max", Op::Max, 1, fq::Expression::maxDepth},
+        {"randint", Op::RandInt, 2, 2},
+        {"uniform", Op::Uniform, 2, 2},
+        {"choice", Op::Choice, 1, fq::Expression::maxDepth},
+    };
+
+    /// @brief Returns the function with the specified name, or nullptr.
+    const Function *findFunction(const std::string &name)
+    {
+        for (const auto &function : functions)
+        {
+            if (name == function.name)
+                return &function;
+        }
+        return nullptr;
+    }
+
+    /// @brief Returns the value of a named constant, or NaN if the name is not a constant.
+    double namedConstant(const std::string &name)
+    {
+        if (name == "pi")
+            return 3.14159265358979323846;
+        if (name == "e")
+            return 2.71828182845904523536;
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /// @brief Returns the number of values an instruction pops from the stack.
+    std::uint32_t arity(const fq::Expression::Instruction &instruction)
+    {
+        switch (instruction.op)
+        {
+        case Op::Constant:
+        case Op::Variable:
+            return 0;
+        case Op::Add:
+        case Op::Subtract:
+        case Op::Multiply:
+        case Op::Divide:
+        case Op::Modulo:
+        case Op::Power:
+        case Op::RoundDigits:
+        case Op::RandInt:
+        case Op::Uniform:
+            return 2;
+        case Op::Min:
+        case Op::Max:
+        case Op::Choice:
+            return instruction.operand;
+        default:
+            return 1;
+        }
+    }
+
+    bool isNameStart(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+
+    bool isNameChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+}
+
+/// @brief Recursive descent parser emitting the instructions of an expression in postfix order.
+class fq::Expression::Parser
+{
+    const std::string &source;
+    const std::vector<std::string> &variables;
+    Expression &result;
+    std::size_t position = 0;
+
+    /// @brief Depth of the evaluation stack after the instructions emitted so far.
+    std::size_t depth = 0;
+
+    /// @brief Number of parseUnary calls in progress. Every recursion of the parser (parentheses, function
+    /// arguments, signs and exponents) goes through parseUnary, so bounding it bounds the C++ stack as well.
+    std::size_t nesting = 0;
+
+    [[noreturn]] void fail(const std::string &message) const
+    {
+        throw std::invalid_argument(message + " in expression '" + source + "'");
+    }
+
+    void skipSpace()
+    {
+        while (position < source.size() && std::isspace(static_cast<unsigned char>(source[position])))
+            ++position;
+    }
+
+    bool accept(char c)
+    {
+        skipSpace();
+        if (position < source.size() && source[position] == c)
+        {
+            ++position;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!accept(c))
+            fail(position < source.size() ? std::string("Expected '") + c + "' but found '" + source[position] + "'" : std::string("Expected '") + c + "' at the end");
+    }
+
+    void pushConstant(double value)
+    {
+        result.code.push_back({Op::Constant, static_cast<std::uint32_t>(result.constants.size())});
+        result.constants.push_back(value);
+        if (++depth > maxDepth)
+            fail("Expression is nested too deeply");
+    }
+
+    /// @brief Emits an instruction. Operations whose operands are all constants are evaluated right away.
+    void emit(Op op, std::uint32_t operand = 0)
+    {
+        Instruction instruction{op, operand};
+        const std::uint32_t pops = arity(instruction);
+        if (op == Op::RandInt || op == Op::Uniform || op == Op::Choice)
+            result.random = true;
+        else if (std::all_of(result.code.end() - pops, result.code.end(), [](const Instruction &it)
+                             { return it.op == Op::Constant; }))
+        {
+            // The operands are the last constants, so the folded value simply replaces them.
+            Expression folded;
+            folded.code.clear();
+            folded.constants.assign(result.constants.end() - pops, result.constants.end());
+            for (std::uint32_t i = 0; i < pops; ++i)
+                folded.code.push_back({Op::Constant, i});
+            folded.code.push_back(instruction);
+            // Random functions are never folded, so the generator is never used.
+            thread_local std::mt19937 unused;
+            double value = folded.evaluate(nullptr, unused);
+            result.code.resize(result.code.size() - pops);
+            result.constants.resize(result.constants.size() - pops);
+            depth -= pops;
+            pushConstant(value);
+            return;
+        }
+        result.code.push_back(instruction);
+        depth = depth - pops + 1;
+    }
+
+    std::string parseName()
+    {
+        std::size_t start = position;
+        while (position < source.size() && isNameChar(source[position]))
+            ++position;
+        return source.substr(start, position - start);
+    }
+
+    void parseNumber()
+    {
+        std::size_t start = position;
+        while (position < source.size() && (std::isdigit(static_cast<unsigned char>(source[position])) || source[position] == '.'))
+            ++position;
+        if (position < source.size() && (source[position] == 'e' || source[position] == 'E'))
+        {
+            std::size_t exponent = position + 1;
+            if (exponent < source.size() && (source[exponent] == '+' || source[exponent] == '-'))
+                ++exponent;
+            if (exponent < source.size() && std::isdigit(static_cast<unsigned char>(source[exponent])))
+            {
+                position = exponent;
+                while (position < source.size() && std::isdigit(static_cast<unsigned char>(source[position])))
+                    ++position;
+            }
+        }
+        // Numbers are read in the classic locale, so the decimal separator is always a point.
+        std::istringstream stream(source.substr(start, position - start));
+        stream.imbue(std::locale::classic());
+        double value = 0.0;
+        stream >> value;
+        if (stream.fail() || !stream.eof())
+            fail("Invalid number '" + source.substr(start, position - start) + "'");
+        pushConstant(value);
+    }
+
+    void parseCall(const std::string &name)
+    {
+        const Function *function = findFunction(name);
+        if (!function)
+            fail("Unknown function '" + name + "'");
+        std::uint32_t arguments = 0;
+        if (!accept(')'))
+        {
+            do
+            {
+                parseSum();
+                ++arguments;
+            } while (accept(','));
+            expect(')');
+        }
+        if (arguments < function->minArguments || arguments > function->maxArguments)
+            fail("Wrong number of arguments for '" + name + "'");
+        if (function->op == Op::Round && arguments == 2)
+            emit(Op::RoundDigits);
+        else
+            emit(function->op, arguments);
+    }
+
+    void parsePrimary()
+    {
+        skipSpace();
+        if (position >= source.size())
+            fail("Unexpected end");
+        char c = source[position];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+            return parseNumber();
+        if (accept('('))
+        {
+            parseSum();
+            expect(')');
+            return;
+        }
+        if (!isNameStart(c))
+            fail(std::string("Unexpected '") + c + "'");
+        std::string name = parseName();
+        if (accept('('))
+            return parseCall(name);
+        auto variable = std::find(variables.begin(), variables.end(), name);
+        if (variable != variables.end())
+        {
+            result.code.push_back({Op::Variable, static_cast<std::uint32_t>(variable - variables.begin())});
+            if (++depth > maxDepth)
+                fail("Expression is nested too deeply");
+            return;
+        }
+        double constant = namedConstant(name);
+        if (std::isnan(constant))
+            fail("Unknown variable '" + name + "'");
+        pushConstant(constant);
+    }
+
+    void parseUnary()
+    {
+        if (++nesting > maxDepth)
+            fail("Expression is nested too deeply");
+        if (accept('-'))
+        {
+            parseUnary();
+            emit(Op::Negate);
+        }
+        else if (accept('+'))
+            parseUnary();
+        else
+            parsePower();
+        --nesting;
+    }
+
+    void parsePower()
+    {
+        parsePrimary();
+        // The exponent may itself be negated or raised to a power, so 2^-1 and 2^3^2 = 2^9 work as expected.
+        if (accept('^'))
+        {
+            parseUnary();
+            emit(Op::Power);
+        }
+    }
+
+    void parseProduct()
+    {
+        parseUnary();
+        for (;;)
+        {
+            if (accept('*'))
+            {
+                parseUnary();
+                emit(Op::Multiply);
+            }
+            else if (accept('/'))
+            {
+                parseUnary();
+                emit(Op::Divide);
+            }
+            else if (accept('%'))
+            {
+                parseUnary();
+                emit(Op::Modulo);
+            }
+            else
+                return;
+        }
+    }
+
+    void parseSum()
+    {
+        parseProduct();
+        for (;;)
+        {
+            if (accept('+'))
+            {
+                parseProduct();
+                emit(Op::Add);
+            }
+            else if (accept('-'))
+            {
+                parseProduct();
+                emit(Op::Subtract);
+            }
+            else
+                return;
+        }
+    }
+
+public:
+    Parser(const std::string &source, const std::vector<std::string> &variables, Expression &result)
+        : source(source), variables(variables), result(result) {}
+
+    void parse()
+    {
+        parseSum();
+        skipSpace();
+        if (position < source.size())
+            fail(std::string("Unexpected '") + source[position] + "'");
+    }
+};
+
+fq::Expression::Expression() : code{{Op::Constant, 0}}, constants{0.0}
+{
+}
+
+fq::Expression::Expression(const std::string &source, const std::vector<std::string> &variables)
+{
+    Parser(source, variables, *this).parse();
+}
+
+fq::Expression fq::Expression::fromCode(std::vector<Instruction> code, std::vector<double> constants, std::size_t variableCount)
+{
+    Expression result;
+    std::size_t depth = 0;
+    for (const Instruction &instruction : code)
+    {
+        if (instruction.op > Op::Choice)
+            throw std::invalid_argument("Invalid instruction in compiled expression");
+        if ((instruction.op == Op::Constant && instruction.operand >= constants.size()) ||
+            (instruction.op == Op::Variable && instruction.operand >= variableCount) ||
+            ((instruction.op == Op::Min || instruction.op == Op::Max || instruction.op == Op::Choice) &&
+             (instruction.operand == 0 || instruction.operand > maxDepth)))
+            throw std::invalid_argument("Invalid operand in compiled expression");
+        std::uint32_t pops = arity(instruction);
+        if (depth < pops)
+            throw std::invalid_argument("Stack underflow in compiled expression");
+        depth = depth - pops + 1;
+        if (depth > maxDepth)
+            throw std::invalid_argument("Compiled expression is nested too deeply");
+        if (instruction.op == Op::RandInt || instruction.op == Op::Uniform || instruction.op == Op::Choice)
+            result.random = true;
+    }
+    if (depth != 1)
+        throw std::invalid_argument("Compiled expression does not leave exactly one value");
+    result.code = std::move(code);
+    result.constants = std::move(constants);
+    return result;
+}
+
+std::optional<double> fq::Expression::constantValue() const
+{
+    if (code.size() == 1 && code[0].op == Op::Constant)
+        return constants[code[0].operand];
+    return std::nullopt;
+}
+
+double fq::Expression::evaluate(const double *variables, std::mt19937 &generator) const
+{
+    double stack[maxDepth];
+    std::size_t top = 0;
+    for (const Instruction &instruction : code)
+    {
+        switch (instruction.op)
+        {
+        case Op::Constant:
+            stack[top++] = constants[instruction.operand];
+            break;
+        case Op::Variable:
+            stack[top++] = variables[instruction.operand];
+            break;
+        case Op::Negate:
+            stack[top - 1] = -stack[top - 1];
+            break;
+        case Op::Add:
+            --top;
+            stack[top - 1] += stack[top];
+            break;
+        case Op::Subtract:
+            --top;
+            stack[top - 1] -= stack[top];
+            break;
+        case Op::Multiply:
+            --top;
+            stack[top - 1] *= stack[top];
+            break;
+        case Op::Divide:
+            --top;
+            stack[top - 1] /= stack[top];
+            break;
+        case Op::Modulo:
+            --top;
+            stack[top - 1] = std::fmod(stack[top - 1], stack[top]);
+            break;
+        case Op::Power:
+            --top;
+            stack[top - 1] = std::pow(stack[top - 1], stack[top]);
+            break;
+        case Op::Abs:
+            stack[top - 1] = std::abs(stack[top - 1]);
+            break;
+        case Op::Sqrt:
+            stack[top - 1] = std::sqrt(stack[top - 1]);
+            break;
+        case Op::Exp:
+            stack[top - 1] = std::exp(stack[top - 1]);
+            break;
+        case Op::Log:
+            stack[top - 1] = std::log(stack[top - 1]);
+            break;
+        case Op::Sin:
+            stack[top - 1] = std::sin(stack[top - 1]);
+            break;
+        case Op::Cos:
+            stack[top - 1] = std::cos(stack[top - 1]);
+            break;
+        case Op::Tan:
+            stack[top - 1] = std::tan(stack[top - 1]);
+            break;
+        case Op::Floor:
+            stack[top - 1] = std::floor(stack[top - 1]);
+            break;
+        case Op::Ceil:
+            stack[top - 1] = std::ceil(stack[top - 1]);
+            break;
+        case Op::Round:
+            stack[top - 1] = std::round(stack[top - 1]);
+            break;
+        case Op::RoundDigits:
+        {
+            --top;
+            double scale = std::pow(10.0, std::round(stack[top]));
+            stack[top - 1] = std::round(stack[top - 1] * scale) / scale;
+            break;
+        }
+        case Op::Min:
+        case Op::Max:
+        {
+            top -= instruction.operand - 1;
+            double &value = stack[top - 1];
+            for (std::uint32_t i = 1; i < instruction.operand; ++i)
+                value = instruction.op == Op::Min ? std::min(value, stack[top - 1 + i]) : std::max(value, stack[top - 1 + i]);
+            break;
+        }
+        case Op::RandInt:
+        {
+            --top;
+            // Only integers which doubles represent exactly can be drawn.
+            constexpr double limit = 9007199254740992.0;
+            double low = std::ceil(std::min(stack[top - 1], stack[top]));
+            double high = std::floor(std::max(stack[top - 1], stack[top]));
+            if (!(low <= high) || low < -limit || high > limit)
+                stack[top - 1] = std::numeric_limits<double>::quiet_NaN();
+            else
+            {
+                std::uniform_int_distribution<long long> dis(static_cast<long long>(low), static_cast<long long>(high));
+                stack[top - 1] = static_cast<double>(dis(generator));
+            }
+            break;
+        }
+        case Op::Uniform:
+        {
+            --top;
+            double low = std::min(stack[top - 1], stack[top]);
+            double high = std::max(stack[top - 1], stack[top]);
+            if (!std::isfinite(low) || !std::isfinite(high))
+                stack[top - 1] = std::numeric_limits<double>::quiet_NaN();
+            else if (low < high)
+            {
+                std::uniform_real_distribution<double> dis(low, high);
+                stack[top - 1] = dis(generator);
+            }
+            break;
+        }
+        case Op::Choice:
+        {
+            std::uniform_int_distribution<std::uint32_t> dis(0, instruction.operand - 1);
+            top -= instruction.operand;
+            stack[top] = stack[top + dis(generator)];
+            ++top;
+            break;
+        }
+        }
+    }
+    return stack[0];
+}
+
+bool fq::Expression::isValidName(const std::string &name)
+{
+    if (name.empty() || !isNameStart(name[0]) || !std::all_of(name.begin(), name.end(), isNameChar))
+        return false;
+    return !findFunction(name) && std::isnan(namedConstant(name));
+}
+
+fq::TextTemplate::TextTemplate(const std::string &source, const std::vector<std::string> &variables)
+{
+    parts.emplace_back();
+    for (std::size_t i = 0; i < source.size(); ++i)
+    {
+        const char c = source[i];
+        if ((c == '{' || c == '}') && i + 1 < source.size() && source[i + 1] == c)
+        {
+            parts.back().text += c;
+            ++i;
+            continue;
+        }
+        if (c == '}')
+            throw std::invalid_argument("Unmatched '}' (write '}}' for a brace) in '" + source + "'");
+        if (c != '{')
+        {
+            parts.back().text += c;
+            continue;
+        }
+        std::size_t end = source.find_first_of("{}", i + 1);
+        if (end == std::string::npos || source[end] != '}')
+            throw std::invalid_argument("Unmatched '{' (write '{{' for a brace) in '" + source + "'");
+        std::string inside = source.substr(i + 1, end - i - 1);
+        int decimals = -1;
+        std::size_t colon = inside.rfind(':');
+        if (colon != std::string::npos)
+        {
+            std::string digits = inside.substr(colon + 1);
+            digits.erase(std::remove_if(digits.begin(), digits.end(), [](unsigned char d)
+                                        { return std::isspace(d); }),
+                         digits.end());
+            if (digits.empty() || digits.size() > 2 || !std::all_of(digits.begin(), digits.end(), [](unsigned char d)
+                                                                     { return std::isdigit(d); }))
+                throw std::invalid_argument("Invalid number of decimals '" + inside.substr(colon + 1) + "' in '" + source + "'");
+            decimals = std::stoi(digits);
+            inside.resize(colon);
+        }
+        Expression expression(inside, variables);
+        if (auto value = expression.constantValue())
+            appendNumber(parts.back().text, *value, decimals);
+        else
+        {
+            parts.back().expression = static_cast<int>(expressions.size());
+            parts.back().decimals = decimals;
+            expressions.push_back(std::move(expression));
+            parts.emplace_back();
+        }
+        i = end;
+    }
+}
+
+fq::TextTemplate fq::TextTemplate::fromParts(std::vector<Part> parts, std::vector<Expression> expressions)
+{
+    if (parts.size() != expressions.size() + 1)
+        throw std::invalid_argument("Compiled text has " + std::to_string(parts.size()) + " parts for " + std::to_string(expressions.size()) + " expressions");
+    for (std::size_t i = 0; i < parts.size(); ++i)
+    {
+        int expected = i + 1 < parts.size() ? static_cast<int>(i) : -1;
+        if (parts[i].expression != expected || parts[i].decimals < -1 || parts[i].decimals > 99)
+            throw std::invalid_argument("Invalid part in compiled text");
+    }
+    TextTemplate result;
+    result.parts = std::move(parts);
+    result.expressions = std::move(expressions);
+    return result;
+}
+
+std::size_t fq::TextTemplate::memoryUsage() const
+{
+    std::size_t bytes = parts.capacity() * sizeof(Part) + expressions.capacity() * sizeof(Expression);
+    for (const Part &part : parts)
+    {
+        // Short texts are stored inside the std::string object itself.
+        if (part.text.capacity() > 15)
+            bytes += part.text.capacity() + 1;
+    }
+    for (const Expression &expression : expressions)
+        bytes += expression.memoryUsage();
+    return bytes;
+}
+
+bool fq::TextTemplate::render(std::string &text, const double *variables, std::mt19937 &generator) const
+{
+    bool finite = true;
+    for (const auto &part : parts)
+    {
+        text += part.text;
+        if (part.expression >= 0)
+        {
+            double value = expressions[part.expression].evaluate(variables, generator);
+            finite = finite && std::isfinite(value);
+            appendNumber(text, value, part.decimals);
+        }
+    }
+    return finite;
+}
+
+void fq::TextTemplate::appendNumber(std::string &text, double value, int decimals)
+{
+    if (value == 0.0)
+        value = 0.0; // Never write "-0".
+    if (decimals < 0 && std::abs(value) < 1e15 && value == std::floor(value))
+    {
+        // Integers are by far the most common values, so they are written without going through a stream.
+        char digits[24];
+        char *end = digits + sizeof(digits);
+        char *begin = end;
+        std::uint64_t magnitude = static_cast<std::uint64_t>(std::abs(value));
+        do
+        {
+            *--begin = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0.0)
+            *--begin = '-';
+        text.append(begin, end);
+        return;
+    }
+    // The stream uses the classic locale, so the decimal separator does not depend on the system settings.
+    thread_local std::ostringstream stream = []()
+    {
+        std::ostringstream classic;
+        classic.imbue(std::locale::classic());
+        return classic;
+    }();
+    stream.str(std::string());
+    if (decimals < 0)
+        stream << std::defaultfloat << std::setprecision(10) << value;
+    else
+        stream << std::fixed << std::setprecision(decimals) << value;
+    text += stream.str();
+}
@@ -0,0 +1,206 @@
+/// @file expression.hpp
+/// @brief Contains the definitions of compiled arithmetic expressions and of texts with embedded expressions.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief An arithmetic expression compiled to bytecode for a small stack machine.
+    /// @details Expressions are compiled once, when a template question is loaded, and evaluated every time a variant
+    /// is generated. Evaluation never allocates: variables are referenced by index, constants are folded at compile
+    /// time and the stack is a fixed array whose required depth is checked when compiling.
+    ///
+    /// The syntax is that of ordinary arithmetic: numbers, variables, parentheses, the operators + - * / % and ^
+    /// (power, right-associative), and the constants pi and e. The functions are abs, sqrt, exp, log, sin, cos, tan,
+    /// floor, ceil, round(x) and round(x, digits), min and max of any number of arguments, and the random functions
+    /// randint(low, high) (an integer in [low, high]), uniform(low, high) (a real number in [low, high)) and
+    /// choice(a, b, ...) (one of its arguments).
+    class Expression
+    {
+    public:
+        /// @brief Instructions of the stack machine.
+        enum class Op : std::uint8_t
+        {
+            Constant,
+            Variable,
+            Negate,
+            Add,
+            Subtract,
+            Multiply,
+            Divide,
+            Modulo,
+            Power,
+            Abs,
+            Sqrt,
+            Exp,
+            Log,
+            Sin,
+            Cos,
+            Tan,
+            Floor,
+            Ceil,
+            Round,
+            RoundDigits,
+            Min,
+            Max,
+            RandInt,
+            Uniform,
+            Choice,
+        };
+
+        /// @brief One instruction: the operation and its operand (the index of a constant or variable, or the number
+        /// of arguments of a variadic function).
+        struct Instruction
+        {
+            Op op;
+            std::uint32_t operand;
+        };
+
+        /// @brief Maximum depth of the evaluation stack, which limits the nesting of expressions.
+        static constexpr std::size_t maxDepth = 32;
+
+    private:
+        /// @brief The instructions, in postfix order.
+        std::vector<Instruction> code;
+
+        /// @brief The constants referenced by the instructions.
+        std::vector<double> constants;
+
+        /// @brief Whether the expression calls a random function.
+        bool random = false;
+
+        class Parser;
+
+    public:
+        /// @brief Constructs an expression which always evaluates to 0.
+        Expression();
+
+        /// @brief Compiles an expression.
+        /// @param source The text of the expression.
+        /// @param variables The names of the variables the expression may use. A variable is passed to evaluate at
+        /// the index of its name.
+        /// @throws std::invalid_argument if the expression is malformed or uses an unknown name.
+        Expression(const std::string &source, const std::vector<std::string> &variables);
+
+        /// @brief Evaluates the expression.
+        /// @param variables The values of the variables, in the order of the names the expression was compiled with.
+        /// @param generator The random number generator used by the random functions.
+        /// @return The value. Invalid operations (e.g. a division by zero) give an infinite or NaN value.
+        double evaluate(const double *variables, std::mt19937 &generator) const;
+
+        /// @brief Returns whether the expression calls a random function.
+        bool isRandom() const { return random; }
+
+        /// @brief Returns the value of the expression if it is a constant, i.e. uses neither variables nor random
+        /// functions.
+        std::optional<double> constantValue() const;
+
+        /// @brief Estimates the heap bytes used by the compiled instructions and constants.
+        std::size_t memoryUsage() const { return code.capacity() * sizeof(Instruction) + constants.capacity() * sizeof(double); }
+
+        /// @brief Returns the compiled instructions, in postfix order.
+        const std::vector<Instruction> &getCode() const { return code; }
+
+        /// @brief Returns the constants referenced by the instructions.
+        const std::vector<double> &getConstants() const { return constants; }
+
+        /// @brief Rebuilds a compiled expression from its instructions and constants, e.g. as stored in a snapshot.
+        /// @details The instructions are verified instead of trusted: every operand must be in range and the stack
+        /// must never underflow, exceed maxDepth or end with other than one value, so evaluate is safe whatever the
+        /// input.
+        /// @param code The instructions, in postfix order.
+        /// @param constants The constants referenced by the instructions.
+        /// @param variableCount The number of variables the expression may use.
+        /// @return The expression.
+        /// @throws std::invalid_argument if the instructions are invalid.
+        static Expression fromCode(std::vector<Instruction> code, std::vector<double> constants, std::size_t variableCount);
+
+        /// @brief Returns whether a name is a valid variable name: a letter or underscore followed by letters,
+        /// digits and underscores, and not the name of a function or constant.
+        static bool isValidName(const std::string &name);
+    };
+
+    /// @brief A text with embedded expressions, e.g. "What is {a}×{b}?".
+    /// @details Every expression is written in braces and replaced by its value when the text is rendered. Integer
+    /// values are written without decimals and other values with up to 10 significant digits; "{x:2}" writes x with
+    /// exactly 2 decimals. "{{" and "}}" stand for literal braces.
+    class TextTemplate
+    {
+    public:
+        /// @brief A literal piece of text followed by an expression, if any.
+        struct Part
+        {
+            /// @brief The literal text.
+            std::string text;
+
+            /// @brief Index of the expression following the text, or -1 for the last part.
+            int expression = -1;
+
+            /// @brief Number of decimals the value of the expression is written with, or -1 for the default format.
+            int decimals = -1;
+        };
+
+    private:
+        /// @brief The parts of the text, in order.
+        std::vector<Part> parts;
+
+        /// @brief The compiled expressions.
+        std::vector<Expression> expressions;
+
+    public:
+        /// @brief Constructs an empty text.
+        TextTemplate() = default;
+
+        /// @brief Compiles a text.
+        /// @param source The text with embedded expressions.
+        /// @param variables The names of the variables the expressions may use.
+        /// @throws std::invalid_argument if a brace is unmatched or an expression is malformed.
+        TextTemplate(const std::string &source, const std::vector<std::string> &variables);
+
+        /// @brief Appends the text with the values of its expressions.
+        /// @param text The rendered text is appended to it.
+        /// @param variables The values of the variables.
+        /// @param generator The random number generator used by the random functions.
+        /// @return false if the value of an expression was infinite or NaN; true otherwise.
+        bool render(std::string &text, const double *variables, std::mt19937 &generator) const;
+
+        /// @brief Returns whether the text contains no expressions.
+        bool isConstant() const { return expressions.empty(); }
+
+        /// @brief Estimates the heap bytes used by the literal parts and the compiled expressions.
+        std::size_t memoryUsage() const;
+
+        /// @brief Returns the parts of the text, in order.
+        const std::vector<Part> &getParts() const { return parts; }
+
+        /// @brief Returns the compiled expressions, in the order of the parts referencing them.
+        const std::vector<Expression> &getExpressions() const { return expressions; }
+
+        /// @brief Rebuilds a compiled text from its parts and expressions, e.g. as stored in a snapshot.
+        /// @param parts The parts. The i-th of them must be followed by the i-th expression, and only the last by none.
+        /// @param expressions The compiled expressions.
+        /// @return The text.
+        /// @throws std::invalid_argument if the parts do not match the expressions or a number of decimals is invalid.
+        static TextTemplate fromParts(std::vector<Part> parts, std::vector<Expression> expressions);
+
+        /// @brief Appends a number as rendered in texts.
+        /// @param text The number is appended to it.
+        /// @param value The number.
+        /// @param decimals Number of decimals, or -1 for the default format.
+        static void appendNumber(std::string &text, double value, int decimals = -1);
+    };
+}
@@ -0,0 +1,132 @@
+#include "internedstring.hpp"
+
+namespace
+{
+    /// @brief Number of shards of the pool. A power of two, so the shard of a hash is found with a mask.
+    constexpr std::size_t shardCount = 64;
+
+    /// @brief A shard of the pool of interned texts, keyed by their contents.
+    /// @details The keys view the interned strings themselves, so every text is stored only once. Shards are aligned
+    /// to cache lines, so threads locking neighbouring shards do not contend for the same line.
+    struct alignas(64) StringShard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, std::weak_ptr<const std::string>> entries;
+    };
+
+    /// @brief The pool of interned texts.
+    struct StringPool
+    {
+        StringShard shards[shardCount];
+
+        /// @brief Returns the shard holding a text.
+        StringShard &shardOf(std::string_view text) { return shards[std::hash<std::string_view>()(text) & (shardCount - 1)]; }
+    };
+
+    /// @brief Returns the process-wide pool.
+    /// @details The pool is never destroyed, so strings released during static destruction can still remove themselves.
+    StringPool &pool()
+    {
+        static StringPool *instance = new StringPool;
+        return *instance;
+    }
+
+    /// @brief Returns the shared empty string, which is not in the pool and never released.
+    const std::shared_ptr<const std::string> &emptyString()
+    {
+        static const std::shared_ptr<const std::string> *instance = new std::shared_ptr<const std::string>(std::make_shared<const std::string>());
+        return *instance;
+    }
+
+    /// @brief Estimates the heap memory used by the characters of a string.
+    std::size_t heapBytes(std::string_view text)
+    {
+        // Short strings (up to 15 characters in common implementations) are stored inside the std::string object itself.
+        return text.size() <= 15 ? 0 : text.size() + 1;
+    }
+
+    /// @brief Estimates the bytes used by an interned text, its control block and its pool entry.
+    std::size_t storedBytes(std::string_view text)
+    {
+        // The control block holds a vtable pointer and two counters; the pool entry holds the key, a weak pointer,
+        // a node link and the cached hash.
+        std::size_t overhead = 3 * sizeof(void *) + sizeof(std::string_view) + sizeof(std::weak_ptr<const std::string>) + 2 * sizeof(void *);
+        return sizeof(std::string) + heapBytes(text) + overhead;
+    }
+
+    /// @brief Removes a text from the pool when its last InternedString is destroyed.
+    struct Release
+    {
+        void operator()(const std::string *text) const
+        {
+            StringShard &strings = pool().shardOf(*text);
+            {
+                std::lock_guard<std::mutex> lock(strings.mutex);
+                auto it = strings.entries.find(*text);
+                // The text may have been interned again in the meantime; the new entry must be kept then.
+                if (it != strings.entries.end() && it->second.expired())
+                    strings.entries.erase(it);
+            }
+            delete text;
+        }
+    };
+}
+
+fq::InternedString::InternedString() : value(emptyString())
+{
+}
+
+fq::InternedString::InternedString(const std::string &text)
+{
+    if (text.empty())
+    {
+        value = emptyString();
+        return;
+    }
+    StringShard &strings = pool().shardOf(text);
+    std::lock_guard<std::mutex> lock(strings.mutex);
+    auto it = strings.entries.find(text);
+    if (it != strings.entries.end())
+    {
+        if ((value = it->second.lock()))
+            return;
+        // The last reference is being released; its entry is replaced, since the key views the dying string.
+        strings.entries.erase(it);
+    }
+    value = std::shared_ptr<const std::string>(new std::string(text), Release());
+    strings.entries.emplace(std::string_view(*value), value);
+}
+
+fq::InternedString fq::InternedString::unpooled(const std::string &text)
+{
+    InternedString string;
+    string.value = std::make_shared<const std::string>(text);
+    return string;
+}
+
+std::size_t fq::InternedString::storageBytes() const
+{
+    return storedBytes(*value);
+}
+
+fq::InternedString::Statistics fq::InternedString::statistics()
+{
+    Statistics statistics;
+    for (StringShard &strings : pool().shards)
+    {
+        std::lock_guard<std::mutex> lock(strings.mutex);
+        for (const auto &entry : strings.entries)
+        {
+            // use_count does not create a temporary owner, so no string can be released while the shard is locked.
+            std::size_t references = static_cast<std::size_t>(entry.second.use_count());
+            if (!references)
+                continue;
+            std::size_t bytes = sizeof(std::string) + heapBytes(entry.first);
+            ++statistics.uniqueStrings;
+            statistics.references += references;
+            statistics.internedBytes += storedBytes(entry.first) + references * sizeof(std::shared_ptr<const std::string>);
+            statistics.plainBytes += references * bytes;
+        }
+    }
+    return statistics;
+}
@@ -0,0 +1,107 @@
+/// @file internedstring.hpp
+/// @brief Contains the definition of strings shared by all identical texts.
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Immutable string whose storage is shared by all equal strings.
+    /// @details Strings are interned in a process-wide pool, so repeated texts (e.g. "True", "None of the above" or
+    /// boilerplate explanations) are stored once no matter how many answers or questions use them. A text is removed
+    /// from the pool when its last InternedString is destroyed. Two interned strings are equal exactly when they have
+    /// the same id, so comparisons are O(1).
+    ///
+    /// Interning is thread-safe. The pool is split into shards chosen by the hash of the text, each with its own lock,
+    /// so threads interning different texts (e.g. the parallel importer or variant generation) rarely wait for each
+    /// other. Only interning a new text and releasing its last reference lock a shard; reading, copying and assigning
+    /// interned strings, and default-constructing (the empty string is shared and never released), never lock.
+    class InternedString
+    {
+        /// @brief The shared text.
+        std::shared_ptr<const std::string> value;
+
+    public:
+        /// @brief Memory usage of the pool, compared with storing every string separately.
+        struct Statistics
+        {
+            /// @brief The number of distinct interned texts.
+            std::size_t uniqueStrings = 0;
+
+            /// @brief The number of InternedString objects referring to them.
+            std::size_t references = 0;
+
+            /// @brief Estimated bytes used by the references and the distinct texts.
+            std::size_t internedBytes = 0;
+
+            /// @brief Estimated bytes the same strings would use if each of them was a separate std::string.
+            std::size_t plainBytes = 0;
+        };
+
+        /// @brief Constructs an empty string.
+        InternedString();
+
+        /// @brief Interns a text.
+        /// @param text The text.
+        InternedString(const std::string &text);
+
+        /// @brief Interns a text.
+        /// @param text The null-terminated text.
+        InternedString(const char *text) : InternedString(std::string(text)) {}
+
+        /// @brief Creates a string which is not added to the pool, e.g. for a text used by a single short-lived object.
+        /// @details Its id differs from the ids of all other strings, even of equal ones, so its text must be compared
+        /// with str(). It never locks the pool.
+        /// @param text The text.
+        static InternedString unpooled(const std::string &text);
+
+        /// @brief Replaces the string with an interned text.
+        /// @details Assigning the current text keeps the string without interning it again.
+        /// @param text The text.
+        InternedString &operator=(const std::string &text)
+        {
+            if (*value != text)
+                *this = InternedString(text);
+            return *this;
+        }
+
+        /// @brief Returns the text.
+        const std::string &str() const { return *value; }
+
+        /// @brief Converts the string to the text, so it can be used wherever a std::string is expected.
+        operator const std::string &() const { return *value; }
+
+        /// @brief Returns whether the text is empty.
+        bool empty() const { return value->empty(); }
+
+        /// @brief Returns the id of the text, equal for all equal strings while any of them exists.
+        std::uintptr_t id() const { return reinterpret_cast<std::uintptr_t>(value.get()); }
+
+        /// @brief Compares two strings by their ids.
+        bool operator==(const InternedString &other) const { return value == other.value; }
+
+        /// @brief Compares two strings by their ids.
+        bool operator!=(const InternedString &other) const { return value != other.value; }
+
+        /// @brief Estimates the bytes used by the shared text, including its control block and its pool entry.
+        /// @details These bytes are used once for all equal strings; every InternedString adds only its own size.
+        std::size_t storageBytes() const;
+
+        /// @brief Returns the memory usage of the pool.
+        /// @return The statistics of all currently interned strings.
+        static Statistics statistics();
+    };
+}
@@ -0,0 +1,146 @@
+#include "jsonwriter.hpp"
+#include "question.hpp"
+#include <cmath>
+#include <exception>
+
+namespace
+{
+    /// @brief Smallest number of questions worth handing to another thread.
+    constexpr std::size_t minChunkSize = 4096;
+}
+
+void fq::JsonWriter::appendString(std::string &json, std::string_view text)
+{
+    static const char hex[] = "0123456789abcdef";
+    json += '"';
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        json.append(text.substr(start, i - start));
+        json += '\\';
+        switch (c)
+        {
+        case '"':
+            json += '"';
+            break;
+        case '\\':
+            json += '\\';
+            break;
+        case '\b':
+            json += 'b';
+            break;
+        case '\f':
+            json += 'f';
+            break;
+        case '\n':
+            json += 'n';
+            break;
+        case '\r':
+            json += 'r';
+            break;
+        case '\t':
+            json += 't';
+            break;
+        default:
+            json += "u00";
+            json += hex[c >> 4];
+            json += hex[c & 0xf];
+            break;
+        }
+        start = i + 1;
+    }
+    json.append(text.substr(start));
+    json += '"';
+}
+
+void fq::JsonWriter::appendNumber(std::string &json, double value)
+{
+    if (!std::isfinite(value))
+    {
+        json += "null";
+        return;
+    }
+    QByteArray number = QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+    json.append(number.constData(), static_cast<std::size_t>(number.size()));
+}
+
+void fq::JsonWriter::appendKey(std::string &json, std::string_view key, int indent)
+{
+    appendIndent(json, indent);
+    appendString(json, key);
+    json += indent < 0 ? ":" : ": ";
+}
+
+QByteArray fq::JsonWriter::writeRepository(const std::vector<fq::Question *> &questions, const std::string &type, unsigned threads)
+{
+    // Every thread writes a contiguous range of questions into its own string; the strings are joined in order.
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, questions.size() / minChunkSize));
+    std::vector<std::string> parts(chunks);
+    // Reserving each part from the size of the first question avoids copying the parts as they grow.
+    std::size_t estimate = 0;
+    if (!questions.empty())
+    {
+        std::string first;
+        questions.front()->appendJSON(first, 2);
+        estimate = first.size() + first.size() / 4 + 16;
+    }
+    std::vector<std::exception_ptr> errors(chunks);
+    auto writeChunk = [&](std::size_t chunk)
+    {
+        try
+        {
+            std::size_t begin = questions.size() * chunk / chunks, end = questions.size() * (chunk + 1) / chunks;
+            std::string &json = parts[chunk];
+            json.reserve((end - begin) * estimate);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                appendIndent(json, 2);
+                questions[i]->appendJSON(json, 2);
+                json += i + 1 < questions.size() ? ",\n" : "\n";
+            }
+        }
+        catch (...)
+        {
+            errors[chunk] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+        workers.emplace_back(writeChunk, chunk);
+    writeChunk(0);
+    for (auto &worker : workers)
+        worker.join();
+    for (const auto &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    std::string head = "{\n";
+    appendKey(head, "questions", 1);
+    head += "[\n";
+    std::string tail;
+    appendIndent(tail, 1);
+    tail += "],\n";
+    appendKey(tail, "type", 1);
+    appendString(tail, type);
+    tail += "\n}\n";
+    std::size_t size = head.size() + tail.size();
+    for (const auto &part : parts)
+        size += part.size();
+    QByteArray contents;
+    contents.reserve(static_cast<qsizetype>(size));
+    contents.append(head.data(), static_cast<qsizetype>(head.size()));
+    for (auto &part : parts)
+    {
+        contents.append(part.data(), static_cast<qsizetype>(part.size()));
+        std::string().swap(part);
+    }
+    contents.append(tail.data(), static_cast<qsizetype>(tail.size()));
+    return contents;
+}
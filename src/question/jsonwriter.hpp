@@ -0,0 +1,81 @@
+/// @file jsonwriter.hpp
+/// @brief Contains the definition of a fast writer of repository JSON files.
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <QByteArray>
+#include <QLocale>
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+    class Question;
+
+    /// @brief Writes JSON text directly from the stored questions, without building QJsonObject trees.
+    /// @details The output is byte for byte what QJsonDocument::toJson(QJsonDocument::Indented) writes for the same
+    /// data: four spaces per level, keys sorted, strings escaped the same way and numbers in their shortest form. Files
+    /// saved by this writer therefore do not differ from files saved before it was introduced, which keeps them
+    /// friendly to version control. Large repositories are serialized in chunks on several threads.
+    ///
+    /// A negative nesting level selects compact JSON, as QJsonDocument::toJson(QJsonDocument::Compact) writes it:
+    /// no line breaks, no indentation and no space after the key separators.
+    class JsonWriter
+    {
+    public:
+        /// @brief Appends the indentation of a nesting level.
+        /// @param json The JSON text.
+        /// @param indent The nesting level. Nothing is appended for compact JSON.
+        static void appendIndent(std::string &json, int indent)
+        {
+            if (indent > 0)
+                json.append(4 * static_cast<std::size_t>(indent), ' ');
+        }
+
+        /// @brief Appends a line break, unless the JSON is compact.
+        /// @param json The JSON text.
+        /// @param indent The nesting level of the current value.
+        static void appendNewline(std::string &json, int indent)
+        {
+            if (indent >= 0)
+                json += '\n';
+        }
+
+        /// @brief Returns the nesting level of a value nested in another one.
+        /// @param indent The nesting level of the outer value.
+        /// @param depth How much deeper the value is nested.
+        /// @return indent + depth, or indent itself for compact JSON.
+        static int nested(int indent, int depth) { return indent < 0 ? indent : indent + depth; }
+
+        /// @brief Appends a quoted and escaped string.
+        /// @param json The JSON text.
+        /// @param text The string, encoded in UTF-8.
+        static void appendString(std::string &json, std::string_view text);
+
+        /// @brief Appends a number in its shortest form which reads back exactly.
+        /// @param json The JSON text.
+        /// @param value The number. Infinite and NaN values are written as null.
+        static void appendNumber(std::string &json, double value);
+
+        /// @brief Appends an object key followed by the separator of its value.
+        /// @param json The JSON text.
+        /// @param key The key.
+        /// @param indent The nesting level of the key. Compact JSON has no space after the separator.
+        static void appendKey(std::string &json, std::string_view key, int indent);
+
+        /// @brief Writes a complete repository file.
+        /// @param questions The questions of the repository.
+        /// @param type The type of the repository.
+        /// @param threads The number of threads, or 0 to use one per core.
+        /// @return The JSON text, as written by QJsonDocument::toJson.
+        static QByteArray writeRepository(const std::vector<fq::Question *> &questions, const std::string &type, unsigned threads = 0);
+    };
+}
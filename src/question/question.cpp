@@ -1,7 +1,8 @@
 #include "question.hpp"
+#include <cmath>
 
 fq::Question::Question(const std::string &question, const std::vector<Answer> &answers, const std::string &explanation)
-    : questionText(question), answers(answers), explanation(explanation)
+    : questionText(question), answers(answers), explanation(explanation), difficulty(0.0), discrimination(1.0)
 {
     if (answers.empty())
         throw std::invalid_argument("Question must have at least one answer");
@@ -9,21 +10,9 @@ fq::Question::Question(const std::string &question, const std::vector<Answer> &a
         throw std::invalid_argument("Question text cannot be empty");
 }
 
-double fq::SingleChoiceQuestion::getScore(const std::vector<Answer> &selectedAnswers)
-{
-    if (selectedAnswers.empty())
-        return 0.0;
-    if (selectedAnswers.size() > 1)
-        throw std::invalid_argument("Multiple answers selected for a single choice question");
-    if (selectedAnswers[0].isCorrect)
-        return 1.0;
-    return 0.0;
-}
-
-QJsonObject fq::SingleChoiceQuestion::toJSON() const
+QJsonObject fq::Question::commonJSON() const
 {
     QJsonObject json;
-    json["type"] = "single";
     QJsonArray answersArray;
     for (const auto &answer : answers)
     {
@@ -35,10 +24,132 @@ QJsonObject fq::SingleChoiceQuestion::toJSON() const
     json["answers"] = answersArray;
     json["explanation"] = QString::fromStdString(explanation);
     json["text"] = QString::fromStdString(questionText);
+    if (!tags.empty())
+    {
+        QJsonArray tagsArray;
+        for (const auto &tag : tags)
+            tagsArray.append(QString::fromStdString(tag));
+        json["tags"] = tagsArray;
+    }
+    if (difficulty != 0.0)
+        json["difficulty"] = difficulty;
+    if (discrimination != 1.0)
+        json["discrimination"] = discrimination;
     return json;
 }
 
-double fq::MultipleChoiceQuestion::getScore(const std::vector<Answer> &selectedAnswers)
+void fq::Question::appendJSON(std::string &json, int indent, const std::vector<std::pair<std::string_view, std::string>> &fields) const
+{
+    // Keys are written in the sorted order QJsonObject keeps them in, and the added fields are merged in.
+    const int member = JsonWriter::nested(indent, 1), element = JsonWriter::nested(indent, 2), elementMember = JsonWriter::nested(indent, 3);
+    auto separate = [&]()
+    {
+        json += ',';
+        JsonWriter::appendNewline(json, indent);
+    };
+    auto field = fields.begin();
+    auto appendKey = [&](std::string_view key)
+    {
+        for (; field != fields.end() && field->first < key; ++field)
+        {
+            JsonWriter::appendKey(json, field->first, member);
+            json += field->second;
+            separate();
+        }
+        JsonWriter::appendKey(json, key, member);
+    };
+    json += '{';
+    JsonWriter::appendNewline(json, indent);
+    appendKey("answers");
+    json += '[';
+    JsonWriter::appendNewline(json, indent);
+    for (std::size_t i = 0; i < answers.size(); ++i)
+    {
+        JsonWriter::appendIndent(json, element);
+        json += '{';
+        JsonWriter::appendNewline(json, indent);
+        JsonWriter::appendKey(json, "is_correct", elementMember);
+        json += answers[i].isCorrect ? "true" : "false";
+        separate();
+        JsonWriter::appendKey(json, "text", elementMember);
+        JsonWriter::appendString(json, answers[i].text.str());
+        JsonWriter::appendNewline(json, indent);
+        JsonWriter::appendIndent(json, element);
+        json += '}';
+        if (i + 1 < answers.size())
+            json += ',';
+        JsonWriter::appendNewline(json, indent);
+    }
+    JsonWriter::appendIndent(json, member);
+    json += ']';
+    separate();
+    if (difficulty != 0.0)
+    {
+        appendKey("difficulty");
+        JsonWriter::appendNumber(json, difficulty);
+        separate();
+    }
+    if (discrimination != 1.0)
+    {
+        appendKey("discrimination");
+        JsonWriter::appendNumber(json, discrimination);
+        separate();
+    }
+    appendKey("explanation");
+    JsonWriter::appendString(json, explanation.str());
+    separate();
+    if (!tags.empty())
+    {
+        appendKey("tags");
+        json += '[';
+        JsonWriter::appendNewline(json, indent);
+        for (std::size_t i = 0; i < tags.size(); ++i)
+        {
+            JsonWriter::appendIndent(json, element);
+            JsonWriter::appendString(json, tags[i]);
+            if (i + 1 < tags.size())
+                json += ',';
+            JsonWriter::appendNewline(json, indent);
+        }
+        JsonWriter::appendIndent(json, member);
+        json += ']';
+        separate();
+    }
+    appendKey("text");
+    JsonWriter::appendString(json, questionText);
+    separate();
+    appendKey("type");
+    JsonWriter::appendString(json, getType());
+    for (; field != fields.end(); ++field)
+    {
+        separate();
+        JsonWriter::appendKey(json, field->first, member);
+        json += field->second;
+    }
+    JsonWriter::appendNewline(json, indent);
+    JsonWriter::appendIndent(json, indent);
+    json += '}';
+}
+
+double fq::SingleChoiceQuestion::getScore(const std::vector<Answer> &selectedAnswers) const
+{
+    if (selectedAnswers.empty())
+        return 0.0;
+    if (selectedAnswers.size() > 1)
+        throw std::invalid_argument("Multiple answers selected for a single choice question");
+    if (selectedAnswers[0].isCorrect)
+        return 1.0;
+    return 0.0;
+}
+
+QJsonObject fq::SingleChoiceQuestion::toJSON() const
+{
+    QJsonObject json = commonJSON();
+    json["type"] = "single";
+    return json;
+}
+
+double fq::MultipleChoiceQuestion::getScore(const std::vector<Answer> &selectedAnswers) const
 {
     double score = 0.0;
     double correctsCount = 0.0;
@@ -64,23 +175,12 @@ double fq::MultipleChoiceQuestion::getScore(const std::vector<Answer> &selectedA
 
 QJsonObject fq::MultipleChoiceQuestion::toJSON() const
 {
-    QJsonObject json;
+    QJsonObject json = commonJSON();
     json["type"] = "multiple";
-    QJsonArray answersArray;
-    for (const auto &answer : answers)
-    {
-        QJsonObject answerObj;
-        answerObj["text"] = QString::fromStdString(answer.text);
-        answerObj["is_correct"] = answer.isCorrect;
-        answersArray.append(answerObj);
-    }
-    json["answers"] = answersArray;
-    json["explanation"] = QString::fromStdString(explanation);
-    json["text"] = QString::fromStdString(questionText);
     return json;
 }
 
-double fq::NegativeScoreMultipleChoiceQuestion::getScore(const std::vector<Answer> &selectedAnswers)
+double fq::NegativeScoreMultipleChoiceQuestion::getScore(const std::vector<Answer> &selectedAnswers) const
 {
     double score = 0.0;
     double correctsCount = 0.0;
@@ -106,19 +206,8 @@ double fq::NegativeScoreMultipleChoiceQuestion::getScore(const std::vector<Answe
 
 QJsonObject fq::NegativeScoreMultipleChoiceQuestion::toJSON() const
 {
-    QJsonObject json;
+    QJsonObject json = commonJSON();
     json["type"] = "negative_multiple";
-    QJsonArray answersArray;
-    for (const auto &answer : answers)
-    {
-        QJsonObject answerObj;
-        answerObj["text"] = QString::fromStdString(answer.text);
-        answerObj["is_correct"] = answer.isCorrect;
-        answersArray.append(answerObj);
-    }
-    json["answers"] = answersArray;
-    json["explanation"] = QString::fromStdString(explanation);
-    json["text"] = QString::fromStdString(questionText);
     return json;
 }
 
@@ -145,43 +234,307 @@ fq::Question *fq::Question::fromJSON(const QJsonObject &json)
     }
     if (answers.empty())
         throw std::invalid_argument("Question must have at least one answer");
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(answers.begin(), answers.end(), g);
-    if (type == "single")
-        return new SingleChoiceQuestion(json["text"].toString().toStdString(),
-                                        answers, explanation);
-    else if (type == "multiple")
-        return new MultipleChoiceQuestion(json["text"].toString().toStdString(),
-                                          answers, explanation);
-    else if (type == "negative_multiple")
-        return new NegativeScoreMultipleChoiceQuestion(json["text"].toString().toStdString(),
-                                                       answers, explanation);
-    throw std::invalid_argument("Unknown question type: " + type);
+    std::vector<std::string> tags;
+    if (json.contains("tags"))
+    {
+        if (!json["tags"].isArray())
+            throw std::invalid_argument("Question 'tags' field must be an array");
+        for (const QJsonValue &value : json["tags"].toArray())
+        {
+            if (!value.isString())
+                throw std::invalid_argument("Question tags must be strings");
+            tags.push_back(value.toString().toStdString());
+        }
+    }
+    if (json.contains("difficulty") && !json["difficulty"].isDouble())
+        throw std::invalid_argument("Question 'difficulty' field must be a number");
+    if (json.contains("discrimination") && !json["discrimination"].isDouble())
+        throw std::invalid_argument("Question 'discrimination' field must be a number");
+    Question *question;
+    if (type == "template")
+    {
+        if (!json["scoring"].isString())
+            throw std::invalid_argument("Template question must contain a 'scoring' field with the type of its variants");
+        if (json.contains("variables") && !json["variables"].isArray())
+            throw std::invalid_argument("Question 'variables' field must be an array");
+        std::vector<std::string> variables;
+        for (const QJsonValue &value : json["variables"].toArray())
+        {
+            if (!value.isString())
+                throw std::invalid_argument("Question variables must be strings");
+            variables.push_back(value.toString().toStdString());
+        }
+        question = new TemplateQuestion(json["text"].toString().toStdString(), answers, explanation.empty() ? "No explanation provided" : explanation,
+                                        json["scoring"].toString().toStdString(), variables);
+        question->setTags(tags);
+    }
+    else
+        question = fromParameters(json["text"].toString().toStdString(), answers, explanation, type, tags);
+    try
+    {
+        question->setDifficulty(json["difficulty"].toDouble(0.0));
+        question->setDiscrimination(json["discrimination"].toDouble(1.0));
+    }
+    catch (...)
+    {
+        delete question;
+        throw;
+    }
+    return question;
 }
 
-fq::Question *fq::Question::fromParameters(const std::string &question, const std::vector<fq::Answer> &answers, std::string explanation, const std::string &type)
+fq::Question *fq::Question::fromParameters(const std::string &question, const std::vector<fq::Answer> &answers, std::string explanation, const std::string &type, const std::vector<std::string> &tags)
 {
     if (answers.empty())
         throw std::invalid_argument("Answers vector cannot be empty.");
     if (question.empty())
         throw std::invalid_argument("Question text cannot be empty.");
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::vector<fq::Answer> shuffledAnswers = answers;
-    std::shuffle(shuffledAnswers.begin(), shuffledAnswers.end(), g);
     if (explanation.empty())
         explanation = "No explanation provided";
+    fq::Question *result;
     if (type == "single")
-        return new fq::SingleChoiceQuestion(question, shuffledAnswers, explanation);
+        result = new fq::SingleChoiceQuestion(question, answers, explanation);
     else if (type == "multiple")
-        return new fq::MultipleChoiceQuestion(question, shuffledAnswers, explanation);
+        result = new fq::MultipleChoiceQuestion(question, answers, explanation);
     else if (type == "negative_multiple")
-        return new fq::NegativeScoreMultipleChoiceQuestion(question, shuffledAnswers, explanation);
-    throw std::invalid_argument("Unknown question type: " + type);
+        result = new fq::NegativeScoreMultipleChoiceQuestion(question, answers, explanation);
+    else
+        throw std::invalid_argument("Unknown question type: " + type);
+    result->setTags(tags);
+    return result;
 }
 
 std::string fq::Question::getExplanation() const
 {
     return explanation;
 }
+
+bool fq::Question::hasSameContent(const Question &other) const
+{
+    if (questionText != other.questionText || answers.size() != other.answers.size() || tags != other.tags ||
+        difficulty != other.difficulty || discrimination != other.discrimination || getType() != other.getType())
+        return false;
+    // Equal interned texts are the same object, so most comparisons end at the pointers.
+    if (explanation != other.explanation && explanation.str() != other.explanation.str())
+        return false;
+    for (std::size_t i = 0; i < answers.size(); ++i)
+    {
+        if (answers[i].isCorrect != other.answers[i].isCorrect ||
+            (answers[i].text != other.answers[i].text && answers[i].text.str() != other.answers[i].text.str()))
+            return false;
+    }
+    return true;
+}
+
+std::size_t fq::Question::stringBytes(const std::string &text)
+{
+    // Short strings (up to 15 characters in common implementations) are stored inside the std::string object itself.
+    return text.capacity() <= 15 ? 0 : text.capacity() + 1;
+}
+
+void fq::Question::setDifficulty(double difficulty_)
+{
+    if (!std::isfinite(difficulty_))
+        throw std::invalid_argument("Question difficulty must be finite");
+    difficulty = difficulty_;
+}
+
+void fq::Question::setDiscrimination(double discrimination_)
+{
+    if (!(discrimination_ > 0.0))
+        throw std::invalid_argument("Question discrimination must be positive");
+    discrimination = discrimination_;
+}
+
+void fq::Question::setTags(const std::vector<std::string> &tags_)
+{
+    tags.clear();
+    for (const auto &tag : tags_)
+    {
+        if (tag.empty())
+            continue;
+        if (std::find(tags.begin(), tags.end(), tag) == tags.end())
+            tags.push_back(tag);
+    }
+}
+
+std::vector<std::size_t> fq::Question::getAnswerOrder(std::mt19937 &generator) const
+{
+    std::vector<std::size_t> order(answers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), generator);
+    return order;
+}
+
+fq::TemplateQuestion::TemplateQuestion(const std::string &question, const std::vector<Answer> &answers, const std::string &explanation, const std::string &scoringType, const std::vector<std::string> &variables)
+    : Question(question, answers, explanation), scoringType(scoringType), definitions(variables)
+{
+    scoring.reset(fromParameters(question, answers, explanation, scoringType));
+    if (variables.size() > maxVariables)
+        throw std::invalid_argument("Template question has more than " + std::to_string(maxVariables) + " variables");
+    std::vector<std::string> names;
+    names.reserve(variables.size());
+    expressions.reserve(variables.size());
+    for (const auto &definition : variables)
+    {
+        auto split = splitDefinition(definition);
+        if (std::find(names.begin(), names.end(), split.first) != names.end())
+            throw std::invalid_argument("Variable '" + split.first + "' is defined twice");
+        // A variable can only use the ones defined before it.
+        expressions.emplace_back(split.second, names);
+        names.push_back(split.first);
+    }
+    textTemplate = TextTemplate(question, names);
+    answerTemplates.reserve(answers.size());
+    for (std::size_t i = 0; i < answers.size(); ++i)
+    {
+        try
+        {
+            answerTemplates.emplace_back(answers[i].text.str(), names);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            throw std::invalid_argument("Answer " + std::to_string(i + 1) + ": " + e.what());
+        }
+    }
+    try
+    {
+        explanationTemplate = TextTemplate(explanation, names);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        throw std::invalid_argument(std::string("Explanation: ") + e.what());
+    }
+}
+
+fq::TemplateQuestion::TemplateQuestion(const std::string &question, const std::vector<Answer> &answers, const std::string &explanation, const std::string &scoringType, const std::vector<std::string> &variables,
+                                       std::vector<Expression> expressions, TextTemplate textTemplate, std::vector<TextTemplate> answerTemplates, TextTemplate explanationTemplate)
+    : Question(question, answers, explanation), scoringType(scoringType), definitions(variables), expressions(std::move(expressions)),
+      textTemplate(std::move(textTemplate)), answerTemplates(std::move(answerTemplates)), explanationTemplate(std::move(explanationTemplate))
+{
+    scoring.reset(fromParameters(question, answers, explanation, scoringType));
+    if (variables.size() > maxVariables)
+        throw std::invalid_argument("Template question has more than " + std::to_string(maxVariables) + " variables");
+    if (this->expressions.size() != variables.size() || this->answerTemplates.size() != answers.size())
+        throw std::invalid_argument("Compiled template does not match its variables and answers");
+}
+
+std::pair<std::string, std::string> fq::TemplateQuestion::splitDefinition(const std::string &definition)
+{
+    auto trim = [](const std::string &text)
+    {
+        std::size_t begin = text.find_first_not_of(" \t\r\n");
+        std::size_t end = text.find_last_not_of(" \t\r\n");
+        return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+    };
+    std::size_t equals = definition.find('=');
+    if (equals == std::string::npos)
+        throw std::invalid_argument("Variable definition '" + definition + "' must have the form 'name = expression'");
+    std::string name = trim(definition.substr(0, equals));
+    if (!Expression::isValidName(name))
+        throw std::invalid_argument("Invalid variable name '" + name + "'");
+    return {name, trim(definition.substr(equals + 1))};
+}
+
+QJsonObject fq::TemplateQuestion::toJSON() const
+{
+    QJsonObject json = commonJSON();
+    json["type"] = "template";
+    json["scoring"] = QString::fromStdString(scoringType);
+    QJsonArray variablesArray;
+    for (const auto &definition : definitions)
+        variablesArray.append(QString::fromStdString(definition));
+    json["variables"] = variablesArray;
+    return json;
+}
+
+void fq::TemplateQuestion::appendJSON(std::string &json, int indent) const
+{
+    std::string scoringValue;
+    JsonWriter::appendString(scoringValue, scoringType);
+    // QJsonDocument writes an empty array as "[\n" followed by the indentation of the closing bracket.
+    std::string variablesValue = "[";
+    JsonWriter::appendNewline(variablesValue, indent);
+    for (std::size_t i = 0; i < definitions.size(); ++i)
+    {
+        JsonWriter::appendIndent(variablesValue, JsonWriter::nested(indent, 2));
+        JsonWriter::appendString(variablesValue, definitions[i]);
+        if (i + 1 < definitions.size())
+            variablesValue += ',';
+        JsonWriter::appendNewline(variablesValue, indent);
+    }
+    JsonWriter::appendIndent(variablesValue, JsonWriter::nested(indent, 1));
+    variablesValue += ']';
+    Question::appendJSON(json, indent, {{"scoring", std::move(scoringValue)}, {"variables", std::move(variablesValue)}});
+}
+
+bool fq::TemplateQuestion::hasSameContent(const Question &other) const
+{
+    if (!Question::hasSameContent(other))
+        return false;
+    const auto &templated = static_cast<const TemplateQuestion &>(other);
+    return scoringType == templated.scoringType && definitions == templated.definitions;
+}
+
+std::size_t fq::TemplateQuestion::memoryUsage() const
+{
+    std::size_t bytes = sizeof(*this) + stringBytes(scoringType) + definitions.capacity() * sizeof(std::string);
+    for (const std::string &definition : definitions)
+        bytes += stringBytes(definition);
+    bytes += expressions.capacity() * sizeof(Expression);
+    for (const Expression &expression : expressions)
+        bytes += expression.memoryUsage();
+    bytes += textTemplate.memoryUsage() + explanationTemplate.memoryUsage() + answerTemplates.capacity() * sizeof(TextTemplate);
+    for (const TextTemplate &answer : answerTemplates)
+        bytes += answer.memoryUsage();
+    // The scoring question has its own copy of the text; its answer texts and explanation are shared.
+    bytes += scoring->memoryUsage() + stringBytes(scoring->getQuestion()) + scoring->getAnswers().capacity() * sizeof(Answer);
+    return bytes;
+}
+
+std::unique_ptr<fq::Question> fq::TemplateQuestion::instantiate(std::mt19937 &generator) const
+{
+    double values[maxVariables];
+    std::vector<Answer> rendered(answers);
+    std::string text;
+    std::string explanationText;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt)
+    {
+        // Nothing is rendered from a draw with an invalid value, so texts never show values of an earlier draw.
+        bool valid = true;
+        for (std::size_t i = 0; i < expressions.size() && valid; ++i)
+        {
+            values[i] = expressions[i].evaluate(values, generator);
+            valid = std::isfinite(values[i]);
+        }
+        if (!valid)
+            continue;
+        text.clear();
+        valid = textTemplate.render(text, values, generator) && !text.empty();
+        // Answers without expressions keep their interned texts. Computed answers are only used by this variant, so
+        // they are not interned.
+        for (std::size_t i = 0; i < answers.size() && valid; ++i)
+        {
+            if (answerTemplates[i].isConstant())
+                continue;
+            std::string answerText;
+            valid = answerTemplates[i].render(answerText, values, generator) && !answerText.empty();
+            rendered[i].text = InternedString::unpooled(answerText);
+        }
+        for (std::size_t i = 0; i < rendered.size() && valid; ++i)
+        {
+            for (std::size_t j = i + 1; j < rendered.size() && valid; ++j)
+                valid = rendered[i].text.str() != rendered[j].text.str();
+        }
+        if (!valid)
+            continue;
+        explanationText.clear();
+        if (!explanationTemplate.render(explanationText, values, generator))
+            continue;
+        std::unique_ptr<Question> variant(fromParameters(text, rendered, explanationText, scoringType, tags));
+        variant->setDifficulty(difficulty);
+        variant->setDiscrimination(discrimination);
+        return variant;
+    }
+    throw std::runtime_error("No valid variant of the template question was found in " + std::to_string(maxAttempts) + " draws: " + questionText);
+}
@@ -6,10 +6,17 @@
 #include <vector>
 #include <stdexcept>
 #include <random>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include <utility>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonValue>
 #include <QString>
+#include "internedstring.hpp"
+#include "jsonwriter.hpp"
+#include "expression.hpp"
 
 /// @namespace fq
 /// @brief Contains classes and structures related to quiz questions and answers.
@@ -24,8 +31,8 @@ namespace fq
     /// @brief Represents an answer to a question in the quiz.
     struct Answer
     {
-        /// @brief The text of the question.
-        std::string text;
+        /// @brief The text of the answer, shared with all equal answer texts.
+        InternedString text;
 
         /// @brief Indicates whether the answer to the question is correct.
         /// true if the answer is correct; false otherwise.
@@ -44,7 +51,29 @@ namespace fq
         std::string questionText;
 
         /// @brief An explanation of the question, which can be used to provide additional context or information.
-        std::string explanation;
+        /// @details Interned, since many questions share the same explanation (e.g. "No explanation provided").
+        InternedString explanation;
+
+        /// @brief Tags of the question, e.g. chapter, topic or difficulty. Used to draw from subsets of a repository.
+        std::vector<std::string> tags;
+
+        /// @brief Difficulty of the question on a logit scale, where 0 is average, negative is easier and positive is harder.
+        double difficulty;
+
+        /// @brief Discrimination of the question, i.e. how sharply it separates learners below and above its difficulty.
+        /// @details Used as the slope of the item response curve by adaptive repositories. 1 is typical.
+        double discrimination;
+
+        /// @brief Creates a JSON object containing the fields shared by all question types.
+        /// @return A QJsonObject with the text, answers, explanation and tags of the question, but without its type.
+        QJsonObject commonJSON() const;
+
+        /// @brief Appends the question as JSON text, with fields added by a question type.
+        /// @param json The JSON text. The object is appended starting with its opening brace.
+        /// @param indent The nesting level of the object, or a negative number for compact JSON.
+        /// @param fields The added fields as pairs of key and JSON text of the value, sorted by key. Values spanning
+        /// several lines must be indented for the nesting level JsonWriter::nested(indent, 1).
+        void appendJSON(std::string &json, int indent, const std::vector<std::pair<std::string_view, std::string>> &fields) const;
 
     public:
         /// @brief Constructs a Question with the specified text and answers.
@@ -55,18 +84,27 @@ namespace fq
         /// @throws std::invalid_argument if the question text is empty.
         Question(const std::string &question, const std::vector<Answer> &answers, const std::string &explanation);
 
+        /// @brief Virtual destructor for the Question class.
+        virtual ~Question() = default;
+
         /// @brief Returns the answers associated with the question.
-        /// @return A vector of answers associated with the question.
-        std::vector<Answer> getAnswers() const { return answers; }
+        /// @return A vector of answers associated with the question, in their canonical (stored) order.
+        const std::vector<Answer> &getAnswers() const { return answers; }
+
+        /// @brief Returns a random presentation order of the answers.
+        /// @param generator The random number generator used to shuffle the order.
+        /// @return A vector of indices into the answers collection, in the order they should be presented.
+        /// @details The stored answers are never reordered, so the question is always saved in the same form.
+        std::vector<std::size_t> getAnswerOrder(std::mt19937 &generator) const;
 
         /// @brief Returns the text of the question.
-        /// @return The text of the question.
-        std::string getQuestion() const { return questionText; }
+        /// @return The text of the question, valid as long as the question.
+        const std::string &getQuestion() const { return questionText; }
 
         /// @brief Returns the score based on the selected answers. Score is calculated based on the question type.
         /// @param selectedAnswers A vector of answers selected by the user.
         /// @return The score based on the selected answers.
-        virtual double getScore(const std::vector<Answer> &selectedAnswers) = 0;
+        virtual double getScore(const std::vector<Answer> &selectedAnswers) const = 0;
 
         /// @brief Checks if the question is a single-choice question.
         /// @return true if the question is a single-choice question; false otherwise.
@@ -77,11 +115,78 @@ namespace fq
         /// @details The explanation can provide additional context or information about the question.
         std::string getExplanation() const;
 
+        /// @brief Returns the interned explanation, whose id tells explanations shared by several questions apart.
+        const InternedString &getInternedExplanation() const { return explanation; }
+
+        /// @brief Returns the tags of the question.
+        /// @return A vector of tags, in the order they were defined.
+        const std::vector<std::string> &getTags() const { return tags; }
+
+        /// @brief Sets the tags of the question.
+        /// @param tags_ The new tags. Empty and duplicate tags are ignored.
+        void setTags(const std::vector<std::string> &tags_);
+
+        /// @brief Returns the difficulty of the question.
+        /// @return The difficulty on a logit scale, where 0 is average.
+        double getDifficulty() const { return difficulty; }
+
+        /// @brief Sets the difficulty of the question.
+        /// @param difficulty_ The difficulty on a logit scale, where 0 is average.
+        /// @throws std::invalid_argument if the difficulty is not finite.
+        void setDifficulty(double difficulty_);
+
+        /// @brief Returns the discrimination of the question.
+        /// @return The slope of the item response curve of the question.
+        double getDiscrimination() const { return discrimination; }
+
+        /// @brief Sets the discrimination of the question.
+        /// @param discrimination_ The slope of the item response curve of the question.
+        /// @throws std::invalid_argument if the discrimination is not positive.
+        void setDiscrimination(double discrimination_);
+
+        /// @brief Returns the type of the question, as used in the JSON representation.
+        /// @return A string identifying the question type (e.g. "single").
+        virtual std::string getType() const = 0;
+
         /// @brief Converts the question to a JSON object.
         /// @return A QJsonObject representing the question, including its text, answers, explanation, and type.
         virtual QJsonObject toJSON() const = 0;
 
+        /// @brief Appends the question as JSON text, exactly as QJsonDocument would write toJSON().
+        /// @details Used to save repositories without building QJsonObject trees; see JsonWriter. The default
+        /// implementation writes the fields of commonJSON and the type, so question types which add fields to toJSON
+        /// must override it as well.
+        /// @param json The JSON text. The object is appended starting with its opening brace.
+        /// @param indent The nesting level of the object, indented like QJsonDocument::Indented, or a negative number
+        /// for compact JSON like QJsonDocument::Compact.
+        virtual void appendJSON(std::string &json, int indent) const { appendJSON(json, indent, {}); }
+
+        /// @brief Checks whether another question has the same content, i.e. would be saved identically.
+        /// @details Compares the fields directly, without building JSON: type, text, answers, explanation, tags,
+        /// difficulty and discrimination. Question types with further fields must override it.
+        /// @param other The other question.
+        /// @return true if the questions have the same content; false otherwise.
+        virtual bool hasSameContent(const Question &other) const;
+
+        /// @brief Estimates the bytes used by the question object and by the data only its type owns.
+        /// @details The text, answers, explanation and tags are not included; see MemoryUsage, which measures them
+        /// once for texts shared by several questions.
+        virtual std::size_t memoryUsage() const = 0;
+
+        /// @brief Estimates the heap bytes used by the characters of a string.
+        /// @param text The string.
+        /// @return 0 for short strings stored inside the std::string object, the allocated capacity otherwise.
+        static std::size_t stringBytes(const std::string &text);
+
+        /// @brief Generates a variant of the question, if it is a template.
+        /// @details Called by sessions whenever the question is drawn, so every draw can ask with different values.
+        /// @param generator The random number generator of the session.
+        /// @return The variant, or nullptr if the question is asked as it is.
+        /// @throws std::runtime_error if the question is a template but no valid variant could be generated.
+        virtual std::unique_ptr<Question> instantiate(std::mt19937 &generator) const { return nullptr; }
+
         /// @brief Creates a Question object from a JSON object.
+        /// @details Questions of type "template" also need the fields "scoring" and "variables"; see TemplateQuestion.
         /// @param json The JSON object containing question data.
         /// @return A pointer to a Question object created from the JSON data.
         /// @throws std::invalid_argument if the JSON object does not contain valid question data.
@@ -92,12 +197,13 @@ namespace fq
         /// @param answers A vector of answers associated with the question.
         /// @param explanation An explanation for the question.
         /// @param type The type of the question.
+        /// @param tags Tags of the question. Defaults to no tags.
         /// @return A pointer to a Question object created from the parameters.
         /// @throws std::invalid_argument if the answers vector is empty.
         /// @throws std::invalid_argument if the question text is empty.
         /// @throws std::invalid_argument if the type is not recognized.
         /// @details The type parameter determines the specific type of question to create (e.g., single-choice, multiple-choice).
-        static Question *fromParameters(const std::string &question, const std::vector<Answer> &answers, std::string explanation, const std::string &type);
+        static Question *fromParameters(const std::string &question, const std::vector<Answer> &answers, std::string explanation, const std::string &type, const std::vector<std::string> &tags = {});
     };
 
     /// @brief Represents a single-choice question in the quiz.
@@ -117,7 +223,7 @@ namespace fq
         /// @param selectedAnswers A vector of answers selected by the user.
         /// @return The score based on the selected answers.
         /// @throws std::invalid_argument if multiple answers are selected.
-        virtual double getScore(const std::vector<Answer> &selectedAnswers) override;
+        virtual double getScore(const std::vector<Answer> &selectedAnswers) const override;
 
         /// @brief Checks if the question is a single-choice question.
         /// @return true, as this is a single-choice question.
@@ -126,6 +232,13 @@ namespace fq
         /// @brief Converts the question to a JSON object.
         /// @return A QJsonObject representing the question, including its text, answers, explanation, and type.
         virtual QJsonObject toJSON() const override;
+
+        /// @brief Returns the type of the question, as used in the JSON representation.
+        /// @return "single".
+        virtual std::string getType() const override { return "single"; }
+
+        /// @brief Returns the size of the question object.
+        virtual std::size_t memoryUsage() const override { return sizeof(*this); }
     };
 
     /// @brief Represents a multiple-choice question in the quiz.
@@ -147,7 +260,7 @@ namespace fq
         /// Score can never be negative.
         /// @param selectedAnswers A vector of answers selected by the user.
         /// @return The score based on the selected answers.
-        virtual double getScore(const std::vector<Answer> &selectedAnswers) override;
+        virtual double getScore(const std::vector<Answer> &selectedAnswers) const override;
 
         /// @brief Checks if the question is a single-choice question.
         /// @return false, as this is a multiple-choice question.
@@ -156,6 +269,13 @@ namespace fq
         /// @brief Converts the question to a JSON object.
         /// @return A QJsonObject representing the question, including its text, answers, explanation, and type.
         virtual QJsonObject toJSON() const override;
+
+        /// @brief Returns the type of the question, as used in the JSON representation.
+        /// @return "multiple".
+        virtual std::string getType() const override { return "multiple"; }
+
+        /// @brief Returns the size of the question object.
+        virtual std::size_t memoryUsage() const override { return sizeof(*this); }
     };
 
     /// @brief Represents a multiple-choice question with negative scoring in the quiz.
@@ -177,7 +297,7 @@ namespace fq
         /// Score can be negative.
         /// @param selectedAnswers A vector of answers selected by the user.
         /// @return The score based on the selected answers.
-        virtual double getScore(const std::vector<Answer> &selectedAnswers) override;
+        virtual double getScore(const std::vector<Answer> &selectedAnswers) const override;
 
         /// @brief Checks if the question is a single-choice question.
         /// @return false, as this is a multiple-choice question.
@@ -186,6 +306,142 @@ namespace fq
         /// @brief Converts the question to a JSON object.
         /// @return A QJsonObject representing the question, including its text, answers, explanation, and type.
         virtual QJsonObject toJSON() const override;
+
+        /// @brief Returns the type of the question, as used in the JSON representation.
+        /// @return "negative_multiple".
+        virtual std::string getType() const override { return "negative_multiple"; }
+
+        /// @brief Returns the size of the question object.
+        virtual std::size_t memoryUsage() const override { return sizeof(*this); }
+    };
+
+    /// @brief Represents a parametric question, generating a new variant with fresh values whenever it is drawn.
+    /// @details The question defines variables, e.g. "a = randint(2, 12)", evaluated in order, so a variable can use
+    /// the ones before it. Its text, answers and explanation embed expressions in braces, e.g. "What is {a}×{b}?" with
+    /// the answer "{a*b}" and the distractor "{a*b+a}" (see TextTemplate). Everything is compiled once when the
+    /// question is constructed; generating a variant only runs the compiled expressions and renders the texts, so
+    /// millions of variants can be generated for exam batches. A variant is a question of the scoring type, which is
+    /// also used to score answers to the template itself. Draws giving an infinite or NaN value or two answers with the
+    /// same text are repeated, so e.g. a division by a variable which came out as 0 is never shown.
+    class TemplateQuestion : public Question
+    {
+        /// @brief The type of the variants, "single", "multiple" or "negative_multiple".
+        std::string scoringType;
+
+        /// @brief The definitions of the variables, as written ("name = expression").
+        std::vector<std::string> definitions;
+
+        /// @brief The compiled expressions of the variables, in the order they are evaluated.
+        std::vector<Expression> expressions;
+
+        /// @brief The compiled question text.
+        TextTemplate textTemplate;
+
+        /// @brief The compiled texts of the answers.
+        std::vector<TextTemplate> answerTemplates;
+
+        /// @brief The compiled explanation.
+        TextTemplate explanationTemplate;
+
+        /// @brief A question of the scoring type with the texts of the template, which scores the answers.
+        std::unique_ptr<Question> scoring;
+
+    public:
+        /// @brief Maximum number of variables of a question.
+        static constexpr std::size_t maxVariables = 64;
+
+        /// @brief Number of draws tried to find a variant with finite values, non-empty texts and distinct answers.
+        static constexpr int maxAttempts = 32;
+
+        /// @brief Constructs a TemplateQuestion and compiles its expressions.
+        /// @param question The text of the question, with embedded expressions.
+        /// @param answers The answers, whose texts may embed expressions.
+        /// @param explanation An explanation for the question, which may embed expressions.
+        /// @param scoringType The type of the variants: "single", "multiple" or "negative_multiple".
+        /// @param variables The definitions of the variables, each as "name = expression".
+        /// @throws std::invalid_argument if the answers vector is empty.
+        /// @throws std::invalid_argument if the question text is empty.
+        /// @throws std::invalid_argument if the scoring type is not recognized.
+        /// @throws std::invalid_argument if a definition, text or expression is malformed.
+        TemplateQuestion(const std::string &question, const std::vector<Answer> &answers, const std::string &explanation, const std::string &scoringType, const std::vector<std::string> &variables);
+
+        /// @brief Constructs a TemplateQuestion from its already compiled expressions and texts, e.g. as stored in a
+        /// snapshot, without compiling them again.
+        /// @details The i-th expression must have been compiled with the names of the first i variables, and the texts
+        /// with the names of all of them; see Expression::fromCode and TextTemplate::fromParts.
+        /// @param question The text of the question, with embedded expressions.
+        /// @param answers The answers, whose texts may embed expressions.
+        /// @param explanation An explanation for the question, which may embed expressions.
+        /// @param scoringType The type of the variants: "single", "multiple" or "negative_multiple".
+        /// @param variables The definitions of the variables, each as "name = expression".
+        /// @param expressions The compiled expressions of the variables.
+        /// @param textTemplate The compiled question text.
+        /// @param answerTemplates The compiled answer texts.
+        /// @param explanationTemplate The compiled explanation.
+        /// @throws std::invalid_argument if the question would be invalid, or the numbers of expressions or answer
+        /// texts do not match the variables and answers.
+        TemplateQuestion(const std::string &question, const std::vector<Answer> &answers, const std::string &explanation, const std::string &scoringType, const std::vector<std::string> &variables,
+                         std::vector<Expression> expressions, TextTemplate textTemplate, std::vector<TextTemplate> answerTemplates, TextTemplate explanationTemplate);
+
+        /// @brief Returns the score based on the selected answers, as a question of the scoring type would.
+        /// @param selectedAnswers A vector of answers selected by the user.
+        /// @return The score based on the selected answers.
+        virtual double getScore(const std::vector<Answer> &selectedAnswers) const override { return scoring->getScore(selectedAnswers); }
+
+        /// @brief Checks if the variants are single-choice questions.
+        virtual bool isSingleChoice() const override { return scoring->isSingleChoice(); }
+
+        /// @brief Converts the question to a JSON object.
+        /// @return A QJsonObject representing the question, including its scoring type and variables.
+        virtual QJsonObject toJSON() const override;
+
+        /// @brief Appends the question as JSON text, including its scoring type and variables.
+        virtual void appendJSON(std::string &json, int indent) const override;
+
+        /// @brief Returns the type of the question, as used in the JSON representation.
+        /// @return "template".
+        virtual std::string getType() const override { return "template"; }
+
+        /// @brief Checks whether another question has the same content, including the scoring type and variables.
+        virtual bool hasSameContent(const Question &other) const override;
+
+        /// @brief Estimates the bytes used by the question object, its definitions, the compiled expressions and texts
+        /// and the question scoring its answers.
+        virtual std::size_t memoryUsage() const override;
+
+        /// @brief Returns the type of the variants.
+        /// @return "single", "multiple" or "negative_multiple".
+        const std::string &getScoringType() const { return scoringType; }
+
+        /// @brief Returns the definitions of the variables, as written.
+        const std::vector<std::string> &getVariables() const { return definitions; }
+
+        /// @brief Returns the compiled expressions of the variables, in the order they are evaluated.
+        const std::vector<Expression> &getExpressions() const { return expressions; }
+
+        /// @brief Returns the compiled question text.
+        const TextTemplate &getTextTemplate() const { return textTemplate; }
+
+        /// @brief Returns the compiled answer texts, in the order of the answers.
+        const std::vector<TextTemplate> &getAnswerTemplates() const { return answerTemplates; }
+
+        /// @brief Returns the compiled explanation.
+        const TextTemplate &getExplanationTemplate() const { return explanationTemplate; }
+
+        /// @brief Generates a variant of the question with freshly drawn values.
+        /// @details Draws are repeated until every value is finite, the question and answer texts are not empty and
+        /// the answers are distinct. Computed answer texts are not interned; see InternedString::unpooled.
+        /// @param generator The random number generator the values are drawn with.
+        /// @return A question of the scoring type with the rendered texts and the tags, difficulty and discrimination
+        /// of the template.
+        /// @throws std::runtime_error if no valid variant was drawn in maxAttempts draws.
+        virtual std::unique_ptr<Question> instantiate(std::mt19937 &generator) const override;
+
+        /// @brief Splits the definition of a variable into its name and expression.
+        /// @param definition The definition, "name = expression".
+        /// @return The trimmed name and expression.
+        /// @throws std::invalid_argument if the definition has no '=' or the name is not a valid variable name.
+        static std::pair<std::string, std::string> splitDefinition(const std::string &definition);
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include "bitset.hpp"
+
+std::vector<std::uint64_t> fq::Bitset::toWords(const Container &container)
+{
+    if (container.isBitmap())
+        return container.bitmap;
+    std::vector<std::uint64_t> words(bitmapWords, 0);
+    for (auto low : container.array)
+        words[low >> 6] |= std::uint64_t(1) << (low & 63);
+    return words;
+}
+
+fq::Bitset::Container fq::Bitset::fromWords(std::uint16_t key, const std::vector<std::uint64_t> &words)
+{
+    Container container;
+    container.key = key;
+    container.cardinality = 0;
+    for (auto word : words)
+        container.cardinality += popcount(word);
+    if (container.cardinality > arrayLimit)
+    {
+        container.bitmap = words;
+        return container;
+    }
+    container.array.reserve(container.cardinality);
+    for (std::size_t i = 0; i < bitmapWords; ++i)
+    {
+        std::uint64_t word = words[i];
+        while (word)
+        {
+            unsigned bit = popcount((word & (~word + 1)) - 1);
+            container.array.push_back(static_cast<std::uint16_t>(i * 64 + bit));
+            word &= word - 1;
+        }
+    }
+    return container;
+}
+
+fq::Bitset::Container fq::Bitset::fromArray(std::uint16_t key, std::vector<std::uint16_t> &&values)
+{
+    Container container;
+    container.key = key;
+    container.cardinality = static_cast<std::uint32_t>(values.size());
+    if (values.size() > arrayLimit)
+    {
+        container.bitmap.assign(bitmapWords, 0);
+        for (auto low : values)
+            container.bitmap[low >> 6] |= std::uint64_t(1) << (low & 63);
+    }
+    else
+        container.array = std::move(values);
+    return container;
+}
+
+std::vector<fq::Bitset::Container>::iterator fq::Bitset::find(std::uint16_t key)
+{
+    return std::lower_bound(containers.begin(), containers.end(), key,
+                            [](const Container &container, std::uint16_t k)
+                            { return container.key < k; });
+}
+
+std::vector<fq::Bitset::Container>::const_iterator fq::Bitset::find(std::uint16_t key) const
+{
+    return std::lower_bound(containers.begin(), containers.end(), key,
+                            [](const Container &container, std::uint16_t k)
+                            { return container.key < k; });
+}
+
+fq::Bitset fq::Bitset::range(std::size_t count)
+{
+    Bitset result;
+    for (std::size_t start = 0; start < count; start += 65536)
+    {
+        std::size_t chunk = std::min<std::size_t>(count - start, 65536);
+        std::vector<std::uint64_t> words(bitmapWords, 0);
+        for (std::size_t i = 0; i < chunk / 64; ++i)
+            words[i] = ~std::uint64_t(0);
+        if (chunk % 64)
+            words[chunk / 64] = (std::uint64_t(1) << (chunk % 64)) - 1;
+        result.containers.push_back(fromWords(static_cast<std::uint16_t>(start >> 16), words));
+    }
+    result.cardinality = count;
+    return result;
+}
+
+void fq::Bitset::add(std::uint32_t value)
+{
+    std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+    std::uint16_t low = static_cast<std::uint16_t>(value & 0xFFFF);
+    auto it = find(key);
+    if (it == containers.end() || it->key != key)
+    {
+        Container container;
+        container.key = key;
+        container.cardinality = 1;
+        container.array.push_back(low);
+        containers.insert(it, std::move(container));
+        ++cardinality;
+        return;
+    }
+    if (it->isBitmap())
+    {
+        std::uint64_t mask = std::uint64_t(1) << (low & 63);
+        if (it->bitmap[low >> 6] & mask)
+            return;
+        it->bitmap[low >> 6] |= mask;
+    }
+    else
+    {
+        auto position = std::lower_bound(it->array.begin(), it->array.end(), low);
+        if (position != it->array.end() && *position == low)
+            return;
+        it->array.insert(position, low);
+        if (it->array.size() > arrayLimit)
+        {
+            it->bitmap = toWords(*it);
+            it->array.clear();
+            it->array.shrink_to_fit();
+        }
+    }
+    ++it->cardinality;
+    ++cardinality;
+}
+
+void fq::Bitset::remove(std::uint32_t value)
+{
+    std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+    std::uint16_t low = static_cast<std::uint16_t>(value & 0xFFFF);
+    auto it = find(key);
+    if (it == containers.end() || it->key != key)
+        return;
+    if (it->isBitmap())
+    {
+        std::uint64_t mask = std::uint64_t(1) << (low & 63);
+        if (!(it->bitmap[low >> 6] & mask))
+            return;
+        it->bitmap[low >> 6] &= ~mask;
+        if (--it->cardinality <= arrayLimit)
+            *it = fromWords(key, it->bitmap);
+    }
+    else
+    {
+        auto position = std::lower_bound(it->array.begin(), it->array.end(), low);
+        if (position == it->array.end() || *position != low)
+            return;
+        it->array.erase(position);
+        --it->cardinality;
+    }
+    --cardinality;
+    if (!it->cardinality)
+        containers.erase(it);
+}
+
+bool fq::Bitset::contains(std::uint32_t value) const
+{
+    std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+    std::uint16_t low = static_cast<std::uint16_t>(value & 0xFFFF);
+    auto it = find(key);
+    if (it == containers.end() || it->key != key)
+        return false;
+    if (it->isBitmap())
+        return it->bitmap[low >> 6] & (std::uint64_t(1) << (low & 63));
+    return std::binary_search(it->array.begin(), it->array.end(), low);
+}
+
+void fq::Bitset::clear()
+{
+    containers.clear();
+    cardinality = 0;
+}
+
+std::uint32_t fq::Bitset::select(std::size_t rank) const
+{
+    if (rank >= cardinality)
+        throw std::out_of_range("Bitset rank out of range");
+    for (const auto &container : containers)
+    {
+        if (rank >= container.cardinality)
+        {
+            rank -= container.cardinality;
+            continue;
+        }
+        std::uint32_t high = static_cast<std::uint32_t>(container.key) << 16;
+        if (!container.isBitmap())
+            return high | container.array[rank];
+        for (std::size_t i = 0; i < bitmapWords; ++i)
+        {
+            std::uint64_t word = container.bitmap[i];
+            unsigned count = popcount(word);
+            if (rank >= count)
+            {
+                rank -= count;
+                continue;
+            }
+            for (; rank; --rank)
+                word &= word - 1;
+            unsigned bit = popcount((word & (~word + 1)) - 1);
+            return high | static_cast<std::uint32_t>(i * 64 + bit);
+        }
+    }
+    throw std::out_of_range("Bitset rank out of range");
+}
+
+fq::Bitset fq::Bitset::operator&(const Bitset &other) const
+{
+    Bitset result;
+    auto a = containers.begin();
+    auto b = other.containers.begin();
+    while (a != containers.end() && b != other.containers.end())
+    {
+        if (a->key < b->key)
+            ++a;
+        else if (b->key < a->key)
+            ++b;
+        else
+        {
+            Container container;
+            if (!a->isBitmap() && !b->isBitmap())
+            {
+                std::vector<std::uint16_t> values;
+                std::set_intersection(a->array.begin(), a->array.end(), b->array.begin(), b->array.end(), std::back_inserter(values));
+                container = fromArray(a->key, std::move(values));
+            }
+            else
+            {
+                auto words = toWords(*a);
+                auto otherWords = toWords(*b);
+                for (std::size_t i = 0; i < bitmapWords; ++i)
+                    words[i] &= otherWords[i];
+                container = fromWords(a->key, words);
+            }
+            if (container.cardinality)
+            {
+                result.cardinality += container.cardinality;
+                result.containers.push_back(std::move(container));
+            }
+            ++a;
+            ++b;
+        }
+    }
+    return result;
+}
+
+fq::Bitset fq::Bitset::operator|(const Bitset &other) const
+{
+    Bitset result;
+    auto a = containers.begin();
+    auto b = other.containers.begin();
+    while (a != containers.end() || b != other.containers.end())
+    {
+        if (b == other.containers.end() || (a != containers.end() && a->key < b->key))
+            result.containers.push_back(*a++);
+        else if (a == containers.end() || b->key < a->key)
+            result.containers.push_back(*b++);
+        else
+        {
+            if (!a->isBitmap() && !b->isBitmap())
+            {
+                std::vector<std::uint16_t> values;
+                std::set_union(a->array.begin(), a->array.end(), b->array.begin(), b->array.end(), std::back_inserter(values));
+                result.containers.push_back(fromArray(a->key, std::move(values)));
+            }
+            else
+            {
+                auto words = toWords(*a);
+                auto otherWords = toWords(*b);
+                for (std::size_t i = 0; i < bitmapWords; ++i)
+                    words[i] |= otherWords[i];
+                result.containers.push_back(fromWords(a->key, words));
+            }
+            ++a;
+            ++b;
+        }
+        result.cardinality += result.containers.back().cardinality;
+    }
+    return result;
+}
+
+fq::Bitset fq::Bitset::operator-(const Bitset &other) const
+{
+    Bitset result;
+    auto b = other.containers.begin();
+    for (const auto &container : containers)
+    {
+        while (b != other.containers.end() && b->key < container.key)
+            ++b;
+        if (b == other.containers.end() || b->key != container.key)
+        {
+            result.containers.push_back(container);
+            result.cardinality += container.cardinality;
+            continue;
+        }
+        Container difference;
+        if (!container.isBitmap() && !b->isBitmap())
+        {
+            std::vector<std::uint16_t> values;
+            std::set_difference(container.array.begin(), container.array.end(), b->array.begin(), b->array.end(), std::back_inserter(values));
+            difference = fromArray(container.key, std::move(values));
+        }
+        else
+        {
+            auto words = toWords(container);
+            auto otherWords = toWords(*b);
+            for (std::size_t i = 0; i < bitmapWords; ++i)
+                words[i] &= ~otherWords[i];
+            difference = fromWords(container.key, words);
+        }
+        if (difference.cardinality)
+        {
+            result.cardinality += difference.cardinality;
+            result.containers.push_back(std::move(difference));
+        }
+    }
+    return result;
+}
+
+bool fq::Bitset::operator==(const Bitset &other) const
+{
+    if (cardinality != other.cardinality || containers.size() != other.containers.size())
+        return false;
+    for (std::size_t i = 0; i < containers.size(); ++i)
+    {
+        const auto &a = containers[i];
+        const auto &b = other.containers[i];
+        if (a.key != b.key || a.cardinality != b.cardinality || a.array != b.array || a.bitmap != b.bitmap)
+            return false;
+    }
+    return true;
+}
+
+std::size_t fq::Bitset::memoryUsage() const
+{
+    std::size_t bytes = containers.capacity() * sizeof(Container);
+    for (const auto &container : containers)
+        bytes += container.array.capacity() * sizeof(std::uint16_t) + container.bitmap.capacity() * sizeof(std::uint64_t);
+    return bytes;
+}
@@ -0,0 +1,164 @@
+/// @file bitset.hpp
+/// @brief Contains the definition of a compressed bitset used to index question slots.
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <bitset>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Compressed set of 32-bit integers, organised like a roaring bitmap.
+    /// @details Values are split into chunks of 65536 by their upper 16 bits. A sparse chunk is stored as a
+    /// sorted array of its lower 16 bits, a dense chunk as a plain 8 KiB bitmap. Every chunk keeps its
+    /// cardinality, so counting and selecting the n-th element only walk the (few) chunks instead of all values.
+    class Bitset
+    {
+        /// @brief Number of values above which a chunk is stored as a bitmap instead of an array.
+        static constexpr std::size_t arrayLimit = 4096;
+
+        /// @brief Number of 64-bit words in a bitmap chunk.
+        static constexpr std::size_t bitmapWords = 1024;
+
+        /// @brief A single chunk of 65536 values sharing the same upper 16 bits.
+        struct Container
+        {
+            /// @brief The upper 16 bits shared by all values in the chunk.
+            std::uint16_t key;
+
+            /// @brief The number of values stored in the chunk.
+            std::uint32_t cardinality;
+
+            /// @brief Sorted lower 16 bits of the values, used while the chunk is sparse.
+            std::vector<std::uint16_t> array;
+
+            /// @brief Bitmap of the lower 16 bits of the values, used once the chunk is dense.
+            std::vector<std::uint64_t> bitmap;
+
+            /// @brief Checks whether the chunk is stored as a bitmap.
+            /// @return true if the chunk is stored as a bitmap; false if it is stored as an array.
+            bool isBitmap() const { return !bitmap.empty(); }
+        };
+
+        /// @brief Chunks of the set, sorted by their key.
+        std::vector<Container> containers;
+
+        /// @brief Total number of values in the set.
+        std::size_t cardinality;
+
+        /// @brief Returns the number of set bits in a word.
+        static unsigned popcount(std::uint64_t word) { return static_cast<unsigned>(std::bitset<64>(word).count()); }
+
+        /// @brief Expands a chunk into bitmap words.
+        static std::vector<std::uint64_t> toWords(const Container &container);
+
+        /// @brief Creates a chunk from bitmap words, choosing the cheaper representation.
+        static Container fromWords(std::uint16_t key, const std::vector<std::uint64_t> &words);
+
+        /// @brief Creates a chunk from sorted values, choosing the cheaper representation.
+        static Container fromArray(std::uint16_t key, std::vector<std::uint16_t> &&values);
+
+        /// @brief Finds the chunk with the specified key.
+        /// @return An iterator to the chunk, or to the position where it would be inserted.
+        std::vector<Container>::iterator find(std::uint16_t key);
+
+        /// @brief Finds the chunk with the specified key.
+        /// @return An iterator to the chunk, or to the position where it would be inserted.
+        std::vector<Container>::const_iterator find(std::uint16_t key) const;
+
+    public:
+        /// @brief Constructs an empty bitset.
+        Bitset() : cardinality(0) {}
+
+        /// @brief Creates a bitset containing all values in the range [0, count).
+        /// @param count The number of values in the range.
+        /// @return A bitset containing all values smaller than count.
+        static Bitset range(std::size_t count);
+
+        /// @brief Adds a value to the set.
+        /// @param value The value to be added.
+        void add(std::uint32_t value);
+
+        /// @brief Removes a value from the set.
+        /// @param value The value to be removed.
+        void remove(std::uint32_t value);
+
+        /// @brief Checks whether the set contains a value.
+        /// @param value The value to look for.
+        /// @return true if the value is in the set; false otherwise.
+        bool contains(std::uint32_t value) const;
+
+        /// @brief Returns the number of values in the set.
+        /// @return The number of values in the set.
+        std::size_t size() const { return cardinality; }
+
+        /// @brief Checks whether the set is empty.
+        /// @return true if the set contains no values; false otherwise.
+        bool empty() const { return cardinality == 0; }
+
+        /// @brief Removes all values from the set.
+        void clear();
+
+        /// @brief Returns the value with the specified rank (the rank-th smallest value).
+        /// @param rank The zero-based rank of the value.
+        /// @return The value with the specified rank.
+        /// @throws std::out_of_range if the rank is not smaller than the size of the set.
+        std::uint32_t select(std::size_t rank) const;
+
+        /// @brief Returns the intersection of two sets.
+        Bitset operator&(const Bitset &other) const;
+
+        /// @brief Returns the union of two sets.
+        Bitset operator|(const Bitset &other) const;
+
+        /// @brief Returns the values of this set which are not in the other set.
+        Bitset operator-(const Bitset &other) const;
+
+        /// @brief Compares two sets for equality.
+        bool operator==(const Bitset &other) const;
+
+        /// @brief Returns the number of bytes used by the set, excluding the object itself.
+        std::size_t memoryUsage() const;
+
+        /// @brief Calls a function for every value in the set, in increasing order.
+        /// @param function The function to be called with each value.
+        template <typename Function>
+        void forEach(Function function) const
+        {
+            for (const auto &container : containers)
+            {
+                std::uint32_t high = static_cast<std::uint32_t>(container.key) << 16;
+                if (container.isBitmap())
+                {
+                    for (std::size_t i = 0; i < bitmapWords; ++i)
+                    {
+                        std::uint64_t word = container.bitmap[i];
+                        while (word)
+                        {
+                            unsigned bit = popcount((word & (~word + 1)) - 1);
+                            function(high | static_cast<std::uint32_t>(i * 64 + bit));
+                            word &= word - 1;
+                        }
+                    }
+                }
+                else
+                {
+                    for (auto low : container.array)
+                        function(high | low);
+                }
+            }
+        }
+    };
+}
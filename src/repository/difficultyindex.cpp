@@ -0,0 +1,120 @@
+#include "difficultyindex.hpp"
+
+double fq::DifficultyIndex::logisticSlope(double x)
+{
+    double e = std::exp(-std::abs(x));
+    return e / ((1.0 + e) * (1.0 + e));
+}
+
+double fq::DifficultyIndex::probability(double discrimination, double difficulty, double ability)
+{
+    return 1.0 / (1.0 + std::exp(-discrimination * (ability - difficulty)));
+}
+
+double fq::DifficultyIndex::information(double discrimination, double difficulty, double ability)
+{
+    return discrimination * discrimination * logisticSlope(discrimination * (ability - difficulty));
+}
+
+void fq::DifficultyIndex::build(const std::vector<fq::Question *> &questions)
+{
+    buckets.clear();
+    if (questions.empty())
+        return;
+    minDifficulty = std::numeric_limits<double>::infinity();
+    double maxDifficulty = -std::numeric_limits<double>::infinity();
+    minDiscrimination = std::numeric_limits<double>::infinity();
+    maxDiscrimination = 0.0;
+    for (const auto &question : questions)
+    {
+        minDifficulty = std::min(minDifficulty, question->getDifficulty());
+        maxDifficulty = std::max(maxDifficulty, question->getDifficulty());
+        minDiscrimination = std::min(minDiscrimination, question->getDiscrimination());
+        maxDiscrimination = std::max(maxDiscrimination, question->getDiscrimination());
+    }
+    bucketWidth = std::max(defaultBucketWidth, (maxDifficulty - minDifficulty) / static_cast<double>(maxBuckets - 1));
+    buckets.resize(static_cast<std::size_t>((maxDifficulty - minDifficulty) / bucketWidth) + 1);
+    for (std::size_t slot = 0; slot < questions.size(); ++slot)
+    {
+        const auto &question = questions[slot];
+        auto index = std::min(buckets.size() - 1, static_cast<std::size_t>((question->getDifficulty() - minDifficulty) / bucketWidth));
+        Bucket &bucket = buckets[index];
+        bucket.items.push_back({question->getDiscrimination(), question->getDifficulty(), static_cast<std::uint32_t>(slot)});
+        bucket.minDiscrimination = std::min(bucket.minDiscrimination, question->getDiscrimination());
+        bucket.maxDiscrimination = std::max(bucket.maxDiscrimination, question->getDiscrimination());
+    }
+    for (auto &bucket : buckets)
+    {
+        std::sort(bucket.items.begin(), bucket.items.end(), [](const Item &a, const Item &b)
+                  { return a.discrimination > b.discrimination; });
+    }
+}
+
+bool fq::DifficultyIndex::selectMaximumInformation(double ability, const Bitset &available, std::uint32_t &slot) const
+{
+    if (buckets.empty() || available.empty())
+        return false;
+    const long long count = static_cast<long long>(buckets.size());
+    long long center = static_cast<long long>(std::floor((ability - minDifficulty) / bucketWidth));
+    center = std::max(0LL, std::min(count - 1, center));
+    double bestInformation = -1.0;
+    bool found = false;
+
+    auto searchBucket = [&](long long index)
+    {
+        const Bucket &bucket = buckets[static_cast<std::size_t>(index)];
+        if (bucket.items.empty())
+            return;
+        double low = minDifficulty + static_cast<double>(index) * bucketWidth;
+        double high = low + bucketWidth;
+        double distance = ability < low ? low - ability : (ability > high ? ability - high : 0.0);
+        double bound = bucket.maxDiscrimination * bucket.maxDiscrimination * logisticSlope(bucket.minDiscrimination * distance);
+        if (bound <= bestInformation)
+            return;
+        for (const auto &item : bucket.items)
+        {
+            // P(1 - P) never exceeds 1/4, so no later (less discriminating) item can do better.
+            if (item.discrimination * item.discrimination * 0.25 <= bestInformation)
+                break;
+            if (!available.contains(item.slot))
+                continue;
+            double itemInformation = information(item.discrimination, item.difficulty, ability);
+            if (itemInformation > bestInformation)
+            {
+                bestInformation = itemInformation;
+                slot = item.slot;
+                found = true;
+            }
+        }
+    };
+
+    for (long long distance = 0;; ++distance)
+    {
+        bool inRange = false;
+        if (center - distance >= 0)
+        {
+            inRange = true;
+            searchBucket(center - distance);
+        }
+        if (distance && center + distance < count)
+        {
+            inRange = true;
+            searchBucket(center + distance);
+        }
+        if (!inRange)
+            break;
+        // Every bucket further away is at least this far from the ability.
+        double bound = maxDiscrimination * maxDiscrimination * logisticSlope(minDiscrimination * static_cast<double>(distance) * bucketWidth);
+        if (found && bound <= bestInformation)
+            break;
+    }
+    return found;
+}
+
+std::size_t fq::DifficultyIndex::memoryUsage() const
+{
+    std::size_t bytes = buckets.capacity() * sizeof(Bucket);
+    for (const auto &bucket : buckets)
+        bytes += bucket.items.capacity() * sizeof(Item);
+    return bytes;
+}
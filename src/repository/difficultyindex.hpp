@@ -0,0 +1,102 @@
+/// @file difficultyindex.hpp
+/// @brief Contains the definition of an index of questions bucketed by difficulty, used for adaptive testing.
+
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "bitset.hpp"
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Index of questions bucketed by difficulty, answering maximum Fisher information queries.
+    /// @details Questions are modelled with the two-parameter logistic item response model, using their difficulty
+    /// and discrimination. The information of a question peaks when its difficulty equals the ability of the learner,
+    /// so the search starts in the bucket containing the ability and moves outwards, skipping every bucket whose
+    /// upper bound of information cannot beat the best question found so far. Within a bucket, questions are sorted
+    /// by discrimination, which bounds their information as well.
+    class DifficultyIndex
+    {
+        /// @brief A question stored in the index.
+        struct Item
+        {
+            double discrimination;
+            double difficulty;
+            std::uint32_t slot;
+        };
+
+        /// @brief Questions with difficulties in one interval, sorted by decreasing discrimination.
+        struct Bucket
+        {
+            std::vector<Item> items;
+            double minDiscrimination = std::numeric_limits<double>::infinity();
+            double maxDiscrimination = 0.0;
+        };
+
+        /// @brief Width of a bucket on the difficulty scale.
+        static constexpr double defaultBucketWidth = 0.25;
+
+        /// @brief Maximum number of buckets. Wider buckets are used if the difficulties span a larger range.
+        static constexpr std::size_t maxBuckets = 4096;
+
+        /// @brief The buckets, in order of increasing difficulty.
+        std::vector<Bucket> buckets;
+
+        /// @brief Lower end of the difficulty interval of the first bucket.
+        double minDifficulty;
+
+        /// @brief Width of a bucket on the difficulty scale.
+        double bucketWidth;
+
+        /// @brief Smallest discrimination of all indexed questions.
+        double minDiscrimination;
+
+        /// @brief Largest discrimination of all indexed questions.
+        double maxDiscrimination;
+
+        /// @brief Returns P(1 - P) of the logistic curve at the specified distance from its centre.
+        static double logisticSlope(double x);
+
+    public:
+        /// @brief Constructs an empty index.
+        DifficultyIndex() : minDifficulty(0.0), bucketWidth(defaultBucketWidth), minDiscrimination(0.0), maxDiscrimination(0.0) {}
+
+        /// @brief Rebuilds the index for the specified question collection.
+        /// @param questions The questions to be indexed. The slot of a question is its position in the vector.
+        void build(const std::vector<fq::Question *> &questions);
+
+        /// @brief Returns the probability of a correct answer under the two-parameter logistic model.
+        /// @param discrimination The discrimination of the question.
+        /// @param difficulty The difficulty of the question.
+        /// @param ability The ability of the learner.
+        /// @return The probability of a correct answer.
+        static double probability(double discrimination, double difficulty, double ability);
+
+        /// @brief Returns the Fisher information of a question at the specified ability.
+        /// @param discrimination The discrimination of the question.
+        /// @param difficulty The difficulty of the question.
+        /// @param ability The ability of the learner.
+        /// @return The Fisher information of the question.
+        static double information(double discrimination, double difficulty, double ability);
+
+        /// @brief Finds the available question with the maximum Fisher information at the specified ability.
+        /// @param ability The ability of the learner.
+        /// @param available Slots of the questions which may be selected.
+        /// @param slot Set to the slot of the selected question.
+        /// @return true if a question was selected; false if no indexed question is available.
+        bool selectMaximumInformation(double ability, const Bitset &available, std::uint32_t &slot) const;
+
+        /// @brief Returns the number of bytes used by the index, excluding the object itself.
+        std::size_t memoryUsage() const;
+    };
+}
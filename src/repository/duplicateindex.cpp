@@ -0,0 +1,257 @@
+#include "duplicateindex.hpp"
+#include "memoryusage.hpp"
+#include <array>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <bitset>
+
+namespace
+{
+    /// @brief Smallest number of questions worth handing to another thread.
+    constexpr std::size_t minChunkSize = 4096;
+
+    /// @brief Scrambles a 64-bit value (the finalizer of SplitMix64).
+    std::uint64_t mix(std::uint64_t value)
+    {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    /// @brief Adds the words and word pairs of a text to the bit weights of a signature.
+    /// @details Words are runs of ASCII letters and digits, compared ignoring case, and of non-ASCII characters.
+    void addFeatures(const std::string &text, std::array<int, 64> &weights)
+    {
+        auto addFeature = [&weights](std::uint64_t hash)
+        {
+            hash = mix(hash);
+            for (int bit = 0; bit < 64; ++bit)
+                weights[bit] += (hash >> bit) & 1 ? 1 : -1;
+        };
+        std::uint64_t previous = 0, word = 0xcbf29ce484222325ULL;
+        bool inWord = false;
+        for (std::size_t i = 0; i <= text.size(); ++i)
+        {
+            unsigned char c = i < text.size() ? static_cast<unsigned char>(text[i]) : ' ';
+            bool wordCharacter = c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            if (wordCharacter)
+            {
+                if (c >= 'A' && c <= 'Z')
+                    c = static_cast<unsigned char>(c - 'A' + 'a');
+                word = (word ^ c) * 0x100000001b3ULL;
+                inWord = true;
+                continue;
+            }
+            if (!inWord)
+                continue;
+            addFeature(word);
+            if (previous)
+                addFeature(previous * 31 + word);
+            previous = word;
+            word = 0xcbf29ce484222325ULL;
+            inWord = false;
+        }
+    }
+
+    /// @brief Turns the bit weights of a signature into the signature.
+    std::uint64_t toSignature(const std::array<int, 64> &weights)
+    {
+        std::uint64_t signature = 0;
+        for (int bit = 0; bit < 64; ++bit)
+        {
+            if (weights[bit] > 0)
+                signature |= std::uint64_t(1) << bit;
+        }
+        return signature;
+    }
+
+    /// @brief Returns the number of bits in which two signatures differ.
+    int distance(std::uint64_t a, std::uint64_t b)
+    {
+        return static_cast<int>(std::bitset<64>(a ^ b).count());
+    }
+
+    /// @brief Runs a function on every index below a count, split into contiguous ranges across threads.
+    template <typename Function>
+    void parallelFor(std::size_t count, unsigned threads, std::size_t minChunk, Function function)
+    {
+        if (!threads)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, count / minChunk));
+        auto run = [&](std::size_t chunk)
+        {
+            for (std::size_t i = count * chunk / chunks; i < count * (chunk + 1) / chunks; ++i)
+                function(i);
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+            workers.emplace_back(run, chunk);
+        run(0);
+        for (auto &worker : workers)
+            worker.join();
+    }
+}
+
+fq::DuplicateIndex::DuplicateIndex(int maxDistance) : maxDistance(maxDistance)
+{
+    if (maxDistance < 0 || maxDistance > 15)
+        throw std::invalid_argument("Near-duplicate distance must be between 0 and 15");
+    bandBits = 64 / (maxDistance + 1);
+    buckets.resize(static_cast<std::size_t>(maxDistance + 1));
+}
+
+std::uint64_t fq::DuplicateIndex::band(std::uint64_t signature, std::size_t index) const
+{
+    // With a distance of 0 the only band is the whole signature, which must not be shifted by 64 bits.
+    if (bandBits >= 64)
+        return signature;
+    return (signature >> (index * bandBits)) & ((std::uint64_t(1) << bandBits) - 1);
+}
+
+void fq::DuplicateIndex::build(const std::vector<fq::Question *> &questions_, unsigned threads)
+{
+    questions.assign(questions_.begin(), questions_.end());
+    signatures.assign(questions.size(), 0);
+    parallelFor(questions.size(), threads, minChunkSize, [this](std::size_t slot)
+                { signatures[slot] = signature(questions[slot]->getQuestion()); });
+
+    // Every band has its own buckets, so the bands are filled in parallel.
+    for (auto &map : buckets)
+        map.clear();
+    parallelFor(buckets.size(), threads, 1, [this](std::size_t index)
+                {
+        auto &map = buckets[index];
+        for (std::uint32_t slot = 0; slot < signatures.size(); ++slot)
+            map[band(signatures[slot], index)].push_back(slot); });
+}
+
+void fq::DuplicateIndex::add(const fq::Question *question)
+{
+    auto slot = static_cast<std::uint32_t>(questions.size());
+    questions.push_back(question);
+    signatures.push_back(signature(question->getQuestion()));
+    for (std::size_t index = 0; index < buckets.size(); ++index)
+        buckets[index][band(signatures.back(), index)].push_back(slot);
+}
+
+std::vector<fq::DuplicateIndex::Similar> fq::DuplicateIndex::find(const std::string &text, std::size_t limit) const
+{
+    std::uint64_t query = signature(text);
+    std::vector<std::uint32_t> candidates;
+    for (std::size_t index = 0; index < buckets.size(); ++index)
+    {
+        auto it = buckets[index].find(band(query, index));
+        if (it != buckets[index].end())
+            candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    std::vector<Similar> similar;
+    for (auto slot : candidates)
+    {
+        int d = distance(query, signatures[slot]);
+        if (d <= maxDistance)
+            similar.push_back({questions[slot], d});
+    }
+    std::stable_sort(similar.begin(), similar.end(), [](const Similar &a, const Similar &b)
+                     { return a.distance < b.distance; });
+    if (similar.size() > limit)
+        similar.resize(limit);
+    return similar;
+}
+
+std::vector<fq::DuplicateIndex::Match> fq::DuplicateIndex::findDuplicates(unsigned threads) const
+{
+    std::vector<std::pair<std::size_t, const std::vector<std::uint32_t> *>> work;
+    for (std::size_t index = 0; index < buckets.size(); ++index)
+    {
+        for (const auto &bucket : buckets[index])
+        {
+            if (bucket.second.size() > 1)
+                work.emplace_back(index, &bucket.second);
+        }
+    }
+
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(work.size() / 256, 1)));
+    std::vector<std::vector<Match>> found(threads);
+    std::atomic<std::size_t> next(0);
+    auto scan = [&](unsigned thread)
+    {
+        std::vector<std::uint32_t> sorted;
+        for (std::size_t item = next++; item < work.size(); item = next++)
+        {
+            std::size_t index = work[item].first;
+            const std::vector<std::uint32_t> *slots = work[item].second;
+            if (slots->size() > maxBucketScan)
+            {
+                sorted = *slots;
+                std::sort(sorted.begin(), sorted.end(), [this](std::uint32_t a, std::uint32_t b)
+                          { return signatures[a] < signatures[b]; });
+                slots = &sorted;
+            }
+            for (std::size_t i = 0; i < slots->size(); ++i)
+            {
+                std::size_t end = std::min(slots->size(), i + 1 + maxBucketScan);
+                for (std::size_t j = i + 1; j < end; ++j)
+                {
+                    std::uint32_t a = std::min((*slots)[i], (*slots)[j]), b = std::max((*slots)[i], (*slots)[j]);
+                    int d = distance(signatures[a], signatures[b]);
+                    if (d > maxDistance)
+                        continue;
+                    // A pair sharing several bands is reported only by the first of them in which all pairs of the
+                    // bucket were compared; larger buckets only compare neighbours and may have missed it.
+                    bool reported = false;
+                    for (std::size_t earlier = 0; earlier < index && !reported; ++earlier)
+                    {
+                        std::uint64_t value = band(signatures[a], earlier);
+                        reported = value == band(signatures[b], earlier) && buckets[earlier].at(value).size() <= maxBucketScan;
+                    }
+                    if (!reported)
+                        found[thread].push_back({a, b, d});
+                }
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned thread = 1; thread < threads; ++thread)
+        workers.emplace_back(scan, thread);
+    scan(0);
+    for (auto &worker : workers)
+        worker.join();
+
+    std::vector<Match> matches;
+    for (auto &part : found)
+        matches.insert(matches.end(), part.begin(), part.end());
+    std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b)
+              { return a.first != b.first ? a.first < b.first : a.second < b.second; });
+    // Pairs found as neighbours in the large buckets of several bands are reported by each of them.
+    matches.erase(std::unique(matches.begin(), matches.end(), [](const Match &a, const Match &b)
+                              { return a.first == b.first && a.second == b.second; }),
+                  matches.end());
+    return matches;
+}
+
+std::uint64_t fq::DuplicateIndex::signature(const std::string &text)
+{
+    std::array<int, 64> weights{};
+    addFeatures(text, weights);
+    return toSignature(weights);
+}
+
+std::size_t fq::DuplicateIndex::memoryUsage() const
+{
+    std::size_t bytes = questions.capacity() * sizeof(const fq::Question *) + signatures.capacity() * sizeof(std::uint64_t);
+    bytes += buckets.capacity() * sizeof(buckets.front());
+    for (const auto &bandBuckets : buckets)
+    {
+        bytes += MemoryUsage::hashMapBytes(bandBuckets);
+        for (const auto &it : bandBuckets)
+            bytes += it.second.capacity() * sizeof(std::uint32_t);
+    }
+    return bytes;
+}
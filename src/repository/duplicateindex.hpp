@@ -0,0 +1,127 @@
+/// @file duplicateindex.hpp
+/// @brief Contains the definition of an index finding near-duplicate questions by their SimHash signatures.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <stdexcept>
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Index of near-duplicate questions, e.g. reworded copies of the same question.
+    /// @details Every question is summarized by a 64-bit SimHash of the words and word pairs of its text (ignoring case
+    /// and punctuation); similar texts get signatures differing in few bits. The answers are left out, so a question
+    /// is flagged while its text is still being typed.
+    /// Two questions are near-duplicates if their signatures differ in at most maxDistance bits. To find them without
+    /// comparing every pair, the signature is cut into maxDistance + 1 bands and the questions are bucketed by each
+    /// band (locality-sensitive hashing): near-duplicates always share at least one band, so only questions in the
+    /// same bucket are compared. With a distance of 0 the only band is the whole signature, so only questions with
+    /// equal signatures are compared.
+    class DuplicateIndex
+    {
+    public:
+        /// @brief Default number of differing signature bits up to which questions are near-duplicates.
+        static constexpr int defaultMaxDistance = 3;
+
+        /// @brief A pair of near-duplicate questions.
+        struct Match
+        {
+            /// @brief The slot of the first question.
+            std::uint32_t first = 0;
+
+            /// @brief The slot of the second question, greater than first.
+            std::uint32_t second = 0;
+
+            /// @brief The number of differing signature bits.
+            int distance = 0;
+        };
+
+        /// @brief A question similar to a queried text.
+        struct Similar
+        {
+            /// @brief The similar question.
+            const fq::Question *question = nullptr;
+
+            /// @brief The number of differing signature bits.
+            int distance = 0;
+        };
+
+    private:
+        /// @brief Questions compared with each other at most within one bucket; larger buckets only compare neighbours
+        /// in signature order.
+        static constexpr std::size_t maxBucketScan = 64;
+
+        /// @brief The indexed questions, indexed by slot.
+        std::vector<const fq::Question *> questions;
+
+        /// @brief The signatures of the questions, indexed by slot.
+        std::vector<std::uint64_t> signatures;
+
+        /// @brief The number of differing bits up to which questions are near-duplicates.
+        int maxDistance;
+
+        /// @brief The width of a band, in bits.
+        int bandBits;
+
+        /// @brief The slots of the questions, keyed by the value of a band; one map per band.
+        std::vector<std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>> buckets;
+
+        /// @brief Returns the value of a band of a signature.
+        std::uint64_t band(std::uint64_t signature, std::size_t index) const;
+
+    public:
+        /// @brief Constructs an empty index.
+        /// @param maxDistance The number of differing signature bits up to which questions are near-duplicates.
+        /// @throws std::invalid_argument if maxDistance is not between 0 and 15.
+        explicit DuplicateIndex(int maxDistance = defaultMaxDistance);
+
+        /// @brief Rebuilds the index for the specified questions.
+        /// @param questions_ The questions to be indexed. The slot of a question is its position in the vector.
+        /// @param threads The number of threads, or 0 to use one per core.
+        void build(const std::vector<fq::Question *> &questions_, unsigned threads = 0);
+
+        /// @brief Adds a question to the index, in the next slot.
+        /// @param question A pointer to the Question object. It must outlive the index.
+        void add(const fq::Question *question);
+
+        /// @brief Returns the indexed questions similar to a question being written.
+        /// @param text The text of the question.
+        /// @param limit The largest number of questions returned.
+        /// @return The similar questions, most similar first.
+        std::vector<Similar> find(const std::string &text, std::size_t limit) const;
+
+        /// @brief Finds all pairs of near-duplicate questions of the index.
+        /// @param threads The number of threads, or 0 to use one per core.
+        /// @return The pairs, ordered by their slots.
+        std::vector<Match> findDuplicates(unsigned threads = 0) const;
+
+        /// @brief Returns the question in the specified slot.
+        /// @param slot A slot smaller than size().
+        const fq::Question *at(std::uint32_t slot) const { return questions[slot]; }
+
+        /// @brief Returns the number of indexed questions.
+        std::size_t size() const { return questions.size(); }
+
+        /// @brief Returns the number of bytes used by the index, excluding the object itself.
+        std::size_t memoryUsage() const;
+
+        /// @brief Returns the SimHash signature of a question text.
+        /// @param text The text of the question.
+        static std::uint64_t signature(const std::string &text);
+
+        /// @brief Converts a signature distance to a similarity between 0 and 1.
+        /// @param distance The number of differing signature bits.
+        static double similarity(int distance) { return 1.0 - distance / 64.0; }
+    };
+}
@@ -0,0 +1,202 @@
+#include "editlog.hpp"
+#include <unordered_set>
+#include <string_view>
+
+fq::EditLog::EditLog(std::shared_ptr<const QuestionBank> base) : base(std::move(base)), done(0)
+{
+    if (!this->base)
+        throw std::invalid_argument("Edit log requires a question bank");
+}
+
+std::shared_ptr<fq::Question> fq::EditLog::owner(const fq::Question *question) const
+{
+    if (auto shared = base->share(question))
+        return shared;
+    auto it = created.find(question);
+    if (it == created.end())
+        throw std::invalid_argument("Question is not in the edited bank: " + question->getQuestion());
+    return it->second;
+}
+
+const fq::EditLog::Command &fq::EditLog::record(Command command)
+{
+    // Questions added by the discarded commands can only be referenced by those commands, which are newer than any
+    // command kept, so they are released with them.
+    for (std::size_t c = done; c < commands.size(); ++c)
+    {
+        for (const auto &change : commands[c].changes)
+        {
+            if (change.after)
+                created.erase(change.after.get());
+        }
+    }
+    commands.resize(done);
+    commands.push_back(std::move(command));
+    apply(commands.back(), false);
+    return commands[done++];
+}
+
+void fq::EditLog::apply(const Command &command, bool revert)
+{
+    snapshot.reset();
+    auto setText = [this](const std::string &text, Question *question)
+    {
+        Question *original = base->find(text);
+        if (original == question)
+        {
+            overlay.erase(text);
+            return;
+        }
+        auto [it, inserted] = overlay.try_emplace(text, question);
+        // A text which is not in the bank goes to the end of the list whenever a question takes it.
+        if (question && !original && (inserted || !it->second))
+            appended.push_back(text);
+        it->second = question;
+    };
+    auto applyChange = [&setText](const Change &change, bool revert)
+    {
+        const auto &from = revert ? change.after : change.before;
+        const auto &to = revert ? change.before : change.after;
+        if (from)
+            setText(from->getQuestion(), nullptr);
+        if (to)
+            setText(to->getQuestion(), to.get());
+    };
+    if (revert)
+    {
+        for (auto it = command.changes.rbegin(); it != command.changes.rend(); ++it)
+            applyChange(*it, true);
+    }
+    else
+    {
+        for (const auto &change : command.changes)
+            applyChange(change, false);
+    }
+}
+
+const fq::EditLog::Command &fq::EditLog::add(const std::vector<fq::Question *> &questions, const std::string &description)
+{
+    Command command{description, {}};
+    command.changes.reserve(questions.size());
+    for (auto *question : questions)
+    {
+        std::shared_ptr<Question> shared(question);
+        created.emplace(question, shared);
+        command.changes.push_back({nullptr, std::move(shared)});
+    }
+    return record(std::move(command));
+}
+
+const fq::EditLog::Command &fq::EditLog::remove(const std::vector<const fq::Question *> &questions, const std::string &description)
+{
+    Command command{description, {}};
+    command.changes.reserve(questions.size());
+    for (const auto *question : questions)
+        command.changes.push_back({owner(question), nullptr});
+    return record(std::move(command));
+}
+
+const fq::EditLog::Command &fq::EditLog::edit(const fq::Question *question, fq::Question *replacement, const std::string &description)
+{
+    std::shared_ptr<Question> shared(replacement);
+    std::shared_ptr<Question> previous = owner(question);
+    created.emplace(replacement, shared);
+    return record({description, {{std::move(previous), std::move(shared)}}});
+}
+
+const fq::EditLog::Command *fq::EditLog::undo()
+{
+    if (!canUndo())
+        return nullptr;
+    apply(commands[--done], true);
+    return &commands[done];
+}
+
+const fq::EditLog::Command *fq::EditLog::redo()
+{
+    if (!canRedo())
+        return nullptr;
+    apply(commands[done], false);
+    return &commands[done++];
+}
+
+fq::Question *fq::EditLog::find(const std::string &text) const
+{
+    auto it = overlay.find(text);
+    return it != overlay.end() ? it->second : base->find(text);
+}
+
+std::shared_ptr<const std::vector<fq::Question *>> fq::EditLog::getQuestions() const
+{
+    if (snapshot)
+        return snapshot;
+    if (overlay.empty())
+    {
+        appended.clear();
+        // The list shares the ownership of the bank, which holds it.
+        snapshot = std::shared_ptr<const std::vector<Question *>>(base, &base->getQuestions());
+        return snapshot;
+    }
+    auto questions = std::make_shared<std::vector<Question *>>();
+    questions->reserve(base->size() + overlay.size());
+    std::unordered_set<std::string_view> placed;
+    for (auto *question : base->getQuestions())
+    {
+        auto it = overlay.find(question->getQuestion());
+        if (it == overlay.end())
+            questions->push_back(question);
+        else if (it->second)
+        {
+            questions->push_back(it->second);
+            placed.insert(it->first);
+        }
+    }
+    // The other questions follow in the order they took their texts; texts given up since are dropped.
+    std::vector<std::string> live;
+    live.reserve(appended.size());
+    for (auto &text : appended)
+    {
+        auto it = overlay.find(text);
+        if (it == overlay.end() || !it->second || !placed.insert(it->first).second)
+            continue;
+        questions->push_back(it->second);
+        live.push_back(std::move(text));
+    }
+    appended = std::move(live);
+    snapshot = std::move(questions);
+    return snapshot;
+}
+
+std::vector<fq::EditLog::Change> fq::EditLog::net() const
+{
+    std::vector<Change> changes;
+    // Position in changes of the change leading to the current version of each changed question.
+    std::unordered_map<const Question *, std::size_t> latest;
+    for (std::size_t c = 0; c < done; ++c)
+    {
+        for (const auto &change : commands[c].changes)
+        {
+            auto it = change.before ? latest.find(change.before.get()) : latest.end();
+            if (it == latest.end())
+            {
+                if (change.after)
+                    latest[change.after.get()] = changes.size();
+                changes.push_back(change);
+                continue;
+            }
+            std::size_t position = it->second;
+            latest.erase(it);
+            changes[position].after = change.after;
+            if (change.after)
+                latest[change.after.get()] = position;
+        }
+    }
+    std::vector<Change> result;
+    result.reserve(changes.size());
+    for (auto &change : changes)
+    {
+        if (change.before || change.after)
+            result.push_back(std::move(change));
+    }
+    return result;
+}
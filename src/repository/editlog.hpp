@@ -0,0 +1,161 @@
+/// @file editlog.hpp
+/// @brief Contains the definition of an undoable log of edits to the questions of a repository.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <stdexcept>
+#include "question.hpp"
+#include "questionbank.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Log of the commands adding, removing and editing questions of a bank, with undo and redo.
+    /// @details The log is a copy-on-write working copy of the bank: starting it only takes a reference to the
+    /// immutable bank, and the questions as edited are the questions of the bank seen through a small overlay of the
+    /// changed texts. Edited questions are never modified; an edit is a new question replacing the old one, so sessions
+    /// still reading the bank are unaffected. Every command stores only the questions it changes, so recording, undoing
+    /// and redoing a command takes time proportional to the questions it changes, not to the size of the bank. The
+    /// commands which are done are applied to a repository in one batch by Repository::applyEdits, which only needs
+    /// their combined effect (see net). Questions added through the log are owned by it until then.
+    class EditLog
+    {
+    public:
+        /// @brief The change of one question.
+        /// @details before is nullptr for an added question and after is nullptr for a removed one.
+        struct Change
+        {
+            /// @brief The question before the change.
+            std::shared_ptr<fq::Question> before;
+
+            /// @brief The question after the change.
+            std::shared_ptr<fq::Question> after;
+        };
+
+        /// @brief A command, undone and redone as a whole.
+        struct Command
+        {
+            /// @brief Description of the command, e.g. "remove 3 questions".
+            std::string description;
+
+            /// @brief The changes of the command, in the order they were made.
+            std::vector<Change> changes;
+        };
+
+    private:
+        /// @brief The bank the commands are applied to.
+        std::shared_ptr<const QuestionBank> base;
+
+        /// @brief Owners of the questions added by the commands, keyed by question.
+        std::unordered_map<const fq::Question *, std::shared_ptr<fq::Question>> created;
+
+        /// @brief The commands, oldest first. Commands from done on were undone and can be redone.
+        std::vector<Command> commands;
+
+        /// @brief The number of commands which are done.
+        std::size_t done;
+
+        /// @brief The questions as edited, keyed by the texts changed by the commands which are done. nullptr marks a
+        /// text which no question has any more. Texts not in the overlay are looked up in the bank.
+        std::unordered_map<std::string, fq::Question *> overlay;
+
+        /// @brief Texts of the overlay which are not in the bank, in the order a question took them. Texts which no
+        /// question has any more are dropped when the questions are listed.
+        mutable std::vector<std::string> appended;
+
+        /// @brief The questions as edited, as last returned by getQuestions, or nullptr if a command changed them since.
+        mutable std::shared_ptr<const std::vector<fq::Question *>> snapshot;
+
+        /// @brief Applies the changes of a command to the overlay, or reverts them.
+        void apply(const Command &command, bool revert);
+
+        /// @brief Returns the owner of a question of the bank or of a question added by a command.
+        /// @throws std::invalid_argument if the question is neither.
+        std::shared_ptr<fq::Question> owner(const fq::Question *question) const;
+
+        /// @brief Appends a command, discarding the commands which can be redone and the questions they added.
+        const Command &record(Command command);
+
+    public:
+        /// @brief Constructs an empty log of edits to a bank.
+        /// @param base The bank the commands are applied to.
+        /// @throws std::invalid_argument if base is nullptr.
+        explicit EditLog(std::shared_ptr<const QuestionBank> base);
+
+        /// @brief Records a command adding questions.
+        /// @param questions The questions to add. Their texts must not be taken yet (see find). The log takes ownership
+        /// of them.
+        /// @param description Description of the command.
+        /// @return The recorded command.
+        const Command &add(const std::vector<fq::Question *> &questions, const std::string &description);
+
+        /// @brief Records a command removing questions.
+        /// @param questions The questions to remove, from the bank or added by earlier commands.
+        /// @param description Description of the command.
+        /// @return The recorded command.
+        /// @throws std::invalid_argument if a question is neither in the bank nor added by a command.
+        const Command &remove(const std::vector<const fq::Question *> &questions, const std::string &description);
+
+        /// @brief Records a command replacing a question by an edited version.
+        /// @param question The question to replace, from the bank or added by an earlier command.
+        /// @param replacement The edited question. Its text must be the text of the question or not be taken yet. The
+        /// log takes ownership of it.
+        /// @param description Description of the command.
+        /// @return The recorded command.
+        /// @throws std::invalid_argument if the question is neither in the bank nor added by a command.
+        const Command &edit(const fq::Question *question, fq::Question *replacement, const std::string &description);
+
+        /// @brief Undoes the last command which is done.
+        /// @return The undone command, or nullptr if there is none.
+        const Command *undo();
+
+        /// @brief Redoes the last undone command.
+        /// @return The redone command, or nullptr if there is none.
+        const Command *redo();
+
+        /// @brief Returns the question with the specified text, as edited.
+        /// @param text The text of the question.
+        /// @return A pointer to the question, or nullptr if no question has this text.
+        fq::Question *find(const std::string &text) const;
+
+        /// @brief Returns the questions as edited.
+        /// @details The list is shared and immutable: it is built at most once after every command, in time
+        /// proportional to the size of the bank, and later calls return the same list. Without edits it is the list of
+        /// the bank itself, so nothing is copied. Commands build a new list and leave lists returned before unchanged.
+        /// @return The questions of the bank in their order, with edited questions in the place of the originals they
+        /// kept the text of, followed by the other added and edited questions in the order they were added.
+        std::shared_ptr<const std::vector<fq::Question *>> getQuestions() const;
+
+        /// @brief Returns whether a command can be undone.
+        bool canUndo() const { return done > 0; }
+
+        /// @brief Returns whether a command can be redone.
+        bool canRedo() const { return done < commands.size(); }
+
+        /// @brief Returns the description of the command undo would undo, or an empty string.
+        std::string undoDescription() const { return canUndo() ? commands[done - 1].description : std::string(); }
+
+        /// @brief Returns the description of the command redo would redo, or an empty string.
+        std::string redoDescription() const { return canRedo() ? commands[done].description : std::string(); }
+
+        /// @brief Returns the bank the commands are applied to.
+        const std::shared_ptr<const QuestionBank> &getBase() const { return base; }
+
+        /// @brief Returns the combined effect of the commands which are done.
+        /// @details Changes of the same question are merged into one, from its version in the bank to its last
+        /// version, and questions added and removed again are left out.
+        /// @return One change per changed question: removed and edited questions of the bank, and added questions in
+        /// the order they were added.
+        std::vector<Change> net() const;
+    };
+}
@@ -0,0 +1,195 @@
+#include "exam.hpp"
+
+fq::ExamGenerator::ExamGenerator(const Repository &repository)
+    : bank(repository.getBank()), questions(bank->getQuestions())
+{
+    difficulties.reserve(questions.size());
+    for (std::size_t slot = 0; slot < questions.size(); ++slot)
+    {
+        difficulties.push_back(questions[slot]->getDifficulty());
+        typeSlots[questions[slot]->getType()].add(static_cast<std::uint32_t>(slot));
+    }
+}
+
+void fq::ExamGenerator::choose(Paper &paper, Bitset &candidates, const ExamConstraints &constraints, std::mt19937 &generator) const
+{
+    std::uniform_int_distribution<std::size_t> dis(0, candidates.size() - 1);
+    std::uint32_t slot = candidates.select(dis(generator));
+    if (constraints.targetDifficulty)
+    {
+        // Steer the running mean towards the target: of a few random candidates, take the one closest to
+        // the difficulty which would bring the mean exactly on target.
+        double desired = *constraints.targetDifficulty * static_cast<double>(paper.slots.size() + 1) - paper.difficultySum;
+        double bestDistance = std::abs(difficulties[slot] - desired);
+        for (int i = 1; i < difficultyChoices; ++i)
+        {
+            std::uint32_t candidate = candidates.select(dis(generator));
+            double distance = std::abs(difficulties[candidate] - desired);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                slot = candidate;
+            }
+        }
+    }
+    candidates.remove(slot);
+    paper.available.remove(slot);
+    paper.slots.push_back(slot);
+    paper.difficultySum += difficulties[slot];
+}
+
+std::vector<fq::Question *> fq::ExamGenerator::generate(const ExamConstraints &constraints, std::uint64_t seed) const
+{
+    return generate(constraints, seed, 0);
+}
+
+std::vector<fq::Question *> fq::ExamGenerator::generate(const ExamConstraints &constraints, std::uint64_t seed, std::uint64_t salt) const
+{
+    if (constraints.questionCount == 0)
+        throw std::invalid_argument("Exam must contain at least one question");
+    std::seed_seq sequence{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                           static_cast<std::uint32_t>(salt), static_cast<std::uint32_t>(salt >> 32)};
+    std::mt19937 generator(sequence);
+    const TagIndex &tagIndex = bank->getTagIndex();
+
+    Paper paper;
+    paper.available = tagIndex.evaluate(constraints.filter);
+    if (paper.available.size() < constraints.questionCount)
+        throw std::invalid_argument("Exam needs " + std::to_string(constraints.questionCount) + " questions, but only " +
+                                    std::to_string(paper.available.size()) + " are available");
+    paper.slots.reserve(constraints.questionCount);
+
+    // Fill the rarest tags first, so that questions carrying several tags are not used up by common ones.
+    std::vector<std::pair<Bitset, std::pair<std::string, std::size_t>>> quotas;
+    for (const auto &quota : constraints.tagQuotas)
+        quotas.push_back({tagIndex.getSlots(quota.first) & paper.available, quota});
+    std::sort(quotas.begin(), quotas.end(), [](const auto &a, const auto &b)
+              { return a.first.size() < b.first.size(); });
+    for (auto &quota : quotas)
+    {
+        const std::string &tag = quota.second.first;
+        std::size_t have = 0;
+        for (auto slot : paper.slots)
+        {
+            const auto &tags = questions[slot]->getTags();
+            if (std::find(tags.begin(), tags.end(), tag) != tags.end())
+                ++have;
+        }
+        Bitset candidates = quota.first & paper.available;
+        if (have + candidates.size() < quota.second.second)
+            throw std::invalid_argument("Not enough questions tagged '" + tag + "' to satisfy its quota");
+        for (; have < quota.second.second; ++have)
+            choose(paper, candidates, constraints, generator);
+    }
+    if (paper.slots.size() > constraints.questionCount)
+        throw std::invalid_argument("Tag quotas need more questions than the exam contains");
+
+    if (constraints.balanceTypes)
+    {
+        std::vector<std::pair<Bitset, std::size_t>> types;
+        for (const auto &type : typeSlots)
+        {
+            std::size_t used = 0;
+            for (auto slot : paper.slots)
+                used += type.second.contains(slot);
+            Bitset candidates = type.second & paper.available;
+            if (!candidates.empty())
+                types.push_back({std::move(candidates), used});
+        }
+        // Always take the next question from the least represented type which still has candidates.
+        while (paper.slots.size() < constraints.questionCount)
+        {
+            std::pair<Bitset, std::size_t> *least = nullptr;
+            for (auto &type : types)
+            {
+                if (!type.first.empty() && (least == nullptr || type.second < least->second))
+                    least = &type;
+            }
+            choose(paper, least->first, constraints, generator);
+            ++least->second;
+        }
+    }
+    else
+    {
+        Bitset candidates = paper.available;
+        while (paper.slots.size() < constraints.questionCount)
+            choose(paper, candidates, constraints, generator);
+    }
+
+    std::shuffle(paper.slots.begin(), paper.slots.end(), generator);
+    std::vector<fq::Question *> result;
+    result.reserve(paper.slots.size());
+    for (auto slot : paper.slots)
+        result.push_back(questions[slot]);
+    return result;
+}
+
+std::vector<std::vector<fq::Question *>> fq::ExamGenerator::generateVariants(const ExamConstraints &constraints, std::size_t count, std::uint64_t seed, unsigned threads) const
+{
+    std::vector<std::vector<fq::Question *>> papers(count);
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(count, 1)));
+
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&]()
+                             {
+            try
+            {
+                for (std::size_t variant = next++; variant < count; variant = next++)
+                    papers[variant] = generate(constraints, seed, variant);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+                next = count;
+            } });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    if (error)
+        std::rethrow_exception(error);
+
+    const std::size_t maxAttempts = 16;
+    std::set<std::vector<fq::Question *>> seen;
+    for (std::size_t variant = 0; variant < count; ++variant)
+    {
+        for (std::size_t attempt = 1;; ++attempt)
+        {
+            std::vector<fq::Question *> key = papers[variant];
+            std::sort(key.begin(), key.end());
+            if (seen.insert(std::move(key)).second || attempt > maxAttempts)
+                break;
+            papers[variant] = generate(constraints, seed, variant + count * attempt);
+        }
+    }
+    return papers;
+}
+
+void fq::ExamGenerator::savePaper(const std::vector<fq::Question *> &paper, const std::string &path, std::uint64_t seed, std::uint64_t variant)
+{
+    std::seed_seq sequence{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                           static_cast<std::uint32_t>(variant), static_cast<std::uint32_t>(variant >> 32)};
+    std::mt19937 generator(sequence);
+    QJsonArray questionsArray;
+    for (const auto &question : paper)
+    {
+        std::unique_ptr<Question> instance = question->instantiate(generator);
+        questionsArray.append(instance ? instance->toJSON() : question->toJSON());
+    }
+    QJsonObject json;
+    json["questions"] = questionsArray;
+    json["type"] = "random_non_repeating";
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly))
+        throw std::runtime_error("Failed to save exam paper: " + path);
+    file.write(QJsonDocument(json).toJson());
+    file.close();
+}
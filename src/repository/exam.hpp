@@ -0,0 +1,122 @@
+/// @file exam.hpp
+/// @brief Contains the definition of a generator of fixed-length exam papers drawn from a repository.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <cmath>
+#include <stdexcept>
+#include "repository.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Constraints an exam paper must satisfy.
+    struct ExamConstraints
+    {
+        /// @brief The number of questions on the paper.
+        std::size_t questionCount = 0;
+
+        /// @brief Minimum number of questions carrying each tag.
+        std::map<std::string, std::size_t> tagQuotas;
+
+        /// @brief Tag expression restricting the questions which may be used. Empty to use all questions.
+        std::string filter;
+
+        /// @brief Whether the question types should be represented as evenly as possible.
+        bool balanceTypes = false;
+
+        /// @brief Target mean difficulty of the paper, if any.
+        std::optional<double> targetDifficulty;
+    };
+
+    /// @brief Generates exam papers satisfying a set of constraints from the questions of a repository.
+    /// @details Candidates are always taken from bitsets of question slots (per tag, per type, not yet used), so
+    /// every question is drawn in constant time per constraint and never rejected. The generator only reads the
+    /// immutable bank of the repository, so many papers can be generated concurrently, and editing the repository
+    /// does not affect a generator created before.
+    class ExamGenerator
+    {
+        /// @brief The bank of the repository the papers are drawn from.
+        /// @details Holding the bank keeps its questions alive and unchanged, even if the repository is edited.
+        std::shared_ptr<const QuestionBank> bank;
+
+        /// @brief The questions of the bank, indexed by slot.
+        std::vector<fq::Question *> questions;
+
+        /// @brief Difficulties of the questions, indexed by slot.
+        std::vector<double> difficulties;
+
+        /// @brief Slots of the questions of each type, keyed by type.
+        std::map<std::string, Bitset> typeSlots;
+
+        /// @brief Number of candidates compared when a question is chosen towards a target difficulty.
+        static constexpr int difficultyChoices = 4;
+
+        /// @brief State of a paper being generated.
+        struct Paper
+        {
+            std::vector<std::uint32_t> slots;
+            Bitset available;
+            double difficultySum = 0.0;
+        };
+
+        /// @brief Chooses a question from the candidates and adds it to the paper.
+        /// @param paper The paper being generated.
+        /// @param candidates Slots which may be chosen. The chosen slot is removed from it.
+        /// @param constraints The constraints of the paper.
+        /// @param generator The random number generator of the paper.
+        void choose(Paper &paper, Bitset &candidates, const ExamConstraints &constraints, std::mt19937 &generator) const;
+
+        /// @brief Generates a paper with a random number generator seeded from the seed and a salt.
+        std::vector<fq::Question *> generate(const ExamConstraints &constraints, std::uint64_t seed, std::uint64_t salt) const;
+
+    public:
+        /// @brief Constructs a generator drawing from the specified repository.
+        /// @param repository The repository the papers are drawn from.
+        explicit ExamGenerator(const Repository &repository);
+
+        /// @brief Generates a single exam paper.
+        /// @param constraints The constraints the paper must satisfy.
+        /// @param seed Seed of the random number generator. The same seed always gives the same paper.
+        /// @return The questions of the paper, in the order they should be presented.
+        /// @throws std::invalid_argument if the constraints cannot be satisfied by the repository.
+        std::vector<fq::Question *> generate(const ExamConstraints &constraints, std::uint64_t seed) const;
+
+        /// @brief Generates distinct variants of an exam paper in parallel.
+        /// @details Variant i is generated from its own random number generator derived from the seed and i, so the
+        /// result does not depend on the number of threads. Variants with the same set of questions as an earlier
+        /// variant are regenerated; if the repository is too small to give enough distinct papers, duplicates remain.
+        /// @param constraints The constraints every paper must satisfy.
+        /// @param count The number of variants.
+        /// @param seed Seed of the whole batch.
+        /// @param threads The number of worker threads. 0 uses one thread per core.
+        /// @return The generated papers.
+        /// @throws std::invalid_argument if the constraints cannot be satisfied by the repository.
+        std::vector<std::vector<fq::Question *>> generateVariants(const ExamConstraints &constraints, std::size_t count, std::uint64_t seed, unsigned threads = 0) const;
+
+        /// @brief Saves an exam paper as a non-repeating repository, so it can be opened in FunQuizz.
+        /// @details Template questions are saved as variants generated for the paper, so every paper of a batch asks
+        /// them with its own values, and the values on a paper do not change when it is opened.
+        /// @param paper The questions of the paper.
+        /// @param path The path of the JSON file to be written.
+        /// @param seed Seed of the batch, used to generate the variants.
+        /// @param variant Index of the paper in the batch, used to generate the variants.
+        /// @throws std::runtime_error if the file cannot be written.
+        static void savePaper(const std::vector<fq::Question *> &paper, const std::string &path, std::uint64_t seed = 0, std::uint64_t variant = 0);
+    };
+}
@@ -0,0 +1,324 @@
+#include "exporter.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+    /// @brief Nesting level selecting compact JSON in JsonWriter and Question::appendJSON.
+    constexpr int compact = -1;
+}
+
+fq::Exporter::Exporter(QIODevice &device, Format format, const Options &options)
+    : device(device), format(format), options(options), count(0), finished(false), generator(options.seed)
+{
+    buffer.reserve(bufferSize + bufferSize / 4);
+    writeHeader();
+}
+
+void fq::Exporter::put(std::string_view text)
+{
+    buffer.append(text);
+    if (buffer.size() >= bufferSize)
+        flush();
+}
+
+void fq::Exporter::flush()
+{
+    if (buffer.empty())
+        return;
+    if (device.write(buffer.data(), static_cast<qint64>(buffer.size())) != static_cast<qint64>(buffer.size()))
+        throw std::runtime_error("Failed to write export: " + device.errorString().toStdString());
+    buffer.clear();
+}
+
+void fq::Exporter::putNumber(double value)
+{
+    put(QByteArray::number(value, 'g', QLocale::FloatingPointShortest).toStdString());
+}
+
+void fq::Exporter::putEscaped(std::string_view text)
+{
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        const char c = text[i];
+        const char *replacement = nullptr;
+        char control[8];
+        switch (format)
+        {
+        case Format::Json:
+            // JSON strings are escaped by JsonWriter.
+            break;
+        case Format::Csv:
+            if (c == '"')
+                replacement = "\"\"";
+            break;
+        case Format::Html:
+            if (c == '&')
+                replacement = "&amp;";
+            else if (c == '<')
+                replacement = "&lt;";
+            else if (c == '>')
+                replacement = "&gt;";
+            else if (c == '"')
+                replacement = "&quot;";
+            else if (c == '\n')
+                replacement = "<br>";
+            break;
+        case Format::Latex:
+            if (c == '\\')
+                replacement = "\\textbackslash{}";
+            else if (c == '~')
+                replacement = "\\textasciitilde{}";
+            else if (c == '^')
+                replacement = "\\textasciicircum{}";
+            else if (c == '&' || c == '%' || c == '$' || c == '#' || c == '_' || c == '{' || c == '}')
+            {
+                control[0] = '\\';
+                control[1] = c;
+                control[2] = '\0';
+                replacement = control;
+            }
+            else if (c == '\n')
+                replacement = "\\newline{}";
+            break;
+        }
+        if (!replacement)
+            continue;
+        buffer.append(text.substr(start, i - start));
+        buffer.append(replacement);
+        start = i + 1;
+    }
+    put(text.substr(start));
+}
+
+void fq::Exporter::writeHeader()
+{
+    switch (format)
+    {
+    case Format::Json:
+        put("{");
+        JsonWriter::appendKey(buffer, "questions", compact);
+        put("[");
+        break;
+    case Format::Csv:
+        put("question,type,explanation,tags,difficulty,correct");
+        for (std::size_t i = 1; i <= options.answerColumns; ++i)
+            put(",answer" + std::to_string(i));
+        put("\n");
+        break;
+    case Format::Html:
+        put("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>");
+        putEscaped(options.title);
+        put("</title>\n<style>\n"
+            "body { font-family: serif; max-width: 50em; margin: 2em auto; }\n"
+            ".question { break-inside: avoid; margin-bottom: 1.5em; }\n"
+            ".answers { list-style-type: upper-alpha; }\n"
+            ".correct { font-weight: bold; }\n"
+            ".explanation { font-style: italic; }\n"
+            "</style>\n</head>\n<body>\n<h1>");
+        putEscaped(options.title);
+        put("</h1>\n<ol>\n");
+        break;
+    case Format::Latex:
+        put("\\documentclass{article}\n\\usepackage[utf8]{inputenc}\n\\usepackage[T1]{fontenc}\n"
+            "\\renewcommand{\\labelenumii}{(\\Alph{enumii})}\n\\title{");
+        putEscaped(options.title);
+        put("}\n\\date{}\n\\begin{document}\n\\maketitle\n\\begin{enumerate}\n");
+        break;
+    }
+    flush();
+}
+
+void fq::Exporter::writeJson(const fq::Question *question)
+{
+    // Questions are written by the same code that saves repositories, only without line breaks and indentation.
+    put(count ? "," : "");
+    question->appendJSON(buffer, compact);
+    if (buffer.size() >= bufferSize)
+        flush();
+}
+
+void fq::Exporter::writeCsv(const fq::Question *question)
+{
+    const auto &answers = question->getAnswers();
+    if (answers.size() > options.answerColumns)
+        throw std::invalid_argument("Question has more answers than the CSV file has columns: " + question->getQuestion());
+    auto field = [this](std::string_view text)
+    {
+        put("\"");
+        putEscaped(text);
+        put("\"");
+    };
+    field(question->getQuestion());
+    put(",");
+    field(question->getType());
+    put(",");
+    field(question->getExplanation());
+    put(",\"");
+    for (std::size_t i = 0; i < question->getTags().size(); ++i)
+    {
+        if (i)
+            put(";");
+        putEscaped(question->getTags()[i]);
+    }
+    put("\",");
+    if (question->getDifficulty() != 0.0)
+        putNumber(question->getDifficulty());
+    put(",");
+    bool first = true;
+    for (std::size_t i = 0; i < answers.size(); ++i)
+    {
+        if (!answers[i].isCorrect)
+            continue;
+        put(first ? "" : ";");
+        put(std::to_string(i + 1));
+        first = false;
+    }
+    for (std::size_t i = 0; i < options.answerColumns; ++i)
+    {
+        put(",");
+        if (i < answers.size())
+            field(answers[i].text.str());
+    }
+    put("\n");
+}
+
+void fq::Exporter::writeHtml(const fq::Question *question)
+{
+    put("<li class=\"question\"><p>");
+    putEscaped(question->getQuestion());
+    put("</p>\n<ol class=\"answers\">\n");
+    for (const auto &answer : question->getAnswers())
+    {
+        put(options.answers && answer.isCorrect ? "<li class=\"correct\">" : "<li>");
+        putEscaped(answer.text.str());
+        put("</li>\n");
+    }
+    put("</ol>\n");
+    if (options.answers)
+    {
+        put("<p class=\"explanation\">");
+        putEscaped(question->getExplanation());
+        put("</p>\n");
+    }
+    put("</li>\n");
+}
+
+void fq::Exporter::writeLatex(const fq::Question *question)
+{
+    put("\\item ");
+    putEscaped(question->getQuestion());
+    put("\n\\begin{enumerate}\n");
+    for (const auto &answer : question->getAnswers())
+    {
+        put(options.answers && answer.isCorrect ? "\\item \\textbf{" : "\\item ");
+        putEscaped(answer.text.str());
+        put(options.answers && answer.isCorrect ? "}\n" : "\n");
+    }
+    put("\\end{enumerate}\n");
+    if (options.answers)
+    {
+        put("\\emph{");
+        putEscaped(question->getExplanation());
+        put("}\n");
+    }
+    put("\n");
+}
+
+void fq::Exporter::write(const fq::Question *question)
+{
+    if (finished)
+        throw std::logic_error("The export is already finished");
+    std::unique_ptr<Question> variant;
+    if (format != Format::Json)
+    {
+        // Only JSON can express variables, so the other formats get one variant of every template.
+        variant = question->instantiate(generator);
+        if (variant)
+            question = variant.get();
+    }
+    switch (format)
+    {
+    case Format::Json:
+        writeJson(question);
+        break;
+    case Format::Csv:
+        writeCsv(question);
+        break;
+    case Format::Html:
+        writeHtml(question);
+        break;
+    case Format::Latex:
+        writeLatex(question);
+        break;
+    }
+    ++count;
+}
+
+void fq::Exporter::finish()
+{
+    if (finished)
+        return;
+    switch (format)
+    {
+    case Format::Json:
+        put("],");
+        JsonWriter::appendKey(buffer, "type", compact);
+        JsonWriter::appendString(buffer, options.type);
+        put("}");
+        break;
+    case Format::Csv:
+        break;
+    case Format::Html:
+        put("</ol>\n</body>\n</html>\n");
+        break;
+    case Format::Latex:
+        put("\\end{enumerate}\n\\end{document}\n");
+        break;
+    }
+    flush();
+    finished = true;
+}
+
+fq::Exporter::Format fq::Exporter::formatOf(const std::string &path)
+{
+    std::size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? std::string() : path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    if (extension == "json")
+        return Format::Json;
+    if (extension == "csv")
+        return Format::Csv;
+    if (extension == "html" || extension == "htm")
+        return Format::Html;
+    if (extension == "tex")
+        return Format::Latex;
+    throw std::invalid_argument("Unknown export format: " + path);
+}
+
+void fq::Exporter::exportFile(const std::string &path, const std::vector<fq::Question *> &questions, Options options)
+{
+    Format format = formatOf(path);
+    options.answerColumns = 1;
+    for (const auto *question : questions)
+        options.answerColumns = std::max(options.answerColumns, question->getAnswers().size());
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly))
+        throw std::runtime_error("Failed to open file: " + path);
+    try
+    {
+        Exporter exporter(file, format, options);
+        for (const auto *question : questions)
+            exporter.write(question);
+        exporter.finish();
+    }
+    catch (...)
+    {
+        file.cancelWriting();
+        throw;
+    }
+    if (!file.commit())
+        throw std::runtime_error("Failed to write file: " + path);
+}
@@ -0,0 +1,168 @@
+/// @file exporter.hpp
+/// @brief Contains the definition of streaming exporters writing questions as JSON, CSV, HTML or LaTeX.
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <stdexcept>
+#include <QIODevice>
+#include <QSaveFile>
+#include <QLocale>
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Writes questions to a file one at a time.
+    /// @details Every question is formatted straight into a fixed-size buffer which is handed to the device whenever it
+    /// fills up, so exporting takes the same small amount of memory for any number of questions; no document of the
+    /// whole repository is ever built. The supported formats are:
+    /// - JSON: a compact repository file which can be opened in FunQuizz. It holds the same data as the file FunQuizz
+    ///   saves for the same questions, written by Question::appendJSON without line breaks and indentation, exactly
+    ///   as QJsonDocument::toJson(QJsonDocument::Compact) would write it.
+    /// - CSV: one row per question, in the layout read by fq::Importer.
+    /// - HTML and LaTeX: a printable exam with numbered questions and lettered answers. With Options::answers set,
+    ///   the correct answers are marked and the explanations shown, e.g. for the teacher's copy.
+    ///
+    /// Template questions are kept as templates in JSON files. CSV, HTML and LaTeX cannot express variables, so one
+    /// variant of every template is written instead, with values drawn from Options::seed; the same seed always
+    /// writes the same values.
+    class Exporter
+    {
+    public:
+        /// @brief Supported file formats.
+        enum class Format
+        {
+            /// @brief Repository JSON.
+            Json,
+
+            /// @brief Comma-separated values.
+            Csv,
+
+            /// @brief Printable HTML exam.
+            Html,
+
+            /// @brief Printable LaTeX exam.
+            Latex,
+        };
+
+        /// @brief Options of an export.
+        struct Options
+        {
+            /// @brief The repository type written to JSON files.
+            std::string type = "random";
+
+            /// @brief The title of HTML and LaTeX exams.
+            std::string title = "Exam";
+
+            /// @brief Indicates whether HTML and LaTeX exams mark the correct answers and show the explanations.
+            bool answers = false;
+
+            /// @brief The number of answer columns of CSV files. Questions with more answers cannot be written.
+            std::size_t answerColumns = 4;
+
+            /// @brief The seed of the values of the variants written for template questions in CSV, HTML and LaTeX.
+            std::uint32_t seed = 0;
+        };
+
+    private:
+        /// @brief Size at which the buffer is handed to the device, in bytes.
+        static constexpr std::size_t bufferSize = 64 * 1024;
+
+        /// @brief The device written to.
+        QIODevice &device;
+
+        /// @brief The format written.
+        Format format;
+
+        /// @brief The options of the export.
+        Options options;
+
+        /// @brief Formatted output not handed to the device yet.
+        std::string buffer;
+
+        /// @brief The number of questions written so far.
+        std::size_t count;
+
+        /// @brief Indicates whether finish was called.
+        bool finished;
+
+        /// @brief Draws the values of template variants.
+        std::mt19937 generator;
+
+        /// @brief Appends text to the buffer, handing the buffer to the device once it is full.
+        void put(std::string_view text);
+
+        /// @brief Hands the buffer to the device.
+        /// @throws std::runtime_error if the device fails to write.
+        void flush();
+
+        /// @brief Appends a number in the shortest form which reads back exactly.
+        void putNumber(double value);
+
+        /// @brief Appends text escaped for the format.
+        void putEscaped(std::string_view text);
+
+        /// @brief Writes the beginning of the file.
+        void writeHeader();
+
+        /// @brief Writes one question as JSON.
+        void writeJson(const fq::Question *question);
+
+        /// @brief Writes one question as a CSV row.
+        void writeCsv(const fq::Question *question);
+
+        /// @brief Writes one question of an HTML exam.
+        void writeHtml(const fq::Question *question);
+
+        /// @brief Writes one question of a LaTeX exam.
+        void writeLatex(const fq::Question *question);
+
+    public:
+        /// @brief Starts an export by writing the beginning of the file.
+        /// @param device The device to write to, open for writing. It must outlive the exporter.
+        /// @param format The format to write.
+        /// @param options The options of the export.
+        /// @throws std::runtime_error if the device fails to write.
+        Exporter(QIODevice &device, Format format, const Options &options);
+
+        Exporter(const Exporter &) = delete;
+        Exporter &operator=(const Exporter &) = delete;
+
+        /// @brief Writes one question.
+        /// @param question A pointer to the Question object. Templates are written as a variant, except in JSON.
+        /// @throws std::invalid_argument if the question has more answers than the CSV answer columns.
+        /// @throws std::runtime_error if no valid variant of a template could be generated.
+        /// @throws std::runtime_error if the device fails to write.
+        /// @throws std::logic_error if finish was already called.
+        void write(const fq::Question *question);
+
+        /// @brief Writes the end of the file and hands all remaining output to the device.
+        /// @throws std::runtime_error if the device fails to write.
+        void finish();
+
+        /// @brief Returns the format of a file from its extension (.json, .csv, .html or .htm, .tex).
+        /// @param path The path to the file.
+        /// @throws std::invalid_argument if the extension is not recognized.
+        static Format formatOf(const std::string &path);
+
+        /// @brief Exports questions to a file, replacing it only once the export is complete.
+        /// @details The CSV answer columns are set to the largest number of answers of the questions.
+        /// @param path The path to the file. Its format is determined by formatOf.
+        /// @param questions The questions to export.
+        /// @param options The options of the export.
+        /// @throws std::invalid_argument if the extension is not recognized.
+        /// @throws std::runtime_error if the file cannot be written.
+        static void exportFile(const std::string &path, const std::vector<fq::Question *> &questions, Options options);
+    };
+}
@@ -0,0 +1,622 @@
+#include "importer.hpp"
+#include <string_view>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cctype>
+#include <cstdlib>
+#include <cmath>
+
+namespace
+{
+    /// @brief Number of questions a thread claims at a time.
+    constexpr std::size_t chunkSize = 256;
+
+    /// @brief The text of one question, found by the sequential scan.
+    struct Block
+    {
+        /// @brief The 1-based line the question starts on.
+        std::size_t line = 0;
+
+        /// @brief The text of the question in the file.
+        std::string_view text;
+
+        /// @brief The GIFT category in effect for the question.
+        std::string category;
+    };
+
+    /// @brief Columns of a CSV file, found in its header row.
+    struct CsvColumns
+    {
+        std::size_t question = std::string::npos;
+        std::size_t correct = std::string::npos;
+        std::size_t type = std::string::npos;
+        std::size_t explanation = std::string::npos;
+        std::size_t tags = std::string::npos;
+        std::size_t difficulty = std::string::npos;
+        std::vector<std::size_t> answers;
+    };
+
+    /// @brief Removes leading and trailing white space.
+    std::string_view trim(std::string_view text)
+    {
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+            text.remove_prefix(1);
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+            text.remove_suffix(1);
+        return text;
+    }
+
+    /// @brief Returns a copy of a text in lower case.
+    std::string lower(std::string_view text)
+    {
+        std::string result(text);
+        for (char &c : result)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return result;
+    }
+
+    /// @brief Returns whether a text starts with a prefix, ignoring case.
+    bool startsWith(std::string_view text, std::string_view prefix)
+    {
+        return text.size() >= prefix.size() && lower(text.substr(0, prefix.size())) == prefix;
+    }
+
+    /// @brief Splits a text at a separator and trims the parts, dropping empty ones.
+    std::vector<std::string> splitList(std::string_view text, char separator)
+    {
+        std::vector<std::string> parts;
+        while (true)
+        {
+            std::size_t end = text.find(separator);
+            std::string_view part = trim(text.substr(0, end));
+            if (!part.empty())
+                parts.emplace_back(part);
+            if (end == std::string_view::npos)
+                return parts;
+            text.remove_prefix(end + 1);
+        }
+    }
+
+    /// @brief Returns the lines of a text, without their line breaks.
+    std::vector<std::string_view> splitLines(std::string_view text)
+    {
+        std::vector<std::string_view> lines;
+        while (!text.empty())
+        {
+            std::size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            lines.push_back(line);
+            if (end == std::string_view::npos)
+                break;
+            text.remove_prefix(end + 1);
+        }
+        return lines;
+    }
+
+    /// @brief Chooses the type of a question with no explicit type.
+    std::string defaultType(const std::vector<fq::Answer> &answers)
+    {
+        auto correct = std::count_if(answers.begin(), answers.end(), [](const fq::Answer &answer)
+                                     { return answer.isCorrect; });
+        return correct == 1 ? "single" : "multiple";
+    }
+
+    /// @brief Creates a question, applying the common checks of all formats.
+    /// @throws std::invalid_argument if the question is invalid.
+    fq::Question *makeQuestion(const std::string &text, const std::vector<fq::Answer> &answers, const std::string &explanation, std::string type, const std::vector<std::string> &tags, double difficulty = 0.0)
+    {
+        if (text.empty())
+            throw std::invalid_argument("Question text cannot be empty");
+        if (answers.empty())
+            throw std::invalid_argument("Question must have at least one answer");
+        if (std::none_of(answers.begin(), answers.end(), [](const fq::Answer &answer)
+                         { return answer.isCorrect; }))
+            throw std::invalid_argument("Question has no correct answer");
+        if (type.empty())
+            type = defaultType(answers);
+        fq::Question *question = fq::Question::fromParameters(text, answers, explanation, type, tags);
+        question->setDifficulty(difficulty);
+        return question;
+    }
+
+    // CSV
+
+    /// @brief Splits CSV contents into records, keeping line breaks inside quoted fields.
+    std::vector<Block> splitCsv(std::string_view contents, std::vector<fq::Importer::Error> &errors)
+    {
+        std::vector<Block> blocks;
+        std::size_t line = 1, start = 0, startLine = 1;
+        bool quoted = false;
+        for (std::size_t i = 0; i < contents.size(); ++i)
+        {
+            if (contents[i] == '"')
+                quoted = !quoted;
+            else if (contents[i] == '\n')
+            {
+                if (!quoted)
+                {
+                    if (!trim(contents.substr(start, i - start)).empty())
+                        blocks.push_back({startLine, contents.substr(start, i - start), {}});
+                    start = i + 1;
+                    startLine = line + 1;
+                }
+                ++line;
+            }
+        }
+        if (quoted)
+            errors.push_back({startLine, "Unterminated quoted field"});
+        else if (!trim(contents.substr(start)).empty())
+            blocks.push_back({startLine, contents.substr(start), {}});
+        return blocks;
+    }
+
+    /// @brief Splits a CSV record into its fields.
+    std::vector<std::string> csvFields(std::string_view record)
+    {
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        for (std::size_t i = 0; i < record.size(); ++i)
+        {
+            char c = record[i];
+            if (quoted)
+            {
+                if (c != '"')
+                    fields.back() += c;
+                else if (i + 1 < record.size() && record[i + 1] == '"')
+                    fields.back() += record[++i];
+                else
+                    quoted = false;
+            }
+            else if (c == '"')
+                quoted = true;
+            else if (c == ',')
+                fields.emplace_back();
+            else if (c != '\r')
+                fields.back() += c;
+        }
+        return fields;
+    }
+
+    /// @brief Reads the columns of a CSV file from its header row.
+    /// @throws std::invalid_argument if a required column is missing.
+    CsvColumns csvColumns(const Block &header)
+    {
+        CsvColumns columns;
+        std::vector<std::string> names = csvFields(header.text);
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            std::string name = lower(trim(names[i]));
+            if (name == "question")
+                columns.question = i;
+            else if (name == "correct")
+                columns.correct = i;
+            else if (name == "type")
+                columns.type = i;
+            else if (name == "explanation")
+                columns.explanation = i;
+            else if (name == "tags")
+                columns.tags = i;
+            else if (name == "difficulty")
+                columns.difficulty = i;
+            else if (startsWith(name, "answer"))
+                columns.answers.push_back(i);
+        }
+        if (columns.question == std::string::npos || columns.correct == std::string::npos || columns.answers.empty())
+            throw std::invalid_argument("The header must name the columns 'question', 'correct' and at least one 'answer' column");
+        return columns;
+    }
+
+    /// @brief Parses one CSV record.
+    /// @throws std::invalid_argument if the record is not a valid question.
+    fq::Question *parseCsv(const Block &block, const CsvColumns &columns)
+    {
+        std::vector<std::string> fields = csvFields(block.text);
+        auto field = [&fields](std::size_t column) -> std::string
+        {
+            return column < fields.size() ? std::string(trim(fields[column])) : std::string();
+        };
+        std::vector<bool> correct(columns.answers.size(), false);
+        for (const std::string &number : splitList(field(columns.correct), ';'))
+        {
+            char *end = nullptr;
+            unsigned long index = std::strtoul(number.c_str(), &end, 10);
+            if (*end || !index || index > correct.size())
+                throw std::invalid_argument("Invalid correct answer number: " + number);
+            correct[index - 1] = true;
+        }
+        std::vector<fq::Answer> answers;
+        for (std::size_t i = 0; i < columns.answers.size(); ++i)
+        {
+            std::string text = field(columns.answers[i]);
+            if (text.empty())
+            {
+                if (correct[i])
+                    throw std::invalid_argument("Correct answer " + std::to_string(i + 1) + " is empty");
+                continue;
+            }
+            answers.push_back({text, correct[i]});
+        }
+        double difficulty = 0.0;
+        std::string difficultyText = field(columns.difficulty);
+        if (!difficultyText.empty())
+        {
+            char *end = nullptr;
+            difficulty = std::strtod(difficultyText.c_str(), &end);
+            if (*end || !std::isfinite(difficulty))
+                throw std::invalid_argument("Invalid difficulty: " + difficultyText);
+        }
+        return makeQuestion(field(columns.question), answers, field(columns.explanation), lower(field(columns.type)), splitList(field(columns.tags), ';'), difficulty);
+    }
+
+    // Markdown
+
+    /// @brief Returns whether a line is an ATX heading: one to six '#' followed by a space, a tab or the end of the line.
+    /// @details Lines such as "#hashtag" are not headings, so they stay part of the question they appear in.
+    bool isHeading(std::string_view line)
+    {
+        std::size_t level = line.find_first_not_of('#');
+        if (level == std::string_view::npos)
+            level = line.size();
+        return level >= 1 && level <= 6 && (level == line.size() || line[level] == ' ' || line[level] == '\t' || line[level] == '\r');
+    }
+
+    /// @brief Splits Markdown contents into questions, each starting with a heading outside code blocks.
+    std::vector<Block> splitMarkdown(std::string_view contents)
+    {
+        std::vector<Block> blocks;
+        std::vector<std::size_t> starts;
+        std::size_t line = 1, position = 0;
+        bool fenced = false;
+        while (position < contents.size())
+        {
+            std::size_t end = std::min(contents.find('\n', position), contents.size());
+            std::string_view text = contents.substr(position, end - position);
+            if (trim(text).substr(0, 3) == "```")
+                fenced = !fenced;
+            else if (!fenced && isHeading(text))
+            {
+                starts.push_back(position);
+                blocks.push_back({line, {}, {}});
+            }
+            position = end + 1;
+            ++line;
+        }
+        for (std::size_t b = 0; b < blocks.size(); ++b)
+        {
+            std::size_t end = b + 1 < blocks.size() ? starts[b + 1] : contents.size();
+            blocks[b].text = contents.substr(starts[b], end - starts[b]);
+        }
+        return blocks;
+    }
+
+    /// @brief Parses one Markdown question.
+    /// @throws std::invalid_argument if the text is not a valid question.
+    fq::Question *parseMarkdown(const Block &block)
+    {
+        std::vector<std::string_view> lines = splitLines(block.text);
+        std::size_t level = std::min(lines.front().find_first_not_of('#'), lines.front().size());
+        std::string heading(trim(lines.front().substr(level)));
+        std::string text = heading, explanation, type;
+        std::vector<std::string> tags;
+        std::vector<fq::Answer> answers;
+        bool fenced = false;
+        for (std::size_t i = 1; i < lines.size(); ++i)
+        {
+            std::string_view line = trim(lines[i]);
+            if (line.substr(0, 3) == "```" || fenced)
+            {
+                // Code blocks belong to the question text, verbatim.
+                if (!answers.empty())
+                    throw std::invalid_argument("Unexpected code block after the answers");
+                fenced ^= line.substr(0, 3) == "```";
+                text += "\n" + std::string(lines[i]);
+                continue;
+            }
+            if (line.empty())
+                continue;
+            if ((line[0] == '-' || line[0] == '*' || line[0] == '+') && line.size() >= 5 && line[1] == ' ' && line[2] == '[' && line[4] == ']')
+            {
+                if (line[3] != 'x' && line[3] != 'X' && line[3] != ' ')
+                    throw std::invalid_argument("Answers must be marked [x] or [ ]");
+                answers.push_back({std::string(trim(line.substr(5))), line[3] != ' '});
+            }
+            else if (line[0] == '>')
+            {
+                if (!explanation.empty())
+                    explanation += '\n';
+                explanation += trim(line.substr(1));
+            }
+            else if (startsWith(line, "type:"))
+                type = lower(trim(line.substr(5)));
+            else if (startsWith(line, "tags:"))
+                tags = splitList(line.substr(5), ',');
+            else if (!answers.empty())
+                throw std::invalid_argument("Unexpected text after the answers: " + std::string(line));
+            else
+                text += "\n" + std::string(line);
+        }
+        return makeQuestion(text, answers, explanation, type, tags);
+    }
+
+    // GIFT
+
+    /// @brief Splits GIFT contents into questions separated by blank lines, tracking "$CATEGORY:" lines.
+    std::vector<Block> splitGift(std::string_view contents)
+    {
+        std::vector<Block> blocks;
+        std::string category;
+        std::size_t line = 1, position = 0, blockStart = 0;
+        bool inBlock = false;
+        while (position < contents.size())
+        {
+            std::size_t end = std::min(contents.find('\n', position), contents.size());
+            std::string_view trimmed = trim(contents.substr(position, end - position));
+            if (trimmed.empty())
+                inBlock = false;
+            else if (!inBlock && startsWith(trimmed, "$category:"))
+            {
+                std::vector<std::string> path = splitList(trimmed.substr(10), '/');
+                category = path.empty() || path.back() == "$course$" || path.back() == "top" ? std::string() : path.back();
+            }
+            else if (inBlock || trimmed.substr(0, 2) != "//")
+            {
+                if (!inBlock)
+                {
+                    blocks.push_back({line, {}, category});
+                    blockStart = position;
+                    inBlock = true;
+                }
+                blocks.back().text = contents.substr(blockStart, end - blockStart);
+            }
+            position = end + 1;
+            ++line;
+        }
+        return blocks;
+    }
+
+    /// @brief Returns the position of the first unescaped occurrence of one of the characters, or npos.
+    std::size_t findUnescaped(std::string_view text, std::string_view characters, std::size_t from = 0)
+    {
+        for (std::size_t i = from; i < text.size(); ++i)
+        {
+            if (text[i] == '\\')
+                ++i;
+            else if (characters.find(text[i]) != std::string_view::npos)
+                return i;
+        }
+        return std::string_view::npos;
+    }
+
+    /// @brief Resolves the escape sequences of GIFT text and trims it.
+    std::string unescape(std::string_view text)
+    {
+        text = trim(text);
+        std::string result;
+        result.reserve(text.size());
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '\\' && i + 1 < text.size())
+            {
+                char next = text[++i];
+                result += next == 'n' ? '\n' : next;
+            }
+            else
+                result += text[i];
+        }
+        return result;
+    }
+
+    /// @brief Parses one GIFT question.
+    /// @throws std::invalid_argument if the text is not a supported question.
+    fq::Question *parseGift(const Block &block)
+    {
+        std::string source;
+        for (std::string_view line : splitLines(block.text))
+        {
+            if (trim(line).substr(0, 2) != "//")
+                source.append(line).append("\n");
+        }
+        std::string_view text = trim(source);
+        if (text.substr(0, 2) == "::")
+        {
+            std::size_t end = text.find("::", 2);
+            if (end == std::string_view::npos)
+                throw std::invalid_argument("Unterminated question title");
+            text = trim(text.substr(end + 2));
+        }
+        if (!text.empty() && text.front() == '[')
+            text = trim(text.substr(text.find(']') + 1));
+        std::size_t open = findUnescaped(text, "{");
+        std::size_t close = open == std::string_view::npos ? open : findUnescaped(text, "}", open + 1);
+        if (open == std::string_view::npos || close == std::string_view::npos)
+            throw std::invalid_argument("Question has no answer block in braces");
+        std::string before = unescape(text.substr(0, open)), after = unescape(text.substr(close + 1));
+        std::string question = after.empty() ? before : before.empty() ? after : before + " _____ " + after;
+        std::string_view body = trim(text.substr(open + 1, close - open - 1));
+
+        std::string explanation;
+        std::size_t general = body.find("####");
+        if (general != std::string_view::npos)
+        {
+            explanation = unescape(body.substr(general + 4));
+            body = trim(body.substr(0, general));
+        }
+        std::vector<std::string> tags;
+        if (!block.category.empty())
+            tags.push_back(block.category);
+        if (body.empty())
+            throw std::invalid_argument("Essay questions are not supported");
+        if (body.front() == '#')
+            throw std::invalid_argument("Numerical questions are not supported");
+        std::string truth = lower(trim(body.substr(0, findUnescaped(body, "#"))));
+        if (truth == "t" || truth == "true" || truth == "f" || truth == "false")
+        {
+            bool isTrue = truth[0] == 't';
+            return makeQuestion(question, {{"True", isTrue}, {"False", !isTrue}}, explanation, "single", tags);
+        }
+
+        std::vector<fq::Answer> answers;
+        bool weighted = false, negative = false, wrongAnswers = false;
+        for (std::size_t start = findUnescaped(body, "=~"); start != std::string_view::npos;)
+        {
+            std::size_t end = findUnescaped(body, "=~", start + 1);
+            std::string_view answer = trim(body.substr(start + 1, end == std::string_view::npos ? std::string_view::npos : end - start - 1));
+            bool correct = body[start] == '=';
+            wrongAnswers |= !correct;
+            if (!answer.empty() && answer.front() == '%')
+            {
+                std::size_t percent = answer.find('%', 1);
+                if (percent == std::string_view::npos)
+                    throw std::invalid_argument("Unterminated answer weight");
+                std::string weightText(answer.substr(1, percent - 1));
+                char *endOfWeight = nullptr;
+                double weight = std::strtod(weightText.c_str(), &endOfWeight);
+                if (*endOfWeight)
+                    throw std::invalid_argument("Invalid answer weight: " + weightText);
+                correct = weight > 0.0;
+                weighted = true;
+                negative |= weight < 0.0;
+                answer = trim(answer.substr(percent + 1));
+            }
+            if (answer.find("->") != std::string_view::npos)
+                throw std::invalid_argument("Matching questions are not supported");
+            std::string answerText = unescape(answer.substr(0, findUnescaped(answer, "#")));
+            if (answerText.empty())
+                throw std::invalid_argument("Answer text cannot be empty");
+            answers.push_back({answerText, correct});
+            start = end;
+        }
+        if (answers.empty())
+            throw std::invalid_argument("Answers must start with '=' or '~'");
+        if (!wrongAnswers)
+            throw std::invalid_argument("Short answer questions are not supported");
+        std::string type = negative ? "negative_multiple" : weighted ? "multiple" : "";
+        return makeQuestion(question, answers, explanation, type, tags);
+    }
+}
+
+fq::Importer::Format fq::Importer::formatOf(const std::string &path)
+{
+    std::size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? std::string() : lower(std::string_view(path).substr(dot + 1));
+    if (extension == "csv")
+        return Format::Csv;
+    if (extension == "md" || extension == "markdown")
+        return Format::Markdown;
+    if (extension == "gift" || extension == "txt")
+        return Format::Gift;
+    throw std::invalid_argument("Unknown import format: " + path);
+}
+
+fq::Importer::Result fq::Importer::importFile(const std::string &path, unsigned threads)
+{
+    Format format = formatOf(path);
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+        throw std::runtime_error("Failed to open file: " + path);
+    QByteArray contents = file.readAll();
+    return parse(contents.toStdString(), format, threads);
+}
+
+fq::Importer::Result fq::Importer::parse(const std::string &contents, Format format, unsigned threads)
+{
+    Result result;
+    std::string_view text = contents;
+    if (text.substr(0, 3) == "\xEF\xBB\xBF")
+        text.remove_prefix(3);
+
+    // The sequential scan only finds where questions start; parsing them is left to the threads.
+    std::vector<Block> blocks;
+    std::function<fq::Question *(const Block &)> parseBlock;
+    CsvColumns columns;
+    switch (format)
+    {
+    case Format::Csv:
+        blocks = splitCsv(text, result.errors);
+        if (blocks.empty())
+            return result;
+        try
+        {
+            columns = csvColumns(blocks.front());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            result.errors.push_back({blocks.front().line, e.what()});
+            return result;
+        }
+        blocks.erase(blocks.begin());
+        parseBlock = [&columns](const Block &block)
+        { return parseCsv(block, columns); };
+        break;
+    case Format::Markdown:
+        blocks = splitMarkdown(text);
+        parseBlock = parseMarkdown;
+        break;
+    case Format::Gift:
+        blocks = splitGift(text);
+        parseBlock = parseGift;
+        break;
+    }
+
+    std::vector<std::unique_ptr<fq::Question>> parsed(blocks.size());
+    std::vector<std::string> failures(blocks.size());
+    std::size_t chunks = (blocks.size() + chunkSize - 1) / chunkSize;
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(chunks, 1)));
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&]()
+                             {
+            try
+            {
+                for (std::size_t chunk = next++; chunk < chunks; chunk = next++)
+                {
+                    std::size_t end = std::min(blocks.size(), (chunk + 1) * chunkSize);
+                    for (std::size_t b = chunk * chunkSize; b < end; ++b)
+                    {
+                        try
+                        {
+                            parsed[b].reset(parseBlock(blocks[b]));
+                        }
+                        catch (const std::invalid_argument &e)
+                        {
+                            failures[b] = e.what();
+                        }
+                    }
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+                next = chunks;
+            } });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    if (error)
+        std::rethrow_exception(error);
+
+    result.questions.reserve(blocks.size());
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+    {
+        if (parsed[b])
+            result.questions.push_back(std::move(parsed[b]));
+        else
+            result.errors.push_back({blocks[b].line, failures[b]});
+    }
+    std::stable_sort(result.errors.begin(), result.errors.end(), [](const Error &a, const Error &b)
+                     { return a.line < b.line; });
+    return result;
+}
@@ -0,0 +1,93 @@
+/// @file importer.hpp
+/// @brief Contains the definition of bulk importers reading questions from CSV, Markdown and GIFT files.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <QFile>
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Imports many questions at once from files written outside FunQuizz.
+    /// @details Three formats are supported:
+    /// - CSV: a header row naming the columns "question", "correct" and one or more "answer" columns, and optionally
+    ///   "type", "explanation", "tags" and "difficulty". "correct" holds the 1-based numbers of the correct answer
+    ///   columns separated by semicolons; tags are separated by semicolons too. Fields may be quoted as in RFC 4180.
+    /// - Markdown: every question starts with a heading ("# " to "###### ") holding its text, followed by optional "Type:" and "Tags:"
+    ///   lines, task list items ("- [x] correct", "- [ ] wrong") as answers, and a block quote as explanation.
+    /// - GIFT (Moodle): multiple choice and true/false questions separated by blank lines. Weighted answers make a
+    ///   multiple choice question, negative weights a negative score one, and "$CATEGORY:" lines tag the questions
+    ///   which follow with the last component of the category. Other GIFT question types are reported as errors.
+    ///
+    /// Without an explicit type, a question is single choice if exactly one answer is correct and multiple choice
+    /// otherwise. The file is first split into the text of each question in one sequential scan, and the questions
+    /// are then parsed on several threads. Invalid questions do not stop the import: they are skipped and reported
+    /// with the line they start on.
+    class Importer
+    {
+    public:
+        /// @brief Supported file formats.
+        enum class Format
+        {
+            /// @brief Comma-separated values.
+            Csv,
+
+            /// @brief Markdown headings and task lists.
+            Markdown,
+
+            /// @brief Moodle GIFT.
+            Gift,
+        };
+
+        /// @brief A question which could not be imported.
+        struct Error
+        {
+            /// @brief The 1-based line the question starts on.
+            std::size_t line = 0;
+
+            /// @brief Description of the problem.
+            std::string message;
+        };
+
+        /// @brief Results of an import.
+        struct Result
+        {
+            /// @brief The imported questions, in the order of the file.
+            std::vector<std::unique_ptr<fq::Question>> questions;
+
+            /// @brief The questions which could not be imported, ordered by line.
+            std::vector<Error> errors;
+        };
+
+        /// @brief Returns the format of a file from its extension (.csv, .md or .markdown, .gift or .txt).
+        /// @param path The path to the file.
+        /// @throws std::invalid_argument if the extension is not recognized.
+        static Format formatOf(const std::string &path);
+
+        /// @brief Imports the questions of a file.
+        /// @param path The path to the file. Its format is determined by formatOf.
+        /// @param threads The number of threads parsing questions, or 0 to use one per core.
+        /// @return The imported questions and the errors.
+        /// @throws std::invalid_argument if the extension is not recognized.
+        /// @throws std::runtime_error if the file cannot be read.
+        static Result importFile(const std::string &path, unsigned threads = 0);
+
+        /// @brief Imports the questions held in memory.
+        /// @param contents The contents of the file, encoded in UTF-8.
+        /// @param format The format of the contents.
+        /// @param threads The number of threads parsing questions, or 0 to use one per core.
+        /// @return The imported questions and the errors.
+        static Result parse(const std::string &contents, Format format, unsigned threads = 0);
+    };
+}
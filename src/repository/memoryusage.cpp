@@ -0,0 +1,107 @@
+#include "memoryusage.hpp"
+#include "questionbank.hpp"
+#include <unordered_set>
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+#include <locale>
+#include <cstdint>
+
+std::size_t fq::MemoryUsage::total() const
+{
+    return textBytes + answerBytes + explanationBytes + tagBytes + objectBytes + containerBytes + statisticsBytes;
+}
+
+fq::MemoryUsage &fq::MemoryUsage::operator+=(const MemoryUsage &other)
+{
+    questions += other.questions;
+    textBytes += other.textBytes;
+    answerBytes += other.answerBytes;
+    explanationBytes += other.explanationBytes;
+    tagBytes += other.tagBytes;
+    objectBytes += other.objectBytes;
+    containerBytes += other.containerBytes;
+    statisticsBytes += other.statisticsBytes;
+    for (const auto &[type, usage] : other.types)
+    {
+        types[type].questions += usage.questions;
+        types[type].bytes += usage.bytes;
+    }
+    return *this;
+}
+
+fq::MemoryUsage fq::MemoryUsage::measure(const QuestionBank &bank)
+{
+    MemoryUsage usage;
+    std::unordered_set<std::uintptr_t> interned;
+    auto internedBytes = [&interned](const InternedString &text)
+    {
+        return interned.insert(text.id()).second ? text.storageBytes() : 0;
+    };
+    for (const Question *question : bank.getQuestions())
+    {
+        std::size_t text = Question::stringBytes(question->getQuestion());
+        std::size_t answers = question->getAnswers().capacity() * sizeof(Answer);
+        for (const Answer &answer : question->getAnswers())
+            answers += internedBytes(answer.text);
+        std::size_t explanation = internedBytes(question->getInternedExplanation());
+        std::size_t tags = question->getTags().capacity() * sizeof(std::string);
+        for (const std::string &tag : question->getTags())
+            tags += Question::stringBytes(tag);
+        std::size_t object = question->memoryUsage();
+
+        ++usage.questions;
+        usage.textBytes += text;
+        usage.answerBytes += answers;
+        usage.explanationBytes += explanation;
+        usage.tagBytes += tags;
+        usage.objectBytes += object;
+        TypeUsage &type = usage.types[question->getType()];
+        ++type.questions;
+        type.bytes += text + answers + explanation + tags + object;
+    }
+    usage.containerBytes = bank.memoryUsage();
+    return usage;
+}
+
+std::string fq::MemoryUsage::formatBytes(std::size_t bytes)
+{
+    static const char *const units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    double value = static_cast<double>(bytes);
+    std::size_t unit = 0;
+    while (value >= 1024.0 && unit + 1 < std::size(units))
+    {
+        value /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream text;
+    text.imbue(std::locale::classic());
+    if (unit == 0)
+        text << bytes << " B";
+    else
+        text << std::fixed << std::setprecision(1) << value << " " << units[unit];
+    return text.str();
+}
+
+std::string fq::MemoryUsage::toString() const
+{
+    std::ostringstream text;
+    auto line = [&text](const std::string &label, std::size_t bytes)
+    {
+        text << std::left << std::setw(22) << label << std::right << std::setw(12) << formatBytes(bytes) << "\n";
+    };
+    line("Question texts:", textBytes);
+    line("Answers:", answerBytes);
+    line("Explanations:", explanationBytes);
+    line("Tags:", tagBytes);
+    line("Question objects:", objectBytes);
+    line("Containers:", containerBytes);
+    line("Statistics:", statisticsBytes);
+    line("Total:", total());
+    text << "\n"
+         << std::left << std::setw(22) << "Type" << std::right << std::setw(12) << "Questions" << std::setw(12) << "Memory" << std::setw(14) << "Per question" << "\n";
+    for (const auto &[type, usage] : types)
+        text << std::left << std::setw(22) << type << std::right << std::setw(12) << usage.questions << std::setw(12)
+             << formatBytes(usage.bytes) << std::setw(14) << formatBytes(usage.questions ? usage.bytes / usage.questions : 0) << "\n";
+    return text.str();
+}
@@ -0,0 +1,93 @@
+/// @file memoryusage.hpp
+/// @brief Contains the definition of the memory accounting of repositories.
+
+#pragma once
+#include <string>
+#include <map>
+#include <cstddef>
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+    class QuestionBank;
+
+    /// @brief Estimated memory used by the questions of a repository, by category and by question type.
+    /// @details The sizes are estimates computed from the sizes and capacities of the containers, assuming the
+    /// common standard library layouts (e.g. strings of up to 15 characters stored inline, hash map nodes holding a
+    /// link and the cached hash). Interned texts (answer texts and explanations) are counted once per repository
+    /// however many questions use them, including their shared control block and pool entry.
+    struct MemoryUsage
+    {
+        /// @brief Number and memory of the questions of one type.
+        struct TypeUsage
+        {
+            /// @brief The number of questions of the type.
+            std::size_t questions = 0;
+
+            /// @brief The bytes of the questions: objects, texts, answers, tags and the interned texts first used by them.
+            std::size_t bytes = 0;
+        };
+
+        /// @brief The number of questions.
+        std::size_t questions = 0;
+
+        /// @brief Bytes of the question texts.
+        std::size_t textBytes = 0;
+
+        /// @brief Bytes of the answer arrays and of the distinct answer texts.
+        std::size_t answerBytes = 0;
+
+        /// @brief Bytes of the distinct explanations.
+        std::size_t explanationBytes = 0;
+
+        /// @brief Bytes of the tags of the questions.
+        std::size_t tagBytes = 0;
+
+        /// @brief Bytes of the question objects, including data only their type has (e.g. compiled template expressions).
+        std::size_t objectBytes = 0;
+
+        /// @brief Bytes of the containers holding the questions: the arrays and hash maps of the bank and its indexes.
+        std::size_t containerBytes = 0;
+
+        /// @brief Bytes of the answer statistics loaded for the questions.
+        std::size_t statisticsBytes = 0;
+
+        /// @brief The number and memory of the questions of each type, keyed by type (e.g. "single").
+        std::map<std::string, TypeUsage> types;
+
+        /// @brief Returns the total number of bytes.
+        std::size_t total() const;
+
+        /// @brief Adds the usage of another repository, e.g. of one bank of a session spanning several.
+        /// @details Texts shared by both are counted twice.
+        MemoryUsage &operator+=(const MemoryUsage &other);
+
+        /// @brief Measures the questions and the containers of a bank.
+        /// @details Questions shared with other banks (e.g. the previous version of an edited repository) are counted
+        /// in full.
+        /// @param bank The bank.
+        /// @return The usage, without statistics.
+        static MemoryUsage measure(const QuestionBank &bank);
+
+        /// @brief Writes a number of bytes for people, e.g. "1.5 MiB".
+        static std::string formatBytes(std::size_t bytes);
+
+        /// @brief Writes the usage as a table with one line per category and per question type.
+        std::string toString() const;
+
+        /// @brief Estimates the bytes used by the nodes and buckets of a hash map.
+        /// @param map An std::unordered_map or std::unordered_set.
+        template <typename Map>
+        static std::size_t hashMapBytes(const Map &map)
+        {
+            // Every node holds the element, a link to the next node and the cached hash.
+            return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(typename Map::value_type) + sizeof(void *) + sizeof(std::size_t));
+        }
+    };
+}
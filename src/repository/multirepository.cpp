@@ -0,0 +1,151 @@
+#include "multirepository.hpp"
+
+fq::MultiRepository::MultiRepository(std::vector<Repository *> banks, std::vector<double> weights)
+    : banks(std::move(banks)), weights(std::move(weights)), drawn(this->banks.size(), nullptr), generator(std::random_device{}())
+{
+    jsonType = "multi";
+}
+
+fq::MultiRepository *fq::MultiRepository::open(const std::vector<std::string> &paths, const std::vector<double> &weights, bool snapshots)
+{
+    if (paths.empty())
+        throw std::invalid_argument("At least one repository must be opened");
+    if (!weights.empty() && weights.size() != paths.size())
+        throw std::invalid_argument("Number of weights does not match the number of repositories");
+    for (auto weight : weights)
+    {
+        if (!(weight >= 0.0))
+            throw std::invalid_argument("Repository weights cannot be negative");
+    }
+
+    std::vector<std::future<Repository *>> loading;
+    loading.reserve(paths.size());
+    for (const auto &path : paths)
+        loading.push_back(std::async(std::launch::async, [path, snapshots]()
+                                     { return Repository::createRepository(path, snapshots); }));
+
+    std::vector<Repository *> banks;
+    std::string error;
+    for (auto &future : loading)
+    {
+        try
+        {
+            banks.push_back(future.get());
+        }
+        catch (const std::exception &e)
+        {
+            if (error.empty())
+                error = e.what();
+        }
+    }
+    if (!error.empty())
+    {
+        for (auto &bank : banks)
+        {
+            bank->setAutoSave(false);
+            delete bank;
+        }
+        throw std::runtime_error(error);
+    }
+    return new MultiRepository(std::move(banks), weights.empty() ? std::vector<double>(paths.size(), 1.0) : weights);
+}
+
+fq::Question *fq::MultiRepository::getQuestion()
+{
+    std::vector<double> probabilities;
+    probabilities.reserve(banks.size());
+    double total = 0.0;
+    for (std::size_t i = 0; i < banks.size(); ++i)
+    {
+        probabilities.push_back(weights[i] * static_cast<double>(banks[i]->getFilteredCount()));
+        total += probabilities.back();
+    }
+    if (total <= 0.0)
+        throw std::runtime_error("No questions available in the opened repositories");
+    std::discrete_distribution<std::size_t> dis(probabilities.begin(), probabilities.end());
+    std::size_t index = dis(generator);
+    Question *question = banks[index]->getQuestion();
+    drawn[index] = question;
+    return question;
+}
+
+std::optional<std::size_t> fq::MultiRepository::bankOf(const Question *question) const
+{
+    if (!question)
+        return std::nullopt;
+    for (std::size_t i = 0; i < drawn.size(); ++i)
+    {
+        if (drawn[i] == question)
+            return i;
+    }
+    return std::nullopt;
+}
+
+void fq::MultiRepository::returnQuestion(Question *question, double score, const std::vector<std::uint32_t> &chosenAnswers)
+{
+    auto index = bankOf(question);
+    if (!index)
+        return;
+    banks[*index]->returnQuestion(question, score, chosenAnswers);
+    drawn[*index] = nullptr;
+}
+
+void fq::MultiRepository::recordResponse(const Question *question, double latency, double score)
+{
+    if (auto index = bankOf(question))
+        banks[*index]->recordResponse(question, latency, score);
+}
+
+fq::MemoryUsage fq::MultiRepository::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    for (const auto &bank : banks)
+        usage += bank->getMemoryUsage();
+    return usage;
+}
+
+std::size_t fq::MultiRepository::getQuestionCount() const
+{
+    std::size_t count = 0;
+    for (const auto &bank : banks)
+        count += bank->getQuestionCount();
+    return count;
+}
+
+std::size_t fq::MultiRepository::getFilteredCount() const
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < banks.size(); ++i)
+    {
+        if (weights[i] > 0.0)
+            count += banks[i]->getFilteredCount();
+    }
+    return count;
+}
+
+std::map<std::string, std::size_t> fq::MultiRepository::getTagCounts() const
+{
+    std::map<std::string, std::size_t> counts;
+    for (const auto &bank : banks)
+    {
+        for (const auto &it : bank->getTagCounts())
+            counts[it.first] += it.second;
+    }
+    return counts;
+}
+
+void fq::MultiRepository::setFilter(const std::string &expression)
+{
+    // Validate the expression before changing any bank, so a malformed one leaves the session untouched.
+    bank->getTagIndex().evaluate(expression);
+    for (auto &bank : banks)
+        bank->setFilter(expression);
+    filterExpression = expression;
+    std::fill(drawn.begin(), drawn.end(), nullptr);
+}
+
+fq::MultiRepository::~MultiRepository()
+{
+    for (auto &bank : banks)
+        delete bank;
+}
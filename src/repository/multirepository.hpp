@@ -0,0 +1,112 @@
+/// @file multirepository.hpp
+/// @brief Contains the definition of a repository drawing from several repositories at once.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <future>
+#include <optional>
+#include <algorithm>
+#include "repository.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Class representing a session drawing from several repositories (banks) at once.
+    /// @details Every bank keeps its own questions, type and draw state; this repository only decides which bank the
+    /// next question comes from. The probability of a bank is its weight multiplied by the number of its questions
+    /// matching the filter, so with equal weights every question of the union is equally likely. Each bank is saved
+    /// to its own file when the session is destroyed.
+    class MultiRepository : public Repository
+    {
+        /// @brief The repositories the questions are drawn from. Owned by this repository.
+        std::vector<Repository *> banks;
+
+        /// @brief Weights of the banks, in the same order as banks.
+        std::vector<double> weights;
+
+        /// @brief The question each bank handed out last and which has not been returned yet, in the same order as banks.
+        /// @details A bank forgets its previous question when it hands out the next one, like a session does with its
+        /// variants, so questions which are skipped without being returned are not kept.
+        std::vector<const fq::Question *> drawn;
+
+        /// @brief Returns the index of the bank a question was drawn from and not returned yet.
+        /// @return The index, or nothing if the question is not outstanding.
+        std::optional<std::size_t> bankOf(const fq::Question *question) const;
+
+        /// @brief Random number generator used to choose where questions are drawn from and to order their answers.
+        std::mt19937 generator;
+
+        /// @brief Tag expression selecting the questions to be drawn. Empty if all questions are drawn.
+        std::string filterExpression;
+
+        /// @brief Constructs a session from already loaded banks.
+        MultiRepository(std::vector<Repository *> banks, std::vector<double> weights);
+
+    public:
+        /// @brief Loads several repositories concurrently and combines them into one session.
+        /// @param paths The paths to the JSON files of the repositories.
+        /// @param weights Weights of the repositories, in the same order as paths. Empty to weigh all repositories equally.
+        /// @param snapshots true to write snapshots of the repositories; see Repository::createRepository.
+        /// @return A pointer to the new MultiRepository.
+        /// @throws std::invalid_argument if no path is given, or if the number of weights does not match or a weight is negative.
+        /// @throws std::runtime_error if any repository cannot be loaded. No repository is kept open in that case.
+        static MultiRepository *open(const std::vector<std::string> &paths, const std::vector<double> &weights = {}, bool snapshots = false);
+
+        /// @brief Returns a question from one of the banks, chosen according to the weights.
+        /// @return A pointer to a Question object.
+        /// @throws std::runtime_error if no bank has a question matching the filter.
+        virtual fq::Question *getQuestion() override;
+
+        /// @brief Returns a question back to the bank it came from.
+        /// @param question A pointer to the Question object to be returned.
+        /// @param score The score gained by the user from the question.
+        /// @param chosenAnswers The indices of the answers chosen by the user.
+        virtual void returnQuestion(fq::Question *question, double score, const std::vector<std::uint32_t> &chosenAnswers = {}) override;
+
+        /// @brief Records the response to a question in the statistics of the bank it came from.
+        virtual void recordResponse(const fq::Question *question, double latency, double score) override;
+
+        /// @brief Returns the memory used by all banks.
+        virtual MemoryUsage getMemoryUsage() const override;
+
+        /// @brief Returns the total number of questions in all banks.
+        virtual std::size_t getQuestionCount() const override;
+
+        /// @brief Returns the total number of questions matching the filter in all banks.
+        virtual std::size_t getFilteredCount() const override;
+
+        /// @brief Returns the number of questions carrying each tag, summed over all banks.
+        virtual std::map<std::string, std::size_t> getTagCounts() const override;
+
+        /// @brief Applies a tag filter to every bank.
+        /// @param expression The tag expression. An empty expression removes the filter.
+        /// @throws std::invalid_argument if the expression is malformed.
+        virtual void setFilter(const std::string &expression) override;
+
+        /// @brief Returns the tag expression used to filter drawn questions.
+        virtual const std::string &getFilter() const override { return filterExpression; }
+
+        /// @brief Returns a random presentation order of the answers of a question.
+        /// @param question A pointer to the Question object to be presented.
+        /// @return A vector of indices into the answers of the question, in the order they should be presented.
+        virtual std::vector<std::size_t> getAnswerOrder(const fq::Question *question) override { return question->getAnswerOrder(generator); }
+
+        /// @brief Sessions spanning several repositories cannot be edited; each bank must be opened on its own.
+        virtual bool isEditable() const override { return false; }
+
+        /// @brief Returns the banks of the session.
+        /// @return A vector of pointers to the banks, owned by this repository.
+        const std::vector<Repository *> &getBanks() const { return banks; }
+
+        /// @brief Destroys the session and all its banks, saving each of them.
+        virtual ~MultiRepository();
+    };
+}
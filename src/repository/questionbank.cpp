@@ -0,0 +1,67 @@
+#include "questionbank.hpp"
+#include "memoryusage.hpp"
+
+fq::QuestionBank::QuestionBank()
+{
+    tagIndex.build(questions);
+    difficultyIndex.build(questions);
+}
+
+fq::QuestionBank::QuestionBank(std::vector<std::shared_ptr<fq::Question>> questions_) : owners(std::move(questions_))
+{
+    questions.reserve(owners.size());
+    slots.reserve(owners.size());
+    textSlots.reserve(owners.size());
+    for (const auto &owner : owners)
+    {
+        slots[owner.get()] = static_cast<std::uint32_t>(questions.size());
+        textSlots.emplace(owner->getQuestion(), static_cast<std::uint32_t>(questions.size()));
+        questions.push_back(owner.get());
+    }
+    tagIndex.build(questions);
+    difficultyIndex.build(questions);
+}
+
+std::optional<std::uint32_t> fq::QuestionBank::slotOf(const fq::Question *question) const
+{
+    auto it = slots.find(question);
+    if (it == slots.end())
+        return std::nullopt;
+    return it->second;
+}
+
+fq::Question *fq::QuestionBank::find(std::string_view text) const
+{
+    auto it = textSlots.find(text);
+    return it == textSlots.end() ? nullptr : questions[it->second];
+}
+
+const fq::DuplicateIndex &fq::QuestionBank::getDuplicateIndex() const
+{
+    std::call_once(duplicateIndexBuilt, [this]()
+                   {
+        auto index = std::make_unique<DuplicateIndex>();
+        index->build(questions);
+        duplicateIndex = std::move(index);
+        duplicateIndexReady.store(true, std::memory_order_release); });
+    return *duplicateIndex;
+}
+
+std::size_t fq::QuestionBank::memoryUsage() const
+{
+    // Every owner also has a control block with a vtable pointer and two counters.
+    std::size_t bytes = owners.capacity() * sizeof(std::shared_ptr<fq::Question>) + owners.size() * 3 * sizeof(void *);
+    bytes += questions.capacity() * sizeof(fq::Question *);
+    bytes += MemoryUsage::hashMapBytes(slots) + MemoryUsage::hashMapBytes(textSlots);
+    bytes += tagIndex.memoryUsage() + difficultyIndex.memoryUsage();
+    // The near-duplicate index only exists once getDuplicateIndex has been called, e.g. by Manage Questions.
+    if (duplicateIndexReady.load(std::memory_order_acquire))
+        bytes += duplicateIndex->memoryUsage();
+    return bytes;
+}
+
+std::shared_ptr<fq::Question> fq::QuestionBank::share(const fq::Question *question) const
+{
+    auto slot = slotOf(question);
+    return slot ? owners[*slot] : nullptr;
+}
@@ -0,0 +1,113 @@
+/// @file questionbank.hpp
+/// @brief Contains the definition of an immutable collection of questions shared by repositories and sessions.
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <string_view>
+#include <mutex>
+#include <atomic>
+#include "question.hpp"
+#include "tagindex.hpp"
+#include "difficultyindex.hpp"
+#include "duplicateindex.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Immutable collection of questions together with its indexes.
+    /// @details A bank never changes after it has been constructed, so any number of sessions can read it from any
+    /// number of threads without locking. Banks are shared through std::shared_ptr; changing the questions of a
+    /// repository creates a new bank, while sessions still holding the previous one keep using it until they switch.
+    /// Questions are owned jointly by all banks containing them, so unchanged questions are shared between a bank
+    /// and the banks derived from it. The questions of a bank must not be modified.
+    class QuestionBank
+    {
+        /// @brief Owners of the questions, indexed by slot.
+        std::vector<std::shared_ptr<fq::Question>> owners;
+
+        /// @brief The questions, indexed by slot.
+        std::vector<fq::Question *> questions;
+
+        /// @brief Slots of the questions, keyed by question.
+        std::unordered_map<const fq::Question *, std::uint32_t> slots;
+
+        /// @brief Slots of the questions, keyed by their text. The keys refer to the texts of the questions.
+        std::unordered_map<std::string_view, std::uint32_t> textSlots;
+
+        /// @brief Index of the tags of the questions.
+        TagIndex tagIndex;
+
+        /// @brief Index of the questions bucketed by difficulty.
+        DifficultyIndex difficultyIndex;
+
+        /// @brief Index of near-duplicate questions, built by the first call to getDuplicateIndex.
+        mutable std::unique_ptr<DuplicateIndex> duplicateIndex;
+
+        /// @brief Guards building the near-duplicate index.
+        mutable std::once_flag duplicateIndexBuilt;
+
+        /// @brief Indicates whether the near-duplicate index has been built, so memoryUsage can count it from any thread.
+        mutable std::atomic<bool> duplicateIndexReady{false};
+
+    public:
+        /// @brief Constructs an empty bank.
+        QuestionBank();
+
+        /// @brief Constructs a bank from the specified questions and builds its indexes.
+        /// @param questions The questions. The slot of a question is its position in the vector.
+        explicit QuestionBank(std::vector<std::shared_ptr<fq::Question>> questions);
+
+        /// @brief Returns the questions of the bank.
+        /// @return A vector of pointers to the questions, indexed by slot.
+        const std::vector<fq::Question *> &getQuestions() const { return questions; }
+
+        /// @brief Returns the number of questions in the bank.
+        std::size_t size() const { return questions.size(); }
+
+        /// @brief Returns the question in the specified slot.
+        /// @param slot A slot smaller than size().
+        fq::Question *at(std::uint32_t slot) const { return questions[slot]; }
+
+        /// @brief Returns the slot of a question.
+        /// @param question A pointer to the Question object.
+        /// @return The slot, or nothing if the question is not in the bank.
+        std::optional<std::uint32_t> slotOf(const fq::Question *question) const;
+
+        /// @brief Returns the question with the specified text.
+        /// @param text The text of the question.
+        /// @return A pointer to the question, or nullptr if no question of the bank has this text. If several
+        /// questions have it, the first of them.
+        fq::Question *find(std::string_view text) const;
+
+        /// @brief Returns shared ownership of a question of the bank, e.g. to put it into a derived bank.
+        /// @param question A pointer to the Question object.
+        /// @return The owner of the question, or nullptr if the question is not in the bank.
+        std::shared_ptr<fq::Question> share(const fq::Question *question) const;
+
+        /// @brief Returns the number of bytes used by the arrays, hash maps and indexes of the bank, excluding the
+        /// questions and the object itself.
+        std::size_t memoryUsage() const;
+
+        /// @brief Returns the index of the tags of the questions.
+        const TagIndex &getTagIndex() const { return tagIndex; }
+
+        /// @brief Returns the index of the questions bucketed by difficulty.
+        const DifficultyIndex &getDifficultyIndex() const { return difficultyIndex; }
+
+        /// @brief Returns the index of near-duplicate questions, with the default distance.
+        /// @details Only the question editor needs it, so it is built on the first call rather than with the bank. The
+        /// bank never changes, so the index is built at most once per bank and shared by every editor opened on it.
+        /// Thread-safe.
+        const DuplicateIndex &getDuplicateIndex() const;
+    };
+}
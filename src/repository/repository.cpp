@@ -1,170 +1,362 @@
 #include "repository.hpp"
+#include "shardedrepository.hpp"
 
-fq::Repository::Repository(const std::string &path) : path(path), disableStdDestructor(false), jsonType("unknown")
+fq::RepositoryFile fq::RepositoryFile::read(const std::string &path)
 {
+    RepositoryFile result;
+    std::vector<Question *> questions;
+    if (Snapshot::load(path, result.type, questions, result.hash))
+    {
+        result.snapshotQuestions = std::vector<std::shared_ptr<Question>>(questions.begin(), questions.end());
+        result.fromSnapshot = true;
+        return result;
+    }
     QFile file(QString::fromStdString(path));
+    // Taken before reading, so a change made while reading prevents writing a snapshot of the old contents.
+    qint64 modified = QFileInfo(QString::fromStdString(path)).lastModified().toMSecsSinceEpoch();
     if (!file.open(QIODevice::ReadOnly))
         throw std::runtime_error("Failed to open file: " + path);
-    QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    QByteArray contents = file.readAll();
     file.close();
+    result = fromJSON(contents);
+    result.modified = modified;
+    return result;
+}
+
+fq::RepositoryFile fq::RepositoryFile::fromJSON(const QByteArray &contents)
+{
+    RepositoryFile result;
+    result.json = QJsonDocument::fromJson(contents).object();
+    if (!result.json.contains("type") || !result.json["type"].isString())
+        throw std::runtime_error("Invalid JSON format: 'type' not found or is not a string");
+    result.type = result.json["type"].toString().toStdString();
+    result.contents = contents;
+    result.hash = QCryptographicHash::hash(contents, QCryptographicHash::Sha1);
+    return result;
+}
+
+std::vector<std::shared_ptr<fq::Question>> fq::RepositoryFile::questions() const
+{
+    if (fromSnapshot)
+        return snapshotQuestions;
     if (!json.contains("questions") || !json["questions"].isArray())
         throw std::runtime_error("Invalid JSON format: 'questions' not found or is not an array");
-    QJsonArray questionsArray = json["questions"].toArray();
-    for (const QJsonValue &value : questionsArray)
+    QJsonArray array = json["questions"].toArray();
+    std::vector<std::shared_ptr<Question>> parsed;
+    parsed.reserve(array.size());
+    for (const QJsonValue &value : array)
     {
         if (!value.isObject())
             throw std::runtime_error("Invalid question format in JSON");
-        QJsonObject questionObj = value.toObject();
-        Question *question = fq::Question::fromJSON(questionObj);
-        questions.push_back(question);
+        parsed.emplace_back(fq::Question::fromJSON(value.toObject()));
     }
+    return parsed;
 }
 
-std::size_t fq::Repository::getQuestionCount() const
+fq::Repository::Repository(const std::string &path, const RepositoryFile &file)
+    : bank(std::make_shared<const QuestionBank>(file.questions())), path(path), jsonType("unknown"), disableStdDestructor(false), modified(false), snapshots(false), fileHash(file.hash)
 {
-    return questions.size();
 }
 
-fq::RandomRepository::RandomRepository(const std::string &path) : Repository(path)
+fq::Repository::Repository() : bank(std::make_shared<const QuestionBank>()), jsonType("unknown"), disableStdDestructor(true), modified(false), snapshots(false)
 {
-    jsonType = "random";
 }
 
-fq::Question *fq::RandomRepository::getQuestion()
+std::unique_ptr<fq::Session> fq::Repository::createSession(std::uint32_t seed) const
 {
-    if (questions.empty())
-        throw std::runtime_error("No questions available in the repository");
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, questions.size() - 1);
-    int index = dis(gen);
-    return questions[index];
+    if (!session)
+        throw std::logic_error("Sessions can only be created for repositories backed by a single file");
+    return Session::create(jsonType, bank, seed);
 }
 
-fq::RandomNonRepeatingRepository::RandomNonRepeatingRepository(const std::string &path) : Repository(path)
+fq::SessionLog::ReplaySummary fq::Repository::openLog(bool resume)
 {
-    jsonType = "random_non_repeating";
-    remainingQuestions = questions;
+    if (!session)
+        throw std::logic_error("Only repositories backed by a single file can be logged");
+    std::string logPath = SessionLog::logPath(path);
+    SessionLog::ReplaySummary summary;
+    if (resume)
+    {
+        auto sessions = SessionLog::splitSessions(SessionLog::read(logPath));
+        if (!sessions.empty() && sessions.back().front().text == jsonType)
+        {
+            auto restored = Session::create(jsonType, bank, sessions.back().front().seed);
+            summary = restored->replay(sessions.back());
+            session = std::move(restored);
+            session->setLog(std::make_unique<SessionLog>(logPath));
+            return summary;
+        }
+    }
+    session->startLog(std::make_unique<SessionLog>(logPath), jsonType);
+    return summary;
 }
 
-fq::Question *fq::RandomNonRepeatingRepository::getQuestion()
+void fq::Repository::restartSession()
 {
-    if (questions.empty())
-        throw std::runtime_error("No questions available in the repository");
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    if (!remainingQuestions.size())
-        remainingQuestions = questions;
-    std::uniform_int_distribution<> dis(0, remainingQuestions.size() - 1);
-    int index = dis(gen);
-    return remainingQuestions[index];
+    if (!session)
+        throw std::logic_error("Only repositories backed by a single file have a session");
+    std::string expression = session->getFilter();
+    std::unique_ptr<SessionLog> log = session->releaseLog();
+    session = Session::create(jsonType, bank, std::random_device{}());
+    session->setFilter(expression);
+    if (log)
+        session->startLog(std::move(log), jsonType);
 }
 
-fq::IntelligentRepository::IntelligentRepository(const std::string &path) : Repository(path)
+fq::RandomRepository::RandomRepository(const std::string &path, const RepositoryFile &file) : Repository(path, file)
 {
-    jsonType = "intelligent";
-    remainingQuestions = questions;
+    jsonType = "random";
+    session = std::make_unique<RandomSession>(bank, std::random_device{}());
 }
 
-fq::Question *fq::IntelligentRepository::getQuestion()
+fq::RandomNonRepeatingRepository::RandomNonRepeatingRepository(const std::string &path, const RepositoryFile &file) : Repository(path, file)
 {
-    if (questions.empty())
-        throw std::runtime_error("No questions available in the repository");
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    if (!remainingQuestions.size())
-    {
-        remainingQuestions = hardQuestions.empty() ? questions : hardQuestions;
-        hardQuestions.clear();
-    }
-    std::uniform_int_distribution<> dis(0, remainingQuestions.size() - 1);
-    int index = dis(gen);
-    return remainingQuestions[index];
+    jsonType = "random_non_repeating";
+    session = std::make_unique<NonRepeatingSession>(bank, std::random_device{}());
 }
 
-void fq::IntelligentRepository::returnQuestion(Question *question, double score)
+fq::IntelligentRepository::IntelligentRepository(const std::string &path, const RepositoryFile &file) : Repository(path, file)
 {
-    if (score < 1.0)
-        hardQuestions.push_back(question);
+    jsonType = "intelligent";
+    session = std::make_unique<IntelligentSession>(bank, std::random_device{}());
 }
 
-fq::Repository *fq::Repository::createRepository(const std::string &path)
+fq::AdaptiveRepository::AdaptiveRepository(const std::string &path, const RepositoryFile &file) : Repository(path, file)
 {
-    QFile file(QString::fromStdString(path));
-    if (!file.open(QIODevice::ReadOnly))
-        throw std::runtime_error("Failed to open file: " + path);
-    QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
-    file.close();
-    if (!json.contains("type") || !json["type"].isString())
-        throw std::runtime_error("Invalid JSON format: 'type' not found or is not a string");
+    jsonType = "adaptive";
+    session = std::make_unique<AdaptiveSession>(bank, std::random_device{}());
+}
 
-    QString type = json["type"].toString();
-    if (type == "random")
-        return new RandomRepository(path);
-    else if (type == "random_non_repeating")
-        return new RandomNonRepeatingRepository(path);
-    else if (type == "intelligent")
-        return new IntelligentRepository(path);
+fq::Repository *fq::Repository::createRepository(const std::string &path, const RepositoryFile &file)
+{
+    if (file.type == "random")
+        return new RandomRepository(path, file);
+    else if (file.type == "random_non_repeating")
+        return new RandomNonRepeatingRepository(path, file);
+    else if (file.type == "intelligent")
+        return new IntelligentRepository(path, file);
+    else if (file.type == "adaptive")
+        return new AdaptiveRepository(path, file);
+    else if (file.type == "sharded")
+        return new ShardedRepository(path, file);
 
-    throw std::runtime_error("Unknown repository type: " + type.toStdString());
+    throw std::runtime_error("Unknown repository type: " + file.type);
+}
+
+fq::Repository *fq::Repository::createRepository(const std::string &path, bool snapshots)
+{
+    RepositoryFile file = RepositoryFile::read(path);
+    Repository *repository = createRepository(path, file);
+    // Sharded repositories hold no questions themselves; their shards are opened without snapshots.
+    if (snapshots && repository->session)
+    {
+        repository->snapshots = true;
+        if (!file.fromSnapshot)
+            Snapshot::save(path, file.contents, file.modified, file.type, repository->getQuestions());
+    }
+    return repository;
 }
 
 void fq::Repository::setQuestions(const std::vector<fq::Question *> &questions_)
 {
-    for (auto &question : questions)
+    std::vector<std::shared_ptr<Question>> owners;
+    owners.reserve(questions_.size());
+    for (auto &question : questions_)
     {
-        if (std::find(questions_.begin(), questions_.end(), question) == questions_.end())
-            delete question;
+        auto owner = bank->share(question);
+        owners.push_back(owner ? owner : std::shared_ptr<Question>(question));
     }
-    questions = questions_;
+    std::atomic_store(&bank, std::make_shared<const QuestionBank>(std::move(owners)));
+    modified = true;
+    session->setBank(bank);
 }
 
-fq::Repository::~Repository()
+std::size_t fq::Repository::addQuestions(const std::vector<fq::Question *> &questions_)
 {
-    if (!disableStdDestructor)
+    if (!isEditable())
+    {
+        for (auto *question : questions_)
+            delete question;
+        throw std::logic_error("Questions cannot be added to a read-only repository");
+    }
+    std::vector<std::shared_ptr<Question>> owners;
+    owners.reserve(bank->size() + questions_.size());
+    std::vector<std::optional<std::uint32_t>> previousSlots;
+    previousSlots.reserve(bank->size() + questions_.size());
+    std::unordered_set<std::string> texts;
+    texts.reserve(bank->size() + questions_.size());
+    for (std::uint32_t slot = 0; slot < bank->size(); ++slot)
     {
-        QJsonArray questionsArray;
-        for (const auto &question : questions)
+        owners.push_back(bank->share(bank->at(slot)));
+        previousSlots.push_back(slot);
+        texts.insert(bank->at(slot)->getQuestion());
+    }
+    std::size_t added = 0;
+    for (auto *question : questions_)
+    {
+        if (!texts.insert(question->getQuestion()).second)
         {
-            QJsonObject questionObj = question->toJSON();
-            questionsArray.append(questionObj);
+            delete question;
+            continue;
         }
-        QJsonObject json;
-        json["questions"] = questionsArray;
-        json["type"] = QString::fromStdString(jsonType);
-        QJsonDocument doc(json);
-        QFile file(QString::fromStdString(path));
-        if (!file.open(QIODevice::WriteOnly))
-            QMessageBox::critical(nullptr, "Error", QString::fromStdString("Failed to save repository: " + path));
+        owners.emplace_back(question);
+        previousSlots.emplace_back();
+        ++added;
+    }
+    if (!added)
+        return 0;
+    std::atomic_store(&bank, std::make_shared<const QuestionBank>(std::move(owners)));
+    modified = true;
+    // The existing questions keep their slots' draw state and history, so a running session goes on.
+    session->setBank(bank, previousSlots);
+    return added;
+}
+
+bool fq::Repository::applyEdits(const EditLog &log)
+{
+    if (!isEditable())
+        throw std::logic_error("Questions of a read-only repository cannot be edited");
+    if (log.getBase() != bank)
+        throw std::logic_error("The questions of the repository changed since the edits were started");
+    std::vector<EditLog::Change> changes = log.net();
+    if (changes.empty())
+        return false;
+    std::unordered_map<const Question *, std::shared_ptr<Question>> replaced;
+    std::vector<std::shared_ptr<Question>> owners;
+    owners.reserve(bank->size() + changes.size());
+    std::vector<std::optional<std::uint32_t>> previousSlots;
+    previousSlots.reserve(bank->size() + changes.size());
+    for (const auto &change : changes)
+    {
+        if (change.before)
+            replaced.emplace(change.before.get(), change.after);
+    }
+    for (std::uint32_t slot = 0; slot < bank->size(); ++slot)
+    {
+        auto it = replaced.find(bank->at(slot));
+        if (it == replaced.end())
+            owners.push_back(bank->share(bank->at(slot)));
+        else if (it->second)
+            owners.push_back(it->second);
         else
-            file.write(doc.toJson());
-        file.close();
+            continue;
+        // An edited question takes the place of its original, including its draw state and history.
+        previousSlots.push_back(slot);
     }
-    for (auto &question : questions)
+    for (const auto &change : changes)
     {
-        delete question;
+        if (!change.before)
+        {
+            owners.push_back(change.after);
+            previousSlots.emplace_back();
+        }
     }
+    std::atomic_store(&bank, std::make_shared<const QuestionBank>(std::move(owners)));
+    modified = true;
+    session->setBank(bank, previousSlots);
+    return true;
+}
+
+void fq::Repository::save()
+{
+    QByteArray contents = JsonWriter::writeRepository(bank->getQuestions(), jsonType);
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly))
+        throw std::runtime_error("Failed to save repository: " + path);
+    file.write(contents);
+    file.close();
+    modified = false;
+    fileHash = QCryptographicHash::hash(contents, QCryptographicHash::Sha1);
+    if (snapshots)
+        Snapshot::save(path, contents, QFileInfo(QString::fromStdString(path)).lastModified().toMSecsSinceEpoch(), jsonType, bank->getQuestions());
+}
+
+bool fq::Repository::isFileChanged() const
+{
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1) != fileHash;
 }
 
-void fq::RandomNonRepeatingRepository::setQuestions(const std::vector<fq::Question *> &questions_)
+fq::ReloadSummary fq::Repository::reload()
 {
-    for (auto &question : questions)
+    QFile input(QString::fromStdString(path));
+    qint64 fileModified = QFileInfo(QString::fromStdString(path)).lastModified().toMSecsSinceEpoch();
+    if (!input.open(QIODevice::ReadOnly))
+        throw std::runtime_error("Failed to open file: " + path);
+    QByteArray contents = input.readAll();
+    input.close();
+    if (QCryptographicHash::hash(contents, QCryptographicHash::Sha1) == fileHash)
+        return ReloadSummary();
+    RepositoryFile file = RepositoryFile::fromJSON(contents);
+    file.modified = fileModified;
+    std::vector<std::shared_ptr<Question>> loaded = file.questions();
+
+    // Questions are identified by their text; a question whose text changed is a removal and an addition.
+    const auto &questions = bank->getQuestions();
+    std::unordered_map<std::string, std::uint32_t> previousByText;
+    previousByText.reserve(questions.size());
+    for (std::uint32_t slot = 0; slot < questions.size(); ++slot)
+        previousByText.emplace(questions[slot]->getQuestion(), slot);
+
+    ReloadSummary summary;
+    std::vector<std::optional<std::uint32_t>> previousSlots(loaded.size());
+    std::vector<bool> matched(questions.size(), false);
+    for (std::size_t slot = 0; slot < loaded.size(); ++slot)
     {
-        if (std::find(questions_.begin(), questions_.end(), question) == questions_.end())
-            delete question;
+        auto it = previousByText.find(loaded[slot]->getQuestion());
+        if (it == previousByText.end() || matched[it->second])
+        {
+            ++summary.added;
+            continue;
+        }
+        matched[it->second] = true;
+        previousSlots[slot] = it->second;
+        if (questions[it->second]->hasSameContent(*loaded[slot]))
+            loaded[slot] = bank->share(questions[it->second]);
+        else
+            ++summary.edited;
     }
-    questions = questions_;
-    remainingQuestions = questions;
+    summary.removed = static_cast<std::size_t>(std::count(matched.begin(), matched.end(), false));
+
+    std::atomic_store(&bank, std::make_shared<const QuestionBank>(std::move(loaded)));
+    modified = false;
+    fileHash = file.hash;
+    session->setBank(bank, previousSlots);
+    if (snapshots)
+        Snapshot::save(path, file.contents, file.modified, file.type, bank->getQuestions());
+    return summary;
+}
+
+fq::QuestionStatistics &fq::Repository::getStatistics()
+{
+    if (!statistics)
+        statistics = path.empty() ? std::make_unique<QuestionStatistics>() : std::make_unique<QuestionStatistics>(QuestionStatistics::statisticsPath(path));
+    return *statistics;
 }
 
-void fq::IntelligentRepository::setQuestions(const std::vector<fq::Question *> &questions_)
+fq::MemoryUsage fq::Repository::getMemoryUsage() const
 {
-    for (auto &question : questions)
+    MemoryUsage usage = MemoryUsage::measure(*bank);
+    if (statistics)
+        usage.statisticsBytes = statistics->memoryUsage();
+    return usage;
+}
+
+fq::Repository::~Repository()
+{
+    if (statistics && statistics->isModified())
+        statistics->save();
+    if (!disableStdDestructor && modified)
     {
-        if (std::find(questions_.begin(), questions_.end(), question) == questions_.end())
-            delete question;
+        try
+        {
+            save();
+        }
+        catch (const std::runtime_error &e)
+        {
+            QMessageBox::critical(nullptr, "Error", QString::fromStdString(e.what()));
+        }
     }
-    questions = questions_;
-    remainingQuestions = questions;
-    hardQuestions.clear();
-}
\ No newline at end of file
+}
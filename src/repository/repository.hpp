@@ -7,12 +7,23 @@
 #include <vector>
 #include <stdexcept>
 #include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <optional>
+#include <memory>
+#include <atomic>
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QMessageBox>
 #include "question.hpp"
+#include "questionbank.hpp"
+#include "session.hpp"
+#include "snapshot.hpp"
+#include "statistics.hpp"
+#include "memoryusage.hpp"
+#include "editlog.hpp"
 
 /// @namespace fq
 /// @brief Contains classes and structures related to quiz questions and answers.
@@ -24,13 +35,78 @@
 namespace fq
 {
 
+    /// @brief Numbers of questions changed by reloading a repository from its JSON file.
+    struct ReloadSummary
+    {
+        /// @brief The number of questions which were not in the repository before.
+        std::size_t added = 0;
+
+        /// @brief The number of questions which are no longer in the file.
+        std::size_t removed = 0;
+
+        /// @brief The number of questions whose answers, explanation, tags, type or parameters changed.
+        std::size_t edited = 0;
+    };
+
+    /// @brief A repository file which has been read, before the repository of its type is constructed from it.
+    /// @details The file is read (and its snapshot checked) once, then handed to the constructor of the repository,
+    /// so opening a repository never reads, hashes or parses the same file twice.
+    struct RepositoryFile
+    {
+        /// @brief The type of the repository (e.g. "random").
+        std::string type;
+
+        /// @brief The root object of the JSON document. Empty if the questions were loaded from the snapshot.
+        QJsonObject json;
+
+        /// @brief The contents of the JSON file, kept to write its snapshot. Empty if loaded from the snapshot.
+        QByteArray contents;
+
+        /// @brief The modification time of the JSON file when it was read, in milliseconds since the epoch, or -1.
+        qint64 modified = -1;
+
+        /// @brief The SHA-1 hash of the contents of the JSON file.
+        QByteArray hash;
+
+        /// @brief The questions loaded from the snapshot.
+        std::vector<std::shared_ptr<Question>> snapshotQuestions;
+
+        /// @brief Whether the questions were loaded from the snapshot of the file.
+        bool fromSnapshot = false;
+
+        /// @brief Reads a repository file, or its snapshot if one matches the file.
+        /// @param path The path to the JSON file.
+        /// @return The read file.
+        /// @throws std::runtime_error if the file cannot be opened or has no type.
+        static RepositoryFile read(const std::string &path);
+
+        /// @brief Parses the contents of a repository file which have already been read.
+        /// @param contents The contents of the JSON file.
+        /// @return The parsed file, without a modification time.
+        /// @throws std::runtime_error if the contents have no type.
+        static RepositoryFile fromJSON(const QByteArray &contents);
+
+        /// @brief Returns the questions of the file, parsing them from the JSON document unless they came from the snapshot.
+        /// @return The questions, owned by the returned pointers.
+        /// @throws std::runtime_error if the JSON format is invalid.
+        std::vector<std::shared_ptr<Question>> questions() const;
+    };
+
     /// @brief Base class for repositories that manage a collection of questions.
-    /// @details This class provides a common interface for different types of question repositories.
+    /// @details This class provides a common interface for different types of question repositories. The questions
+    /// are kept in an immutable QuestionBank and the draw state in a Session of the type of the repository, so
+    /// further independent sessions (e.g. one per learner) can share the same questions; see createSession.
     class Repository
     {
     protected:
-        /// @brief Question collection loaded from the JSON file.
-        std::vector<fq::Question *> questions;
+        /// @brief The questions of the repository.
+        /// @details Replaced by a new bank whenever the questions change. The new bank is published with
+        /// std::atomic_store, so getBank may be called from other threads while the questions change; those threads
+        /// keep reading the previous bank for as long as they hold it.
+        std::shared_ptr<const QuestionBank> bank;
+
+        /// @brief The session of the repository, holding its draw state. nullptr for repositories composed of others.
+        std::unique_ptr<Session> session;
 
         /// @brief The path to the JSON file containing the questions.
         std::string path;
@@ -45,39 +121,239 @@ namespace fq
         /// cleanup logic in derived classes.
         bool disableStdDestructor;
 
-    public:
-        /// @brief Constructs a Repository with the specified path to the JSON file.
+        /// @brief Indicates whether the questions changed since the repository was loaded or saved.
+        /// @details The repository is only written back to its JSON file when it was modified, so changes made to
+        /// the file by other programs are never overwritten with an unchanged copy.
+        bool modified;
+
+        /// @brief Answer statistics of the questions, loaded when first used. See getStatistics.
+        std::unique_ptr<QuestionStatistics> statistics;
+
+        /// @brief Indicates whether a snapshot of the JSON file is written whenever it is read or saved. See Snapshot.
+        bool snapshots;
+
+        /// @brief The SHA-1 hash of the contents of the JSON file as last read or written by the repository.
+        /// @details Lets reload tell changes made by other programs from the repository's own saves.
+        QByteArray fileHash;
+
+        /// @brief Constructs an empty Repository which is not backed by a JSON file.
+        /// @details Used by repositories composed of other repositories. Such a repository is never saved and has no
+        /// session; it must override the methods drawing questions.
+        Repository();
+
+        /// @brief Constructs a Repository from its file.
+        /// @details Derived classes must create the session.
         /// @param path The path to the JSON file containing the questions.
-        /// @throws std::runtime_error if the file cannot be opened or if the JSON format is invalid.
-        Repository(const std::string &path);
+        /// @param file The file, already read.
+        /// @throws std::runtime_error if the JSON format is invalid.
+        Repository(const std::string &path, const RepositoryFile &file);
 
+    public:
         /// @brief Returns question from the repository.
         /// @return A pointer to a Question object.
-        virtual fq::Question *getQuestion() = 0;
+        /// @throws std::runtime_error if there are no questions available in the repository.
+        virtual fq::Question *getQuestion() { return session->next(); }
+
+        /// @brief Predicts the question the next call to getQuestion will return, without drawing it.
+        /// @details See Session::peek. Repositories composed of others do not predict their draws.
+        /// @return The predicted question, or nullptr if it cannot be predicted.
+        virtual const fq::Question *peekQuestion() { return session ? session->peek() : nullptr; }
 
         /// @brief Returns a question back to the repository with its score.
         /// @details This method allows the repository to handle the question based on its score.
         /// @param question A pointer to the Question object to be returned.
         /// @param score The score gained by the user from the question.
-        virtual void returnQuestion(fq::Question *question, double score) = 0;
+        /// @param chosenAnswers The indices of the answers chosen by the user, written to the session log.
+        virtual void returnQuestion(fq::Question *question, double score, const std::vector<std::uint32_t> &chosenAnswers = {}) { session->answer(question, score, chosenAnswers); }
+
+        /// @brief Records how long the user took to answer a question and the score gained.
+        /// @details Must be called before the question is returned with returnQuestion.
+        /// @param question A pointer to the answered Question object.
+        /// @param latency The time between showing the question and the answer, in seconds.
+        /// @param score The score gained by the user from the question.
+        virtual void recordResponse(const fq::Question *question, double latency, double score)
+        {
+            if (const Question *answered = session->origin(question))
+                getStatistics().record(answered, latency, score);
+        }
+
+        /// @brief Returns the answer statistics of the questions of the repository.
+        /// @details The statistics are loaded from the ".fqstats" file next to the JSON file when first used, and
+        /// written back when the repository is destroyed, if answers were recorded. Repositories which are not backed
+        /// by a single file keep them in memory only.
+        /// @return The statistics.
+        QuestionStatistics &getStatistics();
+
+        /// @brief Estimates the memory used by the questions of the repository and their statistics.
+        /// @details Only questions in memory are counted, e.g. only the loaded shards of a sharded repository.
+        /// @return The usage by category and by question type.
+        virtual MemoryUsage getMemoryUsage() const;
 
         /// @brief Returns the number of questions in the repository.
         /// @return The number of questions available in the repository.
-        std::size_t getQuestionCount() const;
+        virtual std::size_t getQuestionCount() const { return bank->size(); }
+
+        /// @brief Returns the number of questions matching the current filter.
+        /// @return The number of questions which can be drawn from the repository.
+        virtual std::size_t getFilteredCount() const { return session->getFilteredCount(); }
+
+        /// @brief Returns the index of the tags of the questions in the repository.
+        /// @return A reference to the tag index. It stays valid until the questions change.
+        const TagIndex &getTagIndex() const { return bank->getTagIndex(); }
+
+        /// @brief Returns the number of questions carrying each tag.
+        /// @return A map from tags to question counts.
+        virtual std::map<std::string, std::size_t> getTagCounts() const { return bank->getTagIndex().getTagCounts(); }
+
+        /// @brief Returns the tag expression used to filter drawn questions.
+        /// @return The current filter expression. Empty if all questions are drawn.
+        virtual const std::string &getFilter() const { return session->getFilter(); }
+
+        /// @brief Restricts drawn questions to those matching a tag expression.
+        /// @details The draw state of the repository is reset. See TagIndex::evaluate for the expression syntax.
+        /// @param expression The tag expression. An empty expression removes the filter.
+        /// @throws std::invalid_argument if the expression is malformed. The previous filter is kept in that case.
+        virtual void setFilter(const std::string &expression) { session->setFilter(expression); }
+
+        /// @brief Returns a random presentation order of the answers of a question.
+        /// @details The order is drawn from the session random number generator. The question itself is not modified.
+        /// @param question A pointer to the Question object to be presented.
+        /// @return A vector of indices into the answers of the question, in the order they should be presented.
+        virtual std::vector<std::size_t> getAnswerOrder(const fq::Question *question) { return session->getAnswerOrder(question); }
 
         /// @brief Factory function to create a repository based on the specified path.
+        /// @details The file is read once. A snapshot matching the file is always used if there is one, but snapshots are
+        /// only written if requested, so tools which only read a repository leave no files behind.
         /// @param path The path to the JSON file containing the questions.
+        /// @param snapshots true to write a snapshot of the file whenever it is read or saved, to reopen it faster.
         /// @return A pointer to a Repository object.
         /// @throws std::runtime_error if the file cannot be opened or if the JSON format is invalid.
-        static Repository *createRepository(const std::string &path);
+        static Repository *createRepository(const std::string &path, bool snapshots = false);
+
+        /// @brief Factory function to create a repository from a file which has already been read.
+        /// @param path The path to the JSON file containing the questions.
+        /// @param file The file.
+        /// @return A pointer to a Repository object. No snapshot is written for it.
+        /// @throws std::runtime_error if the JSON format is invalid or the type is unknown.
+        static Repository *createRepository(const std::string &path, const RepositoryFile &file);
+
+        /// @brief Returns the bank holding the current questions of the repository.
+        /// @details Taking the bank is a snapshot of the questions: it is constant time, and the snapshot is not
+        /// affected by later changes. It may be called from any thread.
+        /// @return The bank. It is never nullptr and never changes; changing the questions replaces it.
+        std::shared_ptr<const QuestionBank> getBank() const { return std::atomic_load(&bank); }
+
+        /// @brief Creates a new session of the type of the repository, drawing from its current questions.
+        /// @details The session is independent of the repository and of other sessions. It keeps drawing from the
+        /// current bank even if the questions of the repository change later.
+        /// @param seed Seed of the random number generator of the session.
+        /// @return The new session.
+        /// @throws std::logic_error if the repository is composed of other repositories.
+        std::unique_ptr<Session> createSession(std::uint32_t seed) const;
+
+        /// @brief Writes the session of the repository to its log, after resuming the last logged session if requested.
+        /// @details The log is stored next to the JSON file; see SessionLog. A session is resumed by replaying the
+        /// last session in the log, if it has the type of the repository. Otherwise, a new session is started in the log.
+        /// Must be called before any question is drawn.
+        /// @param resume true to resume the last logged session; false to start a new one.
+        /// @return A summary of the replayed session. Empty if a new session was started.
+        /// @throws std::logic_error if the repository is composed of other repositories.
+        /// @throws std::runtime_error if the log cannot be opened.
+        SessionLog::ReplaySummary openLog(bool resume);
+
+        /// @brief Takes the session out of the repository, e.g. to keep its draw state while the repository is unloaded.
+        /// @details The repository must not be used afterwards, except to be destroyed or given a session with setSession.
+        /// @return The session, or nullptr for repositories composed of others.
+        std::unique_ptr<Session> releaseSession() { return std::move(session); }
+
+        /// @brief Replaces the session of the repository, e.g. by one released from an earlier instance of it.
+        /// @param newSession The session. Must draw from the bank of the repository and have its type.
+        void setSession(std::unique_ptr<Session> newSession) { session = std::move(newSession); }
+
+        /// @brief Replaces the session of the repository by a new one, forgetting its history and draw state.
+        /// @details The filter is kept. If the session is logged, the new session is started in the same log.
+        /// @throws std::logic_error if the repository is composed of other repositories.
+        void restartSession();
 
         /// @brief Returns the collection of questions in the repository.
-        /// @return A vector of pointers to Question objects.
-        std::vector<fq::Question *> getQuestions() const { return questions; }
+        /// @return A vector of pointers to Question objects, valid until the questions change. Use getBank to keep
+        /// them longer.
+        const std::vector<fq::Question *> &getQuestions() const { return bank->getQuestions(); }
+
+        /// @brief Returns whether a question belongs to the repository.
+        /// @details Questions removed or edited by reload are deleted once no session uses them any more, so pointers
+        /// obtained earlier must be checked.
+        /// @param question A pointer to the Question object, or to the variant of a template returned by getQuestion.
+        /// @return true if the question (or the template of the variant) is in the repository; false otherwise.
+        bool contains(const fq::Question *question) const { return bank->slotOf(session->origin(question)).has_value(); }
+
+        /// @brief Returns the path to the JSON file of the repository.
+        /// @return The path, or an empty string if the repository is not backed by a single file.
+        const std::string &getPath() const { return path; }
 
         /// @brief Sets the collection of questions in the repository.
+        /// @details The draw state of the repository is reset and the repository is marked as modified. Questions which
+        /// are not in the repository yet are owned by it from now on; removed questions are deleted once no session
+        /// uses them any more.
         /// @param questions_ A vector of pointers to Question objects to be set in the repository.
-        virtual void setQuestions(const std::vector<fq::Question *> &questions_);
+        void setQuestions(const std::vector<fq::Question *> &questions_);
+
+        /// @brief Adds questions to the repository in one pass, e.g. after a bulk import.
+        /// @details Like setQuestions, builds one new bank, but the running session keeps its draw state and history
+        /// for the questions already in the repository. Questions whose text is already in the repository, or repeats
+        /// an earlier added question, are deleted instead of added.
+        /// @param questions_ The questions to add. The repository takes ownership of all of them.
+        /// @return The number of questions added.
+        /// @throws std::logic_error if the repository is not editable.
+        std::size_t addQuestions(const std::vector<fq::Question *> &questions_);
+
+        /// @brief Applies the commands of an edit log which are done, in one batch.
+        /// @details Only the combined effect of the commands is applied (see EditLog::net): edited questions keep
+        /// their position, removed questions are dropped and added questions are appended. Like setQuestions, builds
+        /// one new bank, but the running session keeps its draw state and history: edited questions continue those of
+        /// their originals and only the answers to removed questions are forgotten. Nothing happens if the commands
+        /// have no effect.
+        /// @param log The edit log, started on the current bank of the repository.
+        /// @return true if the questions changed; false otherwise.
+        /// @throws std::logic_error if the repository is not editable or its questions changed since the log was started.
+        bool applyEdits(const EditLog &log);
+
+        /// @brief Enables or disables saving the repository to its JSON file when it is destroyed.
+        /// @details Saving is enabled by default; only modified repositories are saved. Tools which only read a repository should disable it.
+        /// @param enabled true to save the repository when it is destroyed; false otherwise.
+        void setAutoSave(bool enabled) { disableStdDestructor = !enabled; }
+
+        /// @brief Returns whether the questions changed since the repository was loaded or saved.
+        bool isModified() const { return modified; }
+
+        /// @brief Returns whether the JSON file holds other contents than the repository last read or wrote.
+        /// @return true if another program changed the file; false if it is unchanged or cannot be read.
+        bool isFileChanged() const;
+
+        /// @brief Writes the repository to its JSON file.
+        /// @throws std::runtime_error if the file cannot be written.
+        void save();
+
+        /// @brief Reloads the questions from the JSON file, applying only the differences.
+        /// @details Nothing is parsed if the contents of the file are the ones the repository last read or wrote, e.g.
+        /// when the change notification was caused by save. Otherwise questions are identified by their text and
+        /// compared field by field (see Question::hasSameContent). Unchanged questions are kept (pointers to them stay
+        /// valid), edited and added questions are replaced by their new versions and removed questions are dropped. The
+        /// draw state of the repository is carried over, so already asked questions are not asked again. The type of
+        /// the repository is kept even if it changed in the file. Unsaved changes (see isModified) are discarded, so
+        /// callers should ask the user first.
+        /// @return The numbers of added, removed and edited questions.
+        /// @throws std::runtime_error if the file cannot be opened or its JSON format is invalid. The questions are
+        /// left unchanged in that case.
+        ReloadSummary reload();
+
+        /// @brief Returns the type of the repository, as stored in its JSON file.
+        /// @return The repository type (e.g. "random").
+        const std::string &getType() const { return jsonType; }
+
+        /// @brief Returns whether the questions of the repository can be edited.
+        /// @return true if setQuestions may be used to change the questions; false otherwise.
+        virtual bool isEditable() const { return true; }
 
         /// @brief Virtual destructor for the Repository class.
         virtual ~Repository();
@@ -89,77 +365,55 @@ namespace fq
     public:
         /// @brief Constructs a RandomRepository with the specified path to the JSON file.
         /// @param path The path to the JSON file containing the questions.
-        /// @throws std::runtime_error if the file cannot be opened or if the JSON format is invalid.
-        RandomRepository(const std::string &path);
-
-        /// @brief Returns a random question from the repository.
-        /// @return A pointer to a randomly selected Question object.
-        /// @throws std::runtime_error if there are no questions available in the repository.
-        virtual fq::Question *getQuestion() override;
-
-        /// @brief Returns a question back to the repository with its score.
-        /// @details In this implementation, this function does nothing, as questions are not returned to the repository.
-        /// @param question A pointer to the Question object to be returned.
-        /// @param score The score gained by the user from the question.
-        virtual void returnQuestion(fq::Question *question, double score) override {};
+        /// @param file The file, already read.
+        /// @throws std::runtime_error if the JSON format is invalid.
+        RandomRepository(const std::string &path, const RepositoryFile &file);
     };
 
-    /// @brief Class representing a repository that provides questions randomly without repeating them.
+    /// @brief Class representing a repository that provides questions randomly without repeating them, unless all
+    /// questions have been asked.
     class RandomNonRepeatingRepository : public Repository
     {
-        /// @brief A collection of remaining questions that have not been asked yet.
-        std::vector<fq::Question *> remainingQuestions;
-
     public:
         /// @brief Constructs a RandomNonRepeatingRepository with the specified path to the JSON file.
         /// @param path The path to the JSON file containing the questions.
-        /// @throws std::runtime_error if the file cannot be opened or if the JSON format is invalid.
-        RandomNonRepeatingRepository(const std::string &path);
-
-        /// @brief Returns a random question from the repository without repeating previously asked questions, unless all questions have been asked.
-        /// @return A pointer to a randomly selected Question object.
-        /// @throws std::runtime_error if there are no questions available in the repository.
-        virtual fq::Question *getQuestion() override;
-
-        /// @brief Returns a question back to the repository with its score.
-        /// @details In this implementation, this function does nothing, as questions are not returned to the repository.
-        /// @param question A pointer to the Question object to be returned.
-        /// @param score The score gained by the user from the question.
-        virtual void returnQuestion(fq::Question *question, double score) override {};
-
-        /// @brief Sets the collection of questions in the repository.
-        /// @param questions_ A vector of pointers to Question objects to be set in the repository.
-        virtual void setQuestions(const std::vector<fq::Question *> &questions_) override;
+        /// @param file The file, already read.
+        /// @throws std::runtime_error if the JSON format is invalid.
+        RandomNonRepeatingRepository(const std::string &path, const RepositoryFile &file);
     };
 
     /// @brief Class representing a repository that provides questions intelligently based on user performance.
+    /// @details Every question is asked once; then the questions the user has scored less than 1.0 on are repeated.
+    /// If there are no such questions, all questions are asked again.
     class IntelligentRepository : public Repository
     {
-        /// @brief A collection of remaining questions that have not been asked yet.
-        std::vector<fq::Question *> remainingQuestions;
-
-        /// @brief A collection of hard questions that the user has struggled with.
-        /// @details Hard questions are those that the user has scored less than 1.0 on.
-        std::vector<fq::Question *> hardQuestions;
-
     public:
         /// @brief Constructs an IntelligentRepository with the specified path to the JSON file.
         /// @param path The path to the JSON file containing the questions.
-        IntelligentRepository(const std::string &path);
+        /// @param file The file, already read.
+        /// @throws std::runtime_error if the JSON format is invalid.
+        IntelligentRepository(const std::string &path, const RepositoryFile &file);
+    };
 
-        /// @brief Returns a random question from the repository. If there are no remaining questions, it will select from hard questions.
-        /// @details If the user has answered all questions, it will select from hard questions that the user has struggled with.
-        /// If there are no hard questions remaining, it will select from all questions.
-        /// @return A pointer to a randomly selected Question object.
-        /// @throws std::runtime_error if there are no questions available in the repository.
-        virtual fq::Question *getQuestion() override;
+    /// @brief Class representing a computerized adaptive testing repository.
+    /// @details The repository keeps an estimate of the ability of the user, updated from the score of every answered
+    /// question using the two-parameter logistic item response model (the difficulty and discrimination of each question).
+    /// The next question is always the not yet asked one with the maximum Fisher information at the current estimate.
+    class AdaptiveRepository : public Repository
+    {
+    public:
+        /// @brief Constructs an AdaptiveRepository with the specified path to the JSON file.
+        /// @param path The path to the JSON file containing the questions.
+        /// @param file The file, already read.
+        /// @throws std::runtime_error if the JSON format is invalid.
+        AdaptiveRepository(const std::string &path, const RepositoryFile &file);
 
-        /// @brief Returns a question back to the repository with its score.
-        /// @details If the score is less than 1.0, the question is added to the hard questions collection for future consideration.
-        virtual void returnQuestion(fq::Question *question, double score) override;
+        /// @brief Returns the current estimate of the ability of the user.
+        /// @return The ability, on the same scale as the difficulty of the questions.
+        double getAbility() const { return static_cast<const AdaptiveSession &>(*session).getAbility(); }
 
-        /// @brief Sets the collection of questions in the repository.
-        /// @param questions_ A vector of pointers to Question objects to be set in the repository.
-        virtual void setQuestions(const std::vector<fq::Question *> &questions_) override;
+        /// @brief Returns the standard error of the current ability estimate.
+        /// @return The standard error of the ability estimate.
+        double getAbilityError() const { return static_cast<const AdaptiveSession &>(*session).getAbilityError(); }
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,462 @@
+#include "session.hpp"
+
+fq::Session::Session(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed) : bank(std::move(bank)), generator(seed), seed(seed)
+{
+    evaluateFilter();
+}
+
+void fq::Session::evaluateFilter()
+{
+    try
+    {
+        filter = bank->getTagIndex().evaluate(filterExpression);
+    }
+    catch (const std::invalid_argument &)
+    {
+        filterExpression.clear();
+        filter = bank->getTagIndex().all();
+    }
+}
+
+std::uint32_t fq::Session::drawSlot(const Bitset &from)
+{
+    std::uniform_int_distribution<std::size_t> dis(0, from.size() - 1);
+    return from.select(dis(generator));
+}
+
+fq::Bitset fq::Session::remapSlots(const Bitset &previous, const std::vector<std::optional<std::uint32_t>> &previousSlots, bool includeAdded)
+{
+    Bitset result;
+    for (std::uint32_t slot = 0; slot < previousSlots.size(); ++slot)
+    {
+        if (previousSlots[slot] ? previous.contains(*previousSlots[slot]) : includeAdded)
+            result.add(slot);
+    }
+    return result;
+}
+
+fq::Question *fq::Session::next()
+{
+    if (!bank->size())
+        throw std::runtime_error("No questions available in the repository");
+    if (filter.empty())
+        throw std::runtime_error("No questions match the current filter");
+    std::uint32_t slot = selectSlot();
+    markDrawn(slot);
+    cursor = slot;
+    if (log)
+    {
+        SessionLog::Record record;
+        record.type = SessionLog::RecordType::Draw;
+        record.timestamp = SessionLog::now();
+        record.question = SessionLog::questionId(bank->at(slot));
+        log->append(record);
+    }
+    // The previous variant is dropped first, so a template without a valid variant leaves none behind.
+    variant.reset();
+    variant = bank->at(slot)->instantiate(generator);
+    return variant ? variant.get() : bank->at(slot);
+}
+
+const fq::Question *fq::Session::peek()
+{
+    if (!bank->size() || filter.empty())
+        return nullptr;
+    // Selecting a slot only advances the generator, which is restored so the next draw is the same.
+    std::mt19937 saved = generator;
+    std::uint32_t slot = selectSlot();
+    generator = saved;
+    return bank->at(slot);
+}
+
+const fq::Question *fq::Session::origin(const fq::Question *question) const
+{
+    if (question && question == variant.get())
+        return cursor ? bank->at(*cursor) : nullptr;
+    return question;
+}
+
+void fq::Session::recordAnswer(std::uint32_t slot, double score)
+{
+    history.push_back({slot, score});
+    recordScore(slot, score);
+}
+
+void fq::Session::answer(const fq::Question *question, double score, const std::vector<std::uint32_t> &chosenAnswers)
+{
+    auto slot = question && question == variant.get() ? cursor : bank->slotOf(question);
+    if (!slot)
+        return;
+    recordAnswer(*slot, score);
+    if (log)
+    {
+        SessionLog::Record record;
+        record.type = SessionLog::RecordType::Answer;
+        record.timestamp = SessionLog::now();
+        record.question = SessionLog::questionId(bank->at(*slot));
+        record.chosenAnswers = chosenAnswers;
+        record.score = score;
+        log->append(record);
+    }
+}
+
+std::vector<std::size_t> fq::Session::getAnswerOrder(const fq::Question *question)
+{
+    return question->getAnswerOrder(generator);
+}
+
+void fq::Session::setFilter(const std::string &expression)
+{
+    filter = bank->getTagIndex().evaluate(expression);
+    filterExpression = expression;
+    resetDrawState();
+    if (log)
+    {
+        SessionLog::Record record;
+        record.type = SessionLog::RecordType::Filter;
+        record.timestamp = SessionLog::now();
+        record.text = expression;
+        log->append(record);
+    }
+}
+
+void fq::Session::reseed(std::uint32_t newSeed)
+{
+    seed = newSeed;
+    generator.seed(seed);
+    if (log)
+    {
+        SessionLog::Record record;
+        record.type = SessionLog::RecordType::Reseed;
+        record.timestamp = SessionLog::now();
+        record.seed = seed;
+        log->append(record);
+    }
+}
+
+void fq::Session::setBank(std::shared_ptr<const QuestionBank> newBank)
+{
+    bank = std::move(newBank);
+    cursor.reset();
+    history.clear();
+    evaluateFilter();
+    resetDrawState();
+    if (log)
+        reseed(std::random_device{}());
+}
+
+void fq::Session::setBank(std::shared_ptr<const QuestionBank> newBank, const std::vector<std::optional<std::uint32_t>> &previousSlots)
+{
+    bank = std::move(newBank);
+    std::vector<std::optional<std::uint32_t>> currentSlots;
+    for (std::uint32_t slot = 0; slot < previousSlots.size(); ++slot)
+    {
+        if (!previousSlots[slot])
+            continue;
+        if (currentSlots.size() <= *previousSlots[slot])
+            currentSlots.resize(*previousSlots[slot] + 1);
+        currentSlots[*previousSlots[slot]] = slot;
+    }
+    auto current = [&currentSlots](std::uint32_t previous) -> std::optional<std::uint32_t>
+    {
+        return previous < currentSlots.size() ? currentSlots[previous] : std::nullopt;
+    };
+    if (cursor)
+        cursor = current(*cursor);
+    std::vector<HistoryEntry> kept;
+    kept.reserve(history.size());
+    for (const auto &entry : history)
+    {
+        if (auto slot = current(entry.slot))
+            kept.push_back({*slot, entry.score});
+    }
+    history = std::move(kept);
+    evaluateFilter();
+    remapDrawState(previousSlots);
+    if (log)
+        reseed(std::random_device{}());
+}
+
+void fq::Session::detachBank()
+{
+    bank.reset();
+    variant.reset();
+}
+
+void fq::Session::attachBank(std::shared_ptr<const QuestionBank> sameBank)
+{
+    std::vector<std::optional<std::uint32_t>> previousSlots(sameBank->size());
+    for (std::uint32_t slot = 0; slot < previousSlots.size(); ++slot)
+        previousSlots[slot] = slot;
+    setBank(std::move(sameBank), previousSlots);
+}
+
+void fq::Session::startLog(std::unique_ptr<SessionLog> newLog, const std::string &type)
+{
+    log = std::move(newLog);
+    SessionLog::Record record;
+    record.type = SessionLog::RecordType::Start;
+    record.timestamp = SessionLog::now();
+    record.seed = seed;
+    record.text = type;
+    log->append(record);
+    if (!filterExpression.empty())
+    {
+        record.type = SessionLog::RecordType::Filter;
+        record.text = filterExpression;
+        log->append(record);
+    }
+}
+
+fq::SessionLog::ReplaySummary fq::Session::replay(const std::vector<SessionLog::Record> &records)
+{
+    std::unique_ptr<SessionLog> attached = std::move(log);
+    std::unordered_map<std::uint64_t, std::uint32_t> slotsById;
+    slotsById.reserve(bank->size());
+    for (std::uint32_t slot = 0; slot < bank->size(); ++slot)
+        slotsById.emplace(SessionLog::questionId(bank->at(slot)), slot);
+    SessionLog::ReplaySummary summary;
+    for (const auto &record : records)
+    {
+        auto recorded = slotsById.find(record.question);
+        switch (record.type)
+        {
+        case SessionLog::RecordType::Start:
+        case SessionLog::RecordType::Reseed:
+            seed = record.seed;
+            generator.seed(seed);
+            break;
+        case SessionLog::RecordType::Filter:
+            try
+            {
+                setFilter(record.text);
+            }
+            catch (const std::invalid_argument &)
+            {
+                // The tags of the questions changed; the session goes on with its previous filter.
+            }
+            break;
+        case SessionLog::RecordType::Draw:
+        {
+            ++summary.draws;
+            variant.reset();
+            std::optional<std::uint32_t> slot;
+            if (!filter.empty())
+                slot = selectSlot();
+            if (slot && SessionLog::questionId(bank->at(*slot)) == record.question)
+            {
+                ++summary.verifiedDraws;
+                // Variants use the generator, so they are generated again to keep the draws in step. A template
+                // without a valid variant failed the same way when it was drawn, so the question was not asked.
+                try
+                {
+                    variant = bank->at(*slot)->instantiate(generator);
+                    getAnswerOrder(variant ? variant.get() : bank->at(*slot));
+                }
+                catch (const std::runtime_error &)
+                {
+                }
+            }
+            else if (recorded != slotsById.end())
+                slot = recorded->second;
+            else
+            {
+                ++summary.missingQuestions;
+                cursor.reset();
+                break;
+            }
+            markDrawn(*slot);
+            cursor = slot;
+            break;
+        }
+        case SessionLog::RecordType::Answer:
+        {
+            ++summary.answers;
+            summary.totalScore += record.score;
+            if (recorded == slotsById.end())
+            {
+                ++summary.missingQuestions;
+                break;
+            }
+            const Question *question = bank->at(recorded->second);
+            const auto &answers = question->getAnswers();
+            std::vector<Answer> chosen;
+            bool valid = true;
+            for (std::uint32_t index : record.chosenAnswers)
+            {
+                if (index >= answers.size())
+                {
+                    valid = false;
+                    break;
+                }
+                chosen.push_back(answers[index]);
+            }
+            try
+            {
+                if (!valid || std::abs(question->getScore(chosen) - record.score) > 1e-9)
+                    ++summary.scoreMismatches;
+            }
+            catch (const std::invalid_argument &)
+            {
+                ++summary.scoreMismatches;
+            }
+            recordAnswer(recorded->second, record.score);
+            break;
+        }
+        }
+    }
+    log = std::move(attached);
+    return summary;
+}
+
+std::unique_ptr<fq::Session> fq::Session::create(const std::string &type, std::shared_ptr<const QuestionBank> bank, std::uint32_t seed)
+{
+    if (type == "random")
+        return std::make_unique<RandomSession>(std::move(bank), seed);
+    else if (type == "random_non_repeating")
+        return std::make_unique<NonRepeatingSession>(std::move(bank), seed);
+    else if (type == "intelligent")
+        return std::make_unique<IntelligentSession>(std::move(bank), seed);
+    else if (type == "adaptive")
+        return std::make_unique<AdaptiveSession>(std::move(bank), seed);
+    throw std::invalid_argument("Unknown session type: " + type);
+}
+
+std::uint32_t fq::RandomSession::selectSlot()
+{
+    return drawSlot(filter);
+}
+
+fq::NonRepeatingSession::NonRepeatingSession(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed) : Session(std::move(bank), seed)
+{
+    resetDrawState();
+}
+
+void fq::NonRepeatingSession::resetDrawState()
+{
+    remainingQuestions = filter;
+}
+
+void fq::NonRepeatingSession::remapDrawState(const std::vector<std::optional<std::uint32_t>> &previousSlots)
+{
+    remainingQuestions = remapSlots(remainingQuestions, previousSlots, true) & filter;
+}
+
+std::uint32_t fq::NonRepeatingSession::selectSlot()
+{
+    return drawSlot(remainingQuestions.empty() ? filter : remainingQuestions);
+}
+
+void fq::NonRepeatingSession::markDrawn(std::uint32_t slot)
+{
+    if (remainingQuestions.empty())
+        remainingQuestions = filter;
+    remainingQuestions.remove(slot);
+}
+
+fq::IntelligentSession::IntelligentSession(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed) : Session(std::move(bank), seed)
+{
+    resetDrawState();
+}
+
+void fq::IntelligentSession::resetDrawState()
+{
+    remainingQuestions = filter;
+    hardQuestions.clear();
+}
+
+void fq::IntelligentSession::remapDrawState(const std::vector<std::optional<std::uint32_t>> &previousSlots)
+{
+    remainingQuestions = remapSlots(remainingQuestions, previousSlots, true) & filter;
+    hardQuestions = remapSlots(hardQuestions, previousSlots, false);
+}
+
+std::uint32_t fq::IntelligentSession::selectSlot()
+{
+    if (!remainingQuestions.empty())
+        return drawSlot(remainingQuestions);
+    Bitset nextRound = hardQuestions & filter;
+    return drawSlot(nextRound.empty() ? filter : nextRound);
+}
+
+void fq::IntelligentSession::markDrawn(std::uint32_t slot)
+{
+    if (remainingQuestions.empty())
+    {
+        remainingQuestions = hardQuestions & filter;
+        if (remainingQuestions.empty())
+            remainingQuestions = filter;
+        hardQuestions.clear();
+    }
+    remainingQuestions.remove(slot);
+}
+
+void fq::IntelligentSession::recordScore(std::uint32_t slot, double score)
+{
+    if (score < 1.0)
+        hardQuestions.add(slot);
+}
+
+fq::AdaptiveSession::AdaptiveSession(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed)
+    : Session(std::move(bank), seed), ability(0.0), abilityError(1.0)
+{
+    resetDrawState();
+}
+
+void fq::AdaptiveSession::resetDrawState()
+{
+    remainingQuestions = filter;
+}
+
+void fq::AdaptiveSession::remapDrawState(const std::vector<std::optional<std::uint32_t>> &previousSlots)
+{
+    remainingQuestions = remapSlots(remainingQuestions, previousSlots, true) & filter;
+}
+
+std::uint32_t fq::AdaptiveSession::selectSlot()
+{
+    const Bitset &candidates = remainingQuestions.empty() ? filter : remainingQuestions;
+    std::uint32_t slot;
+    if (!bank->getDifficultyIndex().selectMaximumInformation(ability, candidates, slot))
+        slot = drawSlot(candidates);
+    return slot;
+}
+
+void fq::AdaptiveSession::markDrawn(std::uint32_t slot)
+{
+    if (remainingQuestions.empty())
+        remainingQuestions = filter;
+    remainingQuestions.remove(slot);
+}
+
+void fq::AdaptiveSession::recordScore(std::uint32_t slot, double score)
+{
+    const Question *question = bank->at(slot);
+    responses.push_back({question->getDiscrimination(), question->getDifficulty(), std::max(0.0, std::min(1.0, score))});
+    estimateAbility();
+}
+
+void fq::AdaptiveSession::estimateAbility()
+{
+    const double limit = 6.0;
+    double estimate = ability;
+    double curvature = -1.0;
+    for (int iteration = 0; iteration < 50; ++iteration)
+    {
+        // Log-posterior with a standard normal prior: its gradient and (negative) second derivative.
+        double gradient = -estimate;
+        curvature = -1.0;
+        for (const auto &response : responses)
+        {
+            double p = DifficultyIndex::probability(response.discrimination, response.difficulty, estimate);
+            gradient += response.discrimination * (response.score - p);
+            curvature -= response.discrimination * response.discrimination * p * (1.0 - p);
+        }
+        double step = gradient / curvature;
+        estimate = std::max(-limit, std::min(limit, estimate - step));
+        if (std::abs(step) < 1e-6)
+            break;
+    }
+    ability = estimate;
+    abilityError = 1.0 / std::sqrt(-curvature);
+}
@@ -0,0 +1,382 @@
+/// @file session.hpp
+/// @brief Contains definitions for sessions, which hold the state of one learner drawing from a question bank.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include "questionbank.hpp"
+#include "sessionlog.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Base class for the state of one learner drawing questions from a shared bank.
+    /// @details A session holds everything that changes while questions are asked (random number generator, filter,
+    /// cursor, history and the draw state of derived classes), while the bank itself is immutable and shared. Sessions
+    /// are cheap, so one process can serve many learners from a single copy of the bank. A session must only be used
+    /// by one thread at a time; different sessions can be used concurrently without any locking.
+    ///
+    /// A session can write everything that happens in it to a SessionLog, and a session can be restored from its log
+    /// by replaying it. For the replay to reproduce the draws, getAnswerOrder must be called exactly once for every
+    /// drawn question, right after next.
+    ///
+    /// Template questions (see TemplateQuestion) are never asked as they are: next generates a variant with the
+    /// random number generator of the session, and the session owns it until the next draw. Answers to the variant
+    /// are recorded, logged and counted in the statistics as answers to its template.
+    class Session
+    {
+    public:
+        /// @brief An answered question.
+        struct HistoryEntry
+        {
+            /// @brief The slot of the question in the bank of the session.
+            std::uint32_t slot;
+
+            /// @brief The score gained by the learner.
+            double score;
+        };
+
+    protected:
+        /// @brief The bank the questions are drawn from.
+        std::shared_ptr<const QuestionBank> bank;
+
+        /// @brief Random number generator of the session, used for drawing questions and ordering their answers.
+        std::mt19937 generator;
+
+        /// @brief The seed the random number generator was last seeded with.
+        std::uint32_t seed;
+
+        /// @brief The log the session is written to, or nullptr if it is not logged.
+        std::unique_ptr<SessionLog> log;
+
+        /// @brief Tag expression selecting the questions to be drawn. Empty if all questions are drawn.
+        std::string filterExpression;
+
+        /// @brief Slots of the questions matching the filter expression.
+        Bitset filter;
+
+        /// @brief Slot of the last drawn question, if any.
+        std::optional<std::uint32_t> cursor;
+
+        /// @brief The answered questions, in the order they were answered.
+        std::vector<HistoryEntry> history;
+
+        /// @brief The variant generated for the last drawn question, if it is a template.
+        std::unique_ptr<Question> variant;
+
+        /// @brief Draws a random slot from the specified set, using the session random number generator.
+        /// @param from A non-empty set of question slots.
+        /// @return A slot selected uniformly from the set.
+        std::uint32_t drawSlot(const Bitset &from);
+
+        /// @brief Maps a set of slots of the previous bank onto a new one.
+        /// @param previous The set of slots in the previous bank.
+        /// @param previousSlots For every slot of the new bank, the slot the same question had in the previous bank,
+        /// or nothing if the question was added.
+        /// @param includeAdded true to include the added questions in the result; false otherwise.
+        /// @return The set of slots in the new bank.
+        static Bitset remapSlots(const Bitset &previous, const std::vector<std::optional<std::uint32_t>> &previousSlots, bool includeAdded);
+
+        /// @brief Selects the slot of the next question, without changing the draw state.
+        /// @details Only called when the filter matches at least one question.
+        virtual std::uint32_t selectSlot() = 0;
+
+        /// @brief Updates the draw state after a question has been drawn.
+        /// @param slot The slot of the drawn question. It may not match the filter when a session is replayed.
+        virtual void markDrawn(std::uint32_t slot) {}
+
+        /// @brief Adds an answered question to the history and updates the draw state.
+        void recordAnswer(std::uint32_t slot, double score);
+
+        /// @brief Updates the draw state after a question has been answered.
+        /// @param slot The slot of the answered question.
+        /// @param score The score gained by the learner.
+        virtual void recordScore(std::uint32_t slot, double score) {}
+
+        /// @brief Resets the draw state of the session.
+        /// @details Called after the bank or the filter have changed. Derived classes holding state about drawn
+        /// questions must override it.
+        virtual void resetDrawState() {}
+
+        /// @brief Carries the draw state of the session over to a new bank.
+        /// @details Called after the bank has been replaced and the filter re-evaluated. The default implementation
+        /// resets the draw state.
+        /// @param previousSlots For every slot of the new bank, the slot the same question had in the previous bank,
+        /// or nothing if the question was added.
+        virtual void remapDrawState(const std::vector<std::optional<std::uint32_t>> &previousSlots) { resetDrawState(); }
+
+        /// @brief Re-evaluates the filter on the current bank. An expression which cannot be evaluated is removed.
+        void evaluateFilter();
+
+    public:
+        /// @brief Constructs a session drawing from the specified bank.
+        /// @param bank The bank. Must not be nullptr.
+        /// @param seed Seed of the random number generator of the session.
+        Session(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed);
+
+        /// @brief Virtual destructor for the Session class.
+        virtual ~Session() = default;
+
+        /// @brief Draws the next question.
+        /// @return A pointer to a Question object of the bank of the session, or to a variant of it if it is a
+        /// template. A variant is valid until the next draw.
+        /// @throws std::runtime_error if the bank is empty, no question matches the filter or the drawn template has no
+        /// valid variant.
+        fq::Question *next();
+
+        /// @brief Predicts the question the next call to next will draw, without changing the session.
+        /// @details The prediction is exact unless answering the current question changes the draw state (e.g. the
+        /// ability of adaptive sessions), or the bank or the filter change before the next draw. It is meant for
+        /// preparing the next question, e.g. loading its media, and must be made after getAnswerOrder.
+        /// @return The question of the bank (the template itself for templates), or nullptr if none can be drawn.
+        const fq::Question *peek();
+
+        /// @brief Returns the question of the bank a drawn question was generated from.
+        /// @param question A pointer to a Question object returned by next.
+        /// @return The template of the last drawn variant, nullptr if it was removed from the bank, or the question
+        /// itself otherwise.
+        const fq::Question *origin(const fq::Question *question) const;
+
+        /// @brief Records the answer to a question.
+        /// @details Answers to questions which are not in the bank of the session are ignored. Answers to the last
+        /// drawn variant are recorded for its template.
+        /// @param question A pointer to the answered Question object.
+        /// @param score The score gained by the learner.
+        /// @param chosenAnswers The indices of the chosen answers in the answers of the question, written to the log.
+        void answer(const fq::Question *question, double score, const std::vector<std::uint32_t> &chosenAnswers = {});
+
+        /// @brief Returns a random presentation order of the answers of a question.
+        /// @param question A pointer to the Question object to be presented.
+        /// @return A vector of indices into the answers of the question, in the order they should be presented.
+        std::vector<std::size_t> getAnswerOrder(const fq::Question *question);
+
+        /// @brief Restricts drawn questions to those matching a tag expression.
+        /// @details The draw state of the session is reset. See TagIndex::evaluate for the expression syntax.
+        /// @param expression The tag expression. An empty expression removes the filter.
+        /// @throws std::invalid_argument if the expression is malformed. The previous filter is kept in that case.
+        void setFilter(const std::string &expression);
+
+        /// @brief Returns the tag expression used to filter drawn questions.
+        const std::string &getFilter() const { return filterExpression; }
+
+        /// @brief Returns the number of questions matching the filter.
+        std::size_t getFilteredCount() const { return filter.size(); }
+
+        /// @brief Returns the bank the session draws from.
+        const std::shared_ptr<const QuestionBank> &getBank() const { return bank; }
+
+        /// @brief Switches the session to a new bank and resets its draw state and history.
+        /// @param newBank The new bank. Must not be nullptr.
+        void setBank(std::shared_ptr<const QuestionBank> newBank);
+
+        /// @brief Switches the session to a new version of its bank, keeping its draw state and history.
+        /// @param newBank The new bank. Must not be nullptr.
+        /// @param previousSlots For every slot of the new bank, the slot the same question had in the previous bank,
+        /// or nothing if the question was added. Answers to questions which are no longer in the bank are forgotten.
+        void setBank(std::shared_ptr<const QuestionBank> newBank, const std::vector<std::optional<std::uint32_t>> &previousSlots);
+
+        /// @brief Releases the bank of the session, keeping its draw state and history, e.g. while the questions are
+        /// unloaded to save memory.
+        /// @details The session must not be used until attachBank is called.
+        void detachBank();
+
+        /// @brief Attaches the session to a bank holding the questions of the detached one in the same slots, e.g.
+        /// reloaded from the same file, keeping its draw state and history.
+        /// @param sameBank The bank. Must not be nullptr.
+        void attachBank(std::shared_ptr<const QuestionBank> sameBank);
+
+        /// @brief Seeds the random number generator of the session again.
+        /// @param newSeed The new seed.
+        void reseed(std::uint32_t newSeed);
+
+        /// @brief Returns the seed the random number generator was last seeded with.
+        std::uint32_t getSeed() const { return seed; }
+
+        /// @brief Writes everything that happens in the session from now on to a log.
+        /// @details No record is written by this method, so it is used to continue a session restored by replay; see
+        /// startLog for new sessions. Whenever the bank is replaced afterwards, the random number generator is seeded again, as the replay cannot
+        /// reproduce the change of the bank.
+        /// @param newLog The log, or nullptr to stop logging.
+        void setLog(std::unique_ptr<SessionLog> newLog) { log = std::move(newLog); }
+
+        /// @brief Starts writing the session to a log, beginning with a Start record.
+        /// @details The Start record holds the current seed; the current filter, if any, is recorded right after it.
+        /// @param newLog The log.
+        /// @param type The session type recorded in the Start record, as accepted by create.
+        void startLog(std::unique_ptr<SessionLog> newLog, const std::string &type);
+
+        /// @brief Stops logging the session.
+        /// @return The log the session was written to, or nullptr if it was not logged.
+        std::unique_ptr<SessionLog> releaseLog() { return std::move(log); }
+
+        /// @brief Restores the state of a session by replaying its log records.
+        /// @details Every recorded draw is repeated with the random number generator and checked against the record. If
+        /// a different question is drawn (e.g. because the questions were edited since), the recorded question is used
+        /// instead, so the history and the draw state still match the session as it happened. Records of questions
+        /// which are no longer in the bank are skipped. Nothing is written to the log of the session while replaying.
+        /// @param records The records of one session, starting with its Start record.
+        /// @return A summary of the replay.
+        SessionLog::ReplaySummary replay(const std::vector<SessionLog::Record> &records);
+
+        /// @brief Returns the slot of the last drawn question, if any.
+        std::optional<std::uint32_t> getCursor() const { return cursor; }
+
+        /// @brief Returns the answered questions, in the order they were answered.
+        const std::vector<HistoryEntry> &getHistory() const { return history; }
+
+        /// @brief Factory function to create a session of the specified repository type.
+        /// @param type The repository type: "random", "random_non_repeating", "intelligent" or "adaptive".
+        /// @param bank The bank the session draws from.
+        /// @param seed Seed of the random number generator of the session.
+        /// @return The new session.
+        /// @throws std::invalid_argument if the type is unknown.
+        static std::unique_ptr<Session> create(const std::string &type, std::shared_ptr<const QuestionBank> bank, std::uint32_t seed);
+    };
+
+    /// @brief Session drawing questions randomly.
+    class RandomSession : public Session
+    {
+    protected:
+        /// @brief Selects a random question matching the filter.
+        virtual std::uint32_t selectSlot() override;
+
+    public:
+        using Session::Session;
+    };
+
+    /// @brief Session drawing questions randomly without repeating them, until all have been asked.
+    class NonRepeatingSession : public Session
+    {
+        /// @brief Slots of the remaining questions that have not been asked yet.
+        Bitset remainingQuestions;
+
+    protected:
+        /// @brief Selects a random question which has not been asked yet.
+        virtual std::uint32_t selectSlot() override;
+
+        /// @brief Marks the question as asked. Once all have been asked, they become available again.
+        virtual void markDrawn(std::uint32_t slot) override;
+
+        /// @brief Makes all questions matching the filter available again.
+        virtual void resetDrawState() override;
+
+        /// @brief Keeps already asked questions unavailable; added questions become available.
+        virtual void remapDrawState(const std::vector<std::optional<std::uint32_t>> &previousSlots) override;
+
+    public:
+        /// @brief Constructs a session drawing from the specified bank.
+        /// @param bank The bank. Must not be nullptr.
+        /// @param seed Seed of the random number generator of the session.
+        NonRepeatingSession(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed);
+    };
+
+    /// @brief Session asking every question once, then repeating those the learner struggled with.
+    class IntelligentSession : public Session
+    {
+        /// @brief Slots of the remaining questions that have not been asked yet.
+        Bitset remainingQuestions;
+
+        /// @brief Slots of the hard questions that the learner has struggled with.
+        /// @details Hard questions are those that the learner has scored less than 1.0 on.
+        Bitset hardQuestions;
+
+    protected:
+        /// @brief Selects a random remaining question. Once none remain, the hard ones (or all questions) are asked again.
+        virtual std::uint32_t selectSlot() override;
+
+        /// @brief Marks the question as asked, starting the next round if none remained.
+        virtual void markDrawn(std::uint32_t slot) override;
+
+        /// @brief Marks the question as hard if the score is less than 1.0.
+        virtual void recordScore(std::uint32_t slot, double score) override;
+
+        /// @brief Makes all questions matching the filter available again and forgets the hard questions.
+        virtual void resetDrawState() override;
+
+        /// @brief Keeps already asked and hard questions; added questions become available.
+        virtual void remapDrawState(const std::vector<std::optional<std::uint32_t>> &previousSlots) override;
+
+    public:
+        /// @brief Constructs a session drawing from the specified bank.
+        /// @param bank The bank. Must not be nullptr.
+        /// @param seed Seed of the random number generator of the session.
+        IntelligentSession(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed);
+    };
+
+    /// @brief Computerized adaptive testing session.
+    /// @details The session keeps an estimate of the ability of the learner, updated from the score of every answered
+    /// question using the two-parameter logistic item response model (the difficulty and discrimination of each question).
+    /// The next question is always the not yet asked one with the maximum Fisher information at the current estimate.
+    class AdaptiveSession : public Session
+    {
+        /// @brief A response of the learner, used to estimate the ability.
+        struct Response
+        {
+            double discrimination;
+            double difficulty;
+            double score;
+        };
+
+        /// @brief Slots of the remaining questions that have not been asked yet.
+        Bitset remainingQuestions;
+
+        /// @brief Responses of the learner in the session.
+        /// @details Kept separately from the history, so the estimate does not change when answered questions are
+        /// edited or removed from the bank.
+        std::vector<Response> responses;
+
+        /// @brief Current estimate of the ability of the learner, on the same scale as the difficulty of the questions.
+        double ability;
+
+        /// @brief Standard error of the current ability estimate.
+        double abilityError;
+
+        /// @brief Re-estimates the ability from all responses.
+        /// @details Computes the maximum a posteriori estimate with a standard normal prior using Newton's method.
+        void estimateAbility();
+
+    protected:
+        /// @brief Selects the not yet asked question with the maximum information at the current ability estimate.
+        /// @details Once all questions matching the filter have been asked, they all become available again.
+        virtual std::uint32_t selectSlot() override;
+
+        /// @brief Marks the question as asked. Once all have been asked, they become available again.
+        virtual void markDrawn(std::uint32_t slot) override;
+
+        /// @brief Updates the ability estimate. Negative scores count as 0.
+        virtual void recordScore(std::uint32_t slot, double score) override;
+
+        /// @brief Makes all questions matching the filter available again.
+        /// @details The ability estimate is kept, as it describes the learner rather than the questions.
+        virtual void resetDrawState() override;
+
+        /// @brief Keeps already asked questions unavailable; added questions become available.
+        virtual void remapDrawState(const std::vector<std::optional<std::uint32_t>> &previousSlots) override;
+
+    public:
+        /// @brief Constructs a session drawing from the specified bank.
+        /// @param bank The bank. Must not be nullptr.
+        /// @param seed Seed of the random number generator of the session.
+        AdaptiveSession(std::shared_ptr<const QuestionBank> bank, std::uint32_t seed);
+
+        /// @brief Returns the current estimate of the ability of the learner.
+        /// @return The ability, on the same scale as the difficulty of the questions.
+        double getAbility() const { return ability; }
+
+        /// @brief Returns the standard error of the current ability estimate.
+        /// @return The standard error of the ability estimate.
+        double getAbilityError() const { return abilityError; }
+    };
+}
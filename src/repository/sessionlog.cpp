@@ -0,0 +1,196 @@
+#include "sessionlog.hpp"
+
+namespace
+{
+    /// @brief Identifies session logs ("FQLG").
+    constexpr quint32 logMagic = 0x46514C47;
+
+    /// @brief Version of the log format. Logs of other versions are ignored.
+    constexpr quint32 logVersion = 2;
+
+    /// @brief Offset basis of the 64-bit FNV-1a hash.
+    constexpr std::uint64_t fnvOffset = 0xcbf29ce484222325ULL;
+
+    /// @brief Continues a 64-bit FNV-1a hash with a text and a terminating zero byte, so consecutive texts cannot
+    /// run into each other.
+    std::uint64_t fnvHash(std::uint64_t hash, const std::string &text)
+    {
+        for (unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash * 0x100000001b3ULL;
+    }
+
+    /// @brief Reads the complete records of a log.
+    /// @param file The log, open for reading and positioned at its start.
+    /// @param records Receives the records.
+    /// @return The size of the part of the log holding the header and the complete records, or 0 if it is not a log.
+    qint64 readRecords(QIODevice &file, std::vector<fq::SessionLog::Record> &records)
+    {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_6_0);
+        quint32 magic = 0, version = 0;
+        stream >> magic >> version;
+        if (stream.status() != QDataStream::Ok || magic != logMagic || version != logVersion)
+            return 0;
+        qint64 validSize = file.pos();
+        while (!stream.atEnd())
+        {
+            using Type = fq::SessionLog::RecordType;
+            fq::SessionLog::Record record;
+            quint8 type = 0;
+            stream >> type >> record.timestamp;
+            record.type = static_cast<Type>(type);
+            QByteArray text;
+            quint64 question = 0;
+            quint32 chosenCount = 0;
+            switch (record.type)
+            {
+            case Type::Start:
+                stream >> record.seed >> text;
+                break;
+            case Type::Reseed:
+                stream >> record.seed;
+                break;
+            case Type::Filter:
+                stream >> text;
+                break;
+            case Type::Draw:
+                stream >> question;
+                break;
+            case Type::Answer:
+                stream >> question >> chosenCount;
+                // Every index takes four bytes, so a count larger than the rest of the log belongs to a torn record.
+                if (static_cast<qint64>(chosenCount) > (file.size() - file.pos()) / 4)
+                    return validSize;
+                record.chosenAnswers.resize(chosenCount);
+                for (auto &index : record.chosenAnswers)
+                    stream >> index;
+                stream >> record.score;
+                break;
+            default:
+                return validSize;
+            }
+            if (stream.status() != QDataStream::Ok)
+                break;
+            record.text = text.toStdString();
+            record.question = question;
+            records.push_back(std::move(record));
+            validSize = file.pos();
+        }
+        return validSize;
+    }
+}
+
+fq::SessionLog::SessionLog(const std::string &path) : file(QString::fromStdString(path))
+{
+    if (!file.open(QIODevice::ReadWrite))
+        throw std::runtime_error("Failed to open session log: " + path);
+    std::vector<Record> records;
+    qint64 validSize = readRecords(file, records);
+    if (!validSize)
+    {
+        QByteArray header;
+        QDataStream stream(&header, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << logMagic << logVersion;
+        file.resize(0);
+        file.seek(0);
+        if (file.write(header) != header.size() || !file.flush())
+            throw std::runtime_error("Failed to write session log: " + path);
+        return;
+    }
+    if (validSize != file.size())
+        file.resize(validSize);
+    file.seek(validSize);
+}
+
+bool fq::SessionLog::append(const Record &record)
+{
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << static_cast<quint8>(record.type) << record.timestamp;
+    switch (record.type)
+    {
+    case RecordType::Start:
+        stream << record.seed << QByteArray::fromStdString(record.text);
+        break;
+    case RecordType::Reseed:
+        stream << record.seed;
+        break;
+    case RecordType::Filter:
+        stream << QByteArray::fromStdString(record.text);
+        break;
+    case RecordType::Draw:
+        stream << static_cast<quint64>(record.question);
+        break;
+    case RecordType::Answer:
+        stream << static_cast<quint64>(record.question) << static_cast<quint32>(record.chosenAnswers.size());
+        for (std::uint32_t index : record.chosenAnswers)
+            stream << index;
+        stream << record.score;
+        break;
+    }
+    return file.write(bytes) == bytes.size() && file.flush();
+}
+
+std::string fq::SessionLog::logPath(const std::string &path)
+{
+    return path + ".fqlog";
+}
+
+std::vector<fq::SessionLog::Record> fq::SessionLog::read(const std::string &path)
+{
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    // Logs are read in one pass, so mapping them avoids copying them into a buffer first.
+    if (uchar *data = file.size() ? file.map(0, file.size()) : nullptr)
+        return parse(QByteArray::fromRawData(reinterpret_cast<const char *>(data), file.size()));
+    return parse(file.readAll());
+}
+
+std::vector<fq::SessionLog::Record> fq::SessionLog::parse(const QByteArray &contents)
+{
+    std::vector<Record> records;
+    QBuffer buffer;
+    buffer.setData(contents);
+    if (buffer.open(QIODevice::ReadOnly))
+        readRecords(buffer, records);
+    return records;
+}
+
+std::vector<std::vector<fq::SessionLog::Record>> fq::SessionLog::splitSessions(const std::vector<Record> &records)
+{
+    std::vector<std::vector<Record>> sessions;
+    for (const auto &record : records)
+    {
+        if (record.type == RecordType::Start)
+            sessions.emplace_back();
+        if (!sessions.empty())
+            sessions.back().push_back(record);
+    }
+    return sessions;
+}
+
+std::uint64_t fq::SessionLog::questionId(const fq::Question *question)
+{
+    std::uint64_t hash = fnvHash(fnvHash(fnvOffset, question->getType()), question->getQuestion());
+    std::vector<std::uint64_t> answers;
+    answers.reserve(question->getAnswers().size());
+    for (const auto &answer : question->getAnswers())
+        answers.push_back(fnvHash(fnvHash(fnvOffset, answer.isCorrect ? "1" : "0"), answer.text));
+    std::sort(answers.begin(), answers.end());
+    for (std::uint64_t answer : answers)
+    {
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            hash ^= answer >> shift & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,156 @@
+/// @file sessionlog.hpp
+/// @brief Contains the definition of append-only logs recording everything that happens in a session.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <QFile>
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief An append-only binary log of sessions, used to resume them and to replay them for auditing.
+    /// @details The log of a repository is stored next to it, with ".fqlog" appended to its name. Every record is
+    /// written with a single write as soon as it happens, so recording an answer costs one small append. A session
+    /// starts with a Start record holding the seed of its random number generator; together with the Draw, Answer,
+    /// Filter and Reseed records that follow, it determines the whole session, so replaying the records on the same
+    /// questions reproduces every draw. A record cut off by a crash is dropped when the log is opened again.
+    ///
+    /// Questions are identified by a 64-bit hash of their contents, so a log stays meaningful when the repository is
+    /// edited: answers to questions which still exist are carried over, and only the draws are no longer verified.
+    class SessionLog
+    {
+    public:
+        /// @brief Types of log records.
+        enum class RecordType : quint8
+        {
+            /// @brief A new session. Holds the seed and the session type.
+            Start = 1,
+
+            /// @brief The random number generator was seeded again, e.g. after the questions changed. Holds the seed.
+            Reseed = 2,
+
+            /// @brief The tag filter was changed. Holds the expression.
+            Filter = 3,
+
+            /// @brief A question was drawn and the order of its answers chosen. Holds the question.
+            Draw = 4,
+
+            /// @brief A question was answered. Holds the question, the chosen answers and the score.
+            Answer = 5,
+        };
+
+        /// @brief A single log record.
+        struct Record
+        {
+            /// @brief The type of the record.
+            RecordType type = RecordType::Start;
+
+            /// @brief The time of the record, in milliseconds since the epoch.
+            qint64 timestamp = 0;
+
+            /// @brief The seed of the random number generator (Start and Reseed records).
+            std::uint32_t seed = 0;
+
+            /// @brief The identifier of the question (Draw and Answer records). See questionId.
+            std::uint64_t question = 0;
+
+            /// @brief The indices of the chosen answers in the answers of the question (Answer records).
+            std::vector<std::uint32_t> chosenAnswers;
+
+            /// @brief The score gained (Answer records).
+            double score = 0.0;
+
+            /// @brief The session type (Start records) or the filter expression (Filter records).
+            std::string text;
+        };
+
+        /// @brief Results of replaying the records of a session.
+        struct ReplaySummary
+        {
+            /// @brief The number of replayed draws.
+            std::size_t draws = 0;
+
+            /// @brief The number of draws which chose the recorded question again.
+            std::size_t verifiedDraws = 0;
+
+            /// @brief The number of replayed answers.
+            std::size_t answers = 0;
+
+            /// @brief The sum of the recorded scores.
+            double totalScore = 0.0;
+
+            /// @brief The number of answers whose recorded score differs from the score of the recorded answers.
+            std::size_t scoreMismatches = 0;
+
+            /// @brief The number of draws and answers of questions which are no longer in the repository.
+            std::size_t missingQuestions = 0;
+
+            /// @brief Returns whether the replay reproduced the session exactly.
+            bool isExact() const { return verifiedDraws == draws && !scoreMismatches && !missingQuestions; }
+        };
+
+    private:
+        /// @brief The log file, open for appending.
+        QFile file;
+
+    public:
+        /// @brief Opens a log for appending, creating it if it does not exist.
+        /// @details A record cut off at the end of the log is removed. A file which is not a log is replaced.
+        /// @param path The path to the log file.
+        /// @throws std::runtime_error if the file cannot be opened.
+        explicit SessionLog(const std::string &path);
+
+        SessionLog(const SessionLog &) = delete;
+        SessionLog &operator=(const SessionLog &) = delete;
+
+        /// @brief Appends a record to the log.
+        /// @details The record is handed to the operating system before the method returns, so it survives the
+        /// application crashing. Like snapshots, the log never interrupts a session: a failed write is only reported.
+        /// @param record The record.
+        /// @return true if the record was written; false otherwise.
+        bool append(const Record &record);
+
+        /// @brief Returns the path of the log of a repository.
+        /// @param path The path to the JSON file of the repository.
+        static std::string logPath(const std::string &path);
+
+        /// @brief Reads all complete records of a log.
+        /// @param path The path to the log file.
+        /// @return The records, oldest first. Empty if the file does not exist or is not a log.
+        static std::vector<Record> read(const std::string &path);
+
+        /// @brief Reads all complete records of a log held in memory.
+        /// @param contents The contents of the log file.
+        /// @return The records, oldest first. Empty if the contents are not a log.
+        static std::vector<Record> parse(const QByteArray &contents);
+
+        /// @brief Splits records into sessions.
+        /// @param records Records of a log, oldest first.
+        /// @return The records of every session, each starting with its Start record. Records before the first Start
+        /// record are dropped.
+        static std::vector<std::vector<Record>> splitSessions(const std::vector<Record> &records);
+
+        /// @brief Returns the identifier of a question, a 64-bit FNV-1a hash of its type, text and answers.
+        /// @details The answers are hashed independently of their order, so reordering them keeps the identifier, while
+        /// questions sharing a text but differing in their type or answers are told apart.
+        /// @param question A pointer to the Question object.
+        static std::uint64_t questionId(const fq::Question *question);
+
+        /// @brief Returns the current time, as stored in records.
+        static qint64 now() { return QDateTime::currentMSecsSinceEpoch(); }
+    };
+}
@@ -0,0 +1,275 @@
+#include "shardedrepository.hpp"
+
+fq::ShardedRepository::ShardedRepository(const std::string &path, const RepositoryFile &file)
+    : memoryBudget(defaultMemoryBudget), memoryUsed(0), lastQuestion(nullptr), generator(std::random_device{}())
+{
+    this->path = path;
+    jsonType = "sharded";
+    const QJsonObject &json = file.json;
+    if (!json.contains("shards") || !json["shards"].isArray())
+        throw std::runtime_error("Invalid manifest format: 'shards' not found or is not an array");
+    QDir directory = QDir(QFileInfo(QString::fromStdString(path)).absolutePath());
+    for (const QJsonValue &value : json["shards"].toArray())
+    {
+        QJsonObject shardObj = value.toObject();
+        if (!value.isObject() || !shardObj["path"].isString() || !shardObj["count"].isDouble())
+            throw std::runtime_error("Invalid shard format in manifest: 'path' and 'count' are required");
+        Shard shard;
+        shard.path = directory.absoluteFilePath(shardObj["path"].toString()).toStdString();
+        shard.count = static_cast<std::size_t>(shardObj["count"].toDouble());
+        shard.checksum = shardObj["checksum"].toString().toStdString();
+        QJsonObject tagsObj = shardObj["tags"].toObject();
+        for (const QString &tag : tagsObj.keys())
+            shard.tags[tag.toStdString()] = static_cast<std::size_t>(tagsObj[tag].toDouble());
+        shards.push_back(std::move(shard));
+    }
+    if (json.contains("memory_budget"))
+        memoryBudget = static_cast<std::size_t>(json["memory_budget"].toDouble());
+}
+
+fq::Repository *fq::ShardedRepository::loadShard(std::size_t index)
+{
+    Shard &shard = shards[index];
+    if (shard.repository)
+    {
+        recentlyUsed.remove(index);
+        recentlyUsed.push_front(index);
+        return shard.repository;
+    }
+    QFile file(QString::fromStdString(shard.path));
+    if (!file.open(QIODevice::ReadOnly))
+        throw std::runtime_error("Failed to open shard: " + shard.path);
+    QByteArray contents = file.readAll();
+    file.close();
+    if (!shard.checksum.empty() &&
+        QCryptographicHash::hash(contents, QCryptographicHash::Sha1).toHex().toStdString() != shard.checksum)
+        throw std::runtime_error("Shard checksum does not match the manifest: " + shard.path);
+
+    // The verified contents are parsed directly, so the shard file is read once.
+    shard.repository = Repository::createRepository(shard.path, RepositoryFile::fromJSON(contents));
+    shard.repository->setAutoSave(false);
+    if (shard.session)
+    {
+        shard.session->attachBank(shard.repository->getBank());
+        shard.repository->setSession(std::move(shard.session));
+    }
+    // Setting the filter resets the draw state, so a resumed session keeps it unless the filter changed meanwhile.
+    if (shard.repository->getFilter() != filterExpression)
+        shard.repository->setFilter(filterExpression);
+    shard.matching = shard.repository->getFilteredCount();
+    shard.bytes = shard.repository->getMemoryUsage().total();
+    memoryUsed += shard.bytes;
+    recentlyUsed.push_front(index);
+    evictOverBudget(index);
+    return shard.repository;
+}
+
+void fq::ShardedRepository::evictShard(std::size_t index)
+{
+    Shard &shard = shards[index];
+    if (!shard.repository)
+        return;
+    shard.session = shard.repository->releaseSession();
+    shard.session->detachBank();
+    delete shard.repository;
+    shard.repository = nullptr;
+    memoryUsed -= shard.bytes;
+    if (lastShard == index)
+    {
+        lastShard.reset();
+        lastQuestion = nullptr;
+    }
+}
+
+void fq::ShardedRepository::evictOverBudget(std::optional<std::size_t> keep)
+{
+    // Walks from the least recently used shard towards the most recently used one. Erasing a shard returns the
+    // iterator to the older shard after it, so the next step visits the shard loaded right before it.
+    for (auto it = recentlyUsed.end(); memoryUsed > memoryBudget && it != recentlyUsed.begin();)
+    {
+        std::size_t candidate = *--it;
+        if (candidate == keep || candidate == lastShard)
+            continue;
+        it = recentlyUsed.erase(it);
+        evictShard(candidate);
+    }
+}
+
+std::size_t fq::ShardedRepository::candidateCount(const Shard &shard) const
+{
+    return shard.matching ? *shard.matching : shard.count;
+}
+
+fq::Question *fq::ShardedRepository::getQuestion()
+{
+    if (!getQuestionCount())
+        throw std::runtime_error("No questions available in the repository");
+    // Every pass either returns a question or learns that the chosen shard has no matching questions,
+    // so this loop ends after at most one pass per shard.
+    for (;;)
+    {
+        std::vector<double> weights;
+        weights.reserve(shards.size());
+        double total = 0.0;
+        for (const auto &shard : shards)
+        {
+            weights.push_back(static_cast<double>(candidateCount(shard)));
+            total += weights.back();
+        }
+        if (total <= 0.0)
+            throw std::runtime_error("No questions match the current filter");
+        std::discrete_distribution<std::size_t> dis(weights.begin(), weights.end());
+        std::size_t index = dis(generator);
+        Repository *shard = loadShard(index);
+        if (!shard->getFilteredCount())
+            continue;
+        lastQuestion = shard->getQuestion();
+        lastShard = index;
+        return lastQuestion;
+    }
+}
+
+void fq::ShardedRepository::returnQuestion(Question *question, double score, const std::vector<std::uint32_t> &chosenAnswers)
+{
+    if (question == lastQuestion && lastShard && shards[*lastShard].repository)
+        shards[*lastShard].repository->returnQuestion(question, score, chosenAnswers);
+}
+
+void fq::ShardedRepository::recordResponse(const Question *question, double latency, double score)
+{
+    if (question == lastQuestion && lastShard && shards[*lastShard].repository)
+        shards[*lastShard].repository->recordResponse(question, latency, score);
+}
+
+fq::MemoryUsage fq::ShardedRepository::getMemoryUsage() const
+{
+    // Merged questions are shared with the loaded shards, so they are counted once, through the bank.
+    if (bank->size())
+        return MemoryUsage::measure(*bank);
+    MemoryUsage usage;
+    for (const auto &shard : shards)
+    {
+        if (shard.repository)
+            usage += shard.repository->getMemoryUsage();
+    }
+    return usage;
+}
+
+std::size_t fq::ShardedRepository::getQuestionCount() const
+{
+    std::size_t count = 0;
+    for (const auto &shard : shards)
+        count += shard.count;
+    return count;
+}
+
+std::size_t fq::ShardedRepository::getFilteredCount() const
+{
+    std::size_t count = 0;
+    for (const auto &shard : shards)
+        count += candidateCount(shard);
+    return count;
+}
+
+std::map<std::string, std::size_t> fq::ShardedRepository::getTagCounts() const
+{
+    std::map<std::string, std::size_t> counts;
+    for (const auto &shard : shards)
+    {
+        for (const auto &it : shard.tags)
+            counts[it.first] += it.second;
+    }
+    return counts;
+}
+
+void fq::ShardedRepository::setFilter(const std::string &expression)
+{
+    // Validate the expression before changing any shard, so a malformed one leaves the repository untouched.
+    bank->getTagIndex().evaluate(expression);
+    filterExpression = expression;
+    for (auto &shard : shards)
+    {
+        shard.matching.reset();
+        if (shard.repository)
+        {
+            shard.repository->setFilter(expression);
+            shard.matching = shard.repository->getFilteredCount();
+        }
+    }
+}
+
+void fq::ShardedRepository::setMemoryBudget(std::size_t bytes)
+{
+    memoryBudget = bytes;
+    evictOverBudget(std::nullopt);
+}
+
+void fq::ShardedRepository::mergeShards()
+{
+    std::vector<std::shared_ptr<Question>> owners;
+    owners.reserve(getQuestionCount());
+    for (std::size_t i = 0; i < shards.size(); ++i)
+    {
+        // Sharing the questions keeps them alive when their shard is evicted to load the next one.
+        std::shared_ptr<const QuestionBank> shardBank = loadShard(i)->getBank();
+        for (Question *question : shardBank->getQuestions())
+            owners.push_back(shardBank->share(question));
+    }
+    std::atomic_store(&bank, std::make_shared<const QuestionBank>(std::move(owners)));
+}
+
+void fq::ShardedRepository::split(const std::vector<fq::Question *> &questions, const std::string &type, const std::string &manifestPath, std::size_t questionsPerShard)
+{
+    if (!questionsPerShard)
+        throw std::invalid_argument("Shards must contain at least one question");
+    QFileInfo manifestInfo(QString::fromStdString(manifestPath));
+    QDir directory(manifestInfo.absolutePath());
+    QJsonArray shardsArray;
+    for (std::size_t start = 0, number = 1; start < questions.size(); start += questionsPerShard, ++number)
+    {
+        std::size_t end = std::min(questions.size(), start + questionsPerShard);
+        QJsonArray questionsArray;
+        std::map<std::string, std::size_t> tagCounts;
+        for (std::size_t i = start; i < end; ++i)
+        {
+            questionsArray.append(questions[i]->toJSON());
+            for (const auto &tag : questions[i]->getTags())
+                ++tagCounts[tag];
+        }
+        QJsonObject shardJson;
+        shardJson["questions"] = questionsArray;
+        shardJson["type"] = QString::fromStdString(type);
+        QByteArray contents = QJsonDocument(shardJson).toJson();
+
+        QString name = QString("%1.%2.json").arg(manifestInfo.completeBaseName()).arg(number, 4, 10, QChar('0'));
+        QFile file(directory.absoluteFilePath(name));
+        if (!file.open(QIODevice::WriteOnly))
+            throw std::runtime_error("Failed to write shard: " + file.fileName().toStdString());
+        file.write(contents);
+        file.close();
+
+        QJsonObject tagsObj;
+        for (const auto &it : tagCounts)
+            tagsObj[QString::fromStdString(it.first)] = static_cast<double>(it.second);
+        QJsonObject entry;
+        entry["path"] = name;
+        entry["count"] = static_cast<double>(end - start);
+        entry["tags"] = tagsObj;
+        entry["checksum"] = QString::fromLatin1(QCryptographicHash::hash(contents, QCryptographicHash::Sha1).toHex());
+        shardsArray.append(entry);
+    }
+    QJsonObject manifest;
+    manifest["type"] = "sharded";
+    manifest["shards"] = shardsArray;
+    QFile file(QString::fromStdString(manifestPath));
+    if (!file.open(QIODevice::WriteOnly))
+        throw std::runtime_error("Failed to write manifest: " + manifestPath);
+    file.write(QJsonDocument(manifest).toJson());
+    file.close();
+}
+
+fq::ShardedRepository::~ShardedRepository()
+{
+    for (auto &shard : shards)
+        delete shard.repository;
+}
@@ -0,0 +1,200 @@
+/// @file shardedrepository.hpp
+/// @brief Contains the definition of a repository split across shard files which are loaded on demand.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <optional>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDir>
+#include "repository.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Class representing a repository split across several shard files, described by a small manifest.
+    /// @details Only the manifest is read when the repository is opened. It lists every shard with its question count,
+    /// the number of questions carrying each tag and a SHA-1 checksum of the shard file. Shards are ordinary repository
+    /// files; they are loaded when a question is drawn from them and evicted, least recently used first, once the loaded
+    /// shards exceed the memory budget. The shard the last question was drawn from is never evicted, so the question
+    /// currently shown stays valid. The session of an evicted shard is kept without its questions and resumed when the
+    /// shard is loaded again, so its draw state does not depend on the memory budget. A shard is chosen with probability proportional to its number of questions matching
+    /// the filter, so every matching question is equally likely. Sharded repositories are read-only.
+    ///
+    /// The bank of the repository is empty until mergeShards is called, so tools which need every question at once
+    /// (e.g. to look for duplicates) must merge the shards first.
+    ///
+    /// Manifest format:
+    /// @code
+    /// { "type": "sharded",
+    ///   "shards": [ { "path": "bank.0001.json", "count": 5000, "tags": { "chapter1": 120 }, "checksum": "<sha1>" } ],
+    ///   "memory_budget": 268435456 }
+    /// @endcode
+    class ShardedRepository : public Repository
+    {
+        /// @brief A shard listed in the manifest.
+        struct Shard
+        {
+            /// @brief The absolute path to the shard file.
+            std::string path;
+
+            /// @brief The number of questions in the shard, according to the manifest.
+            std::size_t count;
+
+            /// @brief The number of questions carrying each tag, according to the manifest.
+            std::map<std::string, std::size_t> tags;
+
+            /// @brief The expected SHA-1 checksum of the shard file, as a hexadecimal string.
+            std::string checksum;
+
+            /// @brief The estimated memory used by the loaded shard in bytes, as measured when it was loaded.
+            std::size_t bytes = 0;
+
+            /// @brief The loaded shard, or nullptr if it is not loaded.
+            Repository *repository = nullptr;
+
+            /// @brief The session of the shard while it is unloaded, or nullptr if it is loaded or was never loaded.
+            /// @details Kept when the shard is evicted, so questions already asked by a non-repeating shard, the hard
+            /// questions of an intelligent shard and the ability estimate of an adaptive shard survive its reloading.
+            std::unique_ptr<Session> session;
+
+            /// @brief The number of questions matching the filter, once known.
+            std::optional<std::size_t> matching;
+        };
+
+        /// @brief The shards listed in the manifest.
+        std::vector<Shard> shards;
+
+        /// @brief Indices of the loaded shards, most recently used first.
+        std::list<std::size_t> recentlyUsed;
+
+        /// @brief Maximum estimated memory used by loaded shards, in bytes.
+        std::size_t memoryBudget;
+
+        /// @brief Estimated memory currently used by loaded shards, in bytes.
+        std::size_t memoryUsed;
+
+        /// @brief Index of the shard the last question was drawn from.
+        std::optional<std::size_t> lastShard;
+
+        /// @brief The last drawn question.
+        fq::Question *lastQuestion;
+
+        /// @brief Random number generator used to choose where questions are drawn from and to order their answers.
+        std::mt19937 generator;
+
+        /// @brief Tag expression selecting the questions to be drawn. Empty if all questions are drawn.
+        std::string filterExpression;
+
+        /// @brief Loads a shard if needed, marks it as most recently used and evicts shards over the memory budget.
+        /// @param index The index of the shard.
+        /// @throws std::runtime_error if the shard cannot be loaded or its checksum does not match the manifest.
+        Repository *loadShard(std::size_t index);
+
+        /// @brief Unloads a shard, keeping its session. The caller removes it from recentlyUsed.
+        /// @param index The index of the shard.
+        void evictShard(std::size_t index);
+
+        /// @brief Evicts the least recently used shards until the loaded shards fit the memory budget.
+        /// @details The shard the last question was drawn from is never evicted.
+        /// @param keep A shard which must not be evicted either, e.g. the one just loaded.
+        void evictOverBudget(std::optional<std::size_t> keep);
+
+        /// @brief Returns the number of questions of a shard which may match the filter.
+        /// @details Exact once the shard has been loaded with the current filter; the question count of the shard before that.
+        std::size_t candidateCount(const Shard &shard) const;
+
+    public:
+        /// @brief Default memory budget for loaded shards, in bytes.
+        static constexpr std::size_t defaultMemoryBudget = 256 * 1024 * 1024;
+
+        /// @brief Constructs a ShardedRepository from its manifest. No shard is loaded.
+        /// @param path The path to the manifest JSON file.
+        /// @param file The manifest, already read.
+        /// @throws std::runtime_error if the manifest is invalid.
+        ShardedRepository(const std::string &path, const RepositoryFile &file);
+
+        /// @brief Returns a random question, loading its shard if needed.
+        /// @return A pointer to a Question object. It stays valid until the next call to getQuestion.
+        /// @throws std::runtime_error if no question matches the filter or a shard cannot be loaded.
+        virtual fq::Question *getQuestion() override;
+
+        /// @brief Returns the last drawn question back to its shard with its score.
+        /// @param question A pointer to the Question object to be returned.
+        /// @param score The score gained by the user from the question.
+        /// @param chosenAnswers The indices of the answers chosen by the user.
+        virtual void returnQuestion(fq::Question *question, double score, const std::vector<std::uint32_t> &chosenAnswers = {}) override;
+
+        /// @brief Records the response to the last drawn question in the statistics of its shard.
+        virtual void recordResponse(const fq::Question *question, double latency, double score) override;
+
+        /// @brief Returns the memory used by the loaded shards, or by all questions once the shards have been merged.
+        virtual MemoryUsage getMemoryUsage() const override;
+
+        /// @brief Returns the total number of questions, according to the manifest.
+        virtual std::size_t getQuestionCount() const override;
+
+        /// @brief Returns the number of questions which may match the filter.
+        /// @details Shards which have not been loaded since the filter was set count with all their questions.
+        virtual std::size_t getFilteredCount() const override;
+
+        /// @brief Returns the number of questions carrying each tag, according to the manifest.
+        virtual std::map<std::string, std::size_t> getTagCounts() const override;
+
+        /// @brief Applies a tag filter to all loaded shards, and to every shard loaded later.
+        /// @param expression The tag expression. An empty expression removes the filter.
+        /// @throws std::invalid_argument if the expression is malformed.
+        virtual void setFilter(const std::string &expression) override;
+
+        /// @brief Returns the tag expression used to filter drawn questions.
+        virtual const std::string &getFilter() const override { return filterExpression; }
+
+        /// @brief Returns a random presentation order of the answers of a question.
+        /// @param question A pointer to the Question object to be presented.
+        /// @return A vector of indices into the answers of the question, in the order they should be presented.
+        virtual std::vector<std::size_t> getAnswerOrder(const fq::Question *question) override { return question->getAnswerOrder(generator); }
+
+        /// @brief Sharded repositories cannot be edited.
+        virtual bool isEditable() const override { return false; }
+
+        /// @brief Sets the memory budget for loaded shards, evicting shards if needed.
+        /// @param bytes The maximum estimated memory used by loaded shards, in bytes.
+        void setMemoryBudget(std::size_t bytes);
+
+        /// @brief Returns the number of currently loaded shards.
+        std::size_t getLoadedShardCount() const { return recentlyUsed.size(); }
+
+        /// @brief Returns the number of shards listed in the manifest.
+        std::size_t getShardCount() const { return shards.size(); }
+
+        /// @brief Makes every question available through getQuestions and getBank, for tools which process all of them.
+        /// @details The shards are loaded one after the other within the memory budget, but their questions are kept
+        /// in the bank of the repository, so all of them stay in memory until the repository is destroyed.
+        /// @throws std::runtime_error if a shard cannot be loaded or its checksum does not match the manifest.
+        void mergeShards();
+
+        /// @brief Splits a repository into shards and writes their manifest.
+        /// @details The shards are written next to the manifest, named after it with a shard number appended.
+        /// Each shard keeps the type of the source repository.
+        /// @param questions The questions to be split.
+        /// @param type The repository type of the shards (e.g. "random").
+        /// @param manifestPath The path of the manifest to be written.
+        /// @param questionsPerShard The maximum number of questions in one shard.
+        /// @throws std::invalid_argument if questionsPerShard is 0.
+        /// @throws std::runtime_error if a file cannot be written.
+        static void split(const std::vector<fq::Question *> &questions, const std::string &type, const std::string &manifestPath, std::size_t questionsPerShard);
+
+        /// @brief Destroys the repository and all loaded shards without saving them.
+        virtual ~ShardedRepository();
+    };
+}
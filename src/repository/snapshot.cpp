@@ -0,0 +1,256 @@
+#include "snapshot.hpp"
+
+namespace
+{
+    /// @brief Identifies snapshot files ("FQSC").
+    constexpr quint32 snapshotMagic = 0x46515343;
+
+    /// @brief Version of the snapshot format. Snapshots of other versions are ignored.
+    constexpr quint32 snapshotVersion = 3;
+
+    /// @brief Writes the instructions and constants of a compiled expression.
+    void writeExpression(QDataStream &stream, const fq::Expression &expression)
+    {
+        stream << static_cast<quint32>(expression.getCode().size());
+        for (const auto &instruction : expression.getCode())
+            stream << static_cast<quint8>(instruction.op) << static_cast<quint32>(instruction.operand);
+        stream << static_cast<quint32>(expression.getConstants().size());
+        for (double constant : expression.getConstants())
+            stream << constant;
+    }
+
+    /// @brief Reads a compiled expression written by writeExpression.
+    /// @param variableCount The number of variables the expression may use.
+    /// @throws std::invalid_argument if the stored instructions are invalid.
+    fq::Expression readExpression(QDataStream &stream, std::size_t variableCount)
+    {
+        quint32 codeSize = 0, constantCount = 0;
+        stream >> codeSize;
+        std::vector<fq::Expression::Instruction> code;
+        for (quint32 i = 0; i < codeSize && stream.status() == QDataStream::Ok; ++i)
+        {
+            quint8 op = 0;
+            quint32 operand = 0;
+            stream >> op >> operand;
+            code.push_back({static_cast<fq::Expression::Op>(op), operand});
+        }
+        stream >> constantCount;
+        std::vector<double> constants;
+        for (quint32 i = 0; i < constantCount && stream.status() == QDataStream::Ok; ++i)
+        {
+            double constant = 0.0;
+            stream >> constant;
+            constants.push_back(constant);
+        }
+        return fq::Expression::fromCode(std::move(code), std::move(constants), variableCount);
+    }
+
+    /// @brief Writes the parts and expressions of a compiled text.
+    void writeTextTemplate(QDataStream &stream, const fq::TextTemplate &text)
+    {
+        stream << static_cast<quint32>(text.getParts().size());
+        for (const auto &part : text.getParts())
+            stream << QByteArray::fromStdString(part.text) << static_cast<qint32>(part.expression) << static_cast<qint32>(part.decimals);
+        stream << static_cast<quint32>(text.getExpressions().size());
+        for (const auto &expression : text.getExpressions())
+            writeExpression(stream, expression);
+    }
+
+    /// @brief Reads a compiled text written by writeTextTemplate.
+    /// @param variableCount The number of variables the expressions of the text may use.
+    /// @throws std::invalid_argument if the stored text is invalid.
+    fq::TextTemplate readTextTemplate(QDataStream &stream, std::size_t variableCount)
+    {
+        quint32 partCount = 0, expressionCount = 0;
+        stream >> partCount;
+        std::vector<fq::TextTemplate::Part> parts;
+        for (quint32 i = 0; i < partCount && stream.status() == QDataStream::Ok; ++i)
+        {
+            QByteArray text;
+            qint32 expression = -1, decimals = -1;
+            stream >> text >> expression >> decimals;
+            parts.push_back({text.toStdString(), expression, decimals});
+        }
+        stream >> expressionCount;
+        std::vector<fq::Expression> expressions;
+        for (quint32 i = 0; i < expressionCount && stream.status() == QDataStream::Ok; ++i)
+            expressions.push_back(readExpression(stream, variableCount));
+        return fq::TextTemplate::fromParts(std::move(parts), std::move(expressions));
+    }
+
+    /// @brief Reads the header of a snapshot and checks that it matches the JSON file of the repository.
+    /// @param stream The stream positioned at the start of the snapshot.
+    /// @param path The path to the JSON file of the repository.
+    /// @param type Receives the repository type stored in the snapshot.
+    /// @param hash Receives the SHA-1 hash of the JSON file stored in the snapshot.
+    /// @return true if the snapshot matches the JSON file; false otherwise.
+    bool readHeader(QDataStream &stream, const std::string &path, std::string &type, QByteArray &hash)
+    {
+        quint32 magic = 0, version = 0;
+        stream >> magic >> version;
+        if (stream.status() != QDataStream::Ok || magic != snapshotMagic || version != snapshotVersion)
+            return false;
+        qint64 size = 0, modified = 0;
+        QByteArray typeBytes;
+        stream >> size >> modified >> hash >> typeBytes;
+        if (stream.status() != QDataStream::Ok)
+            return false;
+
+        QFileInfo info(QString::fromStdString(path));
+        if (!info.exists() || info.size() != size)
+            return false;
+        if (info.lastModified().toMSecsSinceEpoch() != modified)
+        {
+            // The file was touched or copied; it is still the same repository if its contents are unchanged.
+            QFile file(QString::fromStdString(path));
+            if (!file.open(QIODevice::ReadOnly) || QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1) != hash)
+                return false;
+        }
+        type = typeBytes.toStdString();
+        return true;
+    }
+}
+
+std::string fq::Snapshot::snapshotPath(const std::string &path)
+{
+    return path + ".fqcache";
+}
+
+bool fq::Snapshot::load(const std::string &path, std::string &type, std::vector<fq::Question *> &questions, QByteArray &hash)
+{
+    QFile file(QString::fromStdString(snapshotPath(path)));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    std::string repositoryType;
+    QByteArray fileHash;
+    if (!readHeader(stream, path, repositoryType, fileHash))
+        return false;
+
+    quint32 count = 0;
+    stream >> count;
+    std::vector<Question *> loaded;
+    bool corrupted = false;
+    try
+    {
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+        {
+            QByteArray type, text, explanation;
+            quint32 answerCount = 0, tagCount = 0;
+            stream >> type >> text >> explanation >> answerCount;
+            std::vector<Answer> answers;
+            for (quint32 j = 0; j < answerCount && stream.status() == QDataStream::Ok; ++j)
+            {
+                QByteArray answerText;
+                bool isCorrect = false;
+                stream >> answerText >> isCorrect;
+                answers.push_back({answerText.toStdString(), isCorrect});
+            }
+            stream >> tagCount;
+            std::vector<std::string> tags;
+            for (quint32 j = 0; j < tagCount && stream.status() == QDataStream::Ok; ++j)
+            {
+                QByteArray tag;
+                stream >> tag;
+                tags.push_back(tag.toStdString());
+            }
+            double difficulty = 0.0, discrimination = 1.0;
+            stream >> difficulty >> discrimination;
+            if (stream.status() != QDataStream::Ok)
+                break;
+            if (type == "template")
+            {
+                // The compiled form is stored, so expressions are verified but not compiled again.
+                QByteArray scoring;
+                quint32 variableCount = 0;
+                stream >> scoring >> variableCount;
+                std::vector<std::string> variables;
+                std::vector<Expression> expressions;
+                for (quint32 j = 0; j < variableCount && stream.status() == QDataStream::Ok; ++j)
+                {
+                    QByteArray variable;
+                    stream >> variable;
+                    variables.push_back(variable.toStdString());
+                    expressions.push_back(readExpression(stream, j));
+                }
+                TextTemplate textTemplate = readTextTemplate(stream, variables.size());
+                std::vector<TextTemplate> answerTemplates;
+                for (quint32 j = 0; j < answerCount && stream.status() == QDataStream::Ok; ++j)
+                    answerTemplates.push_back(readTextTemplate(stream, variables.size()));
+                TextTemplate explanationTemplate = readTextTemplate(stream, variables.size());
+                if (stream.status() != QDataStream::Ok)
+                    break;
+                loaded.push_back(new TemplateQuestion(text.toStdString(), answers, explanation.toStdString(), scoring.toStdString(), variables,
+                                                      std::move(expressions), std::move(textTemplate), std::move(answerTemplates), std::move(explanationTemplate)));
+                loaded.back()->setTags(tags);
+            }
+            else
+                loaded.push_back(Question::fromParameters(text.toStdString(), answers, explanation.toStdString(), type.toStdString(), tags));
+            loaded.back()->setDifficulty(difficulty);
+            loaded.back()->setDiscrimination(discrimination);
+        }
+    }
+    catch (const std::exception &)
+    {
+        // A snapshot holding an invalid question is ignored like a missing one.
+        corrupted = true;
+    }
+    if (corrupted || stream.status() != QDataStream::Ok || loaded.size() != count)
+    {
+        for (auto &question : loaded)
+            delete question;
+        return false;
+    }
+    type = std::move(repositoryType);
+    hash = std::move(fileHash);
+    questions = std::move(loaded);
+    return true;
+}
+
+bool fq::Snapshot::save(const std::string &path, const QByteArray &contents, qint64 modified, const std::string &type, const std::vector<fq::Question *> &questions)
+{
+    QFileInfo info(QString::fromStdString(path));
+    if (!info.exists() || info.size() != contents.size() || info.lastModified().toMSecsSinceEpoch() != modified)
+        return false;
+    QSaveFile file(QString::fromStdString(snapshotPath(path)));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << snapshotMagic << snapshotVersion << static_cast<qint64>(info.size()) << modified
+           << QCryptographicHash::hash(contents, QCryptographicHash::Sha1) << QByteArray::fromStdString(type);
+    stream << static_cast<quint32>(questions.size());
+    for (const auto &question : questions)
+    {
+        stream << QByteArray::fromStdString(question->getType()) << QByteArray::fromStdString(question->getQuestion())
+               << QByteArray::fromStdString(question->getExplanation()) << static_cast<quint32>(question->getAnswers().size());
+        for (const auto &answer : question->getAnswers())
+            stream << QByteArray::fromStdString(answer.text) << answer.isCorrect;
+        stream << static_cast<quint32>(question->getTags().size());
+        for (const auto &tag : question->getTags())
+            stream << QByteArray::fromStdString(tag);
+        stream << question->getDifficulty() << question->getDiscrimination();
+        if (const auto *templated = dynamic_cast<const TemplateQuestion *>(question))
+        {
+            stream << QByteArray::fromStdString(templated->getScoringType()) << static_cast<quint32>(templated->getVariables().size());
+            for (std::size_t j = 0; j < templated->getVariables().size(); ++j)
+            {
+                stream << QByteArray::fromStdString(templated->getVariables()[j]);
+                writeExpression(stream, templated->getExpressions()[j]);
+            }
+            writeTextTemplate(stream, templated->getTextTemplate());
+            for (const auto &answer : templated->getAnswerTemplates())
+                writeTextTemplate(stream, answer);
+            writeTextTemplate(stream, templated->getExplanationTemplate());
+        }
+    }
+    // The JSON file may have changed while the snapshot was being written.
+    info.refresh();
+    if (stream.status() != QDataStream::Ok || info.size() != contents.size() || info.lastModified().toMSecsSinceEpoch() != modified)
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
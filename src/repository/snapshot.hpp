@@ -0,0 +1,63 @@
+/// @file snapshot.hpp
+/// @brief Contains the definition of binary snapshots used to reopen unchanged repositories without parsing their JSON.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Reads and writes binary snapshots of repositories.
+    /// @details A snapshot is stored next to the repository file, with ".fqcache" appended to its name. It holds the
+    /// type and the questions of the repository in a length-prefixed binary form, template questions with their
+    /// compiled expressions and texts, so loading one parses neither JSON nor expressions. The questions themselves are
+    /// still rebuilt from their fields, since they are polymorphic objects owning their strings. The snapshot also holds
+    /// the size, modification time and SHA-1 hash of the JSON file it was made from. A snapshot is only used while it matches the JSON file:
+    /// the size must be equal, and either the modification time or, if that changed, the hash of the contents.
+    /// Snapshots are a cache only; failing to read or write one never fails loading or saving the repository. They are
+    /// written to a temporary file which replaces the previous snapshot only once it is complete, and only if the JSON
+    /// file has not changed since the contents it describes were read.
+    class Snapshot
+    {
+    public:
+        /// @brief Returns the path of the snapshot of a repository.
+        /// @param path The path to the JSON file of the repository.
+        static std::string snapshotPath(const std::string &path);
+
+        /// @brief Loads the type and the questions stored in the snapshot of a repository.
+        /// @param path The path to the JSON file of the repository.
+        /// @param type Receives the repository type. Left unchanged if false is returned.
+        /// @param questions Receives the loaded questions, owned by the caller. Left unchanged if false is returned.
+        /// @param hash Receives the SHA-1 hash of the JSON file. Left unchanged if false is returned.
+        /// @return true if a snapshot matching the JSON file was loaded; false otherwise.
+        static bool load(const std::string &path, std::string &type, std::vector<fq::Question *> &questions, QByteArray &hash);
+
+        /// @brief Writes the snapshot of a repository.
+        /// @details Nothing is written if the size or modification time of the JSON file no longer match the specified
+        /// contents, e.g. because another program changed the file after it was read.
+        /// @param path The path to the JSON file of the repository.
+        /// @param contents The contents of the JSON file.
+        /// @param modified The modification time of the JSON file when the contents were read or written, in
+        /// milliseconds since the epoch.
+        /// @param type The type of the repository.
+        /// @param questions The questions of the repository.
+        /// @return true if the snapshot was written; false otherwise.
+        static bool save(const std::string &path, const QByteArray &contents, qint64 modified, const std::string &type, const std::vector<fq::Question *> &questions);
+    };
+}
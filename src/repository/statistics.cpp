@@ -0,0 +1,217 @@
+#include "statistics.hpp"
+#include "sessionlog.hpp"
+#include "memoryusage.hpp"
+
+namespace
+{
+    /// @brief Identifies statistics files ("FQST").
+    constexpr quint32 statisticsMagic = 0x46515354;
+
+    /// @brief Version of the statistics format. Files of other versions are ignored.
+    constexpr quint32 statisticsVersion = 2;
+
+    /// @brief Upper bound of the first bin of the response time histograms, in seconds.
+    constexpr double firstBinBound = 0.25;
+
+    /// @brief Reads a column of a statistics file.
+    /// @return False if the stream failed, in which case the column is incomplete.
+    template <typename T, typename Stored>
+    bool readColumn(QDataStream &stream, std::vector<T> &column, quint32 rows)
+    {
+        column.resize(rows);
+        for (auto &value : column)
+        {
+            Stored stored{};
+            stream >> stored;
+            if (stream.status() != QDataStream::Ok)
+                return false;
+            value = static_cast<T>(stored);
+        }
+        return true;
+    }
+
+    /// @brief Writes a column of a statistics file.
+    template <typename Stored, typename T>
+    void writeColumn(QDataStream &stream, const std::vector<T> &column)
+    {
+        for (const auto &value : column)
+            stream << static_cast<Stored>(value);
+    }
+}
+
+double fq::QuestionStatistics::Summary::latencyPercentile(double fraction) const
+{
+    std::uint64_t total = 0;
+    for (auto count : histogram)
+        total += count;
+    if (!total)
+        return 0.0;
+    double target = std::max(0.0, std::min(1.0, fraction)) * total;
+    double cumulative = 0.0;
+    for (std::size_t bin = 0; bin < latencyBins; ++bin)
+    {
+        if (!histogram[bin] || cumulative + histogram[bin] < target)
+        {
+            cumulative += histogram[bin];
+            continue;
+        }
+        double lower = bin ? binUpperBound(bin - 1) : 0.0;
+        double upper = bin + 1 < latencyBins ? binUpperBound(bin) : 2.0 * lower;
+        return lower + (upper - lower) * (target - cumulative) / histogram[bin];
+    }
+    return binUpperBound(latencyBins - 2);
+}
+
+fq::QuestionStatistics::QuestionStatistics() : modified(false)
+{
+}
+
+fq::QuestionStatistics::QuestionStatistics(const std::string &path) : path(path), modified(false)
+{
+    load();
+}
+
+void fq::QuestionStatistics::load()
+{
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0, count = 0;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != statisticsMagic || version != statisticsVersion)
+        return;
+    // A count larger than the rest of the file marks a truncated or corrupt file, which is ignored instead of
+    // allocating columns for rows that cannot be read.
+    constexpr qint64 bytesPerRow = 6 * sizeof(quint64) + latencyBins * sizeof(quint32);
+    if (static_cast<qint64>(count) > (file.size() - file.pos()) / bytesPerRow)
+        return;
+    bool complete = readColumn<std::uint64_t, quint64>(stream, ids, count) &&
+                    readColumn<std::uint64_t, quint64>(stream, counts, count) &&
+                    readColumn<double, double>(stream, scoreMeans, count) &&
+                    readColumn<double, double>(stream, scoreDeviations, count) &&
+                    readColumn<double, double>(stream, latencyMeans, count) &&
+                    readColumn<double, double>(stream, latencyDeviations, count);
+    for (auto &column : histogram)
+        complete = complete && readColumn<std::uint32_t, quint32>(stream, column, count);
+    if (!complete)
+    {
+        ids.clear();
+        counts.clear();
+        scoreMeans.clear();
+        scoreDeviations.clear();
+        latencyMeans.clear();
+        latencyDeviations.clear();
+        for (auto &column : histogram)
+            column.clear();
+        return;
+    }
+    rows.reserve(count);
+    for (quint32 row = 0; row < count; ++row)
+        rows.emplace(ids[row], row);
+}
+
+void fq::QuestionStatistics::record(const fq::Question *question, double latency, double score)
+{
+    std::uint64_t id = SessionLog::questionId(question);
+    auto it = rows.find(id);
+    if (it == rows.end())
+    {
+        it = rows.emplace(id, static_cast<std::uint32_t>(ids.size())).first;
+        ids.push_back(id);
+        counts.push_back(0);
+        scoreMeans.push_back(0.0);
+        scoreDeviations.push_back(0.0);
+        latencyMeans.push_back(0.0);
+        latencyDeviations.push_back(0.0);
+        for (auto &column : histogram)
+            column.push_back(0);
+    }
+    std::uint32_t row = it->second;
+    latency = std::max(0.0, latency);
+    double n = static_cast<double>(++counts[row]);
+    double delta = score - scoreMeans[row];
+    scoreMeans[row] += delta / n;
+    scoreDeviations[row] += delta * (score - scoreMeans[row]);
+    delta = latency - latencyMeans[row];
+    latencyMeans[row] += delta / n;
+    latencyDeviations[row] += delta * (latency - latencyMeans[row]);
+    ++histogram[latencyBin(latency)][row];
+    modified = true;
+}
+
+std::optional<fq::QuestionStatistics::Summary> fq::QuestionStatistics::get(const fq::Question *question) const
+{
+    auto it = rows.find(SessionLog::questionId(question));
+    if (it == rows.end())
+        return std::nullopt;
+    std::uint32_t row = it->second;
+    Summary summary;
+    summary.answers = counts[row];
+    summary.meanScore = scoreMeans[row];
+    summary.scoreVariance = counts[row] > 1 ? scoreDeviations[row] / (counts[row] - 1) : 0.0;
+    summary.meanLatency = latencyMeans[row];
+    summary.latencyVariance = counts[row] > 1 ? latencyDeviations[row] / (counts[row] - 1) : 0.0;
+    for (std::size_t bin = 0; bin < latencyBins; ++bin)
+        summary.histogram[bin] = histogram[bin][row];
+    return summary;
+}
+
+bool fq::QuestionStatistics::save()
+{
+    if (path.empty())
+        return false;
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << statisticsMagic << statisticsVersion << static_cast<quint32>(ids.size());
+    writeColumn<quint64>(stream, ids);
+    writeColumn<quint64>(stream, counts);
+    writeColumn<double>(stream, scoreMeans);
+    writeColumn<double>(stream, scoreDeviations);
+    writeColumn<double>(stream, latencyMeans);
+    writeColumn<double>(stream, latencyDeviations);
+    for (const auto &column : histogram)
+        writeColumn<quint32>(stream, column);
+    if (stream.status() != QDataStream::Ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit())
+        return false;
+    modified = false;
+    return true;
+}
+
+std::string fq::QuestionStatistics::statisticsPath(const std::string &path)
+{
+    return path + ".fqstats";
+}
+
+std::size_t fq::QuestionStatistics::latencyBin(double latency)
+{
+    if (!(latency >= firstBinBound))
+        return 0;
+    auto bin = static_cast<std::size_t>(std::floor(std::log2(latency / firstBinBound))) + 1;
+    return std::min(bin, latencyBins - 1);
+}
+
+double fq::QuestionStatistics::binUpperBound(std::size_t bin)
+{
+    if (bin + 1 >= latencyBins)
+        return std::numeric_limits<double>::infinity();
+    return std::ldexp(firstBinBound, static_cast<int>(bin));
+}
+
+std::size_t fq::QuestionStatistics::memoryUsage() const
+{
+    std::size_t bytes = (ids.capacity() + counts.capacity()) * sizeof(std::uint64_t);
+    bytes += (scoreMeans.capacity() + scoreDeviations.capacity() + latencyMeans.capacity() + latencyDeviations.capacity()) * sizeof(double);
+    for (const auto &bin : histogram)
+        bytes += bin.capacity() * sizeof(std::uint32_t);
+    return bytes + MemoryUsage::hashMapBytes(rows) + Question::stringBytes(path);
+}
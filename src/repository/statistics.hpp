@@ -0,0 +1,149 @@
+/// @file statistics.hpp
+/// @brief Contains the definition of a store of per-question answer statistics.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <array>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Running statistics of the answers to the questions of a repository: scores and response times.
+    /// @details Only aggregates are kept, updated in constant time for every answer: the number of answers, the mean
+    /// and variance of the score and of the response time (Welford's algorithm) and a histogram of the response times.
+    /// The size of the store therefore depends on the number of questions, never on the number of answers. The
+    /// aggregates are stored column by column (one array per aggregate, indexed by row), both in memory and in the
+    /// ".fqstats" file next to the repository. Questions are identified by SessionLog::questionId, so the statistics
+    /// of a question survive reordering its answers and end when its contents change. The store is not thread-safe.
+    class QuestionStatistics
+    {
+    public:
+        /// @brief Number of bins of the response time histograms.
+        static constexpr std::size_t latencyBins = 16;
+
+        /// @brief Aggregated statistics of one question.
+        struct Summary
+        {
+            /// @brief The number of recorded answers.
+            std::uint64_t answers = 0;
+
+            /// @brief Mean score.
+            double meanScore = 0.0;
+
+            /// @brief Variance of the score.
+            double scoreVariance = 0.0;
+
+            /// @brief Mean response time, in seconds.
+            double meanLatency = 0.0;
+
+            /// @brief Variance of the response time, in square seconds.
+            double latencyVariance = 0.0;
+
+            /// @brief Number of answers in each response time bin; see binUpperBound.
+            std::array<std::uint32_t, latencyBins> histogram{};
+
+            /// @brief Estimates a percentile of the response time from the histogram.
+            /// @param fraction The fraction of answers given faster than the returned time, between 0 and 1.
+            /// @return The estimated response time, in seconds.
+            double latencyPercentile(double fraction) const;
+        };
+
+    private:
+        /// @brief Identifiers of the questions, one per row.
+        std::vector<std::uint64_t> ids;
+
+        /// @brief Number of answers, one per row.
+        std::vector<std::uint64_t> counts;
+
+        /// @brief Mean scores, one per row.
+        std::vector<double> scoreMeans;
+
+        /// @brief Sums of squared deviations of the scores from their mean, one per row.
+        std::vector<double> scoreDeviations;
+
+        /// @brief Mean response times, one per row.
+        std::vector<double> latencyMeans;
+
+        /// @brief Sums of squared deviations of the response times from their mean, one per row.
+        std::vector<double> latencyDeviations;
+
+        /// @brief Response time histograms, one column per bin.
+        std::array<std::vector<std::uint32_t>, latencyBins> histogram;
+
+        /// @brief The row of each question, keyed by question identifier.
+        std::unordered_map<std::uint64_t, std::uint32_t> rows;
+
+        /// @brief The path to the statistics file. Empty if the store is not saved.
+        std::string path;
+
+        /// @brief Indicates whether answers were recorded since the store was loaded or saved.
+        bool modified;
+
+        /// @brief Reads the store from its file. A missing or invalid file leaves the store empty.
+        void load();
+
+    public:
+        /// @brief Constructs an empty store which is never saved.
+        QuestionStatistics();
+
+        /// @brief Loads the store from its file, or creates an empty one if there is no valid file.
+        /// @param path The path to the statistics file.
+        explicit QuestionStatistics(const std::string &path);
+
+        /// @brief Records an answer to a question.
+        /// @param question A pointer to the answered Question object.
+        /// @param latency The time the user took to answer, in seconds.
+        /// @param score The score gained by the user.
+        void record(const fq::Question *question, double latency, double score);
+
+        /// @brief Returns the statistics of a question.
+        /// @param question A pointer to the Question object.
+        /// @return The statistics, or nothing if no answer to the question was recorded.
+        std::optional<Summary> get(const fq::Question *question) const;
+
+        /// @brief Returns the number of questions with recorded answers.
+        std::size_t size() const { return ids.size(); }
+
+        /// @brief Returns the number of bytes used by the store, excluding the object itself.
+        std::size_t memoryUsage() const;
+
+        /// @brief Returns whether answers were recorded since the store was loaded or saved.
+        bool isModified() const { return modified; }
+
+        /// @brief Writes the store to its file.
+        /// @return true if the store was written; false otherwise.
+        bool save();
+
+        /// @brief Returns the path of the statistics file of a repository.
+        /// @param path The path to the JSON file of the repository.
+        static std::string statisticsPath(const std::string &path);
+
+        /// @brief Returns the bin of the response time histograms a response time belongs to.
+        /// @param latency The response time, in seconds.
+        static std::size_t latencyBin(double latency);
+
+        /// @brief Returns the upper bound of a bin of the response time histograms.
+        /// @details Bin 0 holds times under 0.25 s, and every further bin doubles the bound; the last bin is unbounded.
+        /// @param bin The bin.
+        /// @return The upper bound, in seconds.
+        static double binUpperBound(std::size_t bin);
+    };
+}
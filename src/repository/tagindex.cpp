@@ -0,0 +1,145 @@
+#include "tagindex.hpp"
+
+namespace
+{
+    /// @brief Recursive descent parser for tag expressions.
+    class ExpressionParser
+    {
+        const fq::TagIndex &index;
+        const std::string &expression;
+        std::size_t position;
+
+        void skipSpaces()
+        {
+            while (position < expression.size() && std::isspace(static_cast<unsigned char>(expression[position])))
+                ++position;
+        }
+
+        bool accept(char c)
+        {
+            skipSpaces();
+            if (position < expression.size() && expression[position] == c)
+            {
+                ++position;
+                return true;
+            }
+            return false;
+        }
+
+        std::string parseTag()
+        {
+            skipSpaces();
+            std::string tag;
+            if (accept('"'))
+            {
+                while (position < expression.size() && expression[position] != '"')
+                    tag += expression[position++];
+                if (!accept('"'))
+                    throw std::invalid_argument("Unterminated quoted tag in filter expression");
+            }
+            else
+            {
+                while (position < expression.size() && !std::isspace(static_cast<unsigned char>(expression[position])) &&
+                       std::string("&|!()\"").find(expression[position]) == std::string::npos)
+                    tag += expression[position++];
+            }
+            if (tag.empty())
+                throw std::invalid_argument("Expected a tag at position " + std::to_string(position + 1) + " of filter expression");
+            return tag;
+        }
+
+        fq::Bitset parsePrimary()
+        {
+            if (accept('!'))
+                return index.all() - parsePrimary();
+            if (accept('('))
+            {
+                fq::Bitset result = parseOr();
+                if (!accept(')'))
+                    throw std::invalid_argument("Missing ')' in filter expression");
+                return result;
+            }
+            return index.getSlots(parseTag());
+        }
+
+        fq::Bitset parseAnd()
+        {
+            fq::Bitset result = parsePrimary();
+            while (accept('&'))
+                result = result & parsePrimary();
+            return result;
+        }
+
+        fq::Bitset parseOr()
+        {
+            fq::Bitset result = parseAnd();
+            while (accept('|'))
+                result = result | parseAnd();
+            return result;
+        }
+
+    public:
+        ExpressionParser(const fq::TagIndex &index, const std::string &expression)
+            : index(index), expression(expression), position(0) {}
+
+        fq::Bitset parse()
+        {
+            fq::Bitset result = parseOr();
+            skipSpaces();
+            if (position != expression.size())
+                throw std::invalid_argument("Unexpected character '" + std::string(1, expression[position]) + "' in filter expression");
+            return result;
+        }
+    };
+}
+
+void fq::TagIndex::build(const std::vector<fq::Question *> &questions)
+{
+    tags.clear();
+    questionCount = questions.size();
+    for (std::size_t slot = 0; slot < questions.size(); ++slot)
+    {
+        for (const auto &tag : questions[slot]->getTags())
+            tags[tag].add(static_cast<std::uint32_t>(slot));
+    }
+}
+
+fq::Bitset fq::TagIndex::getSlots(const std::string &tag) const
+{
+    auto it = tags.find(tag);
+    if (it == tags.end())
+        return Bitset();
+    return it->second;
+}
+
+std::vector<std::string> fq::TagIndex::getTags() const
+{
+    std::vector<std::string> result;
+    result.reserve(tags.size());
+    for (const auto &it : tags)
+        result.push_back(it.first);
+    return result;
+}
+
+std::map<std::string, std::size_t> fq::TagIndex::getTagCounts() const
+{
+    std::map<std::string, std::size_t> result;
+    for (const auto &it : tags)
+        result[it.first] = it.second.size();
+    return result;
+}
+
+fq::Bitset fq::TagIndex::evaluate(const std::string &expression) const
+{
+    if (expression.find_first_not_of(" \t\r\n") == std::string::npos)
+        return all();
+    return ExpressionParser(*this, expression).parse();
+}
+
+std::size_t fq::TagIndex::memoryUsage() const
+{
+    std::size_t bytes = 0;
+    for (const auto &it : tags)
+        bytes += sizeof(it) + it.first.capacity() + it.second.memoryUsage();
+    return bytes;
+}
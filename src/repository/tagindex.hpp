@@ -0,0 +1,71 @@
+/// @file tagindex.hpp
+/// @brief Contains the definition of an index mapping question tags to compressed sets of question slots.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <cctype>
+#include "bitset.hpp"
+#include "question.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Index of the tags of a question collection.
+    /// @details Every tag is mapped to a compressed bitset of the slots (positions in the question collection)
+    /// of the questions carrying that tag. Tag expressions are evaluated directly on these bitsets, so filtering
+    /// never copies the questions themselves.
+    class TagIndex
+    {
+        /// @brief Sets of question slots, keyed by tag.
+        std::map<std::string, Bitset> tags;
+
+        /// @brief Number of indexed questions.
+        std::size_t questionCount;
+
+    public:
+        /// @brief Constructs an empty index.
+        TagIndex() : questionCount(0) {}
+
+        /// @brief Rebuilds the index for the specified question collection.
+        /// @param questions The questions to be indexed. The slot of a question is its position in the vector.
+        void build(const std::vector<fq::Question *> &questions);
+
+        /// @brief Returns the slots of the questions with the specified tag.
+        /// @param tag The tag to look for.
+        /// @return A bitset of question slots. It is empty if no question carries the tag.
+        Bitset getSlots(const std::string &tag) const;
+
+        /// @brief Returns all tags present in the index, in alphabetical order.
+        /// @return A vector of tags.
+        std::vector<std::string> getTags() const;
+
+        /// @brief Returns the number of questions carrying each tag.
+        /// @return A map from tags to question counts.
+        std::map<std::string, std::size_t> getTagCounts() const;
+
+        /// @brief Returns the slots of all indexed questions.
+        /// @return A bitset containing every slot.
+        Bitset all() const { return Bitset::range(questionCount); }
+
+        /// @brief Evaluates a tag expression.
+        /// @details Tags can be combined with '&' (and), '|' (or), '!' (not) and parentheses. '&' binds stronger than '|'.
+        /// Tags containing spaces or operator characters can be written in double quotes. An empty expression matches all questions.
+        /// @param expression The tag expression, e.g. "chapter1 & !hard | \"final exam\"".
+        /// @return A bitset of the slots of the questions matching the expression.
+        /// @throws std::invalid_argument if the expression is malformed.
+        Bitset evaluate(const std::string &expression) const;
+
+        /// @brief Returns the number of bytes used by the index, excluding the object itself.
+        std::size_t memoryUsage() const;
+    };
+}
@@ -0,0 +1,496 @@
+#include "validator.hpp"
+#include "question.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+    using Severity = fq::Validator::Severity;
+    using Problem = fq::Validator::Problem;
+
+    constexpr std::size_t npos = std::string::npos;
+
+    /// @brief Positions of one element of the questions array.
+    struct Element
+    {
+        /// @brief The offset of its first character.
+        std::size_t begin;
+
+        /// @brief The offset just past its last character.
+        std::size_t end;
+    };
+
+    /// @brief The top level of a repository file.
+    struct TopLevel
+    {
+        /// @brief The elements of the questions array.
+        std::vector<Element> elements;
+
+        /// @brief Indicates whether the file has a questions key.
+        bool hasQuestions = false;
+
+        /// @brief The value of the type key, undefined if there is none.
+        QJsonValue type = QJsonValue(QJsonValue::Undefined);
+    };
+
+    /// @brief Returns the position of the first non-whitespace character at or after pos.
+    std::size_t skipSpace(const char *data, std::size_t size, std::size_t pos)
+    {
+        while (pos < size && (data[pos] == ' ' || data[pos] == '\n' || data[pos] == '\r' || data[pos] == '\t'))
+            ++pos;
+        return pos;
+    }
+
+    /// @brief Returns the position just past the string starting at pos, or npos if it is not terminated.
+    std::size_t skipString(const char *data, std::size_t size, std::size_t pos)
+    {
+        for (++pos; pos < size; ++pos)
+        {
+            if (data[pos] == '\\')
+                ++pos;
+            else if (data[pos] == '"')
+                return pos + 1;
+        }
+        return npos;
+    }
+
+    /// @brief Returns the position just past the value starting at pos, or npos if it is not terminated.
+    /// @details Only strings and the nesting of brackets are followed; the value itself is checked when it is parsed.
+    std::size_t skipValue(const char *data, std::size_t size, std::size_t pos)
+    {
+        if (pos >= size)
+            return npos;
+        if (data[pos] == '"')
+            return skipString(data, size, pos);
+        if (data[pos] != '{' && data[pos] != '[')
+        {
+            while (pos < size && data[pos] != ',' && data[pos] != '}' && data[pos] != ']' && data[pos] != ' ' &&
+                   data[pos] != '\n' && data[pos] != '\r' && data[pos] != '\t')
+                ++pos;
+            return pos;
+        }
+        std::size_t depth = 0;
+        while (pos < size)
+        {
+            char c = data[pos];
+            if (c == '"')
+            {
+                pos = skipString(data, size, pos);
+                if (pos == npos)
+                    return npos;
+                continue;
+            }
+            if (c == '{' || c == '[')
+                ++depth;
+            else if ((c == '}' || c == ']') && --depth == 0)
+                return pos + 1;
+            ++pos;
+        }
+        return npos;
+    }
+
+    /// @brief Scans the top level of a repository file, finding the elements of its questions array.
+    /// @details Values other than the questions array are parsed right away, since they are small.
+    /// @return false if the file is malformed beyond the first problem reported.
+    bool scanTopLevel(const QByteArray &contents, TopLevel &topLevel, std::vector<Problem> &problems)
+    {
+        const char *data = contents.constData();
+        const std::size_t size = static_cast<std::size_t>(contents.size());
+        auto fail = [&problems](std::size_t offset, const std::string &location, const std::string &message)
+        {
+            problems.push_back({Severity::Error, 0, location, {}, message, offset});
+            return false;
+        };
+
+        std::size_t pos = skipSpace(data, size, 0);
+        if (pos >= size || data[pos] != '{')
+            return fail(pos, "", "Repository must be a JSON object");
+        pos = skipSpace(data, size, pos + 1);
+        if (pos < size && data[pos] == '}')
+            ++pos;
+        else
+        {
+            while (true)
+            {
+                if (pos >= size || data[pos] != '"')
+                    return fail(pos, "", "Expected a key");
+                std::size_t keyEnd = skipString(data, size, pos);
+                if (keyEnd == npos)
+                    return fail(pos, "", "Unterminated string");
+                std::string key(data + pos + 1, keyEnd - pos - 2);
+                pos = skipSpace(data, size, keyEnd);
+                if (pos >= size || data[pos] != ':')
+                    return fail(pos, key, "Expected ':' after the key");
+                pos = skipSpace(data, size, pos + 1);
+
+                if (key == "questions" && pos < size && data[pos] == '[')
+                {
+                    topLevel.hasQuestions = true;
+                    pos = skipSpace(data, size, pos + 1);
+                    if (pos < size && data[pos] == ']')
+                        ++pos;
+                    else
+                    {
+                        while (true)
+                        {
+                            std::string location = "questions[" + std::to_string(topLevel.elements.size()) + "]";
+                            std::size_t end = skipValue(data, size, pos);
+                            if (end == npos)
+                                return fail(pos, location, "Unterminated value");
+                            if (end == pos)
+                                return fail(pos, location, "Expected a question");
+                            topLevel.elements.push_back({pos, end});
+                            pos = skipSpace(data, size, end);
+                            if (pos < size && data[pos] == ',')
+                            {
+                                pos = skipSpace(data, size, pos + 1);
+                                continue;
+                            }
+                            if (pos < size && data[pos] == ']')
+                            {
+                                ++pos;
+                                break;
+                            }
+                            return fail(pos, location, "Expected ',' or ']' after the question");
+                        }
+                    }
+                }
+                else
+                {
+                    std::size_t end = skipValue(data, size, pos);
+                    if (end == npos || end == pos)
+                        return fail(pos, key, "Expected a value");
+                    QJsonParseError error;
+                    QJsonDocument value = QJsonDocument::fromJson("[" + contents.mid(pos, end - pos) + "]", &error);
+                    if (error.error != QJsonParseError::NoError)
+                        fail(pos + std::max(error.offset - 1, 0), key, "Invalid JSON: " + error.errorString().toStdString());
+                    else if (key == "type")
+                        topLevel.type = value.array().first();
+                    else if (key == "questions")
+                    {
+                        topLevel.hasQuestions = true;
+                        fail(pos, key, "'questions' must be an array");
+                    }
+                    pos = end;
+                }
+
+                pos = skipSpace(data, size, pos);
+                if (pos < size && data[pos] == ',')
+                {
+                    pos = skipSpace(data, size, pos + 1);
+                    continue;
+                }
+                if (pos < size && data[pos] == '}')
+                {
+                    ++pos;
+                    break;
+                }
+                return fail(pos, "", "Expected ',' or '}'");
+            }
+        }
+        pos = skipSpace(data, size, pos);
+        if (pos < size)
+            return fail(pos, "", "Unexpected text after the repository");
+        return true;
+    }
+}
+
+std::size_t fq::Validator::Report::count(Severity severity) const
+{
+    return static_cast<std::size_t>(std::count_if(problems.begin(), problems.end(), [severity](const Problem &problem)
+                                                  { return problem.severity == severity; }));
+}
+
+void fq::Validator::checkQuestion(const QByteArray &element, std::size_t offset, std::size_t index, std::vector<Problem> &problems, std::string &text)
+{
+    const std::string prefix = "questions[" + std::to_string(index) + "]";
+    const std::size_t first = problems.size();
+    auto report = [&](Severity severity, const std::string &location, const std::string &message)
+    {
+        problems.push_back({severity, 0, prefix + location, {}, message, offset});
+    };
+
+    if (!element.startsWith('{'))
+    {
+        report(Severity::Error, "", "Question must be a JSON object");
+        return;
+    }
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(element, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        problems.push_back({Severity::Error, 0, prefix, {}, "Invalid JSON: " + error.errorString().toStdString(), offset + static_cast<std::size_t>(error.offset)});
+        return;
+    }
+    QJsonObject json = document.object();
+
+    QJsonValue textValue = json["text"];
+    if (textValue.isString() && !textValue.toString().isEmpty())
+        text = textValue.toString().toStdString();
+    else
+        report(Severity::Error, ".text", "Question text is missing or empty");
+
+    std::string type;
+    if (!json["type"].isString())
+        report(Severity::Error, ".type", "Question type is missing or not a string");
+    else
+    {
+        type = json["type"].toString().toStdString();
+        if (type != "single" && type != "multiple" && type != "negative_multiple" && type != "template")
+            report(Severity::Error, ".type", "Unknown question type '" + type + "'");
+    }
+
+    // Template questions are scored as their variants, and their texts must compile with their variables.
+    const bool isTemplate = type == "template";
+    std::vector<std::string> names;
+    auto checkTemplate = [&](const QJsonValue &value, const std::string &location)
+    {
+        if (!isTemplate || !value.isString())
+            return;
+        try
+        {
+            TextTemplate(value.toString().toStdString(), names);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            report(Severity::Error, location, e.what());
+        }
+    };
+    if (isTemplate)
+    {
+        if (!json["scoring"].isString())
+            report(Severity::Error, ".scoring", "Template question has no scoring type");
+        else
+        {
+            type = json["scoring"].toString().toStdString();
+            if (type != "single" && type != "multiple" && type != "negative_multiple")
+                report(Severity::Error, ".scoring", "Unknown scoring type '" + type + "'");
+        }
+        if (json.contains("variables") && !json["variables"].isArray())
+            report(Severity::Error, ".variables", "Variables must be an array");
+        QJsonArray variables = json["variables"].toArray();
+        for (qsizetype i = 0; i < variables.size(); ++i)
+        {
+            const std::string location = ".variables[" + std::to_string(i) + "]";
+            if (!variables[i].isString())
+            {
+                report(Severity::Error, location, "Variable must be a string");
+                continue;
+            }
+            std::pair<std::string, std::string> definition;
+            try
+            {
+                definition = TemplateQuestion::splitDefinition(variables[i].toString().toStdString());
+                Expression(definition.second, names);
+            }
+            catch (const std::invalid_argument &e)
+            {
+                report(Severity::Error, location, e.what());
+            }
+            // A variable whose expression is invalid is still defined, so the texts using it are not reported too.
+            if (definition.first.empty())
+                continue;
+            if (std::find(names.begin(), names.end(), definition.first) != names.end())
+                report(Severity::Error, location, "Variable '" + definition.first + "' is defined twice");
+            else
+                names.push_back(definition.first);
+        }
+        if (names.size() > TemplateQuestion::maxVariables)
+            report(Severity::Error, ".variables", "Template question has more than " + std::to_string(TemplateQuestion::maxVariables) + " variables");
+        checkTemplate(textValue, ".text");
+        checkTemplate(json["explanation"], ".explanation");
+    }
+
+    if (json.contains("explanation") && !json["explanation"].isString())
+        report(Severity::Warning, ".explanation", "Explanation is not a string and is ignored");
+
+    if (!json["answers"].isArray())
+        report(Severity::Error, ".answers", "Answers are missing or not an array");
+    else if (json["answers"].toArray().isEmpty())
+        report(Severity::Error, ".answers", "Question must have at least one answer");
+    else
+    {
+        QJsonArray answers = json["answers"].toArray();
+        std::vector<QString> answerTexts;
+        std::size_t correct = 0;
+        for (qsizetype i = 0; i < answers.size(); ++i)
+        {
+            const std::string location = ".answers[" + std::to_string(i) + "]";
+            if (!answers[i].isObject())
+            {
+                report(Severity::Error, location, "Answer must be a JSON object");
+                continue;
+            }
+            QJsonObject answer = answers[i].toObject();
+            if (!answer.contains("text"))
+                report(Severity::Error, location + ".text", "Answer has no text");
+            else if (!answer["text"].isString())
+                report(Severity::Warning, location + ".text", "Answer text is not a string and is read as empty");
+            else if (answer["text"].toString().isEmpty())
+                report(Severity::Warning, location + ".text", "Answer text is empty");
+            else
+            {
+                QString answerText = answer["text"].toString();
+                checkTemplate(answer["text"], location + ".text");
+                auto same = std::find(answerTexts.begin(), answerTexts.end(), answerText);
+                if (same != answerTexts.end())
+                    report(Severity::Warning, location + ".text", "Same text as answers[" + std::to_string(same - answerTexts.begin()) + "]");
+                answerTexts.push_back(answerText);
+            }
+            if (!answer.contains("is_correct"))
+                report(Severity::Error, location + ".is_correct", "Answer has no 'is_correct' field");
+            else if (!answer["is_correct"].isBool())
+                report(Severity::Warning, location + ".is_correct", "'is_correct' is not a boolean and is read as false");
+            else if (answer["is_correct"].toBool())
+                ++correct;
+        }
+        if (type == "single" && correct != 1)
+            report(Severity::Error, ".answers", "Single choice question has " + std::to_string(correct) + " correct answers instead of one");
+        else if ((type == "multiple" || type == "negative_multiple") && correct == 0)
+            report(Severity::Warning, ".answers", "Question has no correct answer");
+    }
+
+    if (json.contains("tags"))
+    {
+        if (!json["tags"].isArray())
+            report(Severity::Error, ".tags", "Tags must be an array");
+        else
+        {
+            QJsonArray tags = json["tags"].toArray();
+            for (qsizetype i = 0; i < tags.size(); ++i)
+            {
+                if (!tags[i].isString())
+                    report(Severity::Error, ".tags[" + std::to_string(i) + "]", "Tag must be a string");
+            }
+        }
+    }
+
+    if (json.contains("difficulty") && !json["difficulty"].isDouble())
+        report(Severity::Error, ".difficulty", "Difficulty must be a number");
+    if (json.contains("discrimination"))
+    {
+        if (!json["discrimination"].isDouble())
+            report(Severity::Error, ".discrimination", "Discrimination must be a number");
+        else if (!(json["discrimination"].toDouble() > 0.0))
+            report(Severity::Error, ".discrimination", "Discrimination must be positive");
+    }
+
+    for (std::size_t i = first; i < problems.size(); ++i)
+        problems[i].question = text;
+}
+
+fq::Validator::Report fq::Validator::validate(const QByteArray &contents, unsigned threads)
+{
+    Report report;
+    TopLevel topLevel;
+    if (scanTopLevel(contents, topLevel, report.problems))
+    {
+        if (topLevel.type.isUndefined())
+            report.problems.push_back({Severity::Error, 0, "type", {}, "Repository has no 'type'", 0});
+        else if (!topLevel.type.isString())
+            report.problems.push_back({Severity::Error, 0, "type", {}, "Repository type must be a string", 0});
+        else
+        {
+            std::string type = topLevel.type.toString().toStdString();
+            if (type == "sharded")
+                report.problems.push_back({Severity::Error, 0, "type", {}, "Sharded manifests have no questions; validate their shard files instead", 0});
+            else if (type != "random" && type != "random_non_repeating" && type != "intelligent" && type != "adaptive")
+                report.problems.push_back({Severity::Error, 0, "type", {}, "Unknown repository type '" + type + "'", 0});
+        }
+        if (!topLevel.hasQuestions)
+            report.problems.push_back({Severity::Error, 0, "questions", {}, "Repository has no 'questions'", 0});
+    }
+
+    const auto &elements = topLevel.elements;
+    report.questions = elements.size();
+    std::vector<std::string> texts(elements.size());
+    std::size_t chunks = (elements.size() + chunkSize - 1) / chunkSize;
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(chunks, 1)));
+    std::vector<std::vector<Problem>> found(threads);
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&, i]()
+                             {
+            try
+            {
+                for (std::size_t chunk = next++; chunk < chunks; chunk = next++)
+                {
+                    std::size_t end = std::min(elements.size(), (chunk + 1) * chunkSize);
+                    for (std::size_t e = chunk * chunkSize; e < end; ++e)
+                    {
+                        QByteArray element = QByteArray::fromRawData(contents.constData() + elements[e].begin, static_cast<qsizetype>(elements[e].end - elements[e].begin));
+                        checkQuestion(element, elements[e].begin, e, found[i], texts[e]);
+                    }
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+                next = chunks;
+            } });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    if (error)
+        std::rethrow_exception(error);
+    for (auto &part : found)
+        report.problems.insert(report.problems.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+
+    // Questions are identified by their text, so only one of several questions with the same text can be edited.
+    std::unordered_map<std::string_view, std::size_t> firstWithText;
+    firstWithText.reserve(texts.size());
+    for (std::size_t e = 0; e < texts.size(); ++e)
+    {
+        if (texts[e].empty())
+            continue;
+        auto inserted = firstWithText.emplace(texts[e], e);
+        if (!inserted.second)
+            report.problems.push_back({Severity::Warning, 0, "questions[" + std::to_string(e) + "].text", texts[e], "Same text as questions[" + std::to_string(inserted.first->second) + "]", elements[e].begin});
+    }
+
+    // Lines are counted once for all problems, in the order of their offsets.
+    std::stable_sort(report.problems.begin(), report.problems.end(), [](const Problem &a, const Problem &b)
+                     { return a.offset < b.offset; });
+    const char *data = contents.constData();
+    std::size_t line = 1, counted = 0;
+    for (auto &problem : report.problems)
+    {
+        std::size_t offset = std::min(problem.offset, static_cast<std::size_t>(contents.size()));
+        line += static_cast<std::size_t>(std::count(data + counted, data + offset, '\n'));
+        counted = offset;
+        problem.line = line;
+    }
+    return report;
+}
+
+fq::Validator::Report fq::Validator::validateFile(const std::string &path, unsigned threads)
+{
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+        throw std::runtime_error("Failed to open file: " + path);
+    // The file is only read, so mapping it avoids copying it into a buffer first.
+    if (uchar *data = file.size() ? file.map(0, file.size()) : nullptr)
+        return validate(QByteArray::fromRawData(reinterpret_cast<const char *>(data), file.size()), threads);
+    return validate(file.readAll(), threads);
+}
+
+std::string fq::Validator::describe(const Problem &problem)
+{
+    std::string description = problem.severity == Severity::Error ? "error: " : "warning: ";
+    if (!problem.location.empty())
+        description += problem.location + ": ";
+    return description + problem.message;
+}
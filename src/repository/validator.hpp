@@ -0,0 +1,109 @@
+/// @file validator.hpp
+/// @brief Contains the definition of a validator reporting every problem of a repository file.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFile>
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Checks repository files and reports all of their problems at once.
+    /// @details Loading a repository stops at its first invalid question, and some mistakes, such as a single choice
+    /// question with several correct answers, load without complaint. The validator instead reports every problem
+    /// with the line and the JSON path (e.g. questions[12].answers[1].is_correct) where it was found. Questions are
+    /// never built: one sequential scan finds where each element of the questions array starts and ends, and the
+    /// elements are then parsed and checked on several threads.
+    class Validator
+    {
+    public:
+        /// @brief How serious a problem is.
+        enum class Severity
+        {
+            /// @brief The repository cannot be loaded, or a question cannot be answered correctly.
+            Error,
+
+            /// @brief The repository loads, but probably not as intended.
+            Warning,
+        };
+
+        /// @brief A problem found in a repository file.
+        struct Problem
+        {
+            /// @brief How serious the problem is.
+            Severity severity = Severity::Error;
+
+            /// @brief The 1-based line of the problem, or of the question it was found in.
+            std::size_t line = 0;
+
+            /// @brief The JSON path of the problem, empty for the whole file.
+            std::string location;
+
+            /// @brief The text of the question the problem was found in, if it has one.
+            std::string question;
+
+            /// @brief Description of the problem.
+            std::string message;
+
+            /// @brief The byte offset of the problem, used to compute its line.
+            std::size_t offset = 0;
+        };
+
+        /// @brief The result of a validation.
+        struct Report
+        {
+            /// @brief The problems found, ordered by their position in the file.
+            std::vector<Problem> problems;
+
+            /// @brief The number of questions checked.
+            std::size_t questions = 0;
+
+            /// @brief Returns the number of problems of the specified severity.
+            std::size_t count(Severity severity) const;
+        };
+
+    private:
+        /// @brief Number of questions a thread checks before taking more.
+        static constexpr std::size_t chunkSize = 256;
+
+        /// @brief Checks one element of the questions array.
+        /// @param element The JSON text of the element.
+        /// @param offset The byte offset of the element in the file.
+        /// @param index The index of the element in the questions array.
+        /// @param problems The problems found are appended to it.
+        /// @param text Receives the text of the question, if it has one.
+        static void checkQuestion(const QByteArray &element, std::size_t offset, std::size_t index, std::vector<Problem> &problems, std::string &text);
+
+    public:
+        /// @brief Validates the contents of a repository file.
+        /// @param contents The JSON text of the file.
+        /// @param threads The number of threads, or 0 to use one per core.
+        /// @return The problems found.
+        static Report validate(const QByteArray &contents, unsigned threads = 0);
+
+        /// @brief Validates a repository file.
+        /// @param path The path to the file.
+        /// @param threads The number of threads, or 0 to use one per core.
+        /// @return The problems found.
+        /// @throws std::runtime_error if the file cannot be opened.
+        static Report validateFile(const std::string &path, unsigned threads = 0);
+
+        /// @brief Formats a problem as "severity: location: message", as printed by the command-line tool.
+        /// @param problem The problem.
+        static std::string describe(const Problem &problem);
+    };
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "quizserver.hpp"
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("FunQuizzServer");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Serves quiz sessions from one repository to many clients at once. Every client gets its own session.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("repository", "The repository JSON file.");
+    QCommandLineOption addressOption({"a", "address"}, "The address to listen on.", "address", "127.0.0.1");
+    QCommandLineOption portOption({"p", "port"}, "The port to listen on.", "port", "5757");
+    QCommandLineOption filterOption({"f", "filter"}, "Tag expression selecting the questions which are served.", "expression");
+    parser.addOptions({addressOption, portOption, filterOption});
+    parser.process(app);
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1)
+        parser.showHelp(1);
+
+    try
+    {
+        QHostAddress address;
+        if (!address.setAddress(parser.value(addressOption)))
+            throw std::invalid_argument("Invalid address: " + parser.value(addressOption).toStdString());
+        bool ok = false;
+        quint16 port = parser.value(portOption).toUShort(&ok);
+        if (!ok)
+            throw std::invalid_argument("Invalid port: " + parser.value(portOption).toStdString());
+
+        std::unique_ptr<fq::Repository> repository(fq::Repository::createRepository(positional[0].toStdString()));
+        repository->setAutoSave(false);
+        fq::QuizServer server(std::move(repository), parser.value(filterOption).toStdString());
+        server.listen(address, port);
+        std::cout << "Serving " << server.getRepository().getQuestionCount() << " questions on "
+                  << address.toString().toStdString() << ":" << server.getPort() << "\n";
+        return app.exec();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,154 @@
+#include "quizserver.hpp"
+
+fq::QuizServer::QuizServer(std::unique_ptr<Repository> repository_, const std::string &filter)
+    : repository(std::move(repository_)), seeds(std::random_device{}()), defaultFilter(filter), requests(0)
+{
+    try
+    {
+        repository->createSession(0)->setFilter(defaultFilter);
+    }
+    catch (const std::logic_error &e)
+    {
+        throw std::invalid_argument(e.what());
+    }
+    QObject::connect(&server, &QTcpServer::newConnection, &server, [this]()
+                     { acceptClients(); });
+}
+
+fq::QuizServer::~QuizServer()
+{
+    server.close();
+    // The sockets are deleted together with the server; they must not reach the clients, which are destroyed first.
+    for (auto &entry : clients)
+        QObject::disconnect(entry.first, nullptr, nullptr, nullptr);
+}
+
+void fq::QuizServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (!server.listen(address, port))
+        throw std::runtime_error("Failed to listen on " + address.toString().toStdString() + ":" + std::to_string(port) + ": " + server.errorString().toStdString());
+}
+
+void fq::QuizServer::acceptClients()
+{
+    while (QTcpSocket *socket = server.nextPendingConnection())
+    {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        Client &client = clients[socket];
+        client.session = repository->createSession(seeds());
+        client.session->setFilter(defaultFilter);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]()
+                         { readRequests(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, [this, socket]()
+                         {
+                             clients.erase(socket);
+                             socket->deleteLater(); });
+    }
+}
+
+void fq::QuizServer::readRequests(QTcpSocket *socket)
+{
+    auto it = clients.find(socket);
+    if (it == clients.end())
+        return;
+    Client &client = it->second;
+    client.pending.append(socket->readAll());
+    QByteArray responses;
+    qsizetype start = 0;
+    for (qsizetype end = client.pending.indexOf('\n'); end >= 0; end = client.pending.indexOf('\n', start))
+    {
+        QByteArray request = client.pending.mid(start, end - start).trimmed();
+        start = end + 1;
+        if (request.isEmpty())
+            continue;
+        responses.append(QJsonDocument(serve(client, request)).toJson(QJsonDocument::Compact));
+        responses.append('\n');
+        ++requests;
+    }
+    client.pending.remove(0, start);
+    if (!responses.isEmpty())
+        socket->write(responses);
+    if (client.pending.size() > maxRequestLength)
+        socket->disconnectFromHost();
+}
+
+QJsonObject fq::QuizServer::serve(Client &client, const QByteArray &request)
+{
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(request, &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject())
+        return QJsonObject{{"error", "Request is not a JSON object"}};
+    QJsonObject object = document.object();
+    QString op = object["op"].toString();
+    try
+    {
+        if (op == "next")
+            return next(client);
+        else if (op == "answer")
+            return answer(client, object);
+        else if (op == "filter")
+            return filter(client, object);
+        return QJsonObject{{"error", "Unknown request: " + op}};
+    }
+    catch (const std::exception &e)
+    {
+        return QJsonObject{{"error", QString::fromStdString(e.what())}};
+    }
+}
+
+QJsonObject fq::QuizServer::next(Client &client)
+{
+    client.question = client.session->next();
+    client.answerOrder = client.session->getAnswerOrder(client.question);
+    const auto &answers = client.question->getAnswers();
+    QJsonArray texts;
+    for (std::size_t index : client.answerOrder)
+        texts.append(QString::fromStdString(answers[index].text));
+    QJsonObject response;
+    response["question"] = QString::fromStdString(client.question->getQuestion());
+    response["type"] = QString::fromStdString(client.question->getType());
+    response["answers"] = texts;
+    return response;
+}
+
+QJsonObject fq::QuizServer::answer(Client &client, const QJsonObject &request)
+{
+    if (!client.question)
+        throw std::invalid_argument("No question to answer");
+    if (!request["selected"].isArray())
+        throw std::invalid_argument("Answer request must contain a 'selected' array");
+    const auto &answers = client.question->getAnswers();
+    std::vector<Answer> selected;
+    std::vector<bool> chosen(answers.size(), false);
+    std::vector<std::uint32_t> chosenAnswers;
+    for (const QJsonValue &value : request["selected"].toArray())
+    {
+        int index = value.toInt(-1);
+        if (index < 0 || static_cast<std::size_t>(index) >= client.answerOrder.size() || chosen[index])
+            throw std::invalid_argument("Invalid answer index");
+        chosen[index] = true;
+        selected.push_back(answers[client.answerOrder[index]]);
+        chosenAnswers.push_back(static_cast<std::uint32_t>(client.answerOrder[index]));
+    }
+    double score = client.question->getScore(selected);
+    QJsonArray correct;
+    for (std::size_t i = 0; i < client.answerOrder.size(); ++i)
+    {
+        if (answers[client.answerOrder[i]].isCorrect)
+            correct.append(static_cast<int>(i));
+    }
+    QJsonObject response;
+    response["score"] = score;
+    response["correct"] = correct;
+    response["explanation"] = QString::fromStdString(client.question->getExplanation());
+    client.session->answer(client.question, score, chosenAnswers);
+    client.question = nullptr;
+    return response;
+}
+
+QJsonObject fq::QuizServer::filter(Client &client, const QJsonObject &request)
+{
+    client.session->setFilter(request["expression"].toString().toStdString());
+    client.question = nullptr;
+    return QJsonObject{{"filtered", static_cast<qint64>(client.session->getFilteredCount())}};
+}
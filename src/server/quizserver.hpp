@@ -0,0 +1,134 @@
+/// @file quizserver.hpp
+/// @brief Contains the definition of a server letting many clients take a quiz from one repository at once.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "repository.hpp"
+
+/// @namespace fq
+/// @brief Contains classes and structures related to quiz questions and answers.
+///
+/// The fq namespace encapsulates all types and logic for representing questions,
+/// answers, and scoring mechanisms in a quiz application. It provides support for
+/// single-choice, multiple-choice, and negative scoring questions, as well as
+/// skippable variants.
+namespace fq
+{
+
+    /// @brief Serves quiz sessions from one repository to many clients over TCP.
+    /// @details Every connection gets its own Session of the type of the repository, drawing from the shared bank,
+    /// so clients never affect each other and the questions are held in memory once. The server is event driven:
+    /// it runs entirely on the thread of its event loop and never blocks on a client.
+    ///
+    /// Clients send requests as JSON objects, one per line, and receive one response line per request, in order.
+    /// Requests may be pipelined. The supported requests are:
+    /// - `{"op":"next"}` draws a question and returns `{"question":text,"type":type,"answers":[texts]}`, with the
+    ///   answers in the order they should be presented.
+    /// - `{"op":"answer","selected":[indices]}` scores the last drawn question, with the indices referring to the
+    ///   presented order, and returns `{"score":score,"correct":[indices],"explanation":text}`.
+    /// - `{"op":"filter","expression":expression}` restricts the drawn questions and returns `{"filtered":count}`.
+    ///
+    /// A request which cannot be served returns `{"error":message}`; the session is left unchanged.
+    class QuizServer
+    {
+        /// @brief The state of one connected client.
+        struct Client
+        {
+            /// @brief The session of the client.
+            std::unique_ptr<Session> session;
+
+            /// @brief Received bytes not forming a complete request yet.
+            QByteArray pending;
+
+            /// @brief The last drawn question, or nullptr if it was answered or none was drawn yet.
+            fq::Question *question = nullptr;
+
+            /// @brief The order the answers of the last drawn question were presented in.
+            std::vector<std::size_t> answerOrder;
+        };
+
+        /// @brief Maximum length of a request. Clients sending longer lines are disconnected.
+        static constexpr int maxRequestLength = 64 * 1024;
+
+        /// @brief The repository the questions are served from.
+        std::unique_ptr<Repository> repository;
+
+        /// @brief The listening socket.
+        QTcpServer server;
+
+        /// @brief The connected clients, keyed by their sockets.
+        std::unordered_map<QTcpSocket *, Client> clients;
+
+        /// @brief Generates the seeds of the sessions of new clients.
+        std::mt19937 seeds;
+
+        /// @brief Tag expression applied to the session of every new client.
+        std::string defaultFilter;
+
+        /// @brief Total number of requests served.
+        std::size_t requests;
+
+        /// @brief Creates the session of a newly connected client.
+        void acceptClients();
+
+        /// @brief Serves all complete requests received from a client.
+        /// @param socket The socket of the client.
+        void readRequests(QTcpSocket *socket);
+
+        /// @brief Serves a single request.
+        /// @param client The client sending the request.
+        /// @param request The request line.
+        /// @return The response.
+        QJsonObject serve(Client &client, const QByteArray &request);
+
+        /// @brief Draws the next question for a client.
+        QJsonObject next(Client &client);
+
+        /// @brief Scores the answer of a client to its last drawn question.
+        QJsonObject answer(Client &client, const QJsonObject &request);
+
+        /// @brief Changes the filter of the session of a client.
+        QJsonObject filter(Client &client, const QJsonObject &request);
+
+    public:
+        /// @brief Constructs a server for the specified repository. It does not listen until listen is called.
+        /// @param repository The repository the questions are served from. Must be backed by a single file.
+        /// @param filter Tag expression applied to the session of every new client. Empty to serve all questions.
+        /// @throws std::invalid_argument if the repository is composed of other repositories or the filter is malformed.
+        QuizServer(std::unique_ptr<Repository> repository, const std::string &filter = "");
+
+        /// @brief Stops the server and disconnects all clients.
+        ~QuizServer();
+
+        QuizServer(const QuizServer &) = delete;
+        QuizServer &operator=(const QuizServer &) = delete;
+
+        /// @brief Starts accepting clients.
+        /// @param address The address to listen on.
+        /// @param port The port to listen on. 0 chooses a free port.
+        /// @throws std::runtime_error if the server cannot listen on the address and port.
+        void listen(const QHostAddress &address, quint16 port);
+
+        /// @brief Returns the port the server is listening on.
+        quint16 getPort() const { return server.serverPort(); }
+
+        /// @brief Returns the repository the questions are served from.
+        const Repository &getRepository() const { return *repository; }
+
+        /// @brief Returns the number of connected clients.
+        std::size_t getClientCount() const { return clients.size(); }
+
+        /// @brief Returns the total number of requests served.
+        std::size_t getRequestCount() const { return requests; }
+    };
+}
@@ -27,7 +27,8 @@ void AddQuestion::save()
             throw std::invalid_argument("Question text cannot be empty");
         if (type.empty())
             throw std::invalid_argument("Question type cannot be empty");
-        if (questions.find(questionText) != questions.end())
+        const fq::Question *existing = questions.find(questionText);
+        if (existing && existing != original)
             throw std::invalid_argument("Question with this text already exists");
 
         if (type == "Single Choice")
@@ -39,11 +40,41 @@ void AddQuestion::save()
         else
             throw std::invalid_argument("Unknown question type: " + type);
 
-        questions[questionText] = fq::Question::fromParameters(
-            questionText,
-            questionAnswers,
-            ui->explanation->toPlainText().toStdString(),
-            type);
+        std::vector<std::string> tags;
+        for (const QString &tag : ui->tags->text().split(',', Qt::SkipEmptyParts))
+            tags.push_back(tag.trimmed().toStdString());
+
+        std::vector<std::string> variables;
+        for (const QString &variable : ui->variables->text().split(';', Qt::SkipEmptyParts))
+        {
+            if (!variable.trimmed().isEmpty())
+                variables.push_back(variable.trimmed().toStdString());
+        }
+
+        fq::Question *question;
+        if (variables.empty())
+            question = fq::Question::fromParameters(
+                questionText,
+                questionAnswers,
+                ui->explanation->toPlainText().toStdString(),
+                type,
+                tags);
+        else
+        {
+            std::string explanation = ui->explanation->toPlainText().toStdString();
+            question = new fq::TemplateQuestion(questionText, questionAnswers, explanation.empty() ? "No explanation provided" : explanation, type, variables);
+            question->setTags(tags);
+        }
+        if (original)
+        {
+            question->setDifficulty(original->getDifficulty());
+            question->setDiscrimination(original->getDiscrimination());
+            emit questionEdited(original, question);
+            close();
+            return;
+        }
+        emit questionAdded(question);
+        changed.add(question);
         cancel();
     }
     catch (const std::invalid_argument &e)
@@ -61,12 +92,43 @@ void AddQuestion::cancel()
     ui->question->clear();
     ui->answers->clear();
     ui->explanation->clear();
+    ui->tags->clear();
+    ui->variables->clear();
     ui->type->setCurrentIndex(0);
     ui->answer->clear();
     ui->correct->setChecked(false);
     ui->removeAnswers->setEnabled(false);
 }
 
+void AddQuestion::updateSimilarQuestions()
+{
+    std::string questionText = ui->question->text().toStdString();
+    const std::size_t limit = 3;
+    std::vector<fq::DuplicateIndex::Similar> similar;
+    if (!questionText.empty())
+    {
+        for (const auto &it : duplicates.find(questionText, duplicates.size()))
+        {
+            if (it.question != original && questions.find(it.question->getQuestion()) == it.question)
+                similar.push_back(it);
+        }
+        for (const auto &it : changed.find(questionText, changed.size()))
+        {
+            if (it.question != original && questions.find(it.question->getQuestion()) == it.question)
+                similar.push_back(it);
+        }
+        std::stable_sort(similar.begin(), similar.end(), [](const fq::DuplicateIndex::Similar &a, const fq::DuplicateIndex::Similar &b)
+                         { return a.distance < b.distance; });
+        if (similar.size() > limit)
+            similar.resize(limit);
+    }
+    QStringList lines;
+    for (const auto &it : similar)
+        lines.append(QString("%1% similar: %2").arg(qRound(fq::DuplicateIndex::similarity(it.distance) * 100)).arg(QString::fromStdString(it.question->getQuestion())));
+    ui->similarQuestions->setText(lines.join('\n'));
+    ui->similarQuestions->setVisible(!similar.empty());
+}
+
 void AddQuestion::addAnswer()
 {
     QString answerText = ui->answer->text();
@@ -94,8 +156,8 @@ void AddQuestion::removeAnswers()
     ui->removeAnswers->setEnabled(false);
 }
 
-AddQuestion::AddQuestion(std::unordered_map<std::string, fq::Question *> &questions, QWidget *parent)
-    : QDialog(parent), ui(new Ui::AddQuestion), questions(questions)
+AddQuestion::AddQuestion(const fq::EditLog &questions, QWidget *parent, const fq::Question *original)
+    : QDialog(parent), ui(new Ui::AddQuestion), questions(questions), original(original), duplicates(questions.getBase()->getDuplicateIndex())
 {
     ui->setupUi(this);
     setWindowFlags(Qt::Window | Qt::WindowTitleHint | Qt::CustomizeWindowHint);
@@ -105,6 +167,43 @@ AddQuestion::AddQuestion(std::unordered_map<std::string, fq::Question *> &questi
     connect(ui->removeAnswers, &QPushButton::clicked, this, &AddQuestion::removeAnswers);
     connect(ui->answers, &QListWidget::itemSelectionChanged, [this]()
             { ui->removeAnswers->setEnabled(!ui->answers->selectedItems().isEmpty()); });
+    connect(ui->question, &QLineEdit::textChanged, this, &AddQuestion::updateSimilarQuestions);
+
+    for (const auto &change : questions.net())
+    {
+        if (change.after)
+            changed.add(change.after.get());
+    }
+    if (original)
+    {
+        setWindowTitle("Edit Question");
+        ui->cancel->setEnabled(false);
+        ui->question->setText(QString::fromStdString(original->getQuestion()));
+        for (const auto &answer : original->getAnswers())
+        {
+            auto *item = new QListWidgetItem(QString::fromStdString(answer.text.str()));
+            QFont font = ui->correct->font();
+            font.setBold(answer.isCorrect);
+            item->setFont(font);
+            ui->answers->addItem(item);
+        }
+        ui->explanation->setPlainText(QString::fromStdString(original->getExplanation()));
+        QStringList tags;
+        for (const auto &tag : original->getTags())
+            tags.append(QString::fromStdString(tag));
+        ui->tags->setText(tags.join(", "));
+        std::string type = original->getType();
+        if (const auto *templated = dynamic_cast<const fq::TemplateQuestion *>(original))
+        {
+            type = templated->getScoringType();
+            QStringList variables;
+            for (const auto &variable : templated->getVariables())
+                variables.append(QString::fromStdString(variable));
+            ui->variables->setText(variables.join("; "));
+        }
+        ui->type->setCurrentIndex(type == "multiple" ? 1 : type == "negative_multiple" ? 2 : 0);
+    }
+    updateSimilarQuestions();
 }
 
 AddQuestion::~AddQuestion()
@@ -8,8 +8,10 @@
 #include <QListWidget>
 #include <QFont>
 #include <QMessageBox>
-#include <unordered_map>
+#include <algorithm>
 #include "question.hpp"
+#include "duplicateindex.hpp"
+#include "editlog.hpp"
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -18,19 +20,39 @@ namespace Ui
 }
 QT_END_NAMESPACE
 
-/// @brief Dialog that allows users to add a new question to the quiz.
+/// @brief Dialog that allows users to add a new question to the quiz, or to edit an existing one.
 
 class AddQuestion : public QDialog
 {
     Q_OBJECT
 
-    /// @brief A reference to the collection of questions in the repository.
-    /// @details This is used to store the questions added by the user.
-    std::unordered_map<std::string, fq::Question *> &questions;
+    /// @brief A reference to the questions being edited.
+    /// @details This is used to reject questions whose text is already taken. Saved questions are handed over through
+    /// the questionAdded and questionEdited signals, whose receivers record them in the log.
+    const fq::EditLog &questions;
+
+    /// @brief The question being edited, or nullptr if a new question is being added.
+    const fq::Question *original;
+
+    /// @brief Index of the questions of the bank being edited, used to flag near-duplicates of the question being
+    /// written.
+    /// @details Owned by the bank and built once for it, so opening the dialog does not index the repository again.
+    const fq::DuplicateIndex &duplicates;
+
+    /// @brief Index of the questions added or edited since the bank was loaded, including those saved in this dialog.
+    fq::DuplicateIndex changed;
+
+    /// @brief Shows the questions in the repository similar to the question being written.
+    /// @details This function is called whenever the question text changes. It looks the question up in
+    /// the near-duplicate indexes, which only compare it with the few questions sharing a part of its signature, so it
+    /// stays responsive for large repositories. Questions of the bank which were removed or replaced since are skipped.
+    void updateSimilarQuestions();
 
     /// @brief Validates the input fields for adding a question and saves the question if valid.
     /// @details This function checks if the question text, answers, and type are provided correctly.
-    /// If valid, it creates a new question object and adds it to the questions collection.
+    /// If valid, it creates a new question object and emits questionAdded with it. When editing, the original question
+    /// is left unchanged: the new question keeps its difficulty and discrimination, questionEdited is emitted instead
+    /// and the dialog is closed.
     /// If any field is invalid, it shows a warning message.
     void save();
 
@@ -51,13 +73,24 @@ class AddQuestion : public QDialog
 
 public:
     /// @brief Constructs an AddQuestion dialog with the specified parent widget and a reference to the questions collection.
-    /// @param questions A reference to the collection of questions where the new question will be added.
+    /// @param questions A reference to the questions being edited, whose texts the new questions must not repeat.
     /// @param parent The parent widget for the dialog. Defaults to nullptr.
-    explicit AddQuestion(std::unordered_map<std::string, fq::Question *> &questions, QWidget *parent = nullptr);
+    /// @param original The question to edit, whose contents fill the dialog, or nullptr to add new questions.
+    explicit AddQuestion(const fq::EditLog &questions, QWidget *parent = nullptr, const fq::Question *original = nullptr);
 
     /// @brief Destroys the AddQuestion dialog.
     ~AddQuestion();
 
+signals:
+    /// @brief Emitted when a question was saved.
+    /// @param question The new question. The receiver takes ownership of it.
+    void questionAdded(fq::Question *question);
+
+    /// @brief Emitted when an edited question was saved.
+    /// @param original The question which was edited. It is not modified.
+    /// @param replacement The edited question. The receiver takes ownership of it.
+    void questionEdited(const fq::Question *original, fq::Question *replacement);
+
 private:
     /// @brief Pointer to the UI elements of the AddQuestion dialog.
     Ui::AddQuestion *ui;
@@ -5,37 +5,36 @@ void MainWindow::okClicked(bool checked)
 {
     if (!isAnswered)
     {
+        const auto &answers = currentQuestion->getAnswers();
         std::vector<fq::Answer> chosenAnswers;
+        std::vector<std::uint32_t> chosenIndices;
         for (int i = 0; i < ui->answers->count(); ++i)
         {
             auto answerWidget = qobject_cast<QAbstractButton *>(ui->answers->itemAt(i)->widget());
             if (answerWidget && answerWidget->isChecked())
             {
-                chosenAnswers.push_back(currentAnswers[i]);
+                chosenAnswers.push_back(answers[answerOrder[i]]);
+                chosenIndices.push_back(static_cast<std::uint32_t>(answerOrder[i]));
             }
         }
         try
         {
             auto score = currentQuestion->getScore(chosenAnswers);
-            repository->returnQuestion(currentQuestion, score);
+            repository->recordResponse(currentQuestion, questionTimer.elapsed() / 1000.0, score);
+            repository->returnQuestion(currentQuestion, score, chosenIndices);
             isAnswered = true;
             totalQuestions++;
             totalScore += score;
-            ui->score->setText(QString::number(totalScore) + "/" + QString::number(totalQuestions));
-            auto percentage = static_cast<int>(totalScore * 100 / static_cast<double>(totalQuestions));
-            ui->scoreBar->setValue(percentage);
-            QColor barColor = QColor(255 - 255 * percentage / 100, 255 * percentage / 100, 0);
-            QString style = QString("QProgressBar::chunk {background-color: %1;width: 20px;}").arg(barColor.name());
-            ui->scoreBar->setStyleSheet(style);
+            updateScore();
             ui->ok->setText("Next");
-            ui->explanation->setText(QString::fromStdString(currentQuestion->getExplanation()));
+            renderer->display(ui->explanation, QString::fromStdString(currentQuestion->getExplanation()));
             for (int i = 0; i < ui->answers->count(); ++i)
             {
                 auto answerWidget = qobject_cast<QAbstractButton *>(ui->answers->itemAt(i)->widget());
                 answerWidget->setEnabled(false);
                 if (answerWidget)
                 {
-                    if (currentAnswers[i].isCorrect)
+                    if (answers[answerOrder[i]].isCorrect)
                     {
                         answerWidget->setStyleSheet("QAbstractButton { color: green; }");
                     }
@@ -65,37 +64,46 @@ void MainWindow::loadQuestion()
         QMessageBox::warning(this, "Error", "No repository loaded. Please open or create a repository first.");
         return;
     }
-    if (repository->getQuestionCount())
+    if (repository->getFilteredCount())
     {
         try
         {
             currentQuestion = repository->getQuestion();
-            ui->question->setText(currentQuestion->getQuestion().c_str());
-            currentAnswers = currentQuestion->getAnswers();
+            renderer->display(ui->question, QString::fromStdString(currentQuestion->getQuestion()));
+            const auto &answers = currentQuestion->getAnswers();
+            answerOrder = repository->getAnswerOrder(currentQuestion);
             removeAnswers();
-            for (std::size_t i = 0; i < currentAnswers.size(); ++i)
+            for (std::size_t i = 0; i < answerOrder.size(); ++i)
             {
-                const auto &answer = currentAnswers[i];
+                const auto &answer = answers[answerOrder[i]];
+                QString text = QString::fromStdString(answer.text);
+                QStringList images = MediaCache::references(text);
+                QAbstractButton *answerWidget;
                 if (currentQuestion->isSingleChoice())
                 {
-                    auto answerWidget = new QRadioButton(QString::fromStdString(answer.text), this);
+                    answerWidget = new QRadioButton(MediaCache::withoutImages(text), this);
                     connect(answerWidget, &QRadioButton::toggled, this, &MainWindow::answerToggled);
-                    answerWidget->setFont(ui->question->font());
-                    ui->answers->addWidget(answerWidget);
                 }
                 else
                 {
-                    auto answerWidget = new QCheckBox(QString::fromStdString(answer.text), this);
+                    answerWidget = new QCheckBox(MediaCache::withoutImages(text), this);
                     connect(answerWidget, &QCheckBox::toggled, this, &MainWindow::answerToggled);
-                    answerWidget->setFont(ui->question->font());
-                    ui->answers->addWidget(answerWidget);
+                }
+                answerWidget->setFont(ui->question->font());
+                ui->answers->addWidget(answerWidget);
+                if (!images.isEmpty())
+                {
+                    answerWidget->setProperty("image", images.first());
+                    showAnswerImage(answerWidget);
                 }
             }
             ui->ok->setText("Skip");
             ui->ok->setEnabled(true);
-            ui->explanation->setText("");
+            renderer->display(ui->explanation, "");
             isAnswered = false;
             selectedAnswers = 0;
+            questionTimer.start();
+            prefetchMedia();
             return;
         }
         catch (const std::invalid_argument &e)
@@ -113,14 +121,33 @@ void MainWindow::loadQuestion()
     }
     ui->score->setText("0/0");
     ui->scoreBar->setValue(0);
-    ui->explanation->setText("");
-    ui->totalQuestions->setText("Total questions in repository: " + QString::number(repository->getQuestionCount()));
+    renderer->display(ui->explanation, "");
+    updateQuestionCount();
     ui->ok->setEnabled(false);
     ui->ok->setText("");
-    ui->question->setText("No questions available");
+    renderer->display(ui->question, "No questions available");
     removeAnswers();
 }
 
+void MainWindow::updateScore()
+{
+    if (!totalQuestions)
+    {
+        ui->score->setText("0/0");
+        ui->scoreBar->setValue(0);
+        return;
+    }
+    ui->score->setText(QString::number(totalScore) + "/" + QString::number(totalQuestions));
+    if (auto *adaptive = dynamic_cast<fq::AdaptiveRepository *>(repository))
+        ui->score->setText(ui->score->text() + "    Ability: " + QString::number(adaptive->getAbility(), 'f', 2) +
+                           " \u00B1 " + QString::number(adaptive->getAbilityError(), 'f', 2));
+    auto percentage = std::max(0, std::min(100, static_cast<int>(totalScore * 100 / static_cast<double>(totalQuestions))));
+    ui->scoreBar->setValue(percentage);
+    QColor barColor = QColor(255 - 255 * percentage / 100, 255 * percentage / 100, 0);
+    QString style = QString("QProgressBar::chunk {background-color: %1;width: 20px;}").arg(barColor.name());
+    ui->scoreBar->setStyleSheet(style);
+}
+
 void MainWindow::removeAnswers()
 {
     QLayoutItem *answer;
@@ -131,6 +158,44 @@ void MainWindow::removeAnswers()
     }
 }
 
+void MainWindow::showAnswerImage(QAbstractButton *answerWidget)
+{
+    QString reference = answerWidget->property("image").toString();
+    QImage image = media->find(reference);
+    if (image.isNull())
+    {
+        media->request(reference);
+        return;
+    }
+    QSize size = image.size();
+    if (size.width() > 320 || size.height() > 240)
+        size.scale(320, 240, Qt::KeepAspectRatio);
+    answerWidget->setIcon(QIcon(QPixmap::fromImage(image)));
+    answerWidget->setIconSize(size);
+}
+
+void MainWindow::mediaLoaded(const QString &reference)
+{
+    for (int i = 0; i < ui->answers->count(); ++i)
+    {
+        auto answerWidget = qobject_cast<QAbstractButton *>(ui->answers->itemAt(i)->widget());
+        // A failed decode leaves the image out of the cache; it is not requested again until the question is shown again.
+        if (answerWidget && answerWidget->property("image").toString() == reference && !media->find(reference).isNull())
+            showAnswerImage(answerWidget);
+    }
+}
+
+void MainWindow::prefetchMedia()
+{
+    media->prefetch(QString::fromStdString(currentQuestion->getExplanation()));
+    const fq::Question *next = repository->peekQuestion();
+    if (next == nullptr)
+        return;
+    media->prefetch(QString::fromStdString(next->getQuestion()));
+    for (const auto &answer : next->getAnswers())
+        media->prefetch(QString::fromStdString(answer.text));
+}
+
 void MainWindow::answerToggled(bool checked)
 {
     if (checked)
@@ -156,6 +221,71 @@ void MainWindow::repositoryAction(QAction *action)
                 loadRepository(fileName.toStdString());
             }
         }
+        else if (action == ui->openRepositories)
+        {
+            QStringList fileNames = QFileDialog::getOpenFileNames(this, "Open Repositories", "", "JSON Files (*.json);;All Files (*)");
+            if (!fileNames.isEmpty())
+            {
+                QString names;
+                QStringList defaultWeights;
+                for (const QString &fileName : fileNames)
+                {
+                    names += QFileInfo(fileName).fileName() + "\n";
+                    defaultWeights << "1";
+                }
+                bool ok = false;
+                QString text = QInputDialog::getText(this, "Repository weights",
+                                                     "Weights of the repositories, separated by commas:\n" + names +
+                                                         "\nWith equal weights every question is equally likely.",
+                                                     QLineEdit::Normal, defaultWeights.join(", "), &ok);
+                if (ok)
+                {
+                    std::vector<double> weights;
+                    for (const QString &weight : text.split(',', Qt::SkipEmptyParts))
+                    {
+                        bool valid = false;
+                        weights.push_back(weight.trimmed().toDouble(&valid));
+                        if (!valid)
+                            throw std::invalid_argument("Invalid weight: " + weight.trimmed().toStdString());
+                    }
+                    std::vector<std::string> paths;
+                    for (const QString &fileName : fileNames)
+                        paths.push_back(fileName.toStdString());
+                    loadRepositories(paths, weights);
+                }
+            }
+        }
+        else if (action == ui->newSession)
+        {
+            if (repository != nullptr)
+            {
+                repository->restartSession();
+                totalScore = 0.0;
+                totalQuestions = 0;
+                updateScore();
+                renderer->display(ui->explanation, "");
+                loadQuestion();
+            }
+        }
+        else if (action == ui->exportRepository)
+        {
+            if (repository != nullptr)
+            {
+                QString fileName = QFileDialog::getSaveFileName(this, "Export Repository", "",
+                                                                "Printable HTML exam (*.html);;LaTeX exam (*.tex);;Repository JSON (*.json);;CSV (*.csv)");
+                if (!fileName.isEmpty())
+                {
+                    fq::Exporter::Options options;
+                    options.type = repository->getType();
+                    options.title = QFileInfo(fileName).completeBaseName().toStdString();
+                    fq::Exporter::Format format = fq::Exporter::formatOf(fileName.toStdString());
+                    if (format == fq::Exporter::Format::Html || format == fq::Exporter::Format::Latex)
+                        options.answers = QMessageBox::question(this, "Export", "Mark the correct answers and show the explanations?") == QMessageBox::Yes;
+                    fq::Exporter::exportFile(fileName.toStdString(), repository->getQuestions(), options);
+                    statusBar()->showMessage(QString("Exported %1 questions to %2").arg(repository->getQuestionCount()).arg(fileName), 5000);
+                }
+            }
+        }
         else if (action == ui->newRepository)
         {
             QString fileName = QFileDialog::getSaveFileName(this, "New Repository", "", "JSON Files (*.json);;All Files (*)");
@@ -197,6 +327,34 @@ void MainWindow::helpAction(QAction *action)
         about->setAttribute(Qt::WA_DeleteOnClose);
         about->show();
     }
+    else if (action == ui->memoryUsage)
+    {
+        showMemoryUsage();
+    }
+}
+
+void MainWindow::showMemoryUsage()
+{
+    if (repository == nullptr)
+    {
+        QMessageBox::warning(this, "Error", "No repository loaded. Please open or create a repository first.");
+        return;
+    }
+    fq::MemoryUsage usage = repository->getMemoryUsage();
+    fq::InternedString::Statistics strings = fq::InternedString::statistics();
+    auto cache = [](qint64 used, qint64 maximum)
+    {
+        return QString::fromStdString(fq::MemoryUsage::formatBytes(static_cast<std::size_t>(used)) + " of " +
+                                      fq::MemoryUsage::formatBytes(static_cast<std::size_t>(maximum)));
+    };
+    QString text = QString("Questions in memory: %1 of %2\n\n").arg(usage.questions).arg(repository->getQuestionCount()) +
+                   QString::fromStdString(usage.toString()) +
+                   QString("\nInterned texts:       %1 (%2 distinct)\n").arg(strings.references).arg(strings.uniqueStrings) +
+                   "Rendered text cache:  " + cache(renderer->cachedBytes(), renderer->maxCachedBytes()) + "\n" +
+                   "Image cache:          " + cache(media->cachedBytes(), media->maxCachedBytes());
+    QMessageBox box(QMessageBox::Information, "Memory usage", "<pre>" + text.toHtmlEscaped() + "</pre>", QMessageBox::Ok, this);
+    box.setTextFormat(Qt::RichText);
+    box.exec();
 }
 
 void MainWindow::manageQuestions(QAction *action)
@@ -208,12 +366,16 @@ void MainWindow::manageQuestions(QAction *action)
             ManageQuestions *manageQuestions = new ManageQuestions(repository, this);
             manageQuestions->setAttribute(Qt::WA_DeleteOnClose);
             manageQuestions->exec();
-            ui->score->setText("0/0");
-            ui->scoreBar->setValue(0);
-            ui->explanation->setText("");
-            ui->totalQuestions->setText("Total questions in repository: " + QString::number(repository->getQuestionCount()));
+            // The session goes on with the edited questions, so the score is kept.
+            updateScore();
+            renderer->display(ui->explanation, "");
+            updateQuestionCount();
             loadQuestion();
         }
+        else if (action == ui->filterQuestions)
+        {
+            filterQuestions();
+        }
     }
     catch (const std::invalid_argument &e)
     {
@@ -229,38 +391,152 @@ void MainWindow::manageQuestions(QAction *action)
     }
 }
 
+void MainWindow::filterQuestions()
+{
+    if (repository == nullptr)
+        return;
+    QString tags;
+    for (const auto &it : repository->getTagCounts())
+        tags += QString::fromStdString(it.first) + " (" + QString::number(it.second) + ")\n";
+    if (tags.isEmpty())
+        tags = "No tags defined in this repository.\n";
+    bool ok = false;
+    QString expression = QInputDialog::getText(this, "Filter by tags",
+                                               "Available tags:\n" + tags +
+                                                   "\nCombine tags with & (and), | (or), ! (not) and parentheses.\nLeave empty to draw from all questions.",
+                                               QLineEdit::Normal, QString::fromStdString(repository->getFilter()), &ok);
+    if (!ok)
+        return;
+    repository->setFilter(expression.trimmed().toStdString());
+    // Only the questions drawn from change, so the score is kept, as after editing the questions.
+    updateScore();
+    renderer->display(ui->explanation, "");
+    updateQuestionCount();
+    loadQuestion();
+}
+
+void MainWindow::updateQuestionCount()
+{
+    QString text = "Total questions in repository: " + QString::number(repository->getQuestionCount());
+    if (!repository->getFilter().empty())
+        text += " (" + QString::number(repository->getFilteredCount()) + " matching filter)";
+    ui->totalQuestions->setText(text);
+}
+
 void MainWindow::loadRepository(const std::string &repositoryPath)
 {
     try
     {
-        removeAnswers();
-        delete repository;
-        repository = fq::Repository::createRepository(repositoryPath);
-        ui->score->setText("0/0");
-        ui->scoreBar->setValue(0);
-        ui->explanation->setText("");
-        ui->totalQuestions->setText("Total questions in repository: " + QString::number(repository->getQuestionCount()));
-        loadQuestion();
-        ui->manageQuestions->setEnabled(true);
-        return;
+        setRepository(fq::Repository::createRepository(repositoryPath, true));
     }
     catch (const std::invalid_argument &e)
     {
         QMessageBox::warning(this, "Error", QString::fromStdString(e.what()));
-        return;
     }
     catch (const std::runtime_error &e)
     {
         QMessageBox::critical(this, "Error", QString::fromStdString(e.what()));
-        return;
     }
     catch (const std::exception &e)
     {
         QMessageBox::critical(this, "Error", QString::fromStdString(e.what()));
-        return;
     }
+}
+
+void MainWindow::loadRepositories(const std::vector<std::string> &repositoryPaths, const std::vector<double> &weights)
+{
+    try
+    {
+        setRepository(fq::MultiRepository::open(repositoryPaths, weights, true));
+    }
+    catch (const std::invalid_argument &e)
+    {
+        QMessageBox::warning(this, "Error", QString::fromStdString(e.what()));
+    }
+    catch (const std::runtime_error &e)
+    {
+        QMessageBox::critical(this, "Error", QString::fromStdString(e.what()));
+    }
+    catch (const std::exception &e)
+    {
+        QMessageBox::critical(this, "Error", QString::fromStdString(e.what()));
+    }
+}
+
+void MainWindow::setRepository(fq::Repository *newRepository)
+{
+    removeAnswers();
+    currentQuestion = nullptr;
     delete repository;
-    repository = nullptr;
+    repository = newRepository;
+    if (!watcher->files().isEmpty())
+        watcher->removePaths(watcher->files());
+    if (repository->isEditable())
+        watcher->addPath(QString::fromStdString(repository->getPath()));
+    QString path = QString::fromStdString(repository->getPath());
+    media->setBaseDirectory(path.isEmpty() ? QDir::currentPath() : QFileInfo(path).absolutePath());
+    totalScore = 0.0;
+    totalQuestions = 0;
+    if (repository->isEditable())
+    {
+        try
+        {
+            fq::SessionLog::ReplaySummary resumed = repository->openLog(true);
+            totalScore = resumed.totalScore;
+            totalQuestions = static_cast<int>(resumed.answers);
+            if (resumed.answers)
+                ui->statusbar->showMessage(QString("Resumed the previous session: %1 questions answered").arg(resumed.answers), 5000);
+        }
+        catch (const std::exception &e)
+        {
+            ui->statusbar->showMessage(QString("The session will not be saved: %1").arg(e.what()), 5000);
+        }
+    }
+    updateScore();
+    renderer->display(ui->explanation, "");
+    updateQuestionCount();
+    loadQuestion();
+    ui->newSession->setEnabled(repository->isEditable());
+    ui->exportRepository->setEnabled(repository->isEditable());
+    ui->manageQuestions->setEnabled(repository->isEditable());
+    ui->filterQuestions->setEnabled(true);
+}
+
+void MainWindow::repositoryFileChanged(const QString &path)
+{
+    // Editors which save by replacing the file remove it from the watcher, so it is watched again.
+    if (QFileInfo::exists(path) && !watcher->files().contains(path))
+        watcher->addPath(path);
+    if (repository == nullptr || !QFileInfo::exists(path))
+        return;
+    if (repository->isModified() && repository->isFileChanged() &&
+        QMessageBox::question(this, "Repository changed",
+                              "The repository file was changed by another program, but your changes to its questions have not been saved yet.\n\n"
+                              "Reload the file and discard your changes? Otherwise your changes overwrite the file when the repository is saved.",
+                              QMessageBox::Yes | QMessageBox::No, QMessageBox::No) != QMessageBox::Yes)
+        return;
+    fq::ReloadSummary summary;
+    try
+    {
+        summary = repository->reload();
+    }
+    catch (const std::exception &)
+    {
+        return;
+    }
+    if (!summary.added && !summary.removed && !summary.edited)
+        return;
+    ui->statusbar->showMessage(QString("Repository reloaded: %1 added, %2 removed, %3 edited")
+                                   .arg(summary.added)
+                                   .arg(summary.removed)
+                                   .arg(summary.edited),
+                               5000);
+    updateQuestionCount();
+    if (currentQuestion == nullptr || !repository->contains(currentQuestion))
+    {
+        currentQuestion = nullptr;
+        loadQuestion();
+    }
 }
 
 void MainWindow::fontSizeChanged(int value)
@@ -278,21 +554,42 @@ void MainWindow::fontSizeChanged(int value)
     ui->repository->setFont(font);
     ui->help->setFont(font);
     ui->about->setFont(font);
+    ui->memoryUsage->setFont(font);
     ui->manageQuestions->setFont(font);
+    ui->filterQuestions->setFont(font);
     ui->newRepository->setFont(font);
     ui->openRepository->setFont(font);
+    ui->openRepositories->setFont(font);
+    ui->newSession->setFont(font);
+    ui->exportRepository->setFont(font);
     for (int i = 0; i < ui->answers->count(); ++i)
     {
         auto answerWidget = qobject_cast<QAbstractButton *>(ui->answers->itemAt(i)->widget());
         if (answerWidget)
             answerWidget->setFont(font);
     }
+    renderer->refresh();
+}
+
+void MainWindow::resizeEvent(QResizeEvent *event)
+{
+    QMainWindow::resizeEvent(event);
+    renderTimer->start();
 }
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow), isAnswered(false), currentQuestion(nullptr), selectedAnswers(0), totalQuestions(0), totalScore(0.0), repository(nullptr)
 {
     ui->setupUi(this);
+    media = new MediaCache(96 * 1024 * 1024, this);
+    connect(media, &MediaCache::loaded, this, &MainWindow::mediaLoaded);
+    renderer = new RichTextRenderer(media, 64 * 1024 * 1024, this);
+    renderTimer = new QTimer(this);
+    renderTimer->setSingleShot(true);
+    renderTimer->setInterval(150);
+    connect(renderTimer, &QTimer::timeout, renderer, &RichTextRenderer::refresh);
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::repositoryFileChanged);
     connect(ui->ok, &QPushButton::clicked, this, &MainWindow::okClicked);
     connect(ui->repository, &QMenu::triggered, this, &MainWindow::repositoryAction);
     connect(ui->questions, &QMenu::triggered, this, &MainWindow::manageQuestions);
@@ -303,13 +600,18 @@ MainWindow::MainWindow(QWidget *parent)
     ui->scoreBar->setStyleSheet(style);
     ui->score->setText("0/0");
     ui->scoreBar->setValue(0);
-    ui->explanation->setText("Welcome to the FunQuizz! Use repository menu to load a quiz repository and start answering questions.");
+    renderer->display(ui->explanation, "Welcome to the FunQuizz! Use repository menu to load a quiz repository and start answering questions.");
     ui->totalQuestions->setText("Repository not loaded yet.");
+    ui->newSession->setEnabled(false);
+    ui->exportRepository->setEnabled(false);
     ui->manageQuestions->setEnabled(false);
+    ui->filterQuestions->setEnabled(false);
 }
 
 MainWindow::~MainWindow()
 {
+    // The renderer decodes images on its worker threads, so it is deleted before the media cache.
+    delete renderer;
     delete ui;
     delete repository;
 }
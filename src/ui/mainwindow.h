@@ -13,10 +13,23 @@
 #include <QFileDialog>
 #include <QSlider>
 #include <QFont>
+#include <QInputDialog>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QStatusBar>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QResizeEvent>
+#include <QIcon>
+#include <QDir>
 #include "repository.hpp"
+#include "multirepository.hpp"
+#include "exporter.hpp"
 #include "managequestions.h"
 #include "about.h"
 #include "newrepository.h"
+#include "richtextrenderer.h"
+#include "mediacache.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -35,13 +48,16 @@ class MainWindow : public QMainWindow
     /// @details This repository is used to fetch questions and manage the quiz state.
     fq::Repository *repository;
 
-    /// @brief A collection of answers currently loaded from the repository.
-    /// @details This vector holds the answers for the current question being displayed.
-    std::vector<fq::Answer> currentAnswers;
+    /// @brief Presentation order of the answers of the current question.
+    /// @details The i-th answer widget shows the answer at index answerOrder[i] of the current question.
+    std::vector<std::size_t> answerOrder;
 
     /// @brief Pointer to the current question being displayed in the UI.
     fq::Question *currentQuestion;
 
+    /// @brief Measures the time since the current question was displayed, recorded with the answer.
+    QElapsedTimer questionTimer;
+
     /// @brief Loads the next question from the repository or shows and explanation and updates the UI accordingly.
     /// @param checked A boolean indicating whether the button was checked or not. Not used in this context.
     /// @details If the question is answered, it updates the score and displays the explanation.
@@ -53,6 +69,9 @@ class MainWindow : public QMainWindow
     /// If no questions are available, it displays a message in the UI indicating that.
     void loadQuestion();
 
+    /// @brief Shows the total score, and the ability estimate for adaptive repositories, in the score label and bar.
+    void updateScore();
+
     /// @brief Removes all answer widgets from the UI.
     /// @details This function clears the layout containing the answer widgets, effectively removing all answers.
     void removeAnswers();
@@ -80,11 +99,13 @@ class MainWindow : public QMainWindow
 
     /// @brief Handles menu actions related to the repository.
     /// @param action The QAction that triggered the repository action.
-    /// @details This function processes actions such as opening a repository and creating a new repository.
+    /// @details This function processes actions such as opening a repository, creating a new repository and starting
+    /// a new session.
     void repositoryAction(QAction *action);
 
     /// @brief Handles the help action triggered from the menu.
     /// @param action The QAction that triggered the help action.
+    /// @details Shows the About dialog, or the memory used by the questions of the repository and by the caches.
     void helpAction(QAction *action);
 
     /// @brief Handles menu actions related to the questions.
@@ -92,14 +113,72 @@ class MainWindow : public QMainWindow
     /// @details This function allows the user to manage questions, such as adding or removing questions.
     void manageQuestions(QAction *action);
 
+    /// @brief Asks the user for a tag expression and restricts drawn questions to those matching it.
+    /// @throws std::invalid_argument if the entered expression is malformed.
+    void filterQuestions();
+
+    /// @brief Updates the label showing the number of questions in the repository and matching the filter.
+    void updateQuestionCount();
+
     /// @brief Loads a repository from the specified path.
     /// @param repositoryPath The path to the repository file.
     void loadRepository(const std::string &repositoryPath);
 
+    /// @brief Loads several repositories concurrently and draws questions from all of them.
+    /// @param repositoryPaths The paths to the repository files.
+    /// @param weights Weights of the repositories, in the same order as the paths.
+    void loadRepositories(const std::vector<std::string> &repositoryPaths, const std::vector<double> &weights);
+
+    /// @brief Replaces the current repository and resets the quiz.
+    /// @param newRepository The new repository. The MainWindow takes ownership of it.
+    void setRepository(fq::Repository *newRepository);
+
+    /// @brief Watches the JSON file of the current repository for changes made by other programs.
+    QFileSystemWatcher *watcher;
+
+    /// @brief Reloads the current repository after its JSON file has changed.
+    /// @details Only the changed questions are reloaded and the draw state is kept. If the displayed question was
+    /// edited or removed, the next question is loaded. A file which cannot be parsed (e.g. while it is still being
+    /// written) is ignored until it changes again, and so are the changes caused by saving the repository. If the
+    /// repository has unsaved changes, the user chooses between reloading the file and keeping them.
+    /// @param path The path to the changed file.
+    void repositoryFileChanged(const QString &path);
+
     /// @brief Changes the font size of various UI elements.
     /// @param value The new font size (in points).
+    /// @details The question and the explanation are rendered again at the new size, or taken from the cache if they
+    /// were shown at that size before.
     void fontSizeChanged(int value);
 
+    /// @brief Renders the Markdown and formulas of the question and the explanation off the UI thread.
+    RichTextRenderer *renderer;
+
+    /// @brief Decodes the images of the questions off the UI thread.
+    MediaCache *media;
+
+    /// @brief Shows the image of an answer next to it, or starts decoding it if it is not in the cache yet.
+    /// @param answerWidget The answer widget, whose "image" property holds the reference of the image.
+    void showAnswerImage(QAbstractButton *answerWidget);
+
+    /// @brief Shows a decoded image in the answer widgets waiting for it.
+    /// @param reference The reference of the image.
+    void mediaLoaded(const QString &reference);
+
+    /// @brief Shows the estimated memory used by the questions of the repository, the interned texts and the caches.
+    void showMemoryUsage();
+
+    /// @brief Starts decoding the images of the explanation of the current question and of the predicted next question.
+    /// @details Called after the current question is shown, so the images are likely decoded by the time they are needed.
+    void prefetchMedia();
+
+    /// @brief Delays rendering the question and the explanation again until the window stops being resized.
+    QTimer *renderTimer;
+
+protected:
+    /// @brief Renders the question and the explanation at the new width once resizing has finished.
+    /// @param event The resize event.
+    void resizeEvent(QResizeEvent *event) override;
+
 public:
     /// @brief Constructs the MainWindow with the specified parent widget.
     /// @param parent The parent widget for the MainWindow. Defaults to nullptr.
@@ -3,58 +3,277 @@
 
 void ManageQuestions::removeQuestions()
 {
-    auto toRemove = ui->questions->selectedItems();
-    for (auto &it : toRemove)
+    QModelIndexList toRemove = ui->questions->selectionModel()->selectedIndexes();
+    if (toRemove.isEmpty())
+        return;
+    std::vector<const fq::Question *> removed;
+    std::vector<int> rows;
+    removed.reserve(toRemove.size());
+    rows.reserve(toRemove.size());
+    for (const auto &index : toRemove)
     {
-        if (!questions.erase(it->text().toStdString()))
-            throw std::runtime_error("Failed to remove question: " + it->text().toStdString());
+        removed.push_back(model->question(index.row()));
+        rows.push_back(index.row());
     }
-    updateQuestionsList();
+    log.remove(removed, removed.size() == 1 ? "remove question" : QString("remove %1 questions").arg(removed.size()).toStdString());
+    model->remove(std::move(rows));
+    updateUndoButtons();
+}
+
+void ManageQuestions::undo()
+{
+    if (log.undo())
+        updateQuestionsList();
+    updateUndoButtons();
+}
+
+void ManageQuestions::redo()
+{
+    if (log.redo())
+        updateQuestionsList();
+    updateUndoButtons();
+}
+
+void ManageQuestions::updateUndoButtons()
+{
+    ui->undo->setEnabled(log.canUndo());
+    ui->undo->setToolTip(log.canUndo() ? QString("Undo %1").arg(QString::fromStdString(log.undoDescription())) : QString());
+    ui->redo->setEnabled(log.canRedo());
+    ui->redo->setToolTip(log.canRedo() ? QString("Redo %1").arg(QString::fromStdString(log.redoDescription())) : QString());
 }
 
 void ManageQuestions::updateQuestionsList()
 {
-    ui->questions->clear();
-    for (auto &it : questions)
+    struct Row
+    {
+        std::uint32_t position;
+        const fq::Question *question;
+        std::optional<fq::QuestionStatistics::Summary> statistics;
+    };
+    const fq::QuestionStatistics &statistics = repository->getStatistics();
+    double maxScore = ui->maxScore->value();
+    double minTime = ui->minTime->value();
+    bool filtered = maxScore < ui->maxScore->maximum() || minTime > 0.0;
+    auto questions = log.getQuestions();
+    // In repository order the model lists the shared questions as they are, without touching them.
+    if (!filtered && ui->sortBy->currentIndex() == 0)
+    {
+        model->setQuestions(std::move(questions));
+        return;
+    }
+    std::vector<Row> rows;
+    rows.reserve(questions->size());
+    for (std::uint32_t position = 0; position < questions->size(); ++position)
     {
-        ui->questions->addItem(QString::fromStdString(it.first));
+        const fq::Question *question = (*questions)[position];
+        auto summary = statistics.get(question);
+        if (filtered && (!summary || summary->meanScore > maxScore || summary->meanLatency < minTime))
+            continue;
+        rows.push_back({position, question, summary});
     }
+
+    // Questions without recorded answers are listed last by every statistic.
+    auto byStatistic = [](auto key)
+    {
+        return [key](const Row &a, const Row &b)
+        {
+            if (a.statistics.has_value() != b.statistics.has_value())
+                return a.statistics.has_value();
+            return a.statistics && key(*a.statistics) < key(*b.statistics);
+        };
+    };
+    switch (ui->sortBy->currentIndex())
+    {
+    case 0:
+        break;
+    case 1:
+        std::sort(rows.begin(), rows.end(), byStatistic([](const auto &s) { return s.meanScore; }));
+        break;
+    case 2:
+        std::sort(rows.begin(), rows.end(), byStatistic([](const auto &s) { return -s.meanLatency; }));
+        break;
+    case 3:
+        std::sort(rows.begin(), rows.end(), byStatistic([](const auto &s) { return -static_cast<double>(s.answers); }));
+        break;
+    case 4:
+        std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b)
+                  { return a.question->getDifficulty() > b.question->getDifficulty(); });
+        break;
+    default:
+        std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b)
+                  { return a.question->getQuestion() < b.question->getQuestion(); });
+        break;
+    }
+
+    std::vector<std::uint32_t> order;
+    order.reserve(rows.size());
+    for (const auto &row : rows)
+        order.push_back(row.position);
+    model->setQuestions(std::move(questions), std::move(order));
+}
+
+void ManageQuestions::editQuestion(const QModelIndex &index)
+{
+    if (!index.isValid())
+        return;
+    const fq::Question *question = model->question(index.row());
+    AddQuestion *editor = new AddQuestion(log, this, question);
+    editor->setAttribute(Qt::WA_DeleteOnClose);
+    connect(editor, &AddQuestion::questionEdited, this, [this](const fq::Question *original, fq::Question *replacement)
+            { log.edit(original, replacement, "edit question"); });
+    editor->exec();
+    updateQuestionsList();
+    updateUndoButtons();
 }
 
 void ManageQuestions::addQuestions()
 {
-    AddQuestion *addQuestion = new AddQuestion(questions, this);
+    AddQuestion *addQuestion = new AddQuestion(log, this);
     addQuestion->setAttribute(Qt::WA_DeleteOnClose);
+    connect(addQuestion, &AddQuestion::questionAdded, this, [this](fq::Question *question)
+            { log.add({question}, "add question"); });
     addQuestion->exec();
     updateQuestionsList();
+    updateUndoButtons();
+}
+
+void ManageQuestions::importQuestions()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, "Import Questions", "", "Question Files (*.csv *.md *.markdown *.gift *.txt);;All Files (*)");
+    if (fileNames.isEmpty())
+        return;
+    std::size_t duplicates = 0, failed = 0;
+    std::vector<std::unique_ptr<fq::Question>> accepted;
+    std::unordered_set<std::string> acceptedTexts;
+    QStringList details;
+    for (const QString &fileName : fileNames)
+    {
+        fq::Importer::Result result;
+        try
+        {
+            result = fq::Importer::importFile(fileName.toStdString());
+        }
+        catch (const std::exception &e)
+        {
+            QMessageBox::critical(this, "Error", QString::fromStdString(e.what()));
+            continue;
+        }
+        for (auto &question : result.questions)
+        {
+            if (!log.find(question->getQuestion()) && acceptedTexts.insert(question->getQuestion()).second)
+                accepted.push_back(std::move(question));
+            else
+                ++duplicates;
+        }
+        failed += result.errors.size();
+        for (const auto &error : result.errors)
+            details.append(QString("%1:%2: %3").arg(QFileInfo(fileName).fileName()).arg(error.line).arg(QString::fromStdString(error.message)));
+    }
+    std::size_t added = accepted.size();
+    if (added)
+    {
+        std::vector<fq::Question *> questions;
+        questions.reserve(accepted.size());
+        for (auto &question : accepted)
+            questions.push_back(question.release());
+        log.add(questions, QString("import %1 questions").arg(added).toStdString());
+        updateQuestionsList();
+        updateUndoButtons();
+    }
+
+    QMessageBox summary(this);
+    summary.setWindowTitle("Import");
+    summary.setIcon(failed ? QMessageBox::Warning : QMessageBox::Information);
+    summary.setText(QString("Imported %1 questions.").arg(added) +
+                    (duplicates ? QString(" %1 questions were already present.").arg(duplicates) : QString()) +
+                    (failed ? QString(" %1 questions could not be imported.").arg(failed) : QString()));
+    if (!details.isEmpty())
+        summary.setDetailedText(details.join('\n'));
+    summary.exec();
+}
+
+void ManageQuestions::validateQuestions()
+{
+    fq::Validator::Report report;
+    try
+    {
+        report = fq::Validator::validate(fq::JsonWriter::writeRepository(*log.getQuestions(), repository->getType()));
+    }
+    catch (const std::exception &e)
+    {
+        QMessageBox::critical(this, "Error", QString::fromStdString(e.what()));
+        return;
+    }
+
+    // Locations refer to the order in which the questions were written, so problems are listed by question text.
+    std::unordered_set<std::string> withProblems;
+    QStringList details;
+    for (const auto &problem : report.problems)
+    {
+        withProblems.insert(problem.question);
+        details.append(QString("%1 %2: %3").arg(problem.severity == fq::Validator::Severity::Error ? "Error in" : "Warning for").arg(QString::fromStdString(problem.question)).arg(QString::fromStdString(problem.message)));
+    }
+    QItemSelection selection;
+    for (int row = 0; row < model->rowCount(); ++row)
+    {
+        if (withProblems.count(model->question(row)->getQuestion()))
+            selection.select(model->index(row), model->index(row));
+    }
+    ui->questions->selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect);
+
+    std::size_t errors = report.count(fq::Validator::Severity::Error);
+    std::size_t warnings = report.count(fq::Validator::Severity::Warning);
+    QMessageBox summary(this);
+    summary.setWindowTitle("Check Questions");
+    summary.setIcon(errors ? QMessageBox::Critical : warnings ? QMessageBox::Warning : QMessageBox::Information);
+    summary.setText(report.problems.empty() ? QString("No problems found in %1 questions.").arg(report.questions)
+                                            : QString("Found %1 errors and %2 warnings in %3 questions. The questions concerned are selected.").arg(errors).arg(warnings).arg(withProblems.size()));
+    if (!details.isEmpty())
+        summary.setDetailedText(details.join('\n'));
+    summary.exec();
 }
 
 void ManageQuestions::saveAndClose()
 {
-    std::vector<fq::Question *> qvec;
-    qvec.reserve(questions.size());
-    for (const auto &pair : questions)
-        qvec.push_back(pair.second);
-    repository->setQuestions(qvec);
+    try
+    {
+        if (repository->applyEdits(log))
+            repository->save();
+    }
+    catch (const std::exception &e)
+    {
+        QMessageBox::critical(this, "Error", QString::fromStdString(e.what()));
+    }
     close();
 }
 
 ManageQuestions::ManageQuestions(fq::Repository *repository, QWidget *parent)
-    : QDialog(parent), ui(new Ui::ManageQuestions), repository(repository)
+    : QDialog(parent), ui(new Ui::ManageQuestions), repository(repository),
+      log(repository ? repository->getBank() : std::make_shared<const fq::QuestionBank>()), model(nullptr)
 {
     ui->setupUi(this);
     setWindowFlags(Qt::Window | Qt::WindowTitleHint | Qt::CustomizeWindowHint);
     if (repository == nullptr)
         throw std::invalid_argument("Repository cannot be null");
-    auto q = repository->getQuestions();
-    for (auto &it : q)
-    {
-        questions[it->getQuestion()] = it;
-    }
+    model = new QuestionListModel(repository->getStatistics(), this);
+    ui->questions->setModel(model);
     updateQuestionsList();
+    updateUndoButtons();
+    ui->undo->setShortcut(QKeySequence::Undo);
+    ui->redo->setShortcut(QKeySequence::Redo);
+    connect(ui->undo, &QPushButton::clicked, this, &ManageQuestions::undo);
+    connect(ui->redo, &QPushButton::clicked, this, &ManageQuestions::redo);
     connect(ui->removeQuestion, &QPushButton::clicked, this, &ManageQuestions::removeQuestions);
     connect(ui->save, &QPushButton::clicked, this, &ManageQuestions::saveAndClose);
     connect(ui->addQuestions, &QPushButton::clicked, this, &ManageQuestions::addQuestions);
+    connect(ui->editQuestion, &QPushButton::clicked, this, [this]()
+            { editQuestion(ui->questions->currentIndex()); });
+    connect(ui->questions, &QListView::doubleClicked, this, &ManageQuestions::editQuestion);
+    connect(ui->importQuestions, &QPushButton::clicked, this, &ManageQuestions::importQuestions);
+    connect(ui->validateQuestions, &QPushButton::clicked, this, &ManageQuestions::validateQuestions);
+    connect(ui->sortBy, &QComboBox::currentIndexChanged, this, &ManageQuestions::updateQuestionsList);
+    connect(ui->maxScore, &QDoubleSpinBox::valueChanged, this, &ManageQuestions::updateQuestionsList);
+    connect(ui->minTime, &QDoubleSpinBox::valueChanged, this, &ManageQuestions::updateQuestionsList);
 }
 
 ManageQuestions::~ManageQuestions()
@@ -6,9 +6,21 @@
 
 #include <QDialog>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
+#include <QListView>
+#include <QItemSelection>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QKeySequence>
 #include <stdexcept>
 #include "repository.hpp"
 #include "addquestion.h"
+#include "importer.hpp"
+#include "validator.hpp"
+#include "jsonwriter.hpp"
+#include "questionlistmodel.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -27,30 +39,66 @@ class ManageQuestions : public QDialog
     /// @details This repository is used to fetch, add, and remove questions.
     fq::Repository *repository;
 
-    /// @brief A collection of questions currently loaded from the repository.
-    /// @details This unordered_map holds the questions with their text as keys and pointers to Question objects as values.
-    /// It allows for quick access and modification of questions.
-    std::unordered_map<std::string, fq::Question *> questions;
+    /// @brief The questions as edited in the dialog, with the log of the edits.
+    /// @details The log is a copy-on-write working copy of the bank of the repository, so opening the dialog copies
+    /// no questions and only edited questions are duplicated. It is used to undo and redo the edits and to apply them
+    /// in saveAndClose; until then, sessions keep reading the bank as it was.
+    fq::EditLog log;
+
+    /// @brief The questions shown in the questions list, as edited.
+    QuestionListModel *model;
+
+    /// @brief Undoes the last edit and updates the questions list.
+    void undo();
+
+    /// @brief Redoes the last undone edit and updates the questions list.
+    void redo();
+
+    /// @brief Enables the undo and redo buttons and describes in their tool tips what they would do.
+    void updateUndoButtons();
 
     /// @brief Removes selected questions from the questions list.
-    /// @details This function retrieves the selected items from the questions list widget and removes them from the
-    /// questions collection. It updates the questions list after removal.
+    /// @details This function retrieves the selected rows from the questions list and removes their questions from
+    /// the questions collection as one command of the edit log. Only the removed rows are taken out of the list; it
+    /// is not rebuilt.
     void removeQuestions();
 
     /// @brief Updates the questions list in the UI.
-    /// @details This function clears the current questions list widget and repopulates it with the
-    /// questions from the questions collection. It ensures that the UI reflects the current state of the questions.
-    /// It is called after adding or removing questions to keep the UI in sync with the underlying data.
+    /// @details This function points the list model at the questions as edited, shared with the edit log, so
+    /// the UI reflects the current state of the questions. It is called after adding or editing questions to keep the
+    /// UI in sync with the underlying data. In repository order and without a filter this takes constant time, and rows
+    /// are only formatted when they are shown; sorting and filtering by the answer statistics, as chosen in the dialog,
+    /// look up the statistics of every question.
     void updateQuestionsList();
 
+    /// @brief Opens the AddQuestion dialog to edit a question.
+    /// @details The edited question replaces the original as one command of the edit log; the original itself is
+    /// not modified.
+    /// @param index The index of the question in the questions list.
+    void editQuestion(const QModelIndex &index);
+
     /// @brief Opens the AddQuestion dialog to add new questions.
-    /// @details This function creates an instance of the AddQuestion dialog, passing the current questions collection.
-    /// It sets the dialog to delete itself when closed and executes it. After adding a question, it updates the questions list to reflect the new state.
+    /// @details This function creates an instance of the AddQuestion dialog, passing the questions as edited.
+    /// Every question saved in the dialog is added as one command of the edit log. It sets the dialog to delete itself
+    /// when closed and executes it. Afterwards, it updates the questions list to reflect the new state.
     void addQuestions();
 
+    /// @brief Imports questions from CSV, Markdown or GIFT files chosen by the user.
+    /// @details The files are parsed by fq::Importer and the imported questions are added to the questions collection,
+    /// skipping questions whose text is already in it, as one command of the edit log. Questions which could not be
+    /// imported are listed with their line numbers in the summary shown afterwards. Like added questions, imported
+    /// questions are only stored in the repository by saveAndClose.
+    void importQuestions();
+
+    /// @brief Checks the questions collection for problems, such as single choice questions without exactly one
+    /// correct answer.
+    /// @details The questions are written as they would be saved and checked by fq::Validator. The questions with
+    /// problems are selected in the list, and the problems are listed in the summary shown afterwards.
+    void validateQuestions();
+
     /// @brief Saves the current state of questions and closes the dialog.
-    /// @details This function collects all questions from the questions collection, sets them in the repository,
-    /// and then closes the dialog. It ensures that any changes made to the questions are saved.
+    /// @details This function applies the edits which are done to the repository in one batch and saves it if they
+    /// changed anything, and then closes the dialog.
     void saveAndClose();
 
 public:
@@ -0,0 +1,160 @@
+#include "mediacache.h"
+#include <QImageReader>
+#include <QBuffer>
+#include <QByteArray>
+#include <QDir>
+#include <QUrl>
+#include <QRegularExpression>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace
+{
+    /// @brief Matches an image in Markdown: ![description](reference "title").
+    const QRegularExpression &imagePattern()
+    {
+        static const QRegularExpression pattern(QStringLiteral("!\\[([^\\]]*)\\]\\(\\s*<?([^)\\s>]+)>?(?:\\s+\"[^\"]*\")?\\s*\\)"));
+        return pattern;
+    }
+}
+
+QImage MediaCache::decode(const QString &resolved)
+{
+    QImageReader reader;
+    QBuffer buffer;
+    if (resolved.startsWith("data:"))
+    {
+        qsizetype comma = resolved.indexOf(',');
+        if (comma < 0)
+            return QImage();
+        QByteArray payload = resolved.mid(comma + 1).toLatin1();
+        buffer.setData(resolved.left(comma).endsWith(";base64") ? QByteArray::fromBase64(payload) : QByteArray::fromPercentEncoding(payload));
+        buffer.open(QIODevice::ReadOnly);
+        reader.setDevice(&buffer);
+    }
+    else
+    {
+        reader.setFileName(resolved);
+    }
+    reader.setAutoTransform(true);
+    QSize size = reader.size();
+    if (size.isValid() && (size.width() > maxDimension || size.height() > maxDimension))
+        reader.setScaledSize(size.scaled(maxDimension, maxDimension, Qt::KeepAspectRatio));
+    return reader.read();
+}
+
+MediaCache::MediaCache(qint64 cacheBytes, QObject *parent)
+    : QObject(parent), images(cacheBytes)
+{
+    pool.setMaxThreadCount(2);
+}
+
+MediaCache::~MediaCache()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void MediaCache::setBaseDirectory(const QString &directory)
+{
+    QMutexLocker locker(&mutex);
+    baseDirectory = directory;
+}
+
+QString MediaCache::getBaseDirectory()
+{
+    QMutexLocker locker(&mutex);
+    return baseDirectory;
+}
+
+qint64 MediaCache::cachedBytes()
+{
+    QMutexLocker locker(&mutex);
+    return images.totalCost();
+}
+
+qint64 MediaCache::maxCachedBytes()
+{
+    QMutexLocker locker(&mutex);
+    return images.maxCost();
+}
+
+QString MediaCache::resolve(const QString &reference)
+{
+    if (reference.startsWith("data:") || reference.startsWith(":/"))
+        return reference;
+    if (reference.startsWith("qrc:"))
+        return ":" + reference.mid(4);
+    if (reference.startsWith("file:"))
+        return QUrl(reference).toLocalFile();
+    QString path = QUrl::fromPercentEncoding(reference.toUtf8());
+    if (QDir::isAbsolutePath(path))
+        return QDir::cleanPath(path);
+    return QDir::cleanPath(QDir(getBaseDirectory()).filePath(path));
+}
+
+QImage MediaCache::find(const QString &reference)
+{
+    QString resolved = resolve(reference);
+    QMutexLocker locker(&mutex);
+    QImage *image = images.object(resolved);
+    return image ? *image : QImage();
+}
+
+QImage MediaCache::load(const QString &reference)
+{
+    QString resolved = resolve(reference);
+    {
+        QMutexLocker locker(&mutex);
+        if (QImage *image = images.object(resolved))
+            return *image;
+    }
+    // Decoded without holding the lock, so lookups never wait for a decode. Two threads may decode the same image.
+    QImage image = decode(resolved);
+    if (!image.isNull())
+    {
+        QMutexLocker locker(&mutex);
+        images.insert(resolved, new QImage(image), std::max<qsizetype>(1, image.sizeInBytes()));
+    }
+    return image;
+}
+
+void MediaCache::request(const QString &reference)
+{
+    if (reference.isEmpty() || pending.contains(reference) || !find(reference).isNull())
+        return;
+    pending.insert(reference);
+    pool.start([this, reference]()
+               {
+                   load(reference);
+                   // The destructor waits for the running decodes, so the cache still exists here.
+                   QMetaObject::invokeMethod(this, [this, reference]()
+                                             {
+                                                 pending.remove(reference);
+                                                 emit loaded(reference); }, Qt::QueuedConnection); });
+}
+
+void MediaCache::prefetch(const QString &text)
+{
+    for (const QString &reference : references(text))
+        request(reference);
+}
+
+QStringList MediaCache::references(const QString &text)
+{
+    QStringList result;
+    if (!text.contains("!["))
+        return result;
+    for (auto it = imagePattern().globalMatch(text); it.hasNext();)
+        result << it.next().captured(2);
+    return result;
+}
+
+QString MediaCache::withoutImages(const QString &text)
+{
+    if (!text.contains("!["))
+        return text;
+    QString result = text;
+    result.replace(imagePattern(), "\\1");
+    return result.trimmed();
+}
@@ -0,0 +1,114 @@
+/// @file mediacache.h
+/// @brief Header file for the MediaCache class, which loads the images referenced by questions off the UI thread.
+
+#ifndef MEDIACACHE_H
+#define MEDIACACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+/// @brief Decodes the images referenced by questions, answers and explanations, and keeps them in an LRU cache.
+/// @details Images are referenced with the Markdown syntax ![description](reference). A reference is a path
+/// relative to the directory of the repository, an absolute path, a Qt resource compiled into the application
+/// (:/path or qrc:/path) or an embedded data: URI (e.g. data:image/png;base64,...). Images larger than maxDimension
+/// are decoded scaled down, and the cache is bounded by the total size of the decoded images, so memory stays bounded
+/// however many images a repository references.
+///
+/// The cache may be used from any thread. request and prefetch decode on worker threads and never block; load decodes
+/// on the calling thread and is meant for worker threads only.
+class MediaCache : public QObject
+{
+    Q_OBJECT
+
+    /// @brief Guards the images and the base directory.
+    QMutex mutex;
+
+    /// @brief Decoded images by resolved reference, with their size in bytes as the cost.
+    QCache<QString, QImage> images;
+
+    /// @brief Directory relative references are resolved against.
+    QString baseDirectory;
+
+    /// @brief References which are queued or decoding on the worker threads. Only used on the thread of the cache.
+    QSet<QString> pending;
+
+    /// @brief Worker threads decoding the images.
+    QThreadPool pool;
+
+    /// @brief Reads and decodes an image.
+    /// @param resolved The resolved reference.
+    /// @return The image, or a null image if it cannot be read.
+    static QImage decode(const QString &resolved);
+
+public:
+    /// @brief Maximum width and height of a decoded image in pixels. Larger images are scaled down.
+    static constexpr int maxDimension = 2048;
+
+    /// @brief Constructs an empty cache.
+    /// @param cacheBytes The maximum total size of the decoded images in bytes.
+    /// @param parent The parent object.
+    explicit MediaCache(qint64 cacheBytes = 96 * 1024 * 1024, QObject *parent = nullptr);
+
+    /// @brief Discards the queued decodes and waits for the running ones.
+    ~MediaCache();
+
+    /// @brief Sets the directory relative references are resolved against, usually that of the repository file.
+    /// @param directory The directory.
+    void setBaseDirectory(const QString &directory);
+
+    /// @brief Returns the directory relative references are resolved against.
+    QString getBaseDirectory();
+
+    /// @brief Returns the total size of the decoded images in the cache in bytes.
+    qint64 cachedBytes();
+
+    /// @brief Returns the maximum total size of the decoded images in the cache in bytes.
+    qint64 maxCachedBytes();
+
+    /// @brief Turns a reference into a file path, a resource path or a data URI.
+    /// @param reference The reference, as written in the text.
+    /// @return The resolved reference.
+    QString resolve(const QString &reference);
+
+    /// @brief Returns an image if it has been decoded, without blocking on the decode.
+    /// @param reference The reference, as written in the text.
+    /// @return The image, or a null image if it is not in the cache.
+    QImage find(const QString &reference);
+
+    /// @brief Returns an image, decoding it on the calling thread if it is not in the cache.
+    /// @param reference The reference, as written in the text.
+    /// @return The image, or a null image if it cannot be read.
+    QImage load(const QString &reference);
+
+    /// @brief Decodes an image on a worker thread, unless it is in the cache or already being decoded.
+    /// @details loaded is emitted once the decode has finished, whether it succeeded or not.
+    /// @param reference The reference, as written in the text.
+    void request(const QString &reference);
+
+    /// @brief Requests all images referenced by a text.
+    /// @param text The text, e.g. of a question or an answer.
+    void prefetch(const QString &text);
+
+    /// @brief Returns the references of the images in a text.
+    /// @param text The text.
+    /// @return The references, in the order they appear.
+    static QStringList references(const QString &text);
+
+    /// @brief Replaces the images in a text by their descriptions, for widgets which can only show plain text.
+    /// @param text The text.
+    /// @return The text without image references.
+    static QString withoutImages(const QString &text);
+
+signals:
+    /// @brief Emitted when a requested image has been decoded or has failed to decode.
+    /// @param reference The reference, as passed to request.
+    void loaded(const QString &reference);
+};
+
+#endif // MEDIACACHE_H
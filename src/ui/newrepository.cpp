@@ -43,6 +43,10 @@ void CreateRepository::createRepository()
         {
             json["type"] = "intelligent";
         }
+        else if (ui->type->currentText() == "Adaptive repository")
+        {
+            json["type"] = "adaptive";
+        }
         else
         {
             throw std::runtime_error("Invalid repository type selected.");
@@ -0,0 +1,73 @@
+#include "questionlistmodel.h"
+
+QuestionListModel::QuestionListModel(const fq::QuestionStatistics &statistics, QObject *parent)
+    : QAbstractListModel(parent), questions(std::make_shared<const std::vector<fq::Question *>>()), statistics(statistics)
+{
+}
+
+void QuestionListModel::setQuestions(std::shared_ptr<const std::vector<fq::Question *>> questions_, std::optional<std::vector<std::uint32_t>> order_)
+{
+    beginResetModel();
+    questions = std::move(questions_);
+    order = std::move(order_);
+    endResetModel();
+}
+
+void QuestionListModel::remove(std::vector<int> rows)
+{
+    if (rows.empty())
+        return;
+    if (!order)
+    {
+        order.emplace(questions->size());
+        for (std::uint32_t position = 0; position < questions->size(); ++position)
+            (*order)[position] = position;
+    }
+    // Rows are removed from the last, so the rows still to remove keep their numbers.
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    for (std::size_t i = 0; i < rows.size();)
+    {
+        // Consecutive rows are removed together.
+        std::size_t j = i + 1;
+        while (j < rows.size() && rows[j] == rows[j - 1] - 1)
+            ++j;
+        int first = rows[j - 1], last = rows[i];
+        beginRemoveRows(QModelIndex(), first, last);
+        order->erase(order->begin() + first, order->begin() + last + 1);
+        endRemoveRows();
+        i = j;
+    }
+}
+
+int QuestionListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return static_cast<int>(order ? order->size() : questions->size());
+}
+
+QVariant QuestionListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount())
+        return QVariant();
+    const fq::Question *row = question(index.row());
+    if (role == Qt::ToolTipRole)
+        return QString::fromStdString(row->getQuestion());
+    if (role != Qt::DisplayRole)
+        return QVariant();
+    const std::string &text = row->getQuestion();
+    std::size_t lineEnd = text.find('\n');
+    QString display = QString::fromStdString(text.substr(0, lineEnd));
+    if (lineEnd != std::string::npos)
+        display += QString(" \u2026");
+    auto summary = statistics.get(row);
+    if (!summary)
+        return display + "\nNo answers recorded";
+    return display + QString("\n%1 answers, mean score %2 \u00B1 %3, mean time %4 s (90% within %5 s)")
+                         .arg(summary->answers)
+                         .arg(summary->meanScore, 0, 'f', 2)
+                         .arg(std::sqrt(summary->scoreVariance), 0, 'f', 2)
+                         .arg(summary->meanLatency, 0, 'f', 1)
+                         .arg(summary->latencyPercentile(0.9), 0, 'f', 1);
+}
@@ -0,0 +1,67 @@
+/// @file questionlistmodel.h
+/// @brief Header file for the QuestionListModel class, which lists the questions being edited without copying them.
+
+#ifndef QUESTIONLISTMODEL_H
+#define QUESTIONLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cmath>
+#include "question.hpp"
+#include "statistics.hpp"
+
+/// @brief List model over a shared, immutable list of questions, such as the questions of an edit log.
+/// @details The model keeps a reference to the list instead of an item per question, and formats a row only when
+/// the view asks for it, i.e. for the rows on screen. Setting the list therefore takes constant time when the rows
+/// are shown in the order of the list; only sorting or filtering them, or removing rows, builds an array of row
+/// positions. Every row shows the first line of its question and the answer statistics below it, so all rows have
+/// the same height and the view never measures them one by one. The full text is shown as tool tip.
+class QuestionListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    /// @brief The listed questions.
+    std::shared_ptr<const std::vector<fq::Question *>> questions;
+
+    /// @brief The position in questions of every row, or nothing if the rows are the questions in their order.
+    std::optional<std::vector<std::uint32_t>> order;
+
+    /// @brief The answer statistics shown below the questions.
+    const fq::QuestionStatistics &statistics;
+
+public:
+    /// @brief Constructs an empty model.
+    /// @param statistics The answer statistics shown below the questions. They must outlive the model.
+    /// @param parent The parent object. Defaults to nullptr.
+    explicit QuestionListModel(const fq::QuestionStatistics &statistics, QObject *parent = nullptr);
+
+    /// @brief Replaces the listed questions.
+    /// @param questions_ The questions. They must stay valid while they are listed.
+    /// @param order_ The position in questions_ of every row, or nothing to list all questions in their order.
+    void setQuestions(std::shared_ptr<const std::vector<fq::Question *>> questions_, std::optional<std::vector<std::uint32_t>> order_ = std::nullopt);
+
+    /// @brief Returns the question of a row.
+    /// @param row A row smaller than rowCount().
+    const fq::Question *question(int row) const { return (*questions)[order ? (*order)[row] : static_cast<std::uint32_t>(row)]; }
+
+    /// @brief Removes rows, e.g. of removed questions, without listing the questions again.
+    /// @param rows The rows to remove, in any order.
+    void remove(std::vector<int> rows);
+
+    /// @brief Returns the number of rows.
+    /// @param parent The parent index; only the invalid root index has rows.
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    /// @brief Returns the text (Qt::DisplayRole) or the full question text (Qt::ToolTipRole) of a row.
+    /// @param index The index of the row.
+    /// @param role The role.
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+};
+
+#endif // QUESTIONLISTMODEL_H
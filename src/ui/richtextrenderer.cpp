@@ -0,0 +1,571 @@
+#include "richtextrenderer.h"
+#include <QCryptographicHash>
+#include <QTextDocument>
+#include <QAbstractTextDocumentLayout>
+#include <QTextOption>
+#include <QPainter>
+#include <QPalette>
+#include <QRegularExpression>
+#include <QHash>
+#include <QtMath>
+#include <QUrl>
+#include <QVariant>
+#include <algorithm>
+
+namespace
+{
+    /// @brief Thin space put around binary operators and relations.
+    const QChar thinSpace(0x2009);
+
+    /// @brief Converts a LaTeX formula to rich text by recursive descent.
+    class TexConverter
+    {
+        /// @brief The formula.
+        const QString &source;
+
+        /// @brief Index of the next character of the formula.
+        qsizetype position = 0;
+
+        /// @brief Whether letters are set upright instead of in italics, e.g. inside \\mathrm.
+        bool upright = false;
+
+        bool atEnd() const
+        {
+            return position >= source.size();
+        }
+
+        void skipSpaces()
+        {
+            while (!atEnd() && source[position].isSpace())
+                ++position;
+        }
+
+        /// @brief Escapes a character for HTML inside Markdown.
+        static QString escape(QChar c)
+        {
+            switch (c.unicode())
+            {
+            case '<':
+                return QStringLiteral("&lt;");
+            case '>':
+                return QStringLiteral("&gt;");
+            case '&':
+                return QStringLiteral("&amp;");
+            case '"':
+                return QStringLiteral("&quot;");
+            case '*':
+            case '_':
+            case '`':
+            case '\\':
+            case '[':
+            case ']':
+            case '#':
+            case '|':
+            case '~':
+            case '$':
+            case '!':
+                return QString("&#%1;").arg(int(c.unicode()));
+            default:
+                return QString(c);
+            }
+        }
+
+        static QString spaced(const QString &symbol)
+        {
+            return thinSpace + symbol + thinSpace;
+        }
+
+        /// @brief Converts a character which is neither a letter nor part of the TeX syntax.
+        static QString symbol(QChar c)
+        {
+            switch (c.unicode())
+            {
+            case '+':
+            case '=':
+            case '<':
+            case '>':
+                return spaced(escape(c));
+            case '-':
+                return spaced(QChar(0x2212));
+            case '*':
+                return spaced(QChar(0x2217));
+            case '\'':
+                return QChar(0x2032);
+            case '~':
+                return QChar(0x00A0);
+            default:
+                return escape(c);
+            }
+        }
+
+        /// @brief Symbols written as commands, e.g. \\alpha.
+        static const QHash<QString, QString> &symbols()
+        {
+            static const QHash<QString, QString> table = []()
+            {
+                QHash<QString, QString> entries = {
+                    {"alpha", "α"}, {"beta", "β"}, {"gamma", "γ"}, {"delta", "δ"}, {"epsilon", "ϵ"}, {"varepsilon", "ε"},
+                    {"zeta", "ζ"}, {"eta", "η"}, {"theta", "θ"}, {"vartheta", "ϑ"}, {"iota", "ι"}, {"kappa", "κ"},
+                    {"lambda", "λ"}, {"mu", "μ"}, {"nu", "ν"}, {"xi", "ξ"}, {"pi", "π"}, {"varpi", "ϖ"}, {"rho", "ρ"},
+                    {"varrho", "ϱ"}, {"sigma", "σ"}, {"varsigma", "ς"}, {"tau", "τ"}, {"upsilon", "υ"}, {"phi", "ϕ"},
+                    {"varphi", "φ"}, {"chi", "χ"}, {"psi", "ψ"}, {"omega", "ω"}, {"Gamma", "Γ"}, {"Delta", "Δ"},
+                    {"Theta", "Θ"}, {"Lambda", "Λ"}, {"Xi", "Ξ"}, {"Pi", "Π"}, {"Sigma", "Σ"}, {"Upsilon", "Υ"},
+                    {"Phi", "Φ"}, {"Psi", "Ψ"}, {"Omega", "Ω"}, {"infty", "∞"}, {"partial", "∂"}, {"nabla", "∇"},
+                    {"forall", "∀"}, {"exists", "∃"}, {"neg", "¬"}, {"lnot", "¬"}, {"emptyset", "∅"},
+                    {"varnothing", "∅"}, {"sum", "∑"}, {"prod", "∏"}, {"int", "∫"}, {"iint", "∬"}, {"oint", "∮"},
+                    {"angle", "∠"}, {"triangle", "△"}, {"degree", "°"}, {"prime", "′"}, {"ldots", "…"}, {"dots", "…"},
+                    {"cdots", "⋯"}, {"vdots", "⋮"}, {"ddots", "⋱"}, {"hbar", "ℏ"}, {"ell", "ℓ"}, {"Re", "ℜ"},
+                    {"Im", "ℑ"}, {"aleph", "ℵ"}, {"langle", "⟨"}, {"rangle", "⟩"}, {"lfloor", "⌊"}, {"rfloor", "⌋"},
+                    {"lceil", "⌈"}, {"rceil", "⌉"}, {"quad", " "}, {"qquad", "  "}};
+                const std::pair<const char *, const char *> operators[] = {
+                    {"times", "×"}, {"cdot", "⋅"}, {"div", "÷"}, {"pm", "±"}, {"mp", "∓"}, {"ast", "∗"}, {"star", "⋆"},
+                    {"circ", "∘"}, {"bullet", "∙"}, {"cap", "∩"}, {"cup", "∪"}, {"wedge", "∧"}, {"land", "∧"},
+                    {"vee", "∨"}, {"lor", "∨"}, {"oplus", "⊕"}, {"otimes", "⊗"}, {"setminus", "∖"}, {"leq", "≤"},
+                    {"le", "≤"}, {"geq", "≥"}, {"ge", "≥"}, {"neq", "≠"}, {"ne", "≠"}, {"approx", "≈"},
+                    {"equiv", "≡"}, {"sim", "∼"}, {"simeq", "≃"}, {"cong", "≅"}, {"propto", "∝"}, {"ll", "≪"},
+                    {"gg", "≫"}, {"in", "∈"}, {"notin", "∉"}, {"ni", "∋"}, {"subset", "⊂"}, {"subseteq", "⊆"},
+                    {"supset", "⊃"}, {"supseteq", "⊇"}, {"perp", "⊥"}, {"parallel", "∥"}, {"mid", "∣"}, {"to", "→"},
+                    {"rightarrow", "→"}, {"leftarrow", "←"}, {"gets", "←"}, {"leftrightarrow", "↔"},
+                    {"Rightarrow", "⇒"}, {"implies", "⇒"}, {"Leftarrow", "⇐"}, {"Leftrightarrow", "⇔"},
+                    {"iff", "⇔"}, {"mapsto", "↦"}};
+                for (const auto &[name, text] : operators)
+                    entries.insert(name, spaced(text));
+                return entries;
+            }();
+            return table;
+        }
+
+        /// @brief Function names which are set upright, e.g. \\sin.
+        static bool isFunction(const QString &name)
+        {
+            static const QSet<QString> functions = {"sin", "cos", "tan", "cot", "sec", "csc", "arcsin", "arccos",
+                                                    "arctan", "sinh", "cosh", "tanh", "log", "ln", "lg", "exp",
+                                                    "lim", "max", "min", "sup", "inf", "det", "gcd", "deg", "arg",
+                                                    "dim", "ker", "Pr", "mod"};
+            return functions.contains(name);
+        }
+
+        /// @brief Reads the text of a braced argument without converting it, as for \\text.
+        QString verbatim()
+        {
+            skipSpaces();
+            if (atEnd() || source[position] != '{')
+                return argument();
+            QString html;
+            int depth = 0;
+            for (++position; !atEnd(); ++position)
+            {
+                QChar c = source[position];
+                if (c == '{')
+                    ++depth;
+                else if (c == '}' && depth-- == 0)
+                {
+                    ++position;
+                    break;
+                }
+                html += escape(c);
+            }
+            return html;
+        }
+
+        /// @brief Converts the argument of a command or script: a braced group, a command or a single character.
+        QString argument()
+        {
+            skipSpaces();
+            if (atEnd())
+                return {};
+            QChar c = source[position++];
+            if (c == '{')
+                return group(true);
+            if (c == '\\')
+                return command();
+            if (c.isLetter())
+                return upright ? escape(c) : "<i>" + escape(c) + "</i>";
+            return symbol(c);
+        }
+
+        /// @brief Converts a command, after its backslash.
+        QString command()
+        {
+            if (atEnd())
+                return escape('\\');
+            QString name;
+            while (!atEnd() && source[position].isLetter())
+                name += source[position++];
+            if (name.isEmpty())
+            {
+                QChar c = source[position++];
+                switch (c.unicode())
+                {
+                case ',':
+                    return thinSpace;
+                case ':':
+                case ';':
+                    return QChar(0x205F);
+                case ' ':
+                    return QStringLiteral(" ");
+                case '!':
+                    return {};
+                case '|':
+                    return QChar(0x2016);
+                case '\\':
+                    return QStringLiteral("<br/>");
+                default:
+                    return escape(c);
+                }
+            }
+            auto symbol = symbols().constFind(name);
+            if (symbol != symbols().constEnd())
+                return *symbol;
+            if (isFunction(name))
+                return name + thinSpace;
+            if (name == "frac" || name == "dfrac" || name == "tfrac")
+            {
+                QString numerator = argument();
+                QString denominator = argument();
+                return "<sup>" + numerator + "</sup>⁄<sub>" + denominator + "</sub>";
+            }
+            if (name == "sqrt")
+            {
+                QString index;
+                skipSpaces();
+                if (!atEnd() && source[position] == '[')
+                {
+                    qsizetype end = source.indexOf(']', position);
+                    if (end < 0)
+                        end = source.size();
+                    index = "<sup>" + TexConverter(source.mid(position + 1, end - position - 1)).group(false) + "</sup>";
+                    position = std::min(end + 1, source.size());
+                }
+                return index + "√<span style=\"text-decoration: overline\">" + argument() + "</span>";
+            }
+            if (name == "text" || name == "textrm" || name == "mbox")
+                return verbatim();
+            if (name == "mathrm" || name == "operatorname" || name == "textit" || name == "mathit")
+            {
+                bool italic = name == "textit" || name == "mathit";
+                bool saved = upright;
+                upright = true;
+                QString text = argument();
+                upright = saved;
+                return italic ? "<i>" + text + "</i>" : text;
+            }
+            if (name == "mathbf" || name == "textbf" || name == "boldsymbol")
+                return "<b>" + argument() + "</b>";
+            if (name == "overline" || name == "bar")
+                return "<span style=\"text-decoration: overline\">" + argument() + "</span>";
+            if (name == "vec")
+                return argument() + QChar(0x20D7);
+            if (name == "hat")
+                return argument() + QChar(0x0302);
+            if (name == "tilde")
+                return argument() + QChar(0x0303);
+            if (name == "dot")
+                return argument() + QChar(0x0307);
+            if (name == "ddot")
+                return argument() + QChar(0x0308);
+            if (name == "left" || name == "right" || name.startsWith("big") || name.startsWith("Big"))
+            {
+                skipSpaces();
+                if (!atEnd() && source[position] == '.')
+                    ++position;
+                return {};
+            }
+            return escape('\\') + name;
+        }
+
+    public:
+        explicit TexConverter(const QString &source) : source(source) {}
+
+        /// @brief Converts the formula up to the end of the current group.
+        /// @param braced Whether the group was opened by a brace and ends at the matching one.
+        QString group(bool braced)
+        {
+            QString html;
+            QString letters;
+            auto flush = [&]()
+            {
+                if (!letters.isEmpty())
+                    html += upright ? letters : "<i>" + letters + "</i>";
+                letters.clear();
+            };
+            while (!atEnd())
+            {
+                QChar c = source[position++];
+                if (c.isLetter())
+                {
+                    letters += escape(c);
+                    continue;
+                }
+                flush();
+                if (c == '}')
+                {
+                    if (braced)
+                        break;
+                }
+                else if (c == '{')
+                    html += group(true);
+                else if (c == '^' || c == '_')
+                {
+                    QString tag = c == '^' ? "sup" : "sub";
+                    html += "<" + tag + ">" + argument() + "</" + tag + ">";
+                }
+                else if (c == '\\')
+                    html += command();
+                else if (!c.isSpace())
+                    html += symbol(c);
+            }
+            flush();
+            return html;
+        }
+    };
+
+    /// @brief Document taking its images from a MediaCache, scaled down to the width of the document.
+    class MediaDocument : public QTextDocument
+    {
+        MediaCache *media;
+
+    public:
+        explicit MediaDocument(MediaCache *media) : media(media) {}
+
+    protected:
+        QVariant loadResource(int type, const QUrl &name) override
+        {
+            if (type != QTextDocument::ImageResource)
+                return QTextDocument::loadResource(type, name);
+            QImage image = media ? media->load(name.toString()) : QImage();
+            int width = qFloor(textWidth());
+            if (!image.isNull() && width > 0 && image.width() / image.devicePixelRatio() > width)
+                image = image.scaledToWidth(qRound(width * image.devicePixelRatio()), Qt::SmoothTransformation);
+            return image;
+        }
+    };
+
+    /// @brief Finds the $ closing a formula.
+    /// @param text The text.
+    /// @param start Index of the first character of the formula.
+    /// @param display Whether the formula was opened by $$.
+    /// @return Index of the closing $, or -1 if the formula is not closed.
+    qsizetype closingDollar(const QString &text, qsizetype start, bool display)
+    {
+        if (start >= text.size() || (!display && text[start].isSpace()))
+            return -1;
+        for (qsizetype i = start; i < text.size(); ++i)
+        {
+            QChar c = text[i];
+            if (c == '\\')
+                ++i;
+            else if (c == '\n' && i + 1 < text.size() && text[i + 1] == '\n')
+                return -1;
+            else if (c == '$' && display)
+            {
+                if (i + 1 < text.size() && text[i + 1] == '$')
+                    return i > start ? i : -1;
+            }
+            else if (c == '$' && i > start && !text[i - 1].isSpace() && !(i + 1 < text.size() && text[i + 1].isDigit()))
+                return i;
+        }
+        return -1;
+    }
+}
+
+void RichTextRenderer::finished(const Key &key, const QImage &image)
+{
+    pending.remove(key);
+    QPixmap pixmap = QPixmap::fromImage(image);
+    for (const Target &target : targets)
+        if (target.label && target.key == key)
+            target.label->setPixmap(pixmap);
+    cache.insert(key, new QPixmap(pixmap), std::max<qsizetype>(1, image.sizeInBytes()));
+}
+
+QImage RichTextRenderer::renderImage(const QString &markdown, const QFont &font, int width, qreal ratio, Qt::Alignment alignment, const QColor &color, MediaCache *media)
+{
+    MediaDocument document(media);
+    document.setDefaultFont(font);
+    document.setDocumentMargin(0);
+    QTextOption option = document.defaultTextOption();
+    option.setAlignment(alignment);
+    option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+    document.setDefaultTextOption(option);
+    document.setTextWidth(width);
+    document.setMarkdown(markdown, QTextDocument::MarkdownDialectGitHub);
+    QSize size(width, std::max(1, qCeil(document.size().height())));
+    QImage image(size * ratio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(ratio);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    QAbstractTextDocumentLayout::PaintContext context;
+    context.palette.setColor(QPalette::Text, color);
+    document.documentLayout()->draw(&painter, context);
+    return image;
+}
+
+RichTextRenderer::RichTextRenderer(MediaCache *media, qint64 cacheBytes, QObject *parent)
+    : QObject(parent), cache(cacheBytes), media(media)
+{
+    pool.setMaxThreadCount(2);
+}
+
+RichTextRenderer::~RichTextRenderer()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void RichTextRenderer::display(QLabel *label, const QString &text)
+{
+    targets.erase(std::remove_if(targets.begin(), targets.end(), [](const Target &target)
+                                 { return target.label.isNull(); }),
+                  targets.end());
+    auto target = std::find_if(targets.begin(), targets.end(), [label](const Target &target)
+                               { return target.label == label; });
+    if (target == targets.end())
+    {
+        // The rendered pixmap sets the minimum size of the label, which would keep the window from shrinking.
+        label->setMinimumWidth(1);
+        targets.push_back({label, QString(), Key()});
+        target = std::prev(targets.end());
+    }
+    bool sameText = target->text == text;
+    target->text = text;
+    if (!isRichText(text))
+    {
+        target->key = Key();
+        label->setText(text);
+        return;
+    }
+
+    Key key;
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(text.toUtf8());
+    if (media)
+        hash.addData(media->getBaseDirectory().toUtf8());
+    key.hash = hash.result();
+    key.pointSize = label->font().pointSize();
+    key.width = std::max(1, label->contentsRect().width() - 2 * label->margin());
+    key.ratio = qRound(label->devicePixelRatioF() * 100);
+    key.alignment = static_cast<int>(label->alignment() & Qt::AlignHorizontal_Mask);
+    key.color = label->palette().color(label->foregroundRole()).rgba();
+    target->key = key;
+    if (QPixmap *pixmap = cache.object(key))
+    {
+        label->setPixmap(*pixmap);
+        return;
+    }
+    // Until the rendering is ready, an earlier rendering of the same text is better than the raw markup.
+    if (!sameText || label->pixmap().isNull())
+        label->setText(text);
+    if (pending.contains(key))
+        return;
+    pending.insert(key);
+
+    QString markdown = toMarkdown(text);
+    QFont font = label->font();
+    qreal ratio = label->devicePixelRatioF();
+    pool.start([this, key, markdown, font, ratio]()
+               {
+                   QImage image = renderImage(markdown, font, key.width, ratio, Qt::Alignment(key.alignment),
+                                              QColor::fromRgba(key.color), media);
+                   // The destructor waits for the running renderings, so the renderer still exists here.
+                   QMetaObject::invokeMethod(this, [this, key, image]()
+                                             { finished(key, image); }, Qt::QueuedConnection); });
+}
+
+void RichTextRenderer::refresh()
+{
+    std::vector<std::pair<QPointer<QLabel>, QString>> shown;
+    for (const Target &target : targets)
+        shown.emplace_back(target.label, target.text);
+    for (const auto &[label, text] : shown)
+        if (label)
+            display(label, text);
+}
+
+bool RichTextRenderer::isRichText(const QString &text)
+{
+    static const QRegularExpression block(QStringLiteral("^\\s*(?:[-+*>]|\\d+[.)]|#{1,6})\\s"),
+                                          QRegularExpression::MultilineOption);
+    for (QChar c : text)
+        if (c == '*' || c == '_' || c == '`' || c == '$' || c == '\\' || c == '[' || c == '|' || c == '~')
+            return true;
+    return text.contains(block);
+}
+
+QString RichTextRenderer::toMarkdown(const QString &text)
+{
+    QString markdown;
+    markdown.reserve(text.size());
+    bool fenced = false;
+    bool lineStart = true;
+    qsizetype i = 0;
+    while (i < text.size())
+    {
+        if (lineStart)
+        {
+            qsizetype end = text.indexOf('\n', i);
+            end = end < 0 ? text.size() : end + 1;
+            QString line = text.mid(i, end - i).trimmed();
+            if (line.startsWith("```") || line.startsWith("~~~"))
+                fenced = !fenced;
+            if (fenced || line.startsWith("```") || line.startsWith("~~~"))
+            {
+                markdown += text.mid(i, end - i);
+                i = end;
+                continue;
+            }
+        }
+        QChar c = text[i];
+        lineStart = c == '\n';
+        if (c == '\\' && i + 1 < text.size())
+        {
+            lineStart = text[i + 1] == '\n';
+            markdown += text.mid(i, 2);
+            i += 2;
+        }
+        else if (c == '`')
+        {
+            qsizetype run = 1;
+            while (i + run < text.size() && text[i + run] == '`')
+                ++run;
+            QString fence(run, '`');
+            qsizetype end = text.indexOf(fence, i + run);
+            while (end >= 0 && end + run < text.size() && text[end + run] == '`')
+            {
+                while (end < text.size() && text[end] == '`')
+                    ++end;
+                end = text.indexOf(fence, end);
+            }
+            end = end < 0 ? i + run : end + run;
+            markdown += text.mid(i, end - i);
+            i = end;
+        }
+        else if (c == '$')
+        {
+            bool display = i + 1 < text.size() && text[i + 1] == '$';
+            qsizetype start = i + (display ? 2 : 1);
+            qsizetype end = closingDollar(text, start, display);
+            if (end < 0)
+            {
+                markdown += text.mid(i, start - i);
+                i = start;
+                continue;
+            }
+            QString html = texToHtml(text.mid(start, end - start));
+            markdown += display ? "\n\n" + html + "\n\n" : html;
+            i = end + (display ? 2 : 1);
+        }
+        else
+        {
+            markdown += c;
+            ++i;
+        }
+    }
+    return markdown;
+}
+
+QString RichTextRenderer::texToHtml(const QString &formula)
+{
+    return TexConverter(formula).group(false);
+}
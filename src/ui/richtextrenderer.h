@@ -0,0 +1,161 @@
+/// @file richtextrenderer.h
+/// @brief Header file for the RichTextRenderer class, which renders Markdown and formulas off the UI thread.
+
+#ifndef RICHTEXTRENDERER_H
+#define RICHTEXTRENDERER_H
+
+#include <QObject>
+#include <QLabel>
+#include <QPointer>
+#include <QCache>
+#include <QSet>
+#include <QThreadPool>
+#include <QPixmap>
+#include <QImage>
+#include <QFont>
+#include <QColor>
+#include <QString>
+#include <QByteArray>
+#include <vector>
+#include "mediacache.h"
+
+/// @brief Renders question and explanation texts with Markdown, code blocks and formulas into labels.
+/// @details Texts without any markup are set on the label directly. Other texts are converted to a QTextDocument
+/// and painted into an image on a worker thread, while the label shows the plain text (or the previous rendering
+/// of the same text) until the image is ready. Rendered pixmaps are kept in an LRU cache keyed by the hash of the
+/// text, the font size, the width and the colour, so showing a text again or returning to a previous font size
+/// does not render it again. Images (see MediaCache) are decoded by the worker threads as part of the rendering, and
+/// scaled down to the width of the label.
+///
+/// Formulas are written between $ signs ($$ for a formula on its own line) in a subset of LaTeX: superscripts and
+/// subscripts, \\frac, \\sqrt, Greek letters, common operators and relations, accents and \\text. They are
+/// converted to rich text, because Qt has no TeX typesetting engine.
+class RichTextRenderer : public QObject
+{
+    Q_OBJECT
+
+    /// @brief Identifies one rendering of a text.
+    struct Key
+    {
+        /// @brief SHA-1 hash of the text and the directory its images are resolved against.
+        QByteArray hash;
+
+        /// @brief Point size of the font.
+        int pointSize = 0;
+
+        /// @brief Width of the rendering in device independent pixels.
+        int width = 0;
+
+        /// @brief Device pixel ratio of the label, in percent.
+        int ratio = 0;
+
+        /// @brief Horizontal alignment of the label.
+        int alignment = 0;
+
+        /// @brief Colour of the text.
+        QRgb color = 0;
+
+        bool operator==(const Key &other) const
+        {
+            return hash == other.hash && pointSize == other.pointSize && width == other.width && ratio == other.ratio &&
+                   alignment == other.alignment && color == other.color;
+        }
+
+        friend size_t qHash(const Key &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.hash, key.pointSize, key.width, key.ratio, key.alignment, key.color);
+        }
+    };
+
+    /// @brief A label whose text is managed by the renderer.
+    struct Target
+    {
+        /// @brief The label, or null once it has been destroyed.
+        QPointer<QLabel> label;
+
+        /// @brief The text the label shows.
+        QString text;
+
+        /// @brief The rendering the label waits for or shows. Empty for plain texts.
+        Key key;
+    };
+
+    /// @brief Rendered pixmaps, with their size in bytes as the cost.
+    QCache<Key, QPixmap> cache;
+
+    /// @brief Renderings which are queued or running on the worker threads.
+    QSet<Key> pending;
+
+    /// @brief The labels shown through the renderer.
+    std::vector<Target> targets;
+
+    /// @brief Worker threads rendering the documents.
+    QThreadPool pool;
+
+    /// @brief The images referenced by the texts, or nullptr if images are not shown.
+    MediaCache *media;
+
+    /// @brief Stores a finished rendering and shows it in the labels waiting for it.
+    /// @param key The rendering.
+    /// @param image The rendered text.
+    void finished(const Key &key, const QImage &image);
+
+    /// @brief Renders Markdown into an image.
+    /// @details Called on the worker threads.
+    /// @param markdown The Markdown text.
+    /// @param font The default font of the document.
+    /// @param width The width of the image in device independent pixels.
+    /// @param ratio The device pixel ratio of the image.
+    /// @param alignment The horizontal alignment of the paragraphs.
+    /// @param color The colour of the text.
+    /// @param media The images referenced by the text, or nullptr.
+    /// @return The image, with a transparent background.
+    static QImage renderImage(const QString &markdown, const QFont &font, int width, qreal ratio, Qt::Alignment alignment, const QColor &color, MediaCache *media);
+
+public:
+    /// @brief Constructs a renderer.
+    /// @param media The images referenced by the texts, or nullptr to show only their descriptions. It is used by
+    /// the worker threads, so it must outlive the renderer.
+    /// @param cacheBytes The maximum total size of the cached pixmaps in bytes.
+    /// @param parent The parent object.
+    explicit RichTextRenderer(MediaCache *media = nullptr, qint64 cacheBytes = 64 * 1024 * 1024, QObject *parent = nullptr);
+
+    /// @brief Discards the queued renderings and waits for the running ones.
+    ~RichTextRenderer();
+
+    /// @brief Shows a text in a label, rendering its markup if it has any.
+    /// @details Never blocks on rendering: if the rendering is not cached, it is started on a worker thread and the
+    /// label is updated when it is finished. The label is rendered at its current font, width and text colour.
+    /// @param label The label.
+    /// @param text The text, possibly with Markdown and formulas.
+    void display(QLabel *label, const QString &text);
+
+    /// @brief Returns the total size of the cached pixmaps in bytes.
+    qint64 cachedBytes() const { return cache.totalCost(); }
+
+    /// @brief Returns the maximum total size of the cached pixmaps in bytes.
+    qint64 maxCachedBytes() const { return cache.maxCost(); }
+
+    /// @brief Shows the texts of all labels again, after their font or size has changed.
+    void refresh();
+
+    /// @brief Checks whether a text contains markup which has to be rendered.
+    /// @param text The text.
+    /// @return True if the text may contain Markdown or formulas.
+    static bool isRichText(const QString &text);
+
+    /// @brief Converts the formulas in a text to rich text, leaving the rest of the Markdown as it is.
+    /// @details Code spans and fenced code blocks are copied unchanged, and \\$ is a literal dollar sign. A formula
+    /// starts at a $ not followed by a space and ends at a $ not preceded by a space and not followed by a digit, so
+    /// prices such as $5 are not formulas.
+    /// @param text The text.
+    /// @return Markdown with the formulas as inline HTML.
+    static QString toMarkdown(const QString &text);
+
+    /// @brief Converts a LaTeX formula to rich text.
+    /// @param formula The formula, without the surrounding $ signs.
+    /// @return The HTML of the formula.
+    static QString texToHtml(const QString &formula);
+};
+
+#endif // RICHTEXTRENDERER_H